@@ -0,0 +1,220 @@
+/** @file analoginput.cpp
+ *    This file contains the implementation of the 0-10 V analog spindle speed input.
+ *
+ *  @date 2026-Oct-16
+ */
+
+#include "analoginput.h"                                                // Include corresponding header file
+
+analogInput* analogInput::active = NULL;                                // No input started yet
+
+/** @brief   Function called to instantiate an analog input object.
+ *  @details This function saves the input pin. The scale starts at zero, so the spindle
+ *           stays off until @c set_scale() is called. The ADC and DMA are not touched until
+ *           @c begin() is called from a task.
+ *  @param   input_GPIO The pin the divided-down reference comes in on, which must be on ADC1
+ */
+analogInput::analogInput (uint8_t input_GPIO)
+{
+    input_pin = input_GPIO;                     // Save the parameter, which will evaporate when the constructor exits
+    full_scale_rpm = 0;                         // Off until a scale is set
+    deadband_rpm = 0;                           // No deadband
+    first = true;                               // No average yet
+    filtered = 0;                               // Initialize to 0
+    setpoint = 0;                               // Off
+    updates = 0;                                // Initialize to 0
+}
+
+/** @brief   Function that sets the speed at the top of the input range.
+ *  @param   rpm The speed when the input is at full scale, usually 10 V [RPM]
+ */
+void analogInput::set_scale (int32_t rpm)
+{
+    full_scale_rpm = rpm;                       // Save the parameter, which will evaporate when the function exits
+}
+
+/** @brief   Function that sets the speed below which the spindle is off.
+ *  @param   rpm The smallest speed passed on [RPM]
+ */
+void analogInput::set_deadband (int32_t rpm)
+{
+    deadband_rpm = rpm;                         // Save the parameter, which will evaporate when the function exits
+}
+
+/** @brief   Function that configures the ADC and DMA and starts converting.
+ *  @details The ADC is clocked from the system clock divided by 4 and converts the one
+ *           channel continuously, with 64 times oversampling. It is calibrated before it
+ *           starts. DMA1 channel 1, which serves ADC1, copies each result into the buffer and
+ *           starts over at the end, interrupting at each half.
+ *  @returns True if the ADC started, false if the pin isn't on ADC1 or the ADC wouldn't start
+ */
+bool analogInput::begin (void)
+{
+    PinName pin_name = digitalPinToPinName(input_pin);                                      // Convert the Arduino pin to an STM32 pin name
+    ADC_TypeDef* instance = (ADC_TypeDef*)pinmap_peripheral(pin_name, PinMap_ADC);          // Find the ADC connected to the pin
+    if (instance != ADC1)                                                                   // If it isn't the one DMA1 channel 1 serves...
+    {                                                                                       //
+        return false;                                                                       //      Then, it can't be used
+    }                                                                                       //
+    uint32_t channel = STM_PIN_CHANNEL(pinmap_function(pin_name, PinMap_ADC));              // Find the channel connected to the pin
+    pinmap_pinout(pin_name, PinMap_ADC);                                                    // Put the pin in analog mode
+    active = this;                                                                          // Let the DMA interrupt find this input
+    __HAL_RCC_ADC_CLK_ENABLE();                                                             // Clock the ADC and DMA
+    __HAL_RCC_DMA1_CLK_ENABLE();                                                            //
+
+    dma.Instance = DMA1_Channel1;                                                           // Copy ADC1 results into the buffer
+    dma.Init.Request = DMA_REQUEST_0;                                                       //
+    dma.Init.Direction = DMA_PERIPH_TO_MEMORY;                                              //
+    dma.Init.PeriphInc = DMA_PINC_DISABLE;                                                  //
+    dma.Init.MemInc = DMA_MINC_ENABLE;                                                      //
+    dma.Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;                                 //
+    dma.Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD;                                    //
+    dma.Init.Mode = DMA_CIRCULAR;                                                           //      Around and around
+    dma.Init.Priority = DMA_PRIORITY_LOW;                                                   //
+    if (HAL_DMA_Init(&dma) != HAL_OK)                                                       //
+    {                                                                                       //
+        return false;                                                                       //
+    }                                                                                       //
+    __HAL_LINKDMA(&adc, DMA_Handle, dma);                                                   //
+    HAL_NVIC_SetPriority(DMA1_Channel1_IRQn, 6, 0);                                         // Below the timers, which time the motor
+    HAL_NVIC_EnableIRQ(DMA1_Channel1_IRQn);                                                 //
+
+    adc.Instance = ADC1;                                                                    // Convert one channel over and over
+    adc.Init.ClockPrescaler = ADC_CLOCK_SYNC_PCLK_DIV4;                                     //      20 MHz from 80 MHz
+    adc.Init.Resolution = ADC_RESOLUTION_12B;                                               //
+    adc.Init.DataAlign = ADC_DATAALIGN_RIGHT;                                               //
+    adc.Init.ScanConvMode = ADC_SCAN_DISABLE;                                               //
+    adc.Init.EOCSelection = ADC_EOC_SINGLE_CONV;                                            //
+    adc.Init.LowPowerAutoWait = DISABLE;                                                    //
+    adc.Init.ContinuousConvMode = ENABLE;                                                   //
+    adc.Init.NbrOfConversion = 1;                                                           //
+    adc.Init.DiscontinuousConvMode = DISABLE;                                               //
+    adc.Init.ExternalTrigConv = ADC_SOFTWARE_START;                                         //
+    adc.Init.ExternalTrigConvEdge = ADC_EXTERNALTRIGCONVEDGE_NONE;                          //
+    adc.Init.DMAContinuousRequests = ENABLE;                                                //      Keep asking for DMA
+    adc.Init.Overrun = ADC_OVR_DATA_OVERWRITTEN;                                            //
+    adc.Init.OversamplingMode = ENABLE;                                                     //      Add up 64 conversions
+    adc.Init.Oversampling.Ratio = ADC_OVERSAMPLING_RATIO_64;                                //
+    adc.Init.Oversampling.RightBitShift = ADC_RIGHTBITSHIFT_2;                              //      18 bits down to 16
+    adc.Init.Oversampling.TriggeredMode = ADC_TRIGGEREDMODE_SINGLE_TRIGGER;                 //
+    adc.Init.Oversampling.OversamplingStopReset = ADC_REGOVERSAMPLING_CONTINUED_MODE;       //
+    if (HAL_ADC_Init(&adc) != HAL_OK)                                                       //
+    {                                                                                       //
+        return false;                                                                       //
+    }                                                                                       //
+
+    ADC_ChannelConfTypeDef config = {};                                                     // Set up the channel
+    config.Channel = __LL_ADC_DECIMAL_NB_TO_CHANNEL(channel);                               //
+    config.Rank = ADC_REGULAR_RANK_1;                                                       //
+    config.SamplingTime = ADC_SAMPLETIME_92CYCLES_5;                                        //      Long enough for a divider
+    config.SingleDiff = ADC_SINGLE_ENDED;                                                   //
+    config.OffsetNumber = ADC_OFFSET_NONE;                                                  //
+    if (HAL_ADC_ConfigChannel(&adc, &config) != HAL_OK                                      //
+        || HAL_ADCEx_Calibration_Start(&adc, ADC_SINGLE_ENDED) != HAL_OK)                   //
+    {                                                                                       //
+        return false;                                                                       //
+    }                                                                                       //
+    return HAL_ADC_Start_DMA(&adc, (uint32_t*)buffer, ANALOG_BUFFER_SIZE) == HAL_OK;        // Start converting
+}
+
+/** @brief   Function that averages half the buffer and works out the speed.
+ *  @details This is called from the DMA interrupt while DMA is filling the other half, so
+ *           the results being read don't change under it. The first average is taken as it
+ *           is, so the filter doesn't start from zero.
+ *  @param   samples The first result in the half to average
+ */
+void analogInput::decimate (const volatile uint16_t* samples)
+{
+    uint32_t sum = 0;                                                                       // Add up the half buffer
+    for (uint8_t i = 0; i < ANALOG_BUFFER_SIZE/2; i++)                                      //
+    {                                                                                       //
+        sum += samples[i];                                                                  //
+    }                                                                                       //
+    int32_t average = sum/(ANALOG_BUFFER_SIZE/2);                                           //
+    if (first)                                                                              // If this is the first average...
+    {                                                                                       //
+        filtered = average;                                                                 //      Then, start from it
+        first = false;                                                                      //
+    }                                                                                       //
+    else                                                                                    // Otherwise...
+    {                                                                                       //
+        filtered += (average - (int32_t)filtered) >> ANALOG_FILTER_SHIFT;                   //      Filter it
+    }                                                                                       //
+    int32_t rpm = ((int64_t)filtered*full_scale_rpm + 32760)/65520;                         // Scale to a speed
+    if (rpm < deadband_rpm)                                                                 // If it is in the deadband...
+    {                                                                                       //
+        rpm = 0;                                                                            //      Then, the spindle is off
+    }                                                                                       //
+    if (rpm == 0 || setpoint == 0 || abs(rpm - setpoint) > ANALOG_HYSTERESIS_RPM)           // If it has really changed...
+    {                                                                                       //
+        setpoint = rpm;                                                                     //      Then, pass it on
+    }                                                                                       //
+    updates ++;                                                                             //
+}
+
+/** @brief   Function called when DMA has filled the first half of the buffer.
+ */
+void analogInput::half_full (void)
+{
+    decimate(buffer);
+}
+
+/** @brief   Function called when DMA has filled the second half of the buffer.
+ */
+void analogInput::full (void)
+{
+    decimate(buffer + ANALOG_BUFFER_SIZE/2);
+}
+
+/** @brief   Function called by the DMA interrupt, which the HAL passes on to the callbacks below.
+ */
+void analogInput::interrupt (void)
+{
+    HAL_DMA_IRQHandler(&dma);
+}
+
+/** @brief   Function that prints the input.
+ *  @param   printer The stream to print to
+ */
+void analogInput::print (Print& printer)
+{
+    printer << "Analog input " << ((filtered*10000 + 32760)/65520) << " mV of 10 V, "    //
+            << setpoint << " RPM, " << updates << " updates" << endl;                     //
+}
+
+#if motorAnalogInput                            // Leave the interrupts to anything else using them unless this input is
+                                                //      the one in use
+/** @brief   Interrupt handler for DMA1 channel 1.
+ */
+extern "C" void DMA1_Channel1_IRQHandler (void)
+{
+    if (analogInput::active)                                                                // If there's an input using it...
+    {                                                                                       //
+        analogInput::active->interrupt();                                                    //      Then, let it sort it out
+    }                                                                                       //
+}
+
+/** @brief   HAL callback for the first half of the buffer being filled.
+ *  @param   hadc The ADC whose buffer it is
+ */
+void HAL_ADC_ConvHalfCpltCallback (ADC_HandleTypeDef* hadc)
+{
+    (void)hadc;                                 // There is only the one
+    if (analogInput::active)                    //
+    {                                           //
+        analogInput::active->half_full();       //
+    }                                           //
+}
+
+/** @brief   HAL callback for the second half of the buffer being filled.
+ *  @param   hadc The ADC whose buffer it is
+ */
+void HAL_ADC_ConvCpltCallback (ADC_HandleTypeDef* hadc)
+{
+    (void)hadc;                                 // There is only the one
+    if (analogInput::active)                    //
+    {                                           //
+        analogInput::active->full();            //
+    }                                           //
+}
+#endif // motorAnalogInput
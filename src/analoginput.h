@@ -0,0 +1,73 @@
+/** @file analoginput.h
+ *    This file contains the class definition for a reader which follows the 0-10 V
+ *    analog spindle speed output of a CNC controller, using the ADC with DMA.
+ *  @date 2026-Oct-16
+ */
+
+#ifndef ANALOGINPUT_H
+#define ANALOGINPUT_H
+#include <Arduino.h>
+#include <PrintStream.h>
+#if (defined STM32L4xx || defined STM32F4xx)
+    #include <STM32FreeRTOS.h>
+#endif
+
+#define ANALOG_BUFFER_SIZE     16               // Oversampled results in the DMA buffer; half of them are averaged at a time
+#define ANALOG_FILTER_SHIFT    2                // Averages are filtered with a time constant of 2^2 half buffers
+#define ANALOG_HYSTERESIS_RPM  20               // Smallest change in speed passed on, so the set point doesn't dither
+
+#define motorAnalogInput      0                 // 1 -> a CNC controller sets the speed with 0-10 V, 0 -> the user does
+                                                //      Only when 1 does this file take over the DMA1 channel 1
+                                                //      and ADC conversion interrupts
+
+/** @brief   Defines the class for a 0-10 V analog spindle speed input.
+ *  @details Many CNC controllers set the spindle speed with a 0-10 V reference, which is
+ *           divided down to the range of the ADC. Reading it with @c analogRead() from a task
+ *           would cost the task a conversion each time and give only 12 bits, with a few counts
+ *           of noise. Instead, the ADC converts continuously, and DMA copies each result into
+ *           a circular buffer, so reading the input takes no processor time at all until the
+ *           buffer is half full.
+ *
+ *           Each result is already 64 conversions added up by the ADC's hardware oversampler
+ *           and shifted down by 2, which gives a 16-bit number, full scale 65520, of which
+ *           about 14 bits are above the noise. The DMA interrupt at each half of the buffer
+ *           averages the @c ANALOG_BUFFER_SIZE/2 results in that half, and the average goes
+ *           through a first-order filter. With a 92.5 cycle sampling time at 20 MHz, a result
+ *           takes about 340 us, and the filtered value is updated every 2.7 ms.
+ *
+ *           The filtered value is scaled to a speed with @c set_scale(), which gives the speed
+ *           at full scale. Speeds below the deadband set with @c set_deadband() are taken as
+ *           zero, so that a few millivolts of offset don't creep the spindle around, and the
+ *           speed is only changed when it moves by more than @c ANALOG_HYSTERESIS_RPM. The
+ *           control loop reads @c setpoint directly, so the speed is picked up at the control
+ *           rate, and the motor task copies it into the set point share.
+ *
+ *           The hardware oversampler belongs to the STM32L4's ADC. Only one analog input can
+ *           be used, since the DMA interrupt has to find it.
+ */
+class analogInput {
+    protected:
+        uint8_t input_pin;                                          // Pin the analog reference comes in on
+        ADC_HandleTypeDef adc;                                      // ADC that converts the input
+        DMA_HandleTypeDef dma;                                      // DMA channel that copies the results
+        volatile uint16_t buffer[ANALOG_BUFFER_SIZE];               // Results, written by DMA
+        int32_t full_scale_rpm;                                     // Speed at full scale
+        int32_t deadband_rpm;                                       // Speeds below this are off
+        bool first;                                                 // True until the first average is in
+        void decimate (const volatile uint16_t* samples);           // Function format for averaging half the buffer
+    public:
+        static analogInput* active;                                 // The input the DMA interrupt belongs to
+        volatile uint32_t filtered;                                 // Filtered input, 0 to 65520
+        volatile int32_t setpoint;                                  // Speed asked for [RPM]
+        volatile uint32_t updates;                                  // Half buffers averaged
+        analogInput (uint8_t input_GPIO);                           // Format for instantiating an analog input object
+        void set_scale (int32_t rpm);                               // Function format for setting the speed at full scale
+        void set_deadband (int32_t rpm);                            // Function format for setting the speed below which it is off
+        bool begin (void);                                          // Function format for starting the ADC and DMA
+        void half_full (void);                                      // Function called when DMA has filled the first half
+        void full (void);                                           // Function called when DMA has filled the second half
+        void interrupt (void);                                      // Function called by the DMA interrupt
+        void print (Print& printer);                                // Function format for printing the input
+};
+
+#endif // ANALOGINPUT_H
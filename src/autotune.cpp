@@ -0,0 +1,181 @@
+/** @file autotune.cpp
+ *    This file contains the implementation of the relay-feedback auto-tuner.
+ *
+ *  @date 2026-Oct-16
+ */
+
+#include "autotune.h"                                                   // Include corresponding header file
+
+/** @brief   Function called to instantiate an auto-tuner object.
+ *  @param   update_period_us Time between calls to @c step(), in microseconds
+ */
+relayTuner::relayTuner (uint32_t update_period_us)
+{
+    dt = update_period_us/1000000.0f;                   // Period in seconds
+    timeout_steps = TUNE_TIMEOUT_US/update_period_us;   // Timeout in control steps
+    state = TUNE_IDLE;                                  // Not tuning
+    rule = TUNE_ZIEGLER_NICHOLS;                        // Default rule
+    ku = 0; tu = 0;                                     // Initialize to 0
+    kp = 0; ki = 0; kd = 0;                             // Initialize to 0
+}
+
+/** @brief   Function that starts tuning.
+ *  @details The bias should be about the duty cycle which holds the set point, such as the
+ *           feed-forward duty cycle or the controller's latest output, so that the limit cycle
+ *           is centred on the set point. The relay is narrowed if needed to keep the duty cycle
+ *           between zero and @c maximum_duty. Tuning fails straight away if there is no set
+ *           point or no room for a relay.
+ *  @param   speed_setpoint The speed to tune at [RPM]
+ *  @param   bias_duty      The duty cycle in the middle of the relay
+ *  @param   relay_duty     How far the relay moves the duty cycle each way
+ *  @param   hysteresis     Speed past the set point at which the relay switches [RPM]
+ *  @param   maximum_duty   The largest duty cycle allowed
+ */
+void relayTuner::start (int32_t speed_setpoint, int32_t bias_duty, int32_t relay_duty,
+                        int32_t hysteresis, int32_t maximum_duty)
+{
+    setpoint = speed_setpoint;                                      // Save the parameters, which will evaporate when the function exits
+    bias = bias_duty;                                               //
+    band = hysteresis;                                              //
+    duty_max = maximum_duty;                                        //
+    relay = min(relay_duty, min(bias, duty_max - bias));            // Keep both sides of the relay within range
+    speed_limit = setpoint + setpoint/2;                            // Stop if it gets half again as fast as the set point
+    steps = 0;                                                      // Initialize to 0
+    last_rise = 0;                                                  // No rise yet
+    last_period = 0;                                                // No cycle yet
+    cycle_in_phase = 0;                                             // Initialize to 0
+    cycle_quadrature = 0;                                           //
+    cycles = 0;                                                     // Initialize to 0
+    period_sum = 0;                                                 // Initialize to 0
+    in_phase_sum = 0;                                               // Initialize to 0
+    quadrature_sum = 0;                                             //
+    relay_high = true;                                              // Start by speeding up
+    state = (setpoint > 0 && relay > 0) ? TUNE_RUNNING : TUNE_FAILED;   // There must be something to tune around
+}
+
+/** @brief   Function that stops tuning without changing the gains.
+ */
+void relayTuner::abort (void)
+{
+    if (state == TUNE_RUNNING)                                      // If tuning...
+    {                                                               //
+        state = TUNE_FAILED;                                        //      Then, it didn't finish
+    }                                                               //
+}
+
+/** @brief   Function that runs one step of the relay.
+ *  @details This must be called once per control step while @c state is @c TUNE_RUNNING,
+ *           and its duty cycle output to the motor. Through each cycle, the speed's difference
+ *           from the set point is added to or taken from two sums, following square waves
+ *           with the previous cycle's period which start in phase and a quarter period late.
+ *           Each time the relay switches up, a cycle has ended: its period and both sums are
+ *           added up, and once enough cycles have been added, the gains are worked out.
+ *  @param   measured_speed The measured speed in RPM, in the direction being driven
+ *  @returns The duty cycle to output to the motor
+ */
+int32_t relayTuner::step (int32_t measured_speed)
+{
+    if (state != TUNE_RUNNING)                                                      // If not tuning...
+    {                                                                               //
+        return bias;                                                                //      Then, hold the bias
+    }                                                                               //
+    steps ++;                                                                       //
+    if (steps > timeout_steps || measured_speed > speed_limit)                      // If it is taking too long or going too fast...
+    {                                                                               //
+        state = TUNE_FAILED;                                                        //      Then, stop
+        return bias;                                                                //
+    }                                                                               //
+    if (last_period != 0)                                                           // If the cycle's period can be guessed...
+    {                                                                               //
+        int32_t error = measured_speed - setpoint;                                  //      Then, correlate with the square waves
+        uint32_t phase = steps - last_rise;                                         //
+        cycle_in_phase += (2*phase < last_period) ? error : -error;                 //
+        cycle_quadrature += (4*phase >= last_period && 4*phase < 3*last_period) ? error : -error;
+    }                                                                               //
+    if (relay_high && measured_speed > setpoint + band)                             // If the speed has gone above the band...
+    {                                                                               //
+        relay_high = false;                                                         //      Then, switch down
+    }                                                                               //
+    else if (!relay_high && measured_speed < setpoint - band)                       // Else if it has gone below the band...
+    {                                                                               //
+        relay_high = true;                                                          //      Then, switch up, which ends a cycle
+        if (last_rise != 0 && ++cycles > TUNE_SKIP_CYCLES)                          //      If the cycle has settled...
+        {                                                                           //
+            period_sum += steps - last_rise;                                        //          Then, add up its period
+            in_phase_sum += cycle_in_phase;                                         //          And its correlations
+            quadrature_sum += cycle_quadrature;                                     //
+        }                                                                           //
+        if (last_rise != 0)                                                         //      The next cycle should be as long
+        {                                                                           //
+            last_period = steps - last_rise;                                        //
+        }                                                                           //
+        last_rise = steps;                                                          //      Start the next cycle
+        cycle_in_phase = 0;                                                         //
+        cycle_quadrature = 0;                                                       //
+        if (cycles >= TUNE_SKIP_CYCLES + TUNE_CYCLES)                               //      If enough cycles have been measured...
+        {                                                                           //
+            finish();                                                               //          Then, work out the gains
+            return bias;                                                            //
+        }                                                                           //
+    }                                                                               //
+    return relay_high ? bias + relay : bias - relay;                                // Output the relay
+}
+
+/** @brief   Function that works out the gains from the measured limit cycle.
+ *  @details A sine wave of amplitude @c a adds up to 2a/pi per step against a square wave
+ *           of the same period, times the cosine of the phase between them, so the amplitude
+ *           of the fundamental is pi/2 times the length of the in-phase and quadrature sums,
+ *           per step. The odd harmonics of a triangle-like swing leak into the sums by less
+ *           than 4%. With hysteresis @c e, the relay switches when the sine wave is at @c e
+ *           rather than zero, so the amplitude used is sqrt(a^2 - e^2). The integral and
+ *           derivative times from the rule are turned into gains with @c ki = @c kp / @c Ti
+ *           and @c kd = @c kp * @c Td.
+ */
+void relayTuner::finish (void)
+{
+    float amplitude = 0;                                                            // Amplitude of the fundamental [RPM]
+    if (period_sum > 0)                                                             //
+    {                                                                               //
+        amplitude = PI/2*hypotf((float)in_phase_sum, (float)quadrature_sum)/period_sum;
+    }                                                                               //
+    if (amplitude > band)                                                           // Take the hysteresis out of it
+    {                                                                               //
+        amplitude = sqrtf(amplitude*amplitude - (float)band*band);                  //
+    }                                                                               //
+    if (amplitude <= 0)                                                             // If the speed didn't swing at all...
+    {                                                                               //
+        state = TUNE_FAILED;                                                        //      Then, there is nothing to go on
+        return;                                                                     //
+    }                                                                               //
+    ku = 4.0f*relay/(PI*amplitude);                                                 // Describing function of a relay
+    tu = period_sum*dt/TUNE_CYCLES;                                                 // Average period [s]
+    float ti, td;                                                                   // Integral and derivative times [s]
+    switch (rule)                                                                   // Apply the tuning rule
+    {                                                                               //
+        case TUNE_TYREUS_LUYBEN:                                                    //
+            kp = ku/2.2f;   ti = 2.2f*tu;  td = tu/6.3f;  break;                    //
+        case TUNE_NO_OVERSHOOT:                                                     //
+            kp = 0.2f*ku;   ti = tu/2;     td = tu/3;     break;                    //
+        case TUNE_PI:                                                               //
+            kp = 0.45f*ku;  ti = tu/1.2f;  td = 0;        break;                    //
+        default:                                                                    //
+            kp = 0.6f*ku;   ti = tu/2;     td = tu/8;     break;                    //
+    }                                                                               //
+    ki = kp/ti;                                                                     //
+    kd = kp*td;                                                                     //
+    state = TUNE_DONE;                                                              //
+}
+
+/** @brief   Function that prints the state of the tuner and what it found.
+ *  @param   printer Reference to the serial device on which to print
+ */
+void relayTuner::print (Print& printer)
+{
+    const char* names[] = {"idle", "running", "done", "failed"};                    // Names of the states
+    printer << "Auto-tune " << names[state & 3] << ", rule " << rule << endl;       //
+    if (state == TUNE_DONE)                                                         // If gains were found...
+    {                                                                               //
+        printer << "Ku " << ku << " Tu " << tu << " s" << endl;                     //      Then, show them
+        printer << "Kp " << kp << " Ki " << ki << " Kd " << kd << endl;             //
+    }                                                                               //
+}
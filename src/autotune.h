@@ -0,0 +1,88 @@
+/** @file autotune.h
+ *    This file contains the class definition for a relay-feedback auto-tuner which
+ *    finds PID gains for the spindle speed loop.
+ *  @date 2026-Oct-16
+ */
+
+#ifndef AUTOTUNE_H
+#define AUTOTUNE_H
+#include <Arduino.h>
+#include <PrintStream.h>
+#if (defined STM32L4xx || defined STM32F4xx)
+    #include <STM32FreeRTOS.h>
+#endif
+
+#define TUNE_ZIEGLER_NICHOLS 0                  // Classic Ziegler-Nichols PID rule; quick, with some overshoot
+#define TUNE_TYREUS_LUYBEN   1                  // Tyreus-Luyben PID rule; slower, more damped
+#define TUNE_NO_OVERSHOOT    2                  // Ziegler-Nichols "no overshoot" PID rule
+#define TUNE_PI              3                  // Ziegler-Nichols PI rule, no derivative
+
+#define TUNE_IDLE            0                  // Not tuning
+#define TUNE_RUNNING         1                  // Relay is running
+#define TUNE_DONE            2                  // Gains have been found
+#define TUNE_FAILED          3                  // Tuning was stopped before gains were found
+
+#define TUNE_SKIP_CYCLES     2                  // Limit cycles to let settle before measuring
+#define TUNE_CYCLES          4                  // Limit cycles to average
+#define TUNE_TIMEOUT_US      30000000           // Longest time tuning may take
+
+/** @brief   Defines the class for a relay-feedback auto-tuner.
+ *  @details In place of the PID controller, the tuner switches the duty cycle between
+ *           @c bias + @c relay and @c bias - @c relay, switching up whenever the speed falls
+ *           below the set point and down whenever it rises above it, with a small band of
+ *           hysteresis so that noise doesn't make it chatter. The motor settles into a limit
+ *           cycle around the set point. Its period is the ultimate period @c tu, where the
+ *           loop has 180 degrees of lag, and the amplitude @c a of its fundamental gives the
+ *           ultimate gain from the describing function of a relay, @c ku = 4*relay/(pi*a),
+ *           corrected for the hysteresis band. A tuning rule then turns @c ku and @c tu into
+ *           PID gains.
+ *
+ *           The relay keeps the duty cycle within a fixed band around the bias, so the motor
+ *           never sees more than that, and tuning is stopped if the speed goes above
+ *           @c speed_limit or it takes longer than @c TUNE_TIMEOUT_US. The first
+ *           @c TUNE_SKIP_CYCLES cycles are ignored while the cycle settles, and the next
+ *           @c TUNE_CYCLES are averaged. The speed's swing is closer to a triangle than a
+ *           sine wave, so its peaks would overstate the fundamental; instead the fundamental
+ *           is picked out by adding up the speed's difference from the set point against
+ *           square waves in phase and in quadrature with the previous cycle. Periods are
+ *           counted in calls to @c step(), so nothing but the final gain calculation uses
+ *           floats.
+ */
+class relayTuner {
+    protected:
+        float dt;                                                   // The period in seconds
+        uint32_t timeout_steps;                                     // TUNE_TIMEOUT_US in control steps
+        int32_t setpoint;                                           // Speed the relay switches around [RPM]
+        int32_t bias;                                               // Duty cycle in the middle of the relay
+        int32_t relay;                                              // Duty cycle added and taken away by the relay
+        int32_t band;                                               // Hysteresis on each side of the set point [RPM]
+        int32_t speed_limit;                                        // Speed which stops tuning [RPM]
+        int32_t duty_max;                                           // Largest duty cycle allowed
+        bool relay_high;                                            // True if the relay is switched up
+        uint32_t steps;                                             // Control steps since tuning started
+        uint32_t last_rise;                                         // Step when the relay last switched up
+        uint32_t last_period;                                       // Period of the previous cycle, in steps
+        int64_t cycle_in_phase;                                     // Speed error against the in-phase square wave this cycle
+        int64_t cycle_quadrature;                                   // Speed error against the quadrature square wave this cycle
+        uint8_t cycles;                                             // Complete cycles so far
+        uint32_t period_sum;                                        // Sum of the measured periods, in steps
+        int64_t in_phase_sum;                                       // Sum of the measured in-phase sums
+        int64_t quadrature_sum;                                     // Sum of the measured quadrature sums
+        void finish (void);                                         // Function format for working out the gains
+    public:
+        uint8_t state;                                              // TUNE_IDLE, TUNE_RUNNING, TUNE_DONE or TUNE_FAILED
+        uint8_t rule;                                               // Tuning rule used to find the gains
+        float ku;                                                   // Ultimate gain [duty/RPM]
+        float tu;                                                   // Ultimate period [s]
+        float kp;                                                   // Proportional gain found [duty/RPM]
+        float ki;                                                   // Integral gain found [duty/(RPM*s)]
+        float kd;                                                   // Derivative gain found [duty*s/RPM]
+        relayTuner (uint32_t update_period_us);                     // Format for instantiating an auto-tuner object
+        void start (int32_t speed_setpoint, int32_t bias_duty, int32_t relay_duty, // Function format for starting to tune
+                    int32_t hysteresis, int32_t maximum_duty);      //
+        int32_t step (int32_t measured_speed);                      // Function format for running one step of the relay
+        void abort (void);                                          // Function format for stopping tuning
+        void print (Print& printer);                                // Function format for printing the results
+};
+
+#endif // AUTOTUNE_H
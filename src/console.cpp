@@ -0,0 +1,234 @@
+/** @file console.cpp
+ *    This file contains the task which reads setup commands from the serial port,
+ *    such as starting the encoder disc calibration. Commands start with '$' and end
+ *    with a carriage return or line feed.
+ *
+ *  @date 2026-Oct-16
+ */
+
+#include "console.h"                                                    // Include corresponding header file
+#include "userInterface.h"                                              // Include user interface files for the task period
+#include "taskshare.h"                                                  // Include task sharing library
+#include "disccalibration.h"                                            // Include encoder disc calibration table
+#include "controltimer.h"                                               // Include control loop timer library
+#include "feedforward.h"                                                // Include feed-forward table library
+#include "autotune.h"                                                   // Include relay auto-tuner library
+#include "gainschedule.h"                                               // Include gain schedule library
+#include "triacdriver.h"                                                // Include phase-angle triac driver library
+#include "pwminput.h"                                                   // Include PWM spindle speed input library
+#include "analoginput.h"                                                // Include 0-10 V spindle speed input library
+#include "modbus.h"                                                     // Include Modbus RTU slave library
+#include "gcode.h"                                                      // Include G-code spindle command parser
+#include "timingprobe.h"                                                // Include timing probe library
+
+extern Share <bool> discCalibrate;                                      // Points to Share created by motor control tasks
+extern discCalibration myDiscCalibration;                               // Points to the table used by the motor task
+extern motorEncoder myMotorEncoder;                                     // Points to the encoder decoded by the motor task
+extern controlTimer myControlTimer;                                     // Points to the timer which runs the control loop
+extern Share <bool> feedForwardSweep;                                   // Points to Share created by motor control tasks
+extern feedForward myFeedForward;                                       // Points to the table used by the motor task
+extern Share <bool> autotuneStart;                                      // Points to Share created by motor control tasks
+extern relayTuner mySpeedTuner;                                         // Points to the auto-tuner used by the motor task
+extern gainSchedule myGainSchedule;                                     // Points to the gain schedule used by the motor task
+extern triacDriver* mainsDriver;                                        // Points to the triac driver, if the motor is on the mains
+extern pwmInput mySpindleInput;                                         // Points to the PWM speed input used by the motor task
+extern analogInput myAnalogInput;                                       // Points to the 0-10 V speed input used by the motor task
+extern modbusSlave myModbusSlave;                                       // Points to the Modbus slave run by the Modbus task
+extern Share <int> speed_SP;                                            // Points to Share created by user interface tasks
+extern Share <int> maxMotorSpeed;                                       // Points to Share created by user interface tasks
+extern Share <bool> spindleReverse;                                     // Points to Share created by motor control tasks
+
+gcodeParser myGcodeParser;                                              // Spindle commands in G-code on the serial port
+
+/** @brief   Function that carries out one command line.
+ *  @details Commands which change something in the motor task are passed to it through
+ *           shares, so that nothing it is using changes under it while it runs. The gain
+ *           schedule is the exception: it keeps two copies of its table, so a point can be
+ *           set from here directly. A point is set with @c "$GS rpm kp ki kd".
+ *  @param   line    The command, without its line ending
+ *  @param   printer Reference to the serial device on which to reply
+ */
+void console_command (const char* line, Print& printer)
+{
+    if (strcmp(line, "$CAL") == 0)                                              // If asked to calibrate the disc...
+    {                                                                           //
+        discCalibrate.put(true);                                                //      Then, ask the motor task to start learning
+        printer << "Learning disc calibration; hold a steady speed" << endl;    //
+    }                                                                           //
+    else if (strcmp(line, "$CAL?") == 0)                                        // Else if asked about the calibration...
+    {                                                                           //
+        myDiscCalibration.print(printer);                                       //      Then, print the table
+    }                                                                           //
+    else if (strcmp(line, "$ENC?") == 0)                                        // Else if asked about the motor encoder...
+    {                                                                           //
+        myMotorEncoder.print(printer);                                          //      Then, print its position and errors
+    }                                                                           //
+    else if (strcmp(line, "$FF") == 0)                                          // Else if asked to sweep the feed-forward table...
+    {                                                                           //
+        feedForwardSweep.put(true);                                             //      Then, ask the motor task to start the sweep
+        printer << "Sweeping duty cycle up to full; spindle must be free" << endl; //
+    }                                                                           //
+    else if (strcmp(line, "$FF?") == 0)                                         // Else if asked about the feed-forward table...
+    {                                                                           //
+        myFeedForward.print(printer);                                           //      Then, print it
+    }                                                                           //
+    else if (strcmp(line, "$TUNE") == 0)                                        // Else if asked to auto-tune...
+    {                                                                           //
+        autotuneStart.put(true);                                                //      Then, ask the motor task to start the relay
+        printer << "Auto-tuning at the current set point" << endl;              //
+    }                                                                           //
+    else if (strcmp(line, "$TUNE?") == 0)                                       // Else if asked about the auto-tuner...
+    {                                                                           //
+        mySpeedTuner.print(printer);                                            //      Then, print what it found
+    }                                                                           //
+    else if (strncmp(line, "$TUNE=", 6) == 0)                                   // Else if asked to choose a tuning rule...
+    {                                                                           //
+        mySpeedTuner.rule = constrain(atoi(line + 6), TUNE_ZIEGLER_NICHOLS, TUNE_PI); //  Then, use it for the next tune
+        printer << "Tuning rule " << mySpeedTuner.rule << endl;                 //
+    }                                                                           //
+    else if (strncmp(line, "$GS ", 4) == 0)                                     // Else if asked to set a gain schedule point...
+    {                                                                           //
+        char* next;                                                             //      Then, read the speed and gains
+        int32_t rpm = strtol(line + 4, &next, 10);                              //
+        float kp = strtof(next, &next);                                         //
+        float ki = strtof(next, &next);                                         //
+        float kd = strtof(next, &next);                                         //
+        if (myGainSchedule.set_point(rpm, kp, ki, kd))                          //      If there was room for it...
+        {                                                                       //
+            myGainSchedule.print(printer);                                      //          Then, show the new schedule
+        }                                                                       //
+        else                                                                    //      Otherwise...
+        {                                                                       //
+            printer << "Gain schedule full or bad speed" << endl;               //          Say so
+        }                                                                       //
+    }                                                                           //
+    else if (strcmp(line, "$GS?") == 0)                                         // Else if asked about the gain schedule...
+    {                                                                           //
+        myGainSchedule.print(printer);                                          //      Then, print it
+    }                                                                           //
+    else if (strcmp(line, "$GS0") == 0)                                         // Else if asked to clear the gain schedule...
+    {                                                                           //
+        myGainSchedule.clear();                                                 //      Then, go back to fixed gains
+        printer << "Gain schedule cleared" << endl;                             //
+    }                                                                           //
+    else if (strcmp(line, "$AC?") == 0)                                         // Else if asked about the mains...
+    {                                                                           //
+        if (mainsDriver)                                                        //      Then, if driving a triac...
+        {                                                                       //
+            mainsDriver->pll.print(printer);                                    //          Print the phase-locked loop
+            printer << (mainsDriver->mode == TRIAC_BURST ? "Burst" : "Phase-angle") << " firing" << endl; //
+        }                                                                       //
+        else                                                                    //      Otherwise...
+        {                                                                       //
+            printer << "Not driving from the mains" << endl;                    //          Say so
+        }                                                                       //
+    }                                                                           //
+    else if (strncmp(line, "$AC=", 4) == 0 && mainsDriver)                      // Else if asked to choose how to fire the triac...
+    {                                                                           //
+        mainsDriver->set_mode(atoi(line + 4) ? TRIAC_BURST : TRIAC_PHASE_ANGLE); //     Then, 1 for burst, 0 for phase-angle
+        printer << (mainsDriver->mode == TRIAC_BURST ? "Burst" : "Phase-angle") << " firing" << endl; //
+    }                                                                           //
+    else if (strcmp(line, "$PWM?") == 0)                                        // Else if asked about the PWM speed input...
+    {                                                                           //
+        mySpindleInput.print(printer);                                          //      Then, print the signal and curve
+    }                                                                           //
+    else if (strcmp(line, "$ADC?") == 0)                                        // Else if asked about the 0-10 V speed input...
+    {                                                                           //
+        myAnalogInput.print(printer);                                           //      Then, print the voltage and speed
+    }                                                                           //
+    else if (strcmp(line, "$MB?") == 0)                                         // Else if asked about the Modbus slave...
+    {                                                                           //
+        myModbusSlave.print(printer);                                           //      Then, print its statistics
+    }                                                                           //
+    else if (strcmp(line, "$G?") == 0)                                          // Else if asked about the G-code spindle commands...
+    {                                                                           //
+        myGcodeParser.print(printer);                                           //      Then, print the spindle state
+    }                                                                           //
+    else if (strcmp(line, "$JIT") == 0)                                         // Else if asked about the control loop timing...
+    {                                                                           //
+        myControlTimer.print(printer);                                          //      Then, print the jitter histogram
+    }                                                                           //
+    else if (strcmp(line, "$JIT0") == 0)                                        // Else if asked to start timing over...
+    {                                                                           //
+        myControlTimer.clear();                                                 //      Then, clear the histogram
+    }                                                                           //
+    else if (strcmp(line, "$PROBE") == 0)                                       // Else if asked about the timing probes...
+    {                                                                           //
+        print_all_probes(printer);                                              //      Then, print every probe
+    }                                                                           //
+    else if (strcmp(line, "$PROBE0") == 0)                                      // Else if asked to start probing over...
+    {                                                                           //
+        clear_all_probes();                                                     //      Then, clear every probe
+    }                                                                           //
+    else                                                                        // Otherwise...
+    {                                                                           //
+        printer << "Unknown command: " << line << endl;                         //      Say so
+    }                                                                           //
+}
+
+/** @brief   Task which reads commands from the serial port.
+ *  @details This task never waits for the serial port. Each time it runs, it takes
+ *           whatever characters have arrived and adds them to the line being read, and
+ *           when a line ending arrives, the line is carried out. Lines which don't start
+ *           with '$' are ignored, and characters past @c CONSOLE_LINE_LENGTH are dropped.
+ *           Every character also goes through the G-code parser, so a controller which
+ *           streams its G-code here sets the spindle speed and direction with M3, M4, M5
+ *           and S. The receive buffer is made big enough in @c platformio.ini to hold what
+ *           arrives at 115200 baud between runs of this task.
+ *           It also saves a newly learned disc calibration, feed-forward table or gain
+ *           schedule, since writing the flash stalls the processor and shouldn't be done by
+ *           the motor task.
+ *  @param   p_params A pointer to function parameters which we don't use.
+ */
+void task_Console (void* p_params)
+{
+    (void)p_params;                                                             // Does nothing but shut up a compiler warning
+    char line[CONSOLE_LINE_LENGTH + 1];                                         // Create the line being read
+    uint8_t length = 0;                                                         // Characters in the line so far
+    for (;;)
+    {
+        while (Serial.available())                                              // While there are characters waiting...
+        {                                                                       //
+            char character = Serial.read();                                     //      Take the next one
+            if (myGcodeParser.feed(character))                                  //      If it ends a G-code spindle command...
+            {                                                                   //
+                int maximum;                                                    //          Then, pass it on, up to the top speed
+                maxMotorSpeed.get(maximum);                                     //
+                int setpoint = min(myGcodeParser.setpoint(), (int32_t)maximum); //
+                portENTER_CRITICAL();                                           //          Put the speed and direction together
+                speed_SP.put(setpoint);                                         //
+                spindleReverse.put(myGcodeParser.reverse());                    //
+                portEXIT_CRITICAL();                                            //
+            }                                                                   //
+            if (character == '\r' || character == '\n')                         //      If it ends the line...
+            {                                                                   //
+                line[length] = '\0';                                            //          Then, finish the string
+                if (line[0] == '$')                                             //          If it is a command...
+                {                                                               //
+                    console_command(line, Serial);                              //              Then, carry it out
+                }                                                               //
+                length = 0;                                                     //          Start the next line
+            }                                                                   //
+            else if (length < CONSOLE_LINE_LENGTH)                              //      Else if there is room for it...
+            {                                                                   //
+                line[length++] = character;                                     //          Add it to the line
+            }                                                                   //
+        }                                                                       //
+        if (myDiscCalibration.needs_saving)                                     // If a new table has been learned...
+        {                                                                       //
+            myDiscCalibration.save();                                           //      Then, save it
+            Serial << "Disc calibration saved" << endl;                         //
+        }                                                                       //
+        if (myFeedForward.needs_saving)                                         // If a new feed-forward table has been built...
+        {                                                                       //
+            myFeedForward.save();                                               //      Then, save it
+            Serial << "Feed-forward table saved" << endl;                       //
+        }                                                                       //
+        if (myGainSchedule.needs_saving)                                        // If the gain schedule has changed...
+        {                                                                       //
+            myGainSchedule.save();                                              //      Then, save it
+            Serial << "Gain schedule saved" << endl;                            //
+        }                                                                       //
+        vTaskDelay(update_period);                                              // Check again after one task period
+    }
+}
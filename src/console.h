@@ -0,0 +1,19 @@
+/** @file console.h
+ *    This file contains the task which reads setup commands from the serial port.
+ *  @date 2026-Oct-16
+ */
+
+#ifndef CONSOLE_H
+#define CONSOLE_H
+#include <Arduino.h>
+#include <PrintStream.h>
+#if (defined STM32L4xx || defined STM32F4xx)
+    #include <STM32FreeRTOS.h>
+#endif
+
+#define CONSOLE_LINE_LENGTH 64                  // Longest command line that can be read
+
+/// Task functions
+void task_Console (void* params);                                           // The serial console task function
+
+#endif // CONSOLE_H
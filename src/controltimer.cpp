@@ -0,0 +1,109 @@
+/** @file controltimer.cpp
+ *    This file contains the implementation of the control loop timer.
+ *
+ *  @date 2026-Oct-16
+ */
+
+#include "controltimer.h"                                               // Include corresponding header file
+
+/** @brief   Function called to instantiate a control timer object.
+ *  @details This function saves the timer and rate. The hardware timer itself is not
+ *           touched until @c begin() is called from a task, because the timer library
+ *           should not be used before the scheduler starts.
+ *  @param   timer_instance The timer peripheral to use, such as @c TIM7, which nothing
+ *           else may be using
+ *  @param   frequency      How many times per second to run the control loop
+ */
+controlTimer::controlTimer (TIM_TypeDef* timer_instance, uint32_t frequency)
+{
+    instance = timer_instance;                  // Save the parameter, which will evaporate when the constructor exits
+    rate = frequency;                           // Save the parameter, which will evaporate when the constructor exits
+    timer = NULL;                               // Created in begin()
+    clear();                                    // No statistics yet
+}
+
+/** @brief   Function that starts the CPU cycle counter and the timer.
+ *  @details The cycle counter in the debug unit is switched on so that jitter can be
+ *           measured to the nearest cycle. After this, @c callback is run from the timer's
+ *           update interrupt once per period. It must not block or call FreeRTOS functions
+ *           which aren't meant for ISRs.
+ *  @param   callback The control loop step to run
+ */
+void controlTimer::begin (callback_function_t callback)
+{
+    step = callback;                                                                        // Save the parameter, which will evaporate when the function exits
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;                                         // Turn on the debug unit
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;                                                    // Start the cycle counter
+    nominal_cycles = SystemCoreClock/rate;                                                  // Cycles in one period
+    timer = new HardwareTimer(instance);                                                    // Create the timer object
+    timer->setOverflow(rate, HERTZ_FORMAT);                                                 // Overflow once per period
+    timer->attachInterrupt(std::bind(&controlTimer::tick, this));                           // Run a step at each overflow
+    timer->resume();                                                                        // Start counting
+}
+
+/** @brief   Function called by the timer's update interrupt.
+ *  @details The period since the last step is compared with the nominal period and added
+ *           to the histogram, then the step is run and timed. The bin is found with a shift,
+ *           so there is no division in the ISR.
+ */
+void controlTimer::tick (void)
+{
+    uint32_t entry = DWT->CYCCNT;                                                           // Time this step started
+    if (!first)                                                                             // If there is a period to time...
+    {                                                                                       //
+        uint32_t period = entry - last_entry;                                               //      Then, find how far it was from nominal
+        uint32_t jitter = (period > nominal_cycles) ? period - nominal_cycles               //
+                                                    : nominal_cycles - period;              //
+        uint32_t bin = jitter >> CONTROL_JITTER_SHIFT;                                      //      Find its bin
+        histogram[bin < CONTROL_JITTER_BINS ? bin : CONTROL_JITTER_BINS - 1] ++;            //      The last bin takes everything larger
+        samples ++;                                                                         //
+        if (jitter > max_jitter) { max_jitter = jitter; }                                   //
+    }                                                                                       //
+    first = false;                                                                          //
+    last_entry = entry;                                                                     //
+    step();                                                                                 // Run the control loop
+    uint32_t busy = DWT->CYCCNT - entry;                                                    // Time the step took
+    if (busy > max_busy) { max_busy = busy; }                                               //
+}
+
+/** @brief   Function that returns the period of the control loop.
+ *  @returns The period in microseconds
+ */
+uint32_t controlTimer::period_us (void)
+{
+    return 1000000/rate;
+}
+
+/** @brief   Function that clears the jitter histogram and the maximums.
+ *  @details The next step only starts a period, so a partly timed period isn't counted.
+ */
+void controlTimer::clear (void)
+{
+    for (uint8_t i = 0; i < CONTROL_JITTER_BINS; i++)                                       // Empty every bin
+    {                                                                                       //
+        histogram[i] = 0;                                                                   //
+    }                                                                                       //
+    samples = 0;                                                                            // Initialize to 0
+    max_jitter = 0;                                                                         // Initialize to 0
+    max_busy = 0;                                                                           // Initialize to 0
+    first = true;                                                                           // Start timing from the next step
+}
+
+/** @brief   Function that prints the jitter histogram and the maximums.
+ *  @details Cycle counts are converted to nanoseconds for printing. Each bin is labelled
+ *           with the smallest jitter it holds.
+ *  @param   printer Reference to the serial device on which to print
+ */
+void controlTimer::print (Print& printer)
+{
+    uint32_t mhz = SystemCoreClock/1000000;                                                 // Cycles per microsecond
+    printer << "Control loop " << rate << " Hz, " << samples << " periods" << endl;         //
+    printer << "Max jitter " << max_jitter*1000/mhz << " ns, max step "                     //
+            << max_busy*1000/mhz << " ns of " << period_us()*1000 << " ns" << endl;         //
+    for (uint8_t i = 0; i < CONTROL_JITTER_BINS; i++)                                       // Print each bin
+    {                                                                                       //
+        printer << ((i == CONTROL_JITTER_BINS - 1) ? ">=" : "  ")                           //
+                << ((uint32_t)i << CONTROL_JITTER_SHIFT)*1000/mhz << " ns: "                //
+                << histogram[i] << endl;                                                    //
+    }                                                                                       //
+}
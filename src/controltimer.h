@@ -0,0 +1,52 @@
+/** @file controltimer.h
+ *    This file contains the class definition for a hardware timer which runs the
+ *    motor control loop at a fixed rate and records how steady that rate is.
+ *  @date 2026-Oct-16
+ */
+
+#ifndef CONTROLTIMER_H
+#define CONTROLTIMER_H
+#include <Arduino.h>
+#include <PrintStream.h>
+#if (defined STM32L4xx || defined STM32F4xx)
+    #include <STM32FreeRTOS.h>
+#endif
+
+#define CONTROL_JITTER_BINS  16                 // Number of bins in the jitter histogram
+#define CONTROL_JITTER_SHIFT 4                  // Each bin is 2^CONTROL_JITTER_SHIFT CPU cycles wide
+
+/** @brief   Defines the class for a control loop timer.
+ *  @details Running the control loop from a task ties its rate to the RTOS tick, and lets
+ *           other tasks and the scheduler delay it by varying amounts. This class runs it from
+ *           the update interrupt of a hardware timer instead, so every step is started by the
+ *           timer hardware at an exact period, at any rate the timer can be set to.
+ *
+ *           To show that the period really is steady, the ISR reads the CPU cycle counter each
+ *           time it starts. The difference from the nominal period, in either direction, is
+ *           added to a histogram with bins @c 2^CONTROL_JITTER_SHIFT cycles wide, and the last
+ *           bin also counts anything larger. The largest jitter and the longest time spent in
+ *           a step are kept too, so it is easy to see how much of the period is left over.
+ */
+class controlTimer {
+    protected:
+        TIM_TypeDef* instance;                                      // Timer peripheral to use
+        uint32_t rate;                                              // Steps per second
+        HardwareTimer* timer;                                       // Timer object, created in begin()
+        callback_function_t step;                                   // Function run by each interrupt
+        uint32_t nominal_cycles;                                    // CPU cycles in one period
+        uint32_t last_entry;                                        // Cycle count when the last step started
+        bool first;                                                 // If no step has been timed yet
+        void tick (void);                                           // Function called by the update interrupt
+    public:
+        volatile uint32_t histogram[CONTROL_JITTER_BINS];           // Count of steps in each jitter bin
+        volatile uint32_t samples;                                  // Number of periods timed
+        volatile uint32_t max_jitter;                               // Largest jitter seen, in CPU cycles
+        volatile uint32_t max_busy;                                 // Longest step, in CPU cycles
+        controlTimer (TIM_TypeDef* timer_instance, uint32_t frequency); // Format for instantiating a control timer object
+        void begin (callback_function_t callback);                  // Function format for starting the timer
+        uint32_t period_us (void);                                  // Function format for getting the period
+        void clear (void);                                          // Function format for clearing the statistics
+        void print (Print& printer);                                // Function format for printing the statistics
+};
+
+#endif // CONTROLTIMER_H
@@ -0,0 +1,329 @@
+/** @file disccalibration.cpp
+ *    This file contains the implementation of the encoder disc calibration table.
+ *
+ *  @date 2026-Oct-16
+ */
+
+#include <EEPROM.h>                                                     // Include emulated EEPROM library
+#include "disccalibration.h"                                            // Include corresponding header file
+
+/** @brief   Function called to instantiate a disc calibration object.
+ *  @details The object starts with no table, so periods are passed through uncorrected
+ *           until a table is learned or loaded.
+ *  @param   counts_per_revolution How many encoder counts the motor makes per revolution,
+ *           up to @c DISC_MAX_COUNTS
+ */
+discCalibration::discCalibration (uint8_t counts_per_revolution)
+{
+    counts = min(counts_per_revolution, (uint8_t)DISC_MAX_COUNTS);  // Save the parameter, which will evaporate when the constructor exits
+    if (counts == 0) { counts = 1; }                                //
+    offset = 0;                                                     // Initialize to 0
+    for (uint8_t i = 0; i < DISC_MAX_COUNTS; i++)                   // Start with every slot nominal
+    {                                                               //
+        gain[i] = 65536;                                            //      1.0 in Q16
+    }                                                               //
+    direction = 0;                                                  // Not learned in either direction yet
+    state = DISC_OFF;                                               // No table yet
+    needs_saving = false;                                           // Nothing to save
+    restart();                                                      // Nothing collected yet
+}
+
+/** @brief   Function that clears everything collected so far.
+ */
+void discCalibration::restart (void)
+{
+    for (uint8_t i = 0; i < DISC_MAX_COUNTS; i++)                   // Clear the totals
+    {                                                               //
+        total[i] = 0;                                               //
+    }                                                               //
+    previous_revolution = 0;                                        // No revolution to compare with
+    collected = 0;                                                  // Initialize to 0
+    kept = 0;                                                       // Initialize to 0
+}
+
+/** @brief   Function that starts learning a new table.
+ *  @details The motor should be held at a steady speed, in the direction the table will be
+ *           used in, until @c state becomes @c DISC_READY. Until then, periods are passed
+ *           through uncorrected.
+ */
+void discCalibration::learn (void)
+{
+    restart();                                                      // Start the totals over
+    direction = 0;                                                  // The first edge sets the direction
+    state = DISC_LEARNING;                                          //
+}
+
+/** @brief   Function that aligns the table again after the count jumped.
+ *  @details Once edges have been missed, the count no longer lines up with the disc the way
+ *           it did when the offset was found, so the table is aligned again before it is used.
+ *           A table being learned has collected periods against the old count, so it is
+ *           started over. The motor task calls this when the encoder ring dropped edges;
+ *           @c correct() calls it for an edge which didn't move the count by exactly one.
+ */
+void discCalibration::realign (void)
+{
+    if (state == DISC_OFF)                                          // If there is no table...
+    {                                                               //
+        return;                                                     //      Then, there is nothing to line up
+    }                                                               //
+    restart();                                                      // Drop what was collected against the old count
+    if (state == DISC_READY)                                        // If the table was in use...
+    {                                                               //
+        state = DISC_ALIGNING;                                      //      Then, find its offset again
+    }                                                               //
+}
+
+/** @brief   Function that finds which slot of the disc a count lies in.
+ *  @details The period ending at an edge is the time the encoder spent at the count before
+ *           it, so that count names the piece of disc which was timed.
+ *  @param   position The encoder count before the edge
+ *  @returns The slot, from 0 to @c counts-1
+ */
+uint8_t discCalibration::slot (int32_t position)
+{
+    int32_t index = position % counts;                              // Wrap it into one revolution
+    if (index < 0) { index += counts; }                             // Keep negative counts in range too
+    return index;
+}
+
+/** @brief   Function that corrects the period of one encoder edge.
+ *  @details This is called for every edge, so when the table is ready it is only a lookup
+ *           and a multiply. While learning or aligning, the period is also collected. An edge
+ *           which didn't move the count by exactly one can't be matched to a slot, so it is
+ *           passed through, and the table is aligned again. Edges in the other direction
+ *           from the table are passed through too.
+ *  @param   period The time since the previous edge, in ticks
+ *  @param   from   The encoder count before the edge
+ *  @param   to     The encoder count after the edge
+ *  @returns The period the edge would have had if the slots were even, in ticks
+ */
+uint32_t discCalibration::correct (uint32_t period, int32_t from, int32_t to)
+{
+    int32_t step = to - from;                                                       // Counts moved by this edge
+    if (step != 1 && step != -1)                                                    // If the count jumped or stood still...
+    {                                                                               //
+        realign();                                                                  //      Then, it may not line up with the disc any more
+        return period;                                                              //
+    }                                                                               //
+    if (state == DISC_OFF)                                                          // If there is no table...
+    {                                                                               //
+        return period;                                                              //      Then, pass the period through
+    }                                                                               //
+    if (step != direction)                                                          // If turning the other way from the table...
+    {                                                                               //
+        if (state != DISC_LEARNING)                                                 //      If the table is already learned...
+        {                                                                           //
+            collected = 0;                                                          //          Then, it doesn't fit these slots
+            return period;                                                          //
+        }                                                                           //
+        restart();                                                                  //      Otherwise, learn the new direction instead
+        direction = step;                                                           //
+    }                                                                               //
+    uint8_t index = slot(from);                                                     // Find the slot this edge timed
+    if (state == DISC_LEARNING || state == DISC_ALIGNING)                           // If collecting periods...
+    {                                                                               //
+        collect(period, index);                                                     //      Collect the period
+        return period;                                                              //      The table isn't ready yet
+    }                                                                               //
+    index += offset;                                                                // Line the table up with the count
+    if (index >= counts) { index -= counts; }                                       //
+    return ((uint64_t)period*gain[index]) >> 16;                                    // Scale by the slot's gain
+}
+
+/** @brief   Function that collects one period and adds up steady revolutions.
+ *  @details Consecutive edges in one direction visit every slot once per revolution, so once
+ *           @c counts of them have been collected, a whole revolution is in @c revolution[].
+ *           It is added to the totals only if its time is within 1/2^DISC_STEADY_SHIFT of the
+ *           previous revolution.
+ *  @param   period The time since the previous edge, in ticks
+ *  @param   index  The slot the edge crossed
+ */
+void discCalibration::collect (uint32_t period, uint8_t index)
+{
+    revolution[index] = period;                                                     // Save the period of this slot
+    if (++collected < counts)                                                       // If the revolution isn't complete...
+    {                                                                               //
+        return;                                                                     //      Then, wait for more edges
+    }                                                                               //
+    collected = 0;                                                                  // Start the next revolution
+    uint64_t sum = 0;                                                               // Add up the revolution's time
+    for (uint8_t i = 0; i < counts; i++)                                            //
+    {                                                                               //
+        sum += revolution[i];                                                       //
+    }                                                                               //
+    uint32_t this_revolution = min(sum, (uint64_t)UINT32_MAX);                      //
+    uint32_t change = (this_revolution > previous_revolution)                       // How much it differs from the last one
+                    ? this_revolution - previous_revolution                         //
+                    : previous_revolution - this_revolution;                        //
+    bool steady = previous_revolution                                               // Steady if it is close to the last one
+               && change <= (previous_revolution >> DISC_STEADY_SHIFT);             //
+    previous_revolution = this_revolution;                                          //
+    if (!steady)                                                                    // If the speed was changing...
+    {                                                                               //
+        return;                                                                     //      Then, don't use this revolution
+    }                                                                               //
+    for (uint8_t i = 0; i < counts; i++)                                            // Add it to the totals
+    {                                                                               //
+        total[i] += revolution[i];                                                  //
+    }                                                                               //
+    kept ++;                                                                        //
+    if (state == DISC_LEARNING && kept >= DISC_LEARN_REVS)                          // If enough revolutions have been learned...
+    {                                                                               //
+        finish_learning();                                                          //      Then, work out the gains
+    }                                                                               //
+    else if (state == DISC_ALIGNING && kept >= DISC_ALIGN_REVS)                     // Else if enough have been collected to align...
+    {                                                                               //
+        finish_aligning();                                                          //      Then, find the offset
+    }                                                                               //
+}
+
+/** @brief   Function that turns the learned totals into gains.
+ *  @details A slot which took up a fraction @c f of the revolution should have taken
+ *           1/counts of it, so its gain is 1/(counts*f). This is the only division per slot,
+ *           and it happens once, when learning is done. The new table lines up with the
+ *           count as it is now, so it needs no offset, and it is marked to be saved.
+ */
+void discCalibration::finish_learning (void)
+{
+    uint64_t sum = 0;                                                               // Add up all of the kept revolutions
+    for (uint8_t i = 0; i < counts; i++)                                            //
+    {                                                                               //
+        sum += total[i];                                                            //
+    }                                                                               //
+    for (uint8_t i = 0; i < counts; i++)                                            // Work out each slot's gain
+    {                                                                               //
+        gain[i] = total[i] ? (sum << 16)/(counts*total[i]) : 65536;                 //      Q16; a slot with no time is left nominal
+    }                                                                               //
+    offset = 0;                                                                     // Lined up with the count already
+    state = DISC_READY;                                                             //
+    needs_saving = true;                                                            //
+}
+
+/** @brief   Function that finds which offset lines the table up with the count.
+ *  @details Each possible offset is tried, and the one whose corrected periods differ least
+ *           in total from the average period is kept. This takes counts^2 multiplies, once.
+ */
+void discCalibration::finish_aligning (void)
+{
+    uint64_t sum = 0;                                                               // Add up all of the kept revolutions
+    for (uint8_t i = 0; i < counts; i++)                                            //
+    {                                                                               //
+        sum += total[i];                                                            //
+    }                                                                               //
+    uint64_t average = sum/counts;                                                  // What every corrected slot should be
+    uint64_t best_error = UINT64_MAX;                                               //
+    for (uint8_t trial = 0; trial < counts; trial++)                                // Try each offset
+    {                                                                               //
+        uint64_t error = 0;                                                         //
+        for (uint8_t i = 0; i < counts; i++)                                        //      Add up how uneven the corrected slots are
+        {                                                                           //
+            uint8_t index = (i + trial) % counts;                                   //
+            uint64_t corrected = (total[i]*gain[index]) >> 16;                      //
+            error += (corrected > average) ? corrected - average : average - corrected; //
+        }                                                                           //
+        if (error < best_error)                                                     //      Keep the best offset so far
+        {                                                                           //
+            best_error = error;                                                     //
+            offset = trial;                                                         //
+        }                                                                           //
+    }                                                                               //
+    state = DISC_READY;                                                             //
+}
+
+/** @brief   Function that loads a table from the emulated EEPROM.
+ *  @details The stored table is only used if it is marked valid, was learned with the
+ *           same number of counts per revolution, and its checksum matches. It then has to
+ *           be aligned with the count before it is used, in the direction it was learned in.
+ *  @returns True if a table was loaded
+ */
+bool discCalibration::load (void)
+{
+    eeprom_buffer_fill();                                                           // Copy the EEPROM page into RAM
+    uint32_t address = DISC_EEPROM_ADDRESS;                                         //
+    uint16_t magic = eeprom_buffered_read_byte(address++);                          // Read the marker
+    magic |= eeprom_buffered_read_byte(address++) << 8;                             //
+    uint8_t stored_counts = eeprom_buffered_read_byte(address++);                   // Read the resolution it was learned at
+    int8_t stored_direction = eeprom_buffered_read_byte(address++);                 // Read the direction it was learned in
+    uint8_t checksum = eeprom_buffered_read_byte(address++);                        // Read the checksum
+    if (magic != DISC_MAGIC || stored_counts != counts                              // If it isn't a table for this encoder...
+        || (stored_direction != 1 && stored_direction != -1))                       //
+    {                                                                               //
+        return false;                                                               //      Then, don't use it
+    }                                                                               //
+    uint32_t stored[DISC_MAX_COUNTS];                                               // Read the gains
+    uint8_t sum = 0;                                                                //
+    for (uint8_t i = 0; i < counts; i++)                                            //
+    {                                                                               //
+        stored[i] = 0;                                                              //
+        for (uint8_t b = 0; b < 4; b++)                                             //      Least significant byte first
+        {                                                                           //
+            uint8_t data = eeprom_buffered_read_byte(address++);                    //
+            stored[i] |= (uint32_t)data << (8*b);                                   //
+            sum += data;                                                            //
+        }                                                                           //
+    }                                                                               //
+    if (sum != checksum)                                                            // If the gains were corrupted...
+    {                                                                               //
+        return false;                                                               //      Then, don't use them
+    }                                                                               //
+    for (uint8_t i = 0; i < counts; i++)                                            // Use the stored gains
+    {                                                                               //
+        gain[i] = stored[i];                                                        //
+    }                                                                               //
+    direction = stored_direction;                                                   //
+    restart();                                                                      // Collect revolutions to align it
+    state = DISC_ALIGNING;                                                          //
+    return true;
+}
+
+/** @brief   Function that saves the table to the emulated EEPROM.
+ *  @details All of the bytes are written into a copy of the EEPROM page in RAM, and the
+ *           flash page is erased and written once at the end. That stalls the processor for
+ *           several milliseconds, so this should be called from a low priority task, not from
+ *           the motor task.
+ */
+void discCalibration::save (void)
+{
+    needs_saving = false;                                                           // Only save it once
+    uint8_t sum = 0;                                                                // Find the checksum first
+    for (uint8_t i = 0; i < counts; i++)                                            //
+    {                                                                               //
+        for (uint8_t b = 0; b < 4; b++)                                             //
+        {                                                                           //
+            sum += gain[i] >> (8*b);                                                //
+        }                                                                           //
+    }                                                                               //
+    eeprom_buffer_fill();                                                           // Keep whatever else is in the page
+    uint32_t address = DISC_EEPROM_ADDRESS;                                         //
+    eeprom_buffered_write_byte(address++, DISC_MAGIC & 0xFF);                       // Write the marker
+    eeprom_buffered_write_byte(address++, DISC_MAGIC >> 8);                         //
+    eeprom_buffered_write_byte(address++, counts);                                  // Write the resolution
+    eeprom_buffered_write_byte(address++, direction);                               // Write the direction
+    eeprom_buffered_write_byte(address++, sum);                                     // Write the checksum
+    for (uint8_t i = 0; i < counts; i++)                                            // Write the gains
+    {                                                                               //
+        for (uint8_t b = 0; b < 4; b++)                                             //      Least significant byte first
+        {                                                                           //
+            eeprom_buffered_write_byte(address++, gain[i] >> (8*b));                //
+        }                                                                           //
+    }                                                                               //
+    eeprom_buffer_flush();                                                          // Erase and write the flash page once
+}
+
+/** @brief   Function that prints the state of the calibration and its table.
+ *  @param   printer Reference to the serial device on which to print
+ */
+void discCalibration::print (Print& printer)
+{
+    const char* names[] = {"off", "learning", "aligning", "ready"};                 // Names of the states
+    printer << "Disc calibration: " << names[state & 3];                            //
+    if (state == DISC_LEARNING || state == DISC_ALIGNING)                           // If collecting...
+    {                                                                               //
+        printer << " (" << kept << " revolutions)";                                 //      Then, show how far along it is
+    }                                                                               //
+    printer << ", offset " << offset << (direction < 0 ? ", reverse" : ", forward") << endl;                                       //
+    for (uint8_t i = 0; i < counts; i++)                                            // Show each slot's gain in thousandths
+    {                                                                               //
+        printer << i << ": " << ((gain[i]*1000UL + 32768) >> 16) << endl;           //
+    }                                                                               //
+}
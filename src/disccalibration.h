@@ -0,0 +1,84 @@
+/** @file disccalibration.h
+ *    This file contains the class definition for a calibration table which
+ *    corrects for uneven slot spacing on the motor encoder disc.
+ *  @date 2026-Oct-16
+ */
+
+#ifndef DISCCALIBRATION_H
+#define DISCCALIBRATION_H
+#include <Arduino.h>
+#include <PrintStream.h>
+#if (defined STM32L4xx || defined STM32F4xx)
+    #include <STM32FreeRTOS.h>
+#endif
+
+#define DISC_MAX_COUNTS     64                  // Most encoder counts per revolution the table can hold
+#define DISC_LEARN_REVS     64                  // Steady revolutions averaged while learning
+#define DISC_ALIGN_REVS     8                   // Steady revolutions averaged while aligning after a restart
+#define DISC_STEADY_SHIFT   5                   // A revolution is steady if it is within 1/32 of the previous one
+#define DISC_EEPROM_ADDRESS 0                   // Where the table is stored in the emulated EEPROM
+#define DISC_MAGIC          0xD15C              // Marks a valid table in the emulated EEPROM
+
+#define DISC_OFF            0                   // No table; edge periods are not corrected
+#define DISC_LEARNING       1                   // Learning a new table
+#define DISC_ALIGNING       2                   // Have a table, finding which slot is which
+#define DISC_READY          3                   // Correcting edge periods
+
+/** @brief   Defines the class for an encoder disc calibration table.
+ *  @details The slots on a cheap encoder disc are not evenly spaced, so even at a steady
+ *           speed the time between edges goes up and down once per revolution. An M/T window
+ *           which spans whole revolutions averages this out, but a short window of a few edges
+ *           does not, and the error shows up as ripple in the speed. This class learns how wide
+ *           each slot really is and then scales each edge period by the ratio of the nominal
+ *           width to the actual width, which makes short windows as smooth as long ones.
+ *
+ *           The table is learned at a steady speed. Periods are collected one revolution at a
+ *           time; a revolution is only kept if its total time is close to the one before, so
+ *           that speed changes don't look like uneven slots. After @c DISC_LEARN_REVS kept
+ *           revolutions, the gain for each slot is its share of the average revolution time
+ *           divided into the nominal share. Gains are in Q16, so correcting a period is one
+ *           table lookup and one multiply. The table is then saved to the emulated EEPROM.
+ *
+ *           The encoder has no index pulse, so after a restart slot 0 of the table is not
+ *           necessarily slot 0 of the count. A loaded table therefore starts out aligning: a
+ *           few steady revolutions are collected, and the table is rotated to whichever offset
+ *           makes the corrected periods most even. Until then, periods are passed through.
+ *
+ *           The period between two edges is the time the encoder spent at the count before
+ *           the second edge, so each period is filed under that count. The table is only used
+ *           in the direction it was learned in. Counting rising edges of A alone, a reverse
+ *           edge falls at the other side of each slot from a forward one, so the slots it
+ *           times are not the ones in the table, and periods in the other direction are passed
+ *           through. If the count jumps, because edges were dropped or a quadrature transition
+ *           was illegal, it no longer lines up with the disc the way it did, so the table is
+ *           aligned again; a table being learned is started over.
+ */
+class discCalibration {
+    protected:
+        uint8_t counts;                                             // Encoder counts per revolution
+        uint8_t offset;                                             // Table slot lined up with count slot 0
+        uint32_t gain[DISC_MAX_COUNTS];                             // Correction for each slot, Q16
+        uint32_t revolution[DISC_MAX_COUNTS];                       // Periods of the revolution being collected
+        uint64_t total[DISC_MAX_COUNTS];                            // Sum of the periods of each slot over kept revolutions
+        uint32_t previous_revolution;                               // Time of the last complete revolution
+        uint8_t collected;                                          // Consecutive edges in the revolution being collected
+        uint8_t kept;                                               // Steady revolutions added to the totals
+        int8_t direction;                                           // Direction the table is learned and used in, 1 or -1
+        uint8_t slot (int32_t position);                            // Function format for finding the slot of a count
+        void restart (void);                                        // Function format for clearing what has been collected
+        void collect (uint32_t period, uint8_t index);              // Function format for collecting one period
+        void finish_learning (void);                                // Function format for turning the totals into gains
+        void finish_aligning (void);                                // Function format for finding the table offset
+    public:
+        uint8_t state;                                              // DISC_OFF, DISC_LEARNING, DISC_ALIGNING or DISC_READY
+        bool needs_saving;                                          // True if a new table hasn't been saved yet
+        discCalibration (uint8_t counts_per_revolution);            // Format for instantiating a calibration object
+        void learn (void);                                          // Function format for starting to learn a new table
+        void realign (void);                                        // Function format for aligning again after the count jumped
+        uint32_t correct (uint32_t period, int32_t from, int32_t to); // Function format for correcting one edge period
+        bool load (void);                                           // Function format for loading the table from EEPROM
+        void save (void);                                           // Function format for saving the table to EEPROM
+        void print (Print& printer);                                // Function format for printing the table
+};
+
+#endif // DISCCALIBRATION_H
@@ -0,0 +1,79 @@
+/** @file disturbanceobserver.cpp
+ *    This file contains the implementation of the load disturbance observer.
+ *
+ *  @date 2026-Oct-16
+ */
+
+#include "disturbanceobserver.h"                                        // Include corresponding header file
+
+/** @brief   Function called to instantiate a disturbance observer object.
+ *  @details The observer starts with no load, a 5 Hz cutoff and full compensation. The
+ *           inertia starts at zero, so @c set_inertia() should be called before it is used.
+ *  @param   update_period_us Time between calls to @c update(), in microseconds
+ */
+disturbanceObserver::disturbanceObserver (uint32_t update_period_us)
+{
+    dt = update_period_us/1000000.0f;           // Period in seconds
+    inertia_q16 = 0;                            // Initialize to 0
+    set_cutoff(5);                              // Default cutoff [Hz]
+    set_gain(1);                                // Compensate all of the load
+    reset();                                    // Start with no load
+}
+
+/** @brief   Function that sets the inertia of the spindle.
+ *  @param   duty_per_accel Duty cycle needed per RPM/s of acceleration [duty*s/RPM]
+ */
+void disturbanceObserver::set_inertia (float duty_per_accel)
+{
+    inertia_q16 = duty_per_accel*65536;         // Convert to Q16
+}
+
+/** @brief   Function that sets the cutoff of the low-pass filter.
+ *  @details A higher cutoff follows load steps sooner but lets more acceleration noise
+ *           through to the duty cycle.
+ *  @param   hertz The cutoff frequency [Hz]
+ */
+void disturbanceObserver::set_cutoff (float hertz)
+{
+    alpha_q16 = (1 - expf(-2*PI*hertz*dt))*65536; // Exact discrete first-order filter
+}
+
+/** @brief   Function that sets how much of the load is compensated.
+ *  @param   fraction 0 to estimate the load without compensating for it, 1 for all of it
+ */
+void disturbanceObserver::set_gain (float fraction)
+{
+    gain_q16 = fraction*65536;                  // Convert to Q16
+}
+
+/** @brief   Function that forgets the load, for when the motor is off or not under control.
+ */
+void disturbanceObserver::reset (void)
+{
+    load_q16 = 0;                               // Initialize to 0
+    load = 0;                                   // Initialize output
+}
+
+/** @brief   Function that runs one step of the observer.
+ *  @details The acceleration seen now was caused by the duty cycle applied over the last
+ *           step, so @c duty should be the duty cycle output one step ago, not the one about
+ *           to be output.
+ *  @param   duty         The duty cycle applied over the last step
+ *  @param   model_duty   The duty cycle which holds the present speed with no load
+ *  @param   acceleration The acceleration in the direction being driven [RPM/s]
+ */
+void disturbanceObserver::update (int32_t duty, int32_t model_duty, int32_t acceleration)
+{
+    int64_t raw_q16 = (int64_t)(duty - model_duty)*65536                    // Duty cycle not explained by the speed
+                    - (int64_t)inertia_q16*acceleration;                    // or by the acceleration
+    load_q16 += ((raw_q16 - load_q16)*alpha_q16) >> 16;                     // Low-pass filter it
+    load = load_q16 >> 16;                                                  // Convert back to duty cycle
+}
+
+/** @brief   Function that returns the duty cycle which cancels the load.
+ *  @returns The filtered load times the gain [duty cycle]
+ */
+int32_t disturbanceObserver::compensation (void)
+{
+    return (load_q16*gain_q16) >> 32;
+}
@@ -0,0 +1,52 @@
+/** @file disturbanceobserver.h
+ *    This file contains the class definition for a disturbance observer which
+ *    estimates the load on the spindle from the duty cycle and acceleration.
+ *  @date 2026-Oct-16
+ */
+
+#ifndef DISTURBANCEOBSERVER_H
+#define DISTURBANCEOBSERVER_H
+#include <Arduino.h>
+#include <PrintStream.h>
+#if (defined STM32L4xx || defined STM32F4xx)
+    #include <STM32FreeRTOS.h>
+#endif
+
+/** @brief   Defines the class for a load disturbance observer.
+ *  @details When the bit enters the material, the spindle slows down, and the PID
+ *           controller only pushes back once the speed error has built up and its integral
+ *           has had time to grow. This observer notices the load sooner, from what the motor
+ *           is doing rather than from how far the speed has fallen.
+ *
+ *           With no load, the duty cycle needed is the feed-forward duty cycle for the speed
+ *           the spindle is turning at, plus the inertia times the acceleration. Whatever duty
+ *           cycle is being applied beyond that must be going into a load, so the load, in duty
+ *           cycle units, is the applied duty cycle minus those two terms. That raw estimate is
+ *           noisy, mostly because the acceleration is, so it is passed through a first-order
+ *           low-pass filter, whose cutoff sets how quickly the observer follows a load step.
+ *           The filtered load times @c gain is added to the duty cycle, which cancels most of
+ *           the load before the controller has to. Anything the table or the inertia gets
+ *           wrong shows up as load too, so the compensation also makes up for an inaccurate
+ *           feed-forward table. Without a table at all the whole duty cycle would look like
+ *           load, so the caller keeps the observer reset until the table is ready. The
+ *           estimate is kept in Q16 and every step is integer math.
+ */
+class disturbanceObserver {
+    protected:
+        int32_t inertia_q16;                                        // Duty cycle per RPM/s of acceleration, Q16
+        int32_t alpha_q16;                                          // Fraction of the raw estimate taken each step, Q16
+        int32_t gain_q16;                                           // Fraction of the load compensated, Q16
+        int64_t load_q16;                                           // Filtered load, Q16 duty cycle
+        float dt;                                                   // The period in seconds
+    public:
+        int32_t load;                                               // Filtered load [duty cycle]
+        disturbanceObserver (uint32_t update_period_us);            // Format for instantiating a disturbance observer object
+        void set_inertia (float duty_per_accel);                    // Function format for setting the inertia
+        void set_cutoff (float hertz);                              // Function format for setting the filter cutoff
+        void set_gain (float fraction);                             // Function format for setting how much load is compensated
+        void reset (void);                                          // Function format for forgetting the load
+        void update (int32_t duty, int32_t model_duty, int32_t acceleration); // Function format for running one step
+        int32_t compensation (void);                                // Function format for getting the duty cycle to add
+};
+
+#endif // DISTURBANCEOBSERVER_H
@@ -183,64 +183,115 @@ void virtualEncoder::getInput ()
     }                                                                       //
 }
 
+/// Marks a transition in @c quadrature_table where both A and B changed at once
+#define QUADRATURE_ILLEGAL 2
+
+/** @brief   Lookup table for decoding quadrature transitions.
+ *  @details The table is indexed by the previous state of the encoder signals times four,
+ *           plus the current state, where each state is B*2 + A. In forward rotation A leads
+ *           B, so the states go 0, 1, 3, 2, 0, and each of those steps adds one to the count.
+ *           The same steps backwards subtract one. If neither signal changed the count stays
+ *           the same, and if both changed an edge was missed, so the direction is unknown.
+ */
+static const int8_t quadrature_table[16] =
+{
+     0, +1, -1, QUADRATURE_ILLEGAL,                                 // From 0: 0, 1, 2, 3
+    -1,  0, QUADRATURE_ILLEGAL, +1,                                 // From 1: 0, 1, 2, 3
+    +1, QUADRATURE_ILLEGAL,  0, -1,                                 // From 2: 0, 1, 2, 3
+    QUADRATURE_ILLEGAL, -1, +1,  0                                  // From 3: 0, 1, 2, 3
+};
+
 /** @brief   Function called to instantiate an encoder object.
  *  @details This function requires two parameters to instantiate an encoder object.
  *           The first parameter is the hardware pin to read signal A, and the second
- *           parameter is the hardware pin to read signal B. 
+ *           parameter is the hardware pin to read signal B.
  */
 motorEncoder::motorEncoder (uint8_t A_GPIO, uint8_t B_GPIO)
 {
     A_pin = A_GPIO;                             // Save the parameter, which will evaporate when the constructor exits
     B_pin = B_GPIO;                             // Save the parameter, which will evaporate when the constructor exits
     direction = 0;                              // Initialize direction to forward
-    speed_RPM = 0;                              // Initialize speed to 0
-    timestamp_previous_interrupt = 0;           // Initialize to 0
-    count_previous_interrupt = 0;               // Initialize to 0
     count = 0;                                  // Initialize to 0
-    counts_until_update = 0;                    // Initialize to 0
-    count_previous_interrupt = 0;               // Initialize to 0
+    quadrature_state = 0;                       // Initialize to 0
+    illegal_transitions = 0;                    // Initialize to 0
 }
 
-/** @brief   This function calculates the speed of the motor.
- *  @details After the direction of the motor is determined in the ISR,
- *           this function calculates the motor's speed. It keeps track of the 
- *           absolute position of the motor, in encoder ticks, with a protected attribute
- *           called "count". Each encoder tick in the forward direction adds 1 to count,
- *           and each encoder tick in the reverse direction subtracts 1 from count.
- *           Although this function is called every interrupt, it does not calculate
- *           the motor speed every interrupt. Rather, it calculates the motor speed every
- *           update_frequency interrupts. To do this, this function calculates the number of encoder
- *           counts between calculations, and the elapsed time between calculations. This uses protected
- *           attributes: timestamp_previous_interrupt, and count_previous_interrupt. The speed,
- *           in RPM, is calculated using the equation below. Units are noted in "[ ]"
- *      
- *           Speed [RPM] = (delta_count/delta_time)[counts/microsecond]*1000000[microseconds/second]
- *                         * 60 [seconds/min] / (counts_per_rev) [counts/revolution]
+/** @brief   This function counts one rising edge of signal A.
+ *  @details The direction of the motor is determined from signal B when A rises. This
+ *           function keeps track of the absolute position of the motor, in encoder ticks,
+ *           with a protected attribute called "count". Each encoder tick in the forward
+ *           direction adds 1 to count, and each encoder tick in the reverse direction
+ *           subtracts 1 from count.
+ *  @param   dir The direction of the edge, 0 for forward and 1 for reverse
  */          
-void motorEncoder::update (uint32_t timestamp, bool dir)
+void motorEncoder::update (bool dir)
 {
     direction = dir;                                                                    // Store the direction in its protected attribute
     if (direction)                                                                      // If motor is spinning in reverse...
     {                                                                                   //
         count --;                                                                       //      Then, subtract 1 from the encoder position
     }                                                                                   //
-    else if (!direction)                                                                // Else if the motor is spinning forward...
+    else                                                                                // Else if the motor is spinning forward...
     {                                                                                   //
         count ++;                                                                       //      Then, add 1 to the encoder position
     }                                                                                   //
-    counts_until_update ++;                                                             // Increase the number of ticks between calculations
-    if (counts_until_update > update_frequency)                                         // If it's time to calculate the motor speed...
-    {                                                                                   //      Then, calculate it:
-        if (timestamp_previous_interrupt < timestamp)                                   //      If micros() returned a not-overflowed value...
-        {                                                                               //              Then, implement the equation:
-            float time_between_interrupts = timestamp - timestamp_previous_interrupt;   //              Units of microseconds
-            int counts_between_interrupts = abs(count - count_previous_interrupt);      //              Units of counts
-            speed_RPM = counts_between_interrupts/time_between_interrupts;              //              Calculate speed in counts per microsecond
-            speed_RPM *= 1000000*60/counts_per_rev;                                     //              Calculate speed in RPM
-            motorSpeed = (int)speed_RPM;                                                //              Set the speed global variable for printing
-        }                                                                               //
-        timestamp_previous_interrupt = timestamp;                                       // Set a new "old" timestamp for next calculation
-        count_previous_interrupt = count;                                               // Set a new "old" count value for next calculation
-        counts_until_update = 0;                                                        // Begin counting up again to next time to calculate
-    }
-}
\ No newline at end of file
+}
+
+/** @brief   Function that sets the starting state for quadrature decoding.
+ *  @details The first edge decoded by @c update_quadrature() is compared against this
+ *           state, so it should be read from the pins before the interrupts are attached.
+ *  @param   AB The current encoder signals, B*2 + A
+ */
+void motorEncoder::reset_quadrature (uint8_t AB)
+{
+    quadrature_state = AB & 0x03;               // Keep only the two signal bits
+}
+
+/** @brief   This function decodes every edge of both encoder signals.
+ *  @details This function is the 4x alternative to @c update(). It must be called on every
+ *           rising and falling edge of both A and B, so the encoder gives four counts per
+ *           slot instead of one, and the speed estimator must be told four times the number
+ *           of slots. The new state of the signals is combined with the previous state and
+ *           looked up in @c quadrature_table, which says whether the position moved forward,
+ *           backward, or not at all. If A and B both changed since the last call, an edge was
+ *           missed and the direction can't be known, so the count is left alone and
+ *           @c illegal_transitions is increased. A growing error count means that the edges
+ *           are too fast for the interrupts, or that the signals are noisy; @c $ENC? shows it.
+ *  @param   AB The encoder signals read just after the edge, B*2 + A
+ */
+void motorEncoder::update_quadrature (uint8_t AB)
+{
+    AB &= 0x03;                                                                         // Keep only the two signal bits
+    int8_t step = quadrature_table[quadrature_state*4 + AB];                            // Look up the transition from the last state
+    quadrature_state = AB;                                                              // Save the state for the next edge
+    if (step == QUADRATURE_ILLEGAL)                                                     // If both signals changed at once...
+    {                                                                                   //
+        illegal_transitions ++;                                                         //      Then, record the error and skip the edge
+        return;                                                                         //
+    }                                                                                   //
+    if (step == 0)                                                                      // If nothing changed (a glitch)...
+    {                                                                                   //
+        return;                                                                         //      Then, there is nothing to count
+    }                                                                                   //
+    direction = (step < 0);                                                             // Backward steps mean reverse rotation
+    count += step;                                                                      // Move the encoder position
+}
+
+/** @brief   Function that returns the absolute position of the motor.
+ *  @details Each forward count adds one to the position, and each reverse count 
+ *           subtracts one, starting from 0 when the encoder was created.
+ *  @returns The encoder count
+ */
+int motorEncoder::position (void)
+{
+    return count;
+}
+
+/** @brief   Function that prints the position and the number of illegal transitions.
+ *  @param   printer The stream to print to
+ */
+void motorEncoder::print (Print& printer)
+{
+    printer << "Encoder at " << count << " counts, " << illegal_transitions                //
+            << " illegal transitions" << endl;                                          //
+}
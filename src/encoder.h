@@ -56,29 +56,38 @@ class virtualEncoder {
         
 };       
 
-/** @brief   Defines the class for an Encoder.
- *  @details This class has several protected attributes, which are mostly used in calculating
- *           the speed of the motor. When instantiating an Encoder object, the user must specify
- *           which hardware pins to use. The user also has the ability to change the frequency
- *           at which the motor speed is updated to the user. The user must also specify the 
- *           resolution of their encoder, i.e. how many ticks per revolution it will trigger.
+/** @brief   One edge of the motor encoder, as recorded by the encoder ISR.
+ *  @details The ISR only records when the edge happened and what the two encoder
+ *           signals were just after it. Decoding the direction and calculating the
+ *           speed are left to the motor task, which keeps the ISR very short.
+ */
+struct encoderEdge {
+    uint32_t timestamp;                                             // Time of the edge, in encoder clock ticks
+    uint8_t signals;                                                // Encoder signals after the edge, B*2 + A
+};
+
+/** @brief   Defines the class for a motor encoder.
+ *  @details This class keeps track of the position and direction of the motor from the
+ *           edges of its encoder, either one count per slot from the rising edge of A, or
+ *           four counts per slot from every edge of both signals. When instantiating a
+ *           motorEncoder object, the user must specify which hardware pins to use. The
+ *           speed is worked out from the positions and edge times by @c speedEstimator.
  */
 class motorEncoder {
     protected:                             
         uint8_t A_pin;                                              // Encoder signal A pin
         uint8_t B_pin;                                              // Encoder signal B pin
         int count;                                                  // Encoder count
-        uint32_t timestamp_previous_interrupt;                      // Time stamp at last interrupt
-        volatile float speed_RPM;                                   // Float for measured speed
-        int count_previous_interrupt;                               // Value of count at last interrupt
         bool direction;                                             // 0 -> Forward, 1 -> Reverse
-        uint8_t counts_until_update;                                // Counting up to next speed calculation
+        uint8_t quadrature_state;                                   // Last state of the A and B signals, B*2 + A
     public:
-        int motorSpeed;
-        uint8_t counts_per_rev;                                     // How many encoder counts per revolution
-        uint8_t update_frequency;                                   // How frequently we want to update
+        uint32_t illegal_transitions;                               // Number of quadrature transitions where A and B both changed
         motorEncoder (uint8_t A_pin, uint8_t B_pin);                // Format for instantiating a debouncer object
-        void update (uint32_t timestamp, bool dir);                 // Function format for getting the signal status
+        void update (bool dir);                                     // Function format for counting one rising edge of A
+        void reset_quadrature (uint8_t AB);                         // Function format for setting the starting A and B state
+        void update_quadrature (uint8_t AB);                        // Function format for decoding every edge of A and B
+        int position (void);                                        // Function format for getting the encoder count
+        void print (Print& printer);                                // Function format for printing the position and errors
 };
 
 #endif // ENCODER_H
\ No newline at end of file
@@ -0,0 +1,269 @@
+/** @file feedforward.cpp
+ *    This file contains the implementation of the feed-forward speed to duty cycle table.
+ *
+ *  @date 2026-Oct-16
+ */
+
+#include <EEPROM.h>                                                     // Include emulated EEPROM library
+#include "feedforward.h"                                                // Include corresponding header file
+
+/** @brief   Function called to instantiate a feed-forward object.
+ *  @details The object starts with no table, so it gives a duty cycle of zero and
+ *           leaves the whole job to the PID controller until a table is built or loaded.
+ *  @param   update_period_us Time between calls to @c sweep(), in microseconds
+ */
+feedForward::feedForward (uint32_t update_period_us)
+{
+    window_steps = FF_WINDOW_US/update_period_us;   // Control steps in one averaging window
+    if (window_steps == 0) { window_steps = 1; }    //
+    points = 0;                                     // No table yet
+    sweeping = false;                               // Not sweeping
+    ready = false;                                  // No table yet
+    needs_saving = false;                           // Nothing to save
+}
+
+/** @brief   Function that starts a calibration sweep.
+ *  @details While the sweep runs, @c sweep() must be called once per control step and
+ *           its duty cycle output to the motor instead of the controller's. The motor will
+ *           be run all the way up to @c maximum_duty, so it must be free to spin.
+ *  @param   maximum_duty The duty cycle at the top of the sweep
+ *  @param   steps        How many duty cycles to visit, from zero up, at most @c FF_MAX_POINTS
+ */
+void feedForward::start_sweep (int32_t maximum_duty, uint8_t steps)
+{
+    duty_max = maximum_duty;                                        // Save the parameter, which will evaporate when the function exits
+    sweep_points = constrain(steps, 2, FF_MAX_POINTS);              // At least the two ends of the sweep
+    sweep_index = 0;                                                // Start at zero duty cycle
+    window_sum = 0;                                                 // Initialize to 0
+    window_count = 0;                                               // Initialize to 0
+    windows = 0;                                                    // Initialize to 0
+    previous_mean = 0;                                              // Initialize to 0
+    sweeping = true;                                                //
+}
+
+/** @brief   Function that returns the duty cycle the sweep is on.
+ *  @returns The duty cycle
+ */
+int32_t feedForward::sweep_duty (void)
+{
+    return duty_max*sweep_index/(sweep_points - 1);
+}
+
+/** @brief   Function that runs one step of the calibration sweep.
+ *  @details The speed is added to the current window. At the end of each window, its mean
+ *           is compared with the mean of the window before; once they agree to within
+ *           @c FF_STEADY_RPM plus 1/64 of the speed, or the sweep has waited long enough, the
+ *           mean is recorded and the sweep moves to the next duty cycle. After the last one,
+ *           the table is built and the duty cycle goes back to zero.
+ *  @param   measured_speed The measured speed in RPM, in the direction being driven
+ *  @returns The duty cycle to output to the motor
+ */
+int32_t feedForward::sweep (int32_t measured_speed)
+{
+    if (!sweeping)                                                                  // If there is no sweep running...
+    {                                                                               //
+        return 0;                                                                   //      Then, leave the motor off
+    }                                                                               //
+    window_sum += measured_speed;                                                   // Add the speed to the window
+    if (++window_count < window_steps)                                              // If the window isn't over yet...
+    {                                                                               //
+        return sweep_duty();                                                        //      Then, stay at this duty cycle
+    }                                                                               //
+    int32_t mean = window_sum/window_count;                                         // Mean speed over the window
+    window_sum = 0;                                                                 // Start the next window
+    window_count = 0;                                                               //
+    windows ++;                                                                     //
+    bool settled = windows > 1                                                      // Settled if it agrees with the last window
+                && abs(mean - previous_mean) <= FF_STEADY_RPM + abs(mean)/64;       //
+    previous_mean = mean;                                                           //
+    if (!settled && windows < FF_MAX_WINDOWS)                                       // If the speed is still changing...
+    {                                                                               //
+        return sweep_duty();                                                        //      Then, wait another window
+    }                                                                               //
+    sweep_speed[sweep_index++] = mean;                                              // Record the steady speed
+    windows = 0;                                                                    //
+    if (sweep_index >= sweep_points)                                                // If that was the last duty cycle...
+    {                                                                               //
+        sweeping = false;                                                           //      Then, the sweep is done
+        build();                                                                    //      Build the table from it
+        return 0;                                                                   //      Switch the motor off
+    }                                                                               //
+    return sweep_duty();                                                            // Move to the next duty cycle
+}
+
+/** @brief   Function that builds a monotonic table from the sweep.
+ *  @details Each point must be faster than the one before it. A duty cycle which still
+ *           doesn't turn the motor faster than @c FF_STEADY_RPM replaces the one before it,
+ *           so the table starts at the highest duty cycle below breakaway. Any other point
+ *           which isn't faster is noise, and is dropped. The slopes between points are the
+ *           only divisions, done once here.
+ */
+void feedForward::build (void)
+{
+    points = 0;                                                                     // Start the table over
+    for (uint8_t i = 0; i < sweep_points; i++)                                      // For each duty cycle visited...
+    {                                                                               //
+        sweep_index = i;                                                            //
+        int32_t duty_here = sweep_duty();                                           //
+        int32_t speed_here = sweep_speed[i];                                        //
+        if (speed_here <= FF_STEADY_RPM)                                            //      Speeds this small are only noise
+        {                                                                           //
+            speed_here = 0;                                                         //
+        }                                                                           //
+        if (points == 0 || speed_here > rpm[points - 1])                            //      If it is faster than the last point...
+        {                                                                           //
+            rpm[points] = speed_here;                                               //          Then, add it
+            duty_at[points] = duty_here;                                            //
+            points ++;                                                              //
+        }                                                                           //
+        else if (speed_here == 0 && points == 1)                                    //      Else if the motor still isn't turning...
+        {                                                                           //
+            duty_at[0] = duty_here;                                                 //          Then, move the breakaway point up
+        }                                                                           //
+    }                                                                               //
+    for (uint8_t i = 0; i + 1 < points; i++)                                        // Work out the slope to each next point
+    {                                                                               //
+        slope_q16[i] = (int64_t)(duty_at[i + 1] - duty_at[i])*65536                 //
+                     / (rpm[i + 1] - rpm[i]);                                       //
+    }                                                                               //
+    ready = (points >= 2);                                                          // A table needs at least two points
+    needs_saving = ready;                                                           //
+}
+
+/** @brief   Function that looks up the duty cycle for a speed.
+ *  @details Speeds below the first point give the breakaway duty cycle, and speeds above
+ *           the last point give the top duty cycle. In between, the duty cycle is interpolated
+ *           with one multiply.
+ *  @param   setpoint The speed wanted, in RPM
+ *  @returns The duty cycle which should hold the motor at that speed, or 0 with no table
+ */
+int32_t feedForward::duty (int32_t setpoint)
+{
+    if (!ready)                                                                     // If there is no table...
+    {                                                                               //
+        return 0;                                                                   //      Then, leave it all to the controller
+    }                                                                               //
+    if (setpoint <= rpm[0])                                                         // If it is below the table...
+    {                                                                               //
+        return duty_at[0];                                                          //      Then, use the first point
+    }                                                                               //
+    if (setpoint >= rpm[points - 1])                                                // If it is above the table...
+    {                                                                               //
+        return duty_at[points - 1];                                                 //      Then, use the last point
+    }                                                                               //
+    uint8_t i = 0;                                                                  // Find the segment it is in
+    while (setpoint >= rpm[i + 1])                                                  //
+    {                                                                               //
+        i ++;                                                                       //
+    }                                                                               //
+    return duty_at[i] + (((int64_t)slope_q16[i]*(setpoint - rpm[i])) >> 16);        // Interpolate along the segment
+}
+
+/** @brief   Function that loads a table from the emulated EEPROM.
+ *  @details The stored table is only used if it is marked valid and its checksum matches.
+ *  @returns True if a table was loaded
+ */
+bool feedForward::load (void)
+{
+    eeprom_buffer_fill();                                                           // Copy the EEPROM page into RAM
+    uint32_t address = FF_EEPROM_ADDRESS;                                           //
+    uint16_t magic = eeprom_buffered_read_byte(address++);                          // Read the marker
+    magic |= eeprom_buffered_read_byte(address++) << 8;                             //
+    uint8_t stored_points = eeprom_buffered_read_byte(address++);                   // Read the number of points
+    uint8_t checksum = eeprom_buffered_read_byte(address++);                        // Read the checksum
+    if (magic != FF_MAGIC || stored_points < 2 || stored_points > FF_MAX_POINTS)    // If it isn't a valid table...
+    {                                                                               //
+        return false;                                                               //      Then, don't use it
+    }                                                                               //
+    int32_t stored[2*FF_MAX_POINTS];                                                // Read the speeds and duty cycles
+    uint8_t sum = 0;                                                                //
+    for (uint8_t i = 0; i < 2*stored_points; i++)                                   //
+    {                                                                               //
+        uint32_t value = 0;                                                         //
+        for (uint8_t b = 0; b < 4; b++)                                             //      Least significant byte first
+        {                                                                           //
+            uint8_t data = eeprom_buffered_read_byte(address++);                    //
+            value |= (uint32_t)data << (8*b);                                       //
+            sum += data;                                                            //
+        }                                                                           //
+        stored[i] = value;                                                          //
+    }                                                                               //
+    if (sum != checksum)                                                            // If it was corrupted...
+    {                                                                               //
+        return false;                                                               //      Then, don't use it
+    }                                                                               //
+    for (uint8_t i = 0; i < stored_points; i++)                                     // Use the stored points
+    {                                                                               //
+        rpm[i] = stored[2*i];                                                       //
+        duty_at[i] = stored[2*i + 1];                                               //
+    }                                                                               //
+    for (uint8_t i = 0; i + 1 < stored_points; i++)                                 // Work out the slopes again
+    {                                                                               //
+        if (rpm[i + 1] <= rpm[i])                                                   //      A table which isn't increasing can't be used
+        {                                                                           //
+            return false;                                                           //
+        }                                                                           //
+        slope_q16[i] = (int64_t)(duty_at[i + 1] - duty_at[i])*65536                 //
+                     / (rpm[i + 1] - rpm[i]);                                       //
+    }                                                                               //
+    points = stored_points;                                                         //
+    ready = true;                                                                   //
+    return true;
+}
+
+/** @brief   Function that saves the table to the emulated EEPROM.
+ *  @details Like the disc calibration, this erases and writes a flash page, which stalls
+ *           the processor, so it should be called from a low priority task.
+ */
+void feedForward::save (void)
+{
+    needs_saving = false;                                                           // Only save it once
+    uint8_t sum = 0;                                                                // Find the checksum first
+    for (uint8_t i = 0; i < points; i++)                                            //
+    {                                                                               //
+        for (uint8_t b = 0; b < 4; b++)                                             //
+        {                                                                           //
+            sum += (uint32_t)rpm[i] >> (8*b);                                       //
+            sum += (uint32_t)duty_at[i] >> (8*b);                                   //
+        }                                                                           //
+    }                                                                               //
+    eeprom_buffer_fill();                                                           // Keep whatever else is in the page
+    uint32_t address = FF_EEPROM_ADDRESS;                                           //
+    eeprom_buffered_write_byte(address++, FF_MAGIC & 0xFF);                         // Write the marker
+    eeprom_buffered_write_byte(address++, FF_MAGIC >> 8);                           //
+    eeprom_buffered_write_byte(address++, points);                                  // Write the number of points
+    eeprom_buffered_write_byte(address++, sum);                                     // Write the checksum
+    for (uint8_t i = 0; i < points; i++)                                            // Write each point
+    {                                                                               //
+        for (uint8_t b = 0; b < 4; b++)                                             //      Least significant byte first
+        {                                                                           //
+            eeprom_buffered_write_byte(address++, (uint32_t)rpm[i] >> (8*b));       //
+        }                                                                           //
+        for (uint8_t b = 0; b < 4; b++)                                             //
+        {                                                                           //
+            eeprom_buffered_write_byte(address++, (uint32_t)duty_at[i] >> (8*b));   //
+        }                                                                           //
+    }                                                                               //
+    eeprom_buffer_flush();                                                          // Erase and write the flash page once
+}
+
+/** @brief   Function that prints the table.
+ *  @param   printer Reference to the serial device on which to print
+ */
+void feedForward::print (Print& printer)
+{
+    if (sweeping)                                                                   // If a sweep is running...
+    {                                                                               //
+        printer << "Feed-forward sweep at duty " << sweep_duty() << endl;           //      Then, show how far along it is
+        return;                                                                     //
+    }                                                                               //
+    if (!ready)                                                                     // If there is no table...
+    {                                                                               //
+        printer << "No feed-forward table" << endl;                                 //
+        return;                                                                     //
+    }                                                                               //
+    for (uint8_t i = 0; i < points; i++)                                            // Show each point
+    {                                                                               //
+        printer << rpm[i] << " RPM: duty " << duty_at[i] << endl;                   //
+    }                                                                               //
+}
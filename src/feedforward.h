@@ -0,0 +1,68 @@
+/** @file feedforward.h
+ *    This file contains the class definition for a feed-forward table which maps
+ *    a speed set point to the duty cycle that holds the motor at that speed.
+ *  @date 2026-Oct-16
+ */
+
+#ifndef FEEDFORWARD_H
+#define FEEDFORWARD_H
+#include <Arduino.h>
+#include <PrintStream.h>
+#if (defined STM32L4xx || defined STM32F4xx)
+    #include <STM32FreeRTOS.h>
+#endif
+
+#define FF_MAX_POINTS     17                    // Most duty cycles the sweep can visit
+#define FF_WINDOW_US      200000                // Time the speed is averaged over at each duty cycle
+#define FF_MAX_WINDOWS    25                    // Most windows to wait for the speed to settle
+#define FF_STEADY_RPM     20                    // Speed change between windows that counts as settled, plus 1/64 of the speed
+#define FF_EEPROM_ADDRESS 512                   // Where the table is stored in the emulated EEPROM
+#define FF_MAGIC          0xFEED                // Marks a valid table in the emulated EEPROM
+
+/** @brief   Defines the class for a feed-forward speed to duty cycle table.
+ *  @details The speed of a universal motor is far from proportional to the duty cycle,
+ *           so the PID controller would otherwise spend most of a speed change waiting for
+ *           its integral to find the right duty cycle. This table gives that duty cycle
+ *           directly, and the controller only has to correct what is left over.
+ *
+ *           The table is built by a sweep. The duty cycle is stepped from zero to full, and
+ *           at each step the speed is averaged over windows of @c FF_WINDOW_US until two
+ *           windows in a row agree, or until @c FF_MAX_WINDOWS have passed. The sweep only
+ *           deals in duty cycles out and speeds in, one call per control step, so it works
+ *           the same on the real motor as on a simulated one. The speeds found are then made
+ *           monotonic: of the duty cycles which don't turn the motor at all, only the highest
+ *           is kept, since it is the one just below breakaway, and any point which is no
+ *           faster than the one before is dropped. Between points the duty cycle is
+ *           interpolated with a slope which is worked out once, when the table is built.
+ */
+class feedForward {
+    protected:
+        uint32_t window_steps;                                      // Control steps in one averaging window
+        int32_t duty_max;                                           // Largest duty cycle the sweep visits
+        uint8_t sweep_points;                                       // Duty cycles the sweep visits
+        uint8_t sweep_index;                                        // Duty cycle the sweep is on
+        int32_t sweep_speed[FF_MAX_POINTS];                         // Steady speed found at each duty cycle
+        int64_t window_sum;                                         // Sum of speeds in the window so far
+        uint32_t window_count;                                      // Speeds in the window so far
+        int32_t previous_mean;                                      // Mean speed of the last window
+        uint8_t windows;                                            // Windows at this duty cycle so far
+        uint8_t points;                                             // Points in the table
+        int32_t rpm[FF_MAX_POINTS];                                 // Speed at each point, increasing
+        int32_t duty_at[FF_MAX_POINTS];                             // Duty cycle at each point
+        int32_t slope_q16[FF_MAX_POINTS];                           // Duty cycle per RPM to the next point, Q16
+        int32_t sweep_duty (void);                                  // Function format for the duty cycle the sweep is on
+        void build (void);                                          // Function format for building the table from a sweep
+    public:
+        bool sweeping;                                              // True while a sweep is running
+        bool ready;                                                 // True if there is a table to use
+        bool needs_saving;                                          // True if a new table hasn't been saved yet
+        feedForward (uint32_t update_period_us);                    // Format for instantiating a feed-forward object
+        void start_sweep (int32_t maximum_duty, uint8_t steps);     // Function format for starting a sweep
+        int32_t sweep (int32_t measured_speed);                     // Function format for running one step of the sweep
+        int32_t duty (int32_t setpoint);                            // Function format for looking up a duty cycle
+        bool load (void);                                           // Function format for loading the table from EEPROM
+        void save (void);                                           // Function format for saving the table to EEPROM
+        void print (Print& printer);                                // Function format for printing the table
+};
+
+#endif // FEEDFORWARD_H
@@ -0,0 +1,267 @@
+/** @file gainschedule.cpp
+ *    This file contains the implementation of the speed controller gain schedule.
+ *
+ *  @date 2026-Oct-16
+ */
+
+#include <EEPROM.h>                                                     // Include emulated EEPROM library
+#include "gainschedule.h"                                               // Include corresponding header file
+
+/** @brief   Function called to instantiate a gain schedule object.
+ *  @details The schedule starts empty, with fallback gains of zero, so @c set_fallback()
+ *           should be called before the schedule is used.
+ *  @param   pid The controller the gains are for, which converts them to its own form
+ */
+gainSchedule::gainSchedule (pidController* pid)
+{
+    controller = pid;                               // Save the parameter, which will evaporate when the constructor exits
+    count[0] = 0;                                   // No points yet
+    count[1] = 0;                                   //
+    active = 0;                                     // Start with the first copy
+    fallback.kp_q16 = 0;                            // Initialize to 0
+    fallback.ki_dt_q32 = 0;                         // Initialize to 0
+    fallback.kd_dt_q16 = 0;                         // Initialize to 0
+    needs_saving = false;                           // Nothing to save
+}
+
+/** @brief   Function that sets the gains used while the schedule is empty.
+ *  @param   kp Proportional gain [duty/RPM]
+ *  @param   ki Integral gain [duty/(RPM*s)]
+ *  @param   kd Derivative gain [duty*s/RPM]
+ */
+void gainSchedule::set_fallback (float kp, float ki, float kd)
+{
+    fallback = controller->scale(kp, ki, kd);       // Keep them in controller form
+}
+
+/** @brief   Function that copies the table in use into the other copy, ready to be changed.
+ *  @returns The copy which isn't in use
+ */
+uint8_t gainSchedule::spare (void)
+{
+    uint8_t from = active;                                                          // The copy in use
+    uint8_t to = 1 - from;                                                          // The other one
+    count[to] = count[from];                                                        // Copy the points
+    for (uint8_t i = 0; i < count[from]; i++)                                       //
+    {                                                                               //
+        table[to][i] = table[from][i];                                              //
+    }                                                                               //
+    return to;
+}
+
+/** @brief   Function that adds a point to the schedule, or changes the gains at a speed.
+ *  @details The points are kept in order of speed. If there is already a point at the
+ *           given speed, its gains are replaced. The change is made to the copy of the table
+ *           which isn't in use, and the control loop is switched to it once it is complete.
+ *  @param   rpm The speed the gains are for [RPM]
+ *  @param   kp  Proportional gain [duty/RPM]
+ *  @param   ki  Integral gain [duty/(RPM*s)]
+ *  @param   kd  Derivative gain [duty*s/RPM]
+ *  @returns True if the point was set, false if the table was full or the speed not positive
+ */
+bool gainSchedule::set_point (int32_t rpm, float kp, float ki, float kd)
+{
+    if (rpm <= 0)                                                                   // If the speed doesn't make sense...
+    {                                                                               //
+        return false;                                                               //      Then, don't use it
+    }                                                                               //
+    uint8_t copy = spare();                                                         // Change the copy not in use
+    gainPoint* points = table[copy];                                                //
+    uint8_t i = 0;                                                                  // Find where the point goes
+    while (i < count[copy] && points[i].rpm < rpm)                                  //
+    {                                                                               //
+        i ++;                                                                       //
+    }                                                                               //
+    if (i == count[copy] || points[i].rpm != rpm)                                   // If there isn't a point at this speed...
+    {                                                                               //
+        if (count[copy] == GS_MAX_POINTS)                                           //      Then, if there's no room...
+        {                                                                           //
+            return false;                                                           //          Leave the table alone
+        }                                                                           //
+        for (uint8_t j = count[copy]; j > i; j--)                                   //      Make room for it
+        {                                                                           //
+            points[j] = points[j - 1];                                              //
+        }                                                                           //
+        count[copy] ++;                                                             //
+    }                                                                               //
+    points[i].rpm = rpm;                                                            // Fill in the point
+    points[i].kp = kp;                                                              //
+    points[i].ki = ki;                                                              //
+    points[i].kd = kd;                                                              //
+    points[i].scaled = controller->scale(kp, ki, kd);                               //
+    active = copy;                                                                  // Switch the control loop to it
+    needs_saving = true;                                                            //
+    return true;
+}
+
+/** @brief   Function that removes every point, so the fallback gains are used again.
+ */
+void gainSchedule::clear (void)
+{
+    uint8_t copy = 1 - active;                                                      // Empty the copy not in use
+    count[copy] = 0;                                                                //
+    active = copy;                                                                  // Switch the control loop to it
+    needs_saving = true;                                                            //
+}
+
+/** @brief   Function that returns the number of points in the schedule.
+ *  @returns The number of points in the copy in use
+ */
+uint8_t gainSchedule::points (void)
+{
+    return count[active];
+}
+
+/** @brief   Function that finds the gains for a speed.
+ *  @details Each gain is interpolated separately between the two points either side of the
+ *           speed, using the same fraction of the way between them. This only uses integer
+ *           math, so it can be called from the control loop every step.
+ *  @param   rpm The measured speed [RPM]
+ *  @returns The gains in controller form
+ */
+pidGains gainSchedule::lookup (int32_t rpm)
+{
+    uint8_t copy = active;                                                          // Read which copy to use once
+    uint8_t n = count[copy];                                                        //
+    const gainPoint* points = table[copy];                                          //
+    if (n == 0)                                                                     // If there is no schedule...
+    {                                                                               //
+        return fallback;                                                            //      Then, use the fixed gains
+    }                                                                               //
+    if (rpm <= points[0].rpm)                                                       // If it is below the table...
+    {                                                                               //
+        return points[0].scaled;                                                    //      Then, use the first point
+    }                                                                               //
+    if (rpm >= points[n - 1].rpm)                                                   // If it is above the table...
+    {                                                                               //
+        return points[n - 1].scaled;                                                //      Then, use the last point
+    }                                                                               //
+    uint8_t i = 0;                                                                  // Find the segment it is in
+    while (rpm >= points[i + 1].rpm)                                                //
+    {                                                                               //
+        i ++;                                                                       //
+    }                                                                               //
+    const pidGains& low = points[i].scaled;                                         // Gains either side
+    const pidGains& high = points[i + 1].scaled;                                    //
+    int64_t fraction_q16 = (int64_t)(rpm - points[i].rpm)*65536                     // How far along the segment, Q16
+                         / (points[i + 1].rpm - points[i].rpm);                     //
+    pidGains gains;                                                                 // Interpolate each gain
+    gains.kp_q16 = low.kp_q16 + (((high.kp_q16 - (int64_t)low.kp_q16)*fraction_q16) >> 16);
+    gains.ki_dt_q32 = low.ki_dt_q32 + (((high.ki_dt_q32 - low.ki_dt_q32)*fraction_q16) >> 16);
+    gains.kd_dt_q16 = low.kd_dt_q16 + (((high.kd_dt_q16 - (int64_t)low.kd_dt_q16)*fraction_q16) >> 16);
+    return gains;
+}
+
+/** @brief   Function that loads a schedule from the emulated EEPROM.
+ *  @details The stored schedule is only used if it is marked valid, its checksum matches,
+ *           and its speeds are increasing. The gains are stored as entered, and converted to
+ *           controller form when loaded, so a schedule still works if the control period
+ *           has changed since it was saved.
+ *  @returns True if a schedule was loaded
+ */
+bool gainSchedule::load (void)
+{
+    eeprom_buffer_fill();                                                           // Copy the EEPROM page into RAM
+    uint32_t address = GS_EEPROM_ADDRESS;                                           //
+    uint16_t magic = eeprom_buffered_read_byte(address++);                          // Read the marker
+    magic |= eeprom_buffered_read_byte(address++) << 8;                             //
+    uint8_t stored_points = eeprom_buffered_read_byte(address++);                   // Read the number of points
+    uint8_t checksum = eeprom_buffered_read_byte(address++);                        // Read the checksum
+    if (magic != GS_MAGIC || stored_points > GS_MAX_POINTS)                         // If it isn't a valid schedule...
+    {                                                                               //
+        return false;                                                               //      Then, don't use it
+    }                                                                               //
+    uint32_t stored[4*GS_MAX_POINTS];                                               // Read the speeds and gains
+    uint8_t sum = 0;                                                                //
+    for (uint8_t i = 0; i < 4*stored_points; i++)                                   //
+    {                                                                               //
+        uint32_t value = 0;                                                         //
+        for (uint8_t b = 0; b < 4; b++)                                             //      Least significant byte first
+        {                                                                           //
+            uint8_t data = eeprom_buffered_read_byte(address++);                    //
+            value |= (uint32_t)data << (8*b);                                       //
+            sum += data;                                                            //
+        }                                                                           //
+        stored[i] = value;                                                          //
+    }                                                                               //
+    if (sum != checksum)                                                            // If it was corrupted...
+    {                                                                               //
+        return false;                                                               //      Then, don't use it
+    }                                                                               //
+    uint8_t copy = 1 - active;                                                      // Fill the copy not in use
+    gainPoint* points = table[copy];                                                //
+    for (uint8_t i = 0; i < stored_points; i++)                                     //
+    {                                                                               //
+        points[i].rpm = stored[4*i];                                                //
+        memcpy(&points[i].kp, &stored[4*i + 1], sizeof(float));                     //      Gains are stored as raw floats
+        memcpy(&points[i].ki, &stored[4*i + 2], sizeof(float));                     //
+        memcpy(&points[i].kd, &stored[4*i + 3], sizeof(float));                     //
+        if (i > 0 && points[i].rpm <= points[i - 1].rpm)                            //      A schedule which isn't increasing can't be used
+        {                                                                           //
+            return false;                                                           //
+        }                                                                           //
+        points[i].scaled = controller->scale(points[i].kp, points[i].ki, points[i].kd); //
+    }                                                                               //
+    count[copy] = stored_points;                                                    //
+    active = copy;                                                                  // Switch the control loop to it
+    return true;
+}
+
+/** @brief   Function that saves the schedule to the emulated EEPROM.
+ *  @details Like the other tables, this erases and writes a flash page, which stalls the
+ *           processor, so it should be called from a low priority task.
+ */
+void gainSchedule::save (void)
+{
+    needs_saving = false;                                                           // Only save it once
+    uint8_t copy = active;                                                          // Save the copy in use
+    uint32_t stored[4*GS_MAX_POINTS];                                               // Put the points into words
+    for (uint8_t i = 0; i < count[copy]; i++)                                       //
+    {                                                                               //
+        stored[4*i] = table[copy][i].rpm;                                           //
+        memcpy(&stored[4*i + 1], &table[copy][i].kp, sizeof(float));                //
+        memcpy(&stored[4*i + 2], &table[copy][i].ki, sizeof(float));                //
+        memcpy(&stored[4*i + 3], &table[copy][i].kd, sizeof(float));                //
+    }                                                                               //
+    uint8_t sum = 0;                                                                // Find the checksum
+    for (uint8_t i = 0; i < 4*count[copy]; i++)                                     //
+    {                                                                               //
+        for (uint8_t b = 0; b < 4; b++)                                             //
+        {                                                                           //
+            sum += stored[i] >> (8*b);                                              //
+        }                                                                           //
+    }                                                                               //
+    eeprom_buffer_fill();                                                           // Keep whatever else is in the page
+    uint32_t address = GS_EEPROM_ADDRESS;                                           //
+    eeprom_buffered_write_byte(address++, GS_MAGIC & 0xFF);                         // Write the marker
+    eeprom_buffered_write_byte(address++, GS_MAGIC >> 8);                           //
+    eeprom_buffered_write_byte(address++, count[copy]);                             // Write the number of points
+    eeprom_buffered_write_byte(address++, sum);                                     // Write the checksum
+    for (uint8_t i = 0; i < 4*count[copy]; i++)                                     // Write each word
+    {                                                                               //
+        for (uint8_t b = 0; b < 4; b++)                                             //      Least significant byte first
+        {                                                                           //
+            eeprom_buffered_write_byte(address++, stored[i] >> (8*b));              //
+        }                                                                           //
+    }                                                                               //
+    eeprom_buffer_flush();                                                          // Erase and write the flash page once
+}
+
+/** @brief   Function that prints the schedule.
+ *  @param   printer Reference to the serial device on which to print
+ */
+void gainSchedule::print (Print& printer)
+{
+    uint8_t copy = active;                                                          // Print the copy in use
+    if (count[copy] == 0)                                                           // If there is no schedule...
+    {                                                                               //
+        printer << "No gain schedule; using fixed gains" << endl;                   //
+        return;                                                                     //
+    }                                                                               //
+    for (uint8_t i = 0; i < count[copy]; i++)                                       // Show each point
+    {                                                                               //
+        const gainPoint& point = table[copy][i];                                    //
+        printer << point.rpm << " RPM: Kp " << point.kp << " Ki " << point.ki       //
+                << " Kd " << point.kd << endl;                                      //
+    }                                                                               //
+}
@@ -0,0 +1,70 @@
+/** @file gainschedule.h
+ *    This file contains the class definition for a gain schedule which changes
+ *    the speed controller's gains with the spindle speed.
+ *  @date 2026-Oct-16
+ */
+
+#ifndef GAINSCHEDULE_H
+#define GAINSCHEDULE_H
+#include <Arduino.h>
+#include <PrintStream.h>
+#if (defined STM32L4xx || defined STM32F4xx)
+    #include <STM32FreeRTOS.h>
+#endif
+#include "pidcontroller.h"                      // The schedule holds gains for the PID controller
+
+#define GS_MAX_POINTS     8                     // Most speeds the schedule can hold gains for
+#define GS_EEPROM_ADDRESS 768                   // Where the schedule is stored in the emulated EEPROM
+#define GS_MAGIC          0x6A15                // Marks a valid schedule in the emulated EEPROM
+
+/** @brief   Holds one point of a gain schedule.
+ */
+struct gainPoint {
+    int32_t rpm;                                                    // Speed the gains are for [RPM]
+    float kp;                                                       // Proportional gain [duty/RPM]
+    float ki;                                                       // Integral gain [duty/(RPM*s)]
+    float kd;                                                       // Derivative gain [duty*s/RPM]
+    pidGains scaled;                                                // The same gains in controller form
+};
+
+/** @brief   Defines the class for a speed controller gain schedule.
+ *  @details A universal motor behaves very differently at 5000 RPM than at 30000 RPM, so
+ *           gains which are crisp at one end are sluggish or ringing at the other. This class
+ *           holds a short table of gains, each for a given speed, and gives the controller
+ *           gains interpolated linearly between the two points either side of the measured
+ *           speed. Below the first point and above the last, the end points are used. With no
+ *           points, the fixed gains set by @c set_fallback() are used, which is how the
+ *           controller behaved before there was a schedule. Because the gains change a little
+ *           at a time as the speed changes, and the controller keeps its output steady when its
+ *           gains change, moving along the schedule doesn't bump the motor.
+ *
+ *           Points are added from the serial console while the control loop, which may be an
+ *           interrupt, is reading the table. So there are two copies of the table: a change is
+ *           made to the copy not in use, and then @c active is switched to it in one write. The
+ *           control loop reads @c active once per step, and a step is far shorter than the time
+ *           between two console commands, so it never sees a copy being changed. Each point is
+ *           kept both as entered, for printing and saving, and in controller form, so that a
+ *           lookup is only integer math.
+ */
+class gainSchedule {
+    protected:
+        pidController* controller;                                  // Controller whose form the gains are kept in
+        gainPoint table[2][GS_MAX_POINTS];                          // Two copies of the table
+        uint8_t count[2];                                           // Points in each copy
+        volatile uint8_t active;                                    // The copy the control loop uses
+        pidGains fallback;                                          // Gains used when the schedule is empty
+        uint8_t spare (void);                                       // Function format for preparing the unused copy
+    public:
+        bool needs_saving;                                          // True if a change hasn't been saved yet
+        gainSchedule (pidController* pid);                          // Format for instantiating a gain schedule object
+        void set_fallback (float kp, float ki, float kd);           // Function format for setting the gains used with no schedule
+        bool set_point (int32_t rpm, float kp, float ki, float kd); // Function format for adding or changing a point
+        void clear (void);                                          // Function format for removing every point
+        uint8_t points (void);                                      // Function format for counting the points
+        pidGains lookup (int32_t rpm);                              // Function format for finding the gains at a speed
+        bool load (void);                                           // Function format for loading the schedule from EEPROM
+        void save (void);                                           // Function format for saving the schedule to EEPROM
+        void print (Print& printer);                                // Function format for printing the schedule
+};
+
+#endif // GAINSCHEDULE_H
@@ -0,0 +1,221 @@
+/** @file gcode.cpp
+ *    This file contains the implementation of the streaming G-code spindle command parser.
+ *
+ *  @date 2026-Oct-16
+ */
+
+#include "gcode.h"                                                      // Include corresponding header file
+
+/** @brief   Function called to instantiate a G-code parser object.
+ *  @details The spindle starts off, with no speed, and the parser starts at the beginning
+ *           of a line.
+ */
+gcodeParser::gcodeParser (void)
+{
+    speed = 0;                                  // No S word yet
+    mode = GCODE_STOPPED;                       // Off
+    lines = 0;                                  // Initialize to 0
+    commands = 0;                               // Initialize to 0
+    errors = 0;                                 // Initialize to 0
+    state = GCODE_LINE_START;                   // Nothing read yet
+    letter = 0;                                 // No word yet
+    number = 0;                                 // Initialize to 0
+    scale = 0;                                  // Initialize to 0
+    negative = false;                           // Initialize to false
+    digits = false;                             // Initialize to false
+    error = false;                              // Nothing wrong yet
+    has_speed = false;                          // No S word on this line
+    line_speed = 0;                             // Initialize to 0
+    line_mode = 0;                              // No spindle M word on this line
+}
+
+/** @brief   Function that reads one character of G-code.
+ *  @details The character moves the state machine along. A letter ends the word before
+ *           it, and the end of a line ends the last word and the line.
+ *  @param   character The next character from the stream
+ *  @returns True if a line with spindle words has just ended, so the set point and
+ *           direction should be passed on
+ */
+bool gcodeParser::feed (char character)
+{
+    if (character == '\n' || character == '\r')                                            // If the line has ended...
+    {                                                                                       //
+        if (state == GCODE_NUMBER) { finish_word(); }                                       //      Then, use its last word
+        return finish_line();                                                               //      Use the line
+    }                                                                                       //
+    if (state == GCODE_SKIP)                                                                // If ignoring the rest of the line...
+    {                                                                                       //
+        return false;                                                                       //      Then, wait for its end
+    }                                                                                       //
+    if (state == GCODE_COMMENT)                                                             // If inside a comment...
+    {                                                                                       //
+        if (character == ')') { state = GCODE_WORDS; }                                      //      Then, wait for its end
+        return false;                                                                       //
+    }                                                                                       //
+    if (character == ' ' || character == '\t')                                              // White space means nothing
+    {                                                                                       //
+        return false;                                                                       //
+    }                                                                                       //
+    if (state == GCODE_LINE_START)                                                          // If this is the first character...
+    {                                                                                       //
+        if (character == '$' || character == '%')                                           //      Then, if it isn't G-code, skip it
+        {                                                                                   //
+            state = GCODE_SKIP;                                                             //
+            return false;                                                                   //
+        }                                                                                   //
+        state = GCODE_WORDS;                                                                //
+    }                                                                                       //
+    if (character == '(')                                                                   // If a comment starts...
+    {                                                                                       //
+        if (state == GCODE_NUMBER) { finish_word(); }                                       //      Then, it ends the word before it
+        state = GCODE_COMMENT;                                                              //
+        return false;                                                                       //
+    }                                                                                       //
+    if (character == ';' || character == '*')                                               // If a comment or checksum ends the line...
+    {                                                                                       //
+        if (state == GCODE_NUMBER) { finish_word(); }                                       //      Then, use the last word
+        state = GCODE_SKIP;                                                                 //      Skip the rest
+        return false;                                                                       //
+    }                                                                                       //
+    char upper = character & ~0x20;                                                         // Upper case, if it is a letter
+    if (upper >= 'A' && upper <= 'Z')                                                       // If a word starts...
+    {                                                                                       //
+        if (state == GCODE_NUMBER) { finish_word(); }                                       //      Then, use the one before
+        letter = upper;                                                                     //      Start reading its number
+        number = 0;                                                                         //
+        scale = 0;                                                                          //
+        negative = false;                                                                   //
+        digits = false;                                                                     //
+        state = GCODE_NUMBER;                                                               //
+        return false;                                                                       //
+    }                                                                                       //
+    if (state == GCODE_NUMBER)                                                              // If reading a number...
+    {                                                                                       //
+        if (character >= '0' && character <= '9')                                           //      Then, add a digit
+        {                                                                                   //
+            int32_t digit = character - '0';                                                //
+            if (scale == 0)                                                                 //          In front of the point
+            {                                                                               //
+                number = (number > GCODE_MAX_NUMBER/10) ? GCODE_MAX_NUMBER : number*10 + digit*1000; //
+            }                                                                               //
+            else if (scale > 0)                                                             //          Behind it, down to thousandths
+            {                                                                               //
+                number += digit*scale;                                                      //
+                scale = (scale > 1) ? scale/10 : -1;                                        //          The rest are too small to keep
+            }                                                                               //
+            digits = true;                                                                  //
+            return false;                                                                   //
+        }                                                                                   //
+        if (character == '.' && scale == 0)                                                 //      If the point comes...
+        {                                                                                   //
+            scale = 100;                                                                    //          Then, the next digit is tenths
+            return false;                                                                   //
+        }                                                                                   //
+        if ((character == '-' || character == '+') && !digits && scale == 0 && !negative)   //      If a sign comes first...
+        {                                                                                   //
+            negative = character == '-';                                                    //
+            return false;                                                                   //
+        }                                                                                   //
+    }                                                                                       //
+    error = true;                                                                           // Anything else doesn't belong
+    state = GCODE_SKIP;                                                                     //
+    return false;
+}
+
+/** @brief   Function that uses the word which has just been read.
+ *  @details Only M and S words are kept; M words with a fraction aren't spindle words.
+ */
+void gcodeParser::finish_word (void)
+{
+    state = GCODE_WORDS;                                                                    // Between words again
+    if (!digits)                                                                            // If there was no number...
+    {                                                                                       //
+        error = true;                                                                       //      Then, the word is no good
+        return;                                                                             //
+    }                                                                                       //
+    if (letter == 'S')                                                                      // If it sets the speed...
+    {                                                                                       //
+        if (negative)                                                                       //      Then, it can't be negative
+        {                                                                                   //
+            error = true;                                                                   //
+            return;                                                                         //
+        }                                                                                   //
+        has_speed = true;                                                                   //      Round it to whole RPM
+        line_speed = (number + 500)/1000;                                                   //
+    }                                                                                       //
+    else if (letter == 'M' && !negative && number % 1000 == 0)                              // Else if it is a whole M word...
+    {                                                                                       //
+        uint8_t code = 0;                                                                   //      Then, see what it does to the spindle
+        switch (number/1000)                                                                //
+        {                                                                                   //
+            case 3: code = GCODE_CLOCKWISE; break;                                          //
+            case 4: code = GCODE_COUNTERCLOCK; break;                                       //
+            case 5: case 2: case 30: code = GCODE_STOPPED; break;                           //      Ending the program stops it too
+            default: break;                                                                 //
+        }                                                                                   //
+        if (code && line_mode)                                                              //      Only one to a line
+        {                                                                                   //
+            error = true;                                                                   //
+        }                                                                                   //
+        else if (code)                                                                      //
+        {                                                                                   //
+            line_mode = code;                                                               //
+        }                                                                                   //
+    }                                                                                       //
+}
+
+/** @brief   Function that uses the line which has just been read, and starts the next.
+ *  @returns True if the line had spindle words and no errors
+ */
+bool gcodeParser::finish_line (void)
+{
+    bool used = false;                                                                      // If the spindle words were used
+    if (state != GCODE_LINE_START || error)                                                 // If there was anything on the line...
+    {                                                                                       //
+        lines ++;                                                                           //      Then, count it
+    }                                                                                       //
+    if (error)                                                                              // If it was wrong...
+    {                                                                                       //
+        errors ++;                                                                          //      Then, throw it all away
+    }                                                                                       //
+    else if (has_speed || line_mode)                                                        // Else if it has spindle words...
+    {                                                                                       //
+        if (has_speed) { speed = line_speed; }                                              //      Then, use them together
+        if (line_mode) { mode = line_mode; }                                                //
+        commands ++;                                                                        //
+        used = true;                                                                        //
+    }                                                                                       //
+    state = GCODE_LINE_START;                                                               // Start the next line
+    letter = 0;                                                                             //
+    digits = false;                                                                         //
+    error = false;                                                                          //
+    has_speed = false;                                                                      //
+    line_speed = 0;                                                                         //
+    line_mode = 0;                                                                          //
+    return used;
+}
+
+/** @brief   Function that gives the speed the G-code asks for.
+ *  @returns The speed from the last S word if the spindle is on, or 0 if it is off [RPM]
+ */
+int32_t gcodeParser::setpoint (void)
+{
+    return (mode == GCODE_STOPPED) ? 0 : speed;
+}
+
+/** @brief   Function that gives the direction the G-code asks for.
+ *  @returns True for M4, counterclockwise, and false otherwise
+ */
+bool gcodeParser::reverse (void)
+{
+    return mode == GCODE_COUNTERCLOCK;
+}
+
+/** @brief   Function that prints the spindle state and the line counts.
+ *  @param   printer The stream to print to
+ */
+void gcodeParser::print (Print& printer)
+{
+    printer << "G-code M" << mode << " S" << speed << ", " << lines << " lines, "         //
+            << commands << " spindle commands, " << errors << " errors" << endl;          //
+}
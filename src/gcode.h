@@ -0,0 +1,76 @@
+/** @file gcode.h
+ *    This file contains the class definition for a parser which picks the spindle
+ *    commands M3, M4, M5 and S out of a stream of G-code, one character at a time.
+ *  @date 2026-Oct-16
+ */
+
+#ifndef GCODE_H
+#define GCODE_H
+#include <Arduino.h>
+#include <PrintStream.h>
+#if (defined STM32L4xx || defined STM32F4xx)
+    #include <STM32FreeRTOS.h>
+#endif
+
+#define GCODE_MAX_NUMBER    100000000           // Largest number kept, in thousandths; bigger ones are clamped
+
+#define GCODE_LINE_START    0                   // Nothing but white space on this line yet
+#define GCODE_WORDS         1                   // Between words
+#define GCODE_NUMBER        2                   // Reading the number after a letter
+#define GCODE_COMMENT       3                   // Inside a comment in parentheses
+#define GCODE_SKIP          4                   // Ignoring the rest of the line
+
+#define GCODE_CLOCKWISE     3                   // M3, spindle on clockwise
+#define GCODE_COUNTERCLOCK  4                   // M4, spindle on counterclockwise
+#define GCODE_STOPPED       5                   // M5, spindle off
+
+/** @brief   Defines the class for a streaming G-code spindle command parser.
+ *  @details A hobby motion controller which only forwards its G-code can drive the spindle
+ *           through this parser. Each character is handed to @c feed() as it is taken out of
+ *           the serial port's receive buffer, and the parser moves through a small state
+ *           machine, so it never waits for a whole line, never blocks, and keeps no line
+ *           buffer: numbers are built up as they arrive, in thousandths, and each word is
+ *           dealt with as soon as the next one starts.
+ *
+ *           Only the spindle words are used. M3 and M4 turn the spindle on clockwise and
+ *           counterclockwise, M5 turns it off, and M2 and M30, which end a program, turn it off
+ *           too. S sets the speed, rounded to the nearest RPM, which is kept while the spindle
+ *           is off, as in any G-code interpreter. Every other word is read and ignored. Letters
+ *           may be either case, and white space is ignored everywhere, even inside numbers.
+ *           Comments in parentheses or after a semicolon, a checksum after @c '*', and lines
+ *           starting with @c '$' or @c '%', which are controller commands and program markers,
+ *           are skipped.
+ *
+ *           Nothing changes until a line ends, so the speed and direction from one line always
+ *           take effect together. A line with two spindle M words, a negative speed, a letter
+ *           without a number or a character which doesn't belong in G-code is thrown away and
+ *           counted in @c errors.
+ */
+class gcodeParser {
+    protected:
+        uint8_t state;                                              // GCODE_LINE_START to GCODE_SKIP
+        char letter;                                                // Letter of the word being read, or 0
+        int32_t number;                                             // Its number so far, in thousandths
+        int32_t scale;                                              // Value of the next digit in thousandths, 0 before the point
+        bool negative;                                              // If the number has a minus sign
+        bool digits;                                                // If the number has any digits yet
+        bool error;                                                 // If something on this line was wrong
+        bool has_speed;                                             // If this line has an S word
+        int32_t line_speed;                                         // The S word's speed
+        uint8_t line_mode;                                          // This line's spindle M word, or 0
+        void finish_word (void);                                    // Function format for using the word just read
+        bool finish_line (void);                                    // Function format for using the line just read
+    public:
+        int32_t speed;                                              // Speed from the last S word [RPM]
+        uint8_t mode;                                               // GCODE_CLOCKWISE, GCODE_COUNTERCLOCK or GCODE_STOPPED
+        uint32_t lines;                                             // Lines read
+        uint32_t commands;                                          // Lines with spindle words used
+        uint32_t errors;                                            // Lines thrown away
+        gcodeParser (void);                                         // Format for instantiating a G-code parser object
+        bool feed (char character);                                 // Function format for reading one character
+        int32_t setpoint (void);                                    // Function format for getting the speed asked for
+        bool reverse (void);                                        // Function format for getting the direction asked for
+        void print (Print& printer);                                // Function format for printing the spindle state
+};
+
+#endif // GCODE_H
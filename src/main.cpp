@@ -19,6 +19,8 @@
 #include "encoder.h"                          // Include the encoder files
 #include "userInterface.h"                    // Incldue the user interface files
 #include "motorstuff.h"                       // Include the motor control files
+#include "console.h"                          // Include the serial console files
+#include "modbus.h"                           // Include the Modbus RTU slave files
 
 /** @brief   Arduino setup function which runs once at program startup.
  *  @details This function sets up a serial port for communication and creates
@@ -44,6 +46,18 @@ void setup ()
                  NULL,                            // Parameters for task fn.
                  2,                               // Priority
                  NULL);                           // Task handle
+    xTaskCreate (task_Console,                    // Create task for serial commands
+                 "Console",                       // Name for printouts
+                 1024,                            // Stack size
+                 NULL,                            // Parameters for task fn.
+                 1,                               // Priority
+                 NULL);                           // Task handle
+    xTaskCreate (task_Modbus,                     // Create task for the Modbus RTU slave
+                 "Modbus",                        // Name for printouts
+                 1024,                            // Stack size
+                 NULL,                            // Parameters for task fn.
+                 3,                               // Priority, above the rest so replies go out at once
+                 NULL);                           // Task handle
     // If using an STM32, we need to call the scheduler startup function now;
     // if using an ESP32, it has already been called for us
     #if (defined STM32L4xx || defined STM32F4xx)
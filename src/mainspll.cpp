@@ -0,0 +1,156 @@
+/** @file mainspll.cpp
+ *    This file contains the implementation of the mains zero-crossing phase-locked loop.
+ *
+ *  @date 2026-Oct-16
+ */
+
+#include "mainspll.h"                                                   // Include corresponding header file
+
+/** @brief   Function called to instantiate a mains PLL object.
+ *  @param   half_period_us The expected time between zero crossings, 10000 for 50 Hz
+ *           or 8333 for 60 Hz
+ */
+mainsPLL::mainsPLL (uint32_t half_period_us)
+{
+    glitches = 0;                               // Initialize to 0
+    missed = 0;                                 // Initialize to 0
+    set_period(half_period_us);                 // Start with no edges
+}
+
+/** @brief   Function that sets the expected half period and starts acquiring again.
+ *  @param   half_period_us The expected time between zero crossings [us]
+ */
+void mainsPLL::set_period (uint32_t half_period_us)
+{
+    nominal_q16 = half_period_us << 16;         // Convert to Q16
+    reset();                                    // Start with no edges
+}
+
+/** @brief   Function that forgets the mains and starts acquiring it again.
+ */
+void mainsPLL::reset (void)
+{
+    locked = false;                             // Not following the mains yet
+    stage = 0;                                  // No edges yet
+    period_q16 = nominal_q16;                   // Assume the nominal frequency
+    used = 0;                                   // Initialize to 0
+    rejects = 0;                                // Initialize to 0
+    coasting = 0;                               // Initialize to 0
+}
+
+/** @brief   Function that adds one zero-cross edge to the loop.
+ *  @details While acquiring, the first two edges a plausible half period apart start the
+ *           loop. After that, each edge is checked against the prediction and, if it is
+ *           close enough, used to correct the phase and the period. The size of the error is
+ *           averaged over about eight edges, and the loop locks once it has used
+ *           @c PLL_LOCK_EDGES edges and that average is under @c PLL_LOCK_US, and unlocks if
+ *           the average grows past twice that. This only uses integer math, so it is called
+ *           from the zero-cross interrupt.
+ *  @param   time The timer count when the edge happened [us]
+ *  @returns False if the edge was rejected as a glitch, true otherwise
+ */
+bool mainsPLL::edge (uint16_t time)
+{
+    uint32_t time_q16 = (uint32_t)time << 16;                                       // The whole part wraps with the timer
+    coasting = 0;                                                                   // The mains is still there
+    if (stage < 2)                                                                  // If still acquiring...
+    {                                                                               //
+        uint32_t gap_q16 = (uint32_t)(uint16_t)(time - last_edge) << 16;            //      Then, time since the last edge
+        last_edge = time;                                                           //
+        if (stage == 1 && gap_q16 > nominal_q16 - nominal_q16/8                     //      If it is a plausible half period...
+                       && gap_q16 < nominal_q16 + nominal_q16/8)                    //
+        {                                                                           //
+            period_q16 = gap_q16;                                                   //          Then, start tracking from it
+            current_q16 = time_q16;                                                 //
+            next_q16 = time_q16 + period_q16;                                       //
+            error_q16 = PLL_LOCK_US << 16;                                          //          Not known to be close yet
+            stage = 2;                                                              //
+            return true;                                                            //
+        }                                                                           //
+        stage = 1;                                                                  //      Otherwise, measure from this edge
+        return true;                                                                //
+    }                                                                               //
+    int32_t error = time_q16 - next_q16;                                            // How far the edge is from the prediction
+    for (uint8_t i = 0; i < 4 && error > (int32_t)(period_q16/2); i++)              // If edges were lost...
+    {                                                                               //
+        next_q16 += period_q16;                                                     //      Then, step on to meet this one
+        error -= period_q16;                                                        //
+        missed ++;                                                                  //
+    }                                                                               //
+    int32_t window = locked ? (PLL_WINDOW_US << 16) : (int32_t)(period_q16/4);      // How far off an edge may be
+    if (error > window || error < -window)                                          // If it is too far off...
+    {                                                                               //
+        glitches ++;                                                                //      Then, it is a glitch
+        if (++rejects > PLL_MAX_REJECTS)                                            //      If nothing has fit for a while...
+        {                                                                           //
+            reset();                                                                //          Then, start over
+        }                                                                           //
+        return false;                                                               //
+    }                                                                               //
+    rejects = 0;                                                                    //
+    current_q16 = next_q16 + (error >> PLL_KP_SHIFT);                               // Correct the phase
+    int32_t period = period_q16 + (error >> PLL_KI_SHIFT);                          // Correct the period
+    period_q16 = constrain(period, (int32_t)(nominal_q16 - nominal_q16/8),          //      but keep it near the nominal one
+                                   (int32_t)(nominal_q16 + nominal_q16/8));         //
+    next_q16 = current_q16 + period_q16;                                            // Predict the next crossing
+    int32_t size = (error < 0) ? -error : error;                                    // Average the size of the error
+    error_q16 += (size - error_q16) >> 3;                                           //
+    if (used < PLL_LOCK_EDGES) { used ++; }                                         // Count the edges used
+    if (used == PLL_LOCK_EDGES && error_q16 < (PLL_LOCK_US << 16))                  // If the loop has settled...
+    {                                                                               //
+        locked = true;                                                              //      Then, it is locked
+    }                                                                               //
+    else if (error_q16 > (2*PLL_LOCK_US << 16))                                     // Else if it has drifted off...
+    {                                                                               //
+        locked = false;                                                             //      Then, it isn't any more
+    }                                                                               //
+    return true;
+}
+
+/** @brief   Function that returns the estimated time of the latest zero crossing.
+ *  @returns The timer count of the crossing [us]
+ */
+uint16_t mainsPLL::current (void)
+{
+    return (current_q16 + 0x8000) >> 16;
+}
+
+/** @brief   Function that predicts the first zero crossing after a given time.
+ *  @details If the edge for the predicted crossing hasn't arrived yet, and that crossing
+ *           has already passed, the one after it is given. Each call with no new edge since
+ *           the last counts toward unlocking, so a loop which has lost the mains stops
+ *           predicting after @c PLL_MAX_COAST half cycles.
+ *  @param   now The timer count now [us]
+ *  @returns The timer count of the crossing [us]
+ */
+uint16_t mainsPLL::next_after (uint16_t now)
+{
+    if (++coasting > PLL_MAX_COAST)                                                 // If there have been no edges for a while...
+    {                                                                               //
+        locked = false;                                                             //      Then, don't trust the prediction
+        stage = 0;                                                                  //
+    }                                                                               //
+    uint32_t next = next_q16;                                                       //
+    for (uint8_t i = 0; i < 2 && (int16_t)(((next + 0x8000) >> 16) - now) <= 0; i++) // Skip crossings already past
+    {                                                                               //
+        next += period_q16;                                                         //
+    }                                                                               //
+    return (next + 0x8000) >> 16;
+}
+
+/** @brief   Function that returns the estimated half period.
+ *  @returns The time between zero crossings [us]
+ */
+uint16_t mainsPLL::period (void)
+{
+    return (period_q16 + 0x8000) >> 16;
+}
+
+/** @brief   Function that prints the state of the loop.
+ *  @param   printer Reference to the serial device on which to print
+ */
+void mainsPLL::print (Print& printer)
+{
+    printer << "Mains " << (locked ? "locked" : "not locked") << ", half period " << period() << " us, "
+            << glitches << " glitches, " << missed << " missed" << endl;
+}
@@ -0,0 +1,72 @@
+/** @file mainspll.h
+ *    This file contains the class definition for a phase-locked loop which tracks
+ *    the mains zero crossings.
+ *  @date 2026-Oct-16
+ */
+
+#ifndef MAINSPLL_H
+#define MAINSPLL_H
+#include <Arduino.h>
+#include <PrintStream.h>
+#if (defined STM32L4xx || defined STM32F4xx)
+    #include <STM32FreeRTOS.h>
+#endif
+
+#define PLL_KP_SHIFT     3                      // Fraction of the phase error taken out each edge, 1/2^n
+#define PLL_KI_SHIFT     6                      // Fraction of the phase error added to the period each edge, 1/2^n
+#define PLL_WINDOW_US    500                    // Farthest an edge may be from the prediction once locked
+#define PLL_LOCK_US      100                    // Largest average phase error while locked
+#define PLL_LOCK_EDGES   16                     // Edges used before the loop can lock
+#define PLL_MAX_REJECTS  8                      // Rejected edges in a row before starting over
+#define PLL_MAX_COAST    4                      // Half cycles to keep predicting with no edges before unlocking
+
+/** @brief   Defines the class for a mains zero-crossing phase-locked loop.
+ *  @details The zero-cross detector's edges wander by tens of microseconds from one half
+ *           cycle to the next, because of noise on the mains and because the detector's
+ *           threshold shifts with the load, and now and then a spike makes an extra edge or
+ *           a dip loses one. Firing a triac a fixed delay after each raw edge passes all of
+ *           that straight into the motor's torque. The mains itself, though, is very steady.
+ *           This class keeps its own estimate of when the zero crossings happen, and only
+ *           nudges it a little with each edge, so it can predict the next crossing far more
+ *           precisely than any one edge.
+ *
+ *           Times are in ticks of a free-running 16-bit microsecond timer, and the estimates
+ *           are kept in Q16 in a 32-bit word, so the whole part wraps with the timer and the
+ *           differences work across the wrap. Each edge is compared with the predicted
+ *           crossing. The estimate of this crossing moves by 1/2^PLL_KP_SHIFT of the error,
+ *           and the half period by 1/2^PLL_KI_SHIFT of it, which is a second-order loop with
+ *           a damping ratio of about one half; the next crossing is then predicted one half
+ *           period on. An edge more than a few hundred microseconds from the prediction is a
+ *           glitch and is ignored, and an edge about a whole half period late means edges were
+ *           lost, so the prediction is stepped on to meet it. The loop is locked once it has
+ *           settled, with the average error under @c PLL_LOCK_US. It starts over
+ *           after too many rejected edges in a row, and unlocks if it has been asked to predict
+ *           @c PLL_MAX_COAST crossings with no edges at all, for example if the mains is lost.
+ */
+class mainsPLL {
+    protected:
+        uint32_t nominal_q16;                                       // Expected half period, Q16 us
+        uint32_t period_q16;                                        // Estimated half period, Q16 us
+        uint32_t current_q16;                                       // Estimated time of the latest crossing, Q16 us
+        uint32_t next_q16;                                          // Predicted time of the next crossing, Q16 us
+        uint16_t last_edge;                                         // Time of the last edge while acquiring
+        uint8_t stage;                                              // 0: no edges, 1: one edge, 2: tracking
+        uint8_t used;                                               // Edges used since starting, up to PLL_LOCK_EDGES
+        int32_t error_q16;                                          // Average size of the phase error, Q16 us
+        uint8_t rejects;                                            // Rejected edges in a row
+        uint8_t coasting;                                           // Predictions made since the last edge
+    public:
+        volatile bool locked;                                       // True once the loop is following the mains
+        volatile uint32_t glitches;                                 // Edges rejected as glitches
+        volatile uint32_t missed;                                   // Crossings with no edge
+        mainsPLL (uint32_t half_period_us);                         // Format for instantiating a PLL object
+        void set_period (uint32_t half_period_us);                  // Function format for setting the expected half period
+        void reset (void);                                          // Function format for starting over
+        bool edge (uint16_t time);                                  // Function format for adding a zero-cross edge
+        uint16_t current (void);                                    // Function format for the latest crossing
+        uint16_t next_after (uint16_t now);                         // Function format for predicting the next crossing
+        uint16_t period (void);                                     // Function format for the estimated half period
+        void print (Print& printer);                                // Function format for printing the loop's state
+};
+
+#endif // MAINSPLL_H
@@ -0,0 +1,414 @@
+/** @file modbus.cpp
+ *    This file contains the implementation of the Modbus RTU slave, and the task
+ *    which passes the set point and the spindle's state between it and the other tasks.
+ *
+ *  @date 2026-Oct-16
+ */
+
+#include "modbus.h"                                                     // Include corresponding header file
+#include "taskshare.h"                                                  // Include task sharing library
+#include "seqshare.h"                                                   // Include sequence-locked share library
+#include "autotune.h"                                                   // Include relay auto-tuner library for its states
+
+#define modbusRxPin      PC11                                           // USART3 receive, on the morpho header
+#define modbusTxPin      PC10                                           // USART3 transmit
+#define modbusDEPin      PD2                                            // USART3 RTS, to the RS-485 driver enable, or NC
+#define modbusTimer      TIM15                                          // Timer which times the silence between frames
+#define modbusBaud       19200                                          // Bits per second, 8 data bits, even parity, 1 stop bit
+#define modbusAddress    1                                              // Slave address, 1 to 247
+
+extern Share <int> speed_SP;                                            // Points to Share created by user interface tasks
+extern Share <int> maxMotorSpeed;                                       // Points to Share created by user interface tasks
+extern SeqShare <int> actualMotorSpeed;                                 // Points to Share created by motor control tasks
+extern SeqShare <int> filteredMotorSpeed;                               // Points to Share created by motor control tasks
+extern SeqShare <int> speedReference;                                   // Points to Share created by motor control tasks
+extern SeqShare <bool> spindleStopped;                                  // Points to Share created by motor control tasks
+extern SeqShare <int> motorDuty;                                        // Points to Share created by motor control tasks
+extern SeqShare <int> estimatedLoad;                                    // Points to Share created by motor control tasks
+extern SeqShare <uint8_t> autotuneState;                                // Points to Share created by motor control tasks
+
+modbusSlave myModbusSlave(modbusRxPin, modbusTxPin, modbusDEPin, modbusTimer, modbusBaud, modbusAddress);
+
+/** @brief   Function called to instantiate a Modbus slave object.
+ *  @details This function saves the pins, timer and line settings. Every holding register
+ *           accepts any value until @c set_limit() is called. The port and timer are not
+ *           touched until @c begin() is called from the task.
+ *  @param   rx_GPIO         The pin the port receives on
+ *  @param   tx_GPIO         The pin the port transmits on
+ *  @param   de_GPIO         The UART's RTS pin, wired to the RS-485 driver enable, or NC
+ *  @param   silence_timer   The timer peripheral to time the silence with, which nothing
+ *                           else may be using
+ *  @param   bits_per_second The baud rate
+ *  @param   slave_address   The address this slave answers to, 1 to 247
+ */
+modbusSlave::modbusSlave (uint32_t rx_GPIO, uint32_t tx_GPIO, uint32_t de_GPIO, TIM_TypeDef* silence_timer,
+                          uint32_t bits_per_second, uint8_t slave_address)
+{
+    rx_pin = rx_GPIO;                           // Save the parameter, which will evaporate when the constructor exits
+    tx_pin = tx_GPIO;                           // Save the parameter, which will evaporate when the constructor exits
+    de_pin = de_GPIO;                           // Save the parameter, which will evaporate when the constructor exits
+    timer_instance = silence_timer;             // Save the parameter, which will evaporate when the constructor exits
+    baud = bits_per_second;                     // Save the parameter, which will evaporate when the constructor exits
+    address = slave_address;                    // Save the parameter, which will evaporate when the constructor exits
+    port = NULL;                                // Created in begin()
+    timer = NULL;                               // Created in begin()
+    task = NULL;                                // Found in begin()
+    last_count = 0;                             // Nothing received yet
+    quiet_ticks = MODBUS_SILENCE_TICKS;         // Not in a frame
+    frame_end = 0;                              // Initialize to 0
+    for (uint8_t i = 0; i < MODBUS_HOLDING_COUNT; i++)                                      // Clear the registers
+    {                                                                                       //
+        holding[i] = 0;                                                                     //
+        holding_max[i] = 0xFFFF;                                                            //      No limit
+    }                                                                                       //
+    for (uint8_t i = 0; i < MODBUS_INPUT_COUNT; i++)                                        //
+    {                                                                                       //
+        input[i] = 0;                                                                       //
+    }                                                                                       //
+    written = 0;                                // Initialize to 0
+    frames = 0;                                 // Initialize to 0
+    crc_errors = 0;                             // Initialize to 0
+    exceptions = 0;                             // Initialize to 0
+    overruns = 0;                               // Initialize to 0
+    max_latency = 0;                            // Initialize to 0
+}
+
+/** @brief   Function that works out the Modbus CRC of a block of bytes.
+ *  @details The CRC is sent low byte first, so the CRC of a whole frame including its own
+ *           CRC comes out as zero.
+ *  @param   data   The bytes to check
+ *  @param   length The number of bytes
+ *  @returns The CRC, polynomial 0xA001 reflected, starting from 0xFFFF
+ */
+uint16_t modbusSlave::crc16 (const uint8_t* data, uint16_t length)
+{
+    uint16_t crc = 0xFFFF;                                                                  // Start with all ones
+    for (uint16_t i = 0; i < length; i++)                                                   // Fold in each byte
+    {                                                                                       //
+        crc ^= data[i];                                                                     //
+        for (uint8_t bit = 0; bit < 8; bit++)                                               //      A bit at a time
+        {                                                                                   //
+            crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;                               //
+        }                                                                                   //
+    }                                                                                       //
+    return crc;
+}
+
+/** @brief   Function that sets the largest value a holding register accepts.
+ *  @param   reg     The holding register
+ *  @param   maximum The largest value which can be written to it
+ */
+void modbusSlave::set_limit (uint16_t reg, uint16_t maximum)
+{
+    if (reg < MODBUS_HOLDING_COUNT)                                                         // If the register exists...
+    {                                                                                       //
+        holding_max[reg] = maximum;                                                         //      Then, save the limit
+    }                                                                                       //
+}
+
+/** @brief   Function that starts the serial port and the silence timer.
+ *  @details This must be called from the task which will call @c receive(), since that is
+ *           the task the timer interrupt wakes. The timer ticks every half character time,
+ *           which is 11 bits with the parity bit, or every 250 us above 19200 baud, where the
+ *           silence is fixed at 1.75 ms. If there is a driver enable pin, the UART is switched
+ *           into driver enable mode, which drives the RTS pin high while it transmits.
+ */
+void modbusSlave::begin (void)
+{
+    task = xTaskGetCurrentTaskHandle();                                                     // Wake this task at the end of each frame
+    port = new HardwareSerial(rx_pin, tx_pin);                                              // Create the port
+    port->begin(baud, SERIAL_8E1);                                                          // Modbus RTU is 8 data bits, even parity
+    if (de_pin != NC)                                                                       // If there's an RS-485 driver to enable...
+    {                                                                                       //
+        USART_TypeDef* uart = (USART_TypeDef*)pinmap_peripheral(digitalPinToPinName(tx_pin), PinMap_UART_TX); // Find the UART
+        pinmap_pinout(digitalPinToPinName(de_pin), PinMap_UART_RTS);                        //      Then, give the UART the pin
+        uart->CR1 &= ~USART_CR1_UE;                                                         //      Driver enable mode can only be set while it's off
+        uart->CR3 |= USART_CR3_DEM;                                                         //
+        uart->CR1 |= USART_CR1_UE;                                                          //
+    }                                                                                       //
+    uint32_t tick_us = (baud > 19200) ? 250 : 11*1000000/2/baud;                            // Half a character time
+    timer = new HardwareTimer(timer_instance);                                              // Create the timer object
+    timer->setOverflow(tick_us, MICROSEC_FORMAT);                                           // Overflow every half character
+    timer->attachInterrupt(std::bind(&modbusSlave::tick, this));                            // Watch for silence at each overflow
+    timer->resume();                                                                        // Start counting
+}
+
+/** @brief   Function called by the timer's update interrupt.
+ *  @details The number of characters waiting only goes up while a frame is arriving, and
+ *           drops when the task reads it, so the frame has ended when the count is above zero
+ *           and has not changed for @c MODBUS_SILENCE_TICKS ticks. The task is woken once, and
+ *           not again until the count changes.
+ */
+void modbusSlave::tick (void)
+{
+    int count = port->available();                                                          // Characters waiting
+    if (count != last_count)                                                                // If one has come in, or they've been read...
+    {                                                                                       //
+        last_count = count;                                                                 //      Then, start timing the silence again
+        quiet_ticks = 0;                                                                    //
+        return;                                                                             //
+    }                                                                                       //
+    if (count == 0 || quiet_ticks == MODBUS_SILENCE_TICKS)                                  // If there's no frame, or it has been passed on...
+    {                                                                                       //
+        return;                                                                             //      Then, there's nothing to do
+    }                                                                                       //
+    if (++quiet_ticks == MODBUS_SILENCE_TICKS)                                              // If the silence is long enough...
+    {                                                                                       //
+        frame_end = micros();                                                               //      Then, the frame is over
+        BaseType_t woken = pdFALSE;                                                         //      Wake the task
+        vTaskNotifyGiveFromISR(task, &woken);                                               //
+        portYIELD_FROM_ISR(woken);                                                          //
+    }                                                                                       //
+}
+
+/** @brief   Function that waits for a frame and reads it into @c frame.
+ *  @details The task sleeps until the timer interrupt finds the silence after a frame. A
+ *           frame too long for the buffer is read and thrown away.
+ *  @returns The length of the frame, or 0 if it was too long
+ */
+uint16_t modbusSlave::receive (void)
+{
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);                                                // Sleep until a frame has ended
+    uint16_t length = 0;                                                                    // Read everything waiting
+    bool overrun = false;                                                                   //
+    while (port->available())                                                               //
+    {                                                                                       //
+        uint8_t character = port->read();                                                   //
+        if (length < MODBUS_FRAME_SIZE)                                                     //      Keep what fits
+        {                                                                                   //
+            frame[length++] = character;                                                    //
+        }                                                                                   //
+        else                                                                                //
+        {                                                                                   //
+            overrun = true;                                                                 //
+        }                                                                                   //
+    }                                                                                       //
+    if (overrun)                                                                            // If it didn't fit...
+    {                                                                                       //
+        overruns ++;                                                                        //      Then, it can't be used
+        return 0;                                                                           //
+    }                                                                                       //
+    return length;
+}
+
+/** @brief   Function that checks a frame, carries it out and builds the reply.
+ *  @details Frames with a bad CRC or for another slave are ignored without a reply, as the
+ *           standard requires. A frame which can't be carried out gets an exception reply:
+ *           the function code with its top bit set, and the exception code. A write with a
+ *           value above a register's limit changes nothing. Each holding register which is
+ *           written sets its bit in @c written.
+ *  @param   data   The frame, which is overwritten by the reply; it must hold
+ *                  @c MODBUS_FRAME_SIZE bytes
+ *  @param   length The length of the frame
+ *  @returns The length of the reply, or 0 if there is no reply to send
+ */
+uint16_t modbusSlave::handle (uint8_t* data, uint16_t length)
+{
+    if (length < 4 || crc16(data, length) != 0)                                             // If the frame was damaged...
+    {                                                                                       //
+        if (length > 0) { crc_errors ++; }                                                  //      Then, ignore it
+        return 0;                                                                           //
+    }                                                                                       //
+    if (data[0] != address && data[0] != 0)                                                 // If it's for another slave...
+    {                                                                                       //
+        return 0;                                                                           //      Then, ignore it
+    }                                                                                       //
+    frames ++;                                                                              //
+    uint8_t function = data[1];                                                             //
+    uint16_t start = (data[2] << 8) | data[3];                                              // First register
+    uint16_t count = (data[4] << 8) | data[5];                                              // Number of registers, or the value for 06
+    uint8_t error = 0;                                                                      // Exception code, if any
+    uint16_t reply = 0;                                                                     // Length of the reply without its CRC
+    switch (function)                                                                       //
+    {                                                                                       //
+        case 3:                                                                             // Read holding registers
+        case 4:                                                                             // Read input registers
+        {                                                                                   //
+            const uint16_t* registers = (function == 3) ? holding : input;                  //
+            uint16_t size = (function == 3) ? MODBUS_HOLDING_COUNT : MODBUS_INPUT_COUNT;    //
+            if (length != 8 || count < 1 || count > 125)                                    //
+            {                                                                               //
+                error = MODBUS_ILLEGAL_VALUE;                                               //
+            }                                                                               //
+            else if (start + count > size)                                                  //
+            {                                                                               //
+                error = MODBUS_ILLEGAL_ADDRESS;                                             //
+            }                                                                               //
+            else                                                                            //
+            {                                                                               //
+                data[2] = count*2;                                                          //      Byte count, then each register high byte first
+                for (uint16_t i = 0; i < count; i++)                                        //
+                {                                                                           //
+                    data[3 + 2*i] = registers[start + i] >> 8;                              //
+                    data[4 + 2*i] = registers[start + i] & 0xFF;                            //
+                }                                                                           //
+                reply = 3 + 2*count;                                                        //
+            }                                                                               //
+            break;                                                                          //
+        }                                                                                   //
+        case 6:                                                                             // Write a single holding register
+        {                                                                                   //
+            if (length != 8)                                                                //
+            {                                                                               //
+                error = MODBUS_ILLEGAL_VALUE;                                               //
+            }                                                                               //
+            else if (start >= MODBUS_HOLDING_COUNT)                                         //
+            {                                                                               //
+                error = MODBUS_ILLEGAL_ADDRESS;                                             //
+            }                                                                               //
+            else if (count > holding_max[start])                                            //
+            {                                                                               //
+                error = MODBUS_ILLEGAL_VALUE;                                               //
+            }                                                                               //
+            else                                                                            //
+            {                                                                               //
+                holding[start] = count;                                                     //
+                written |= 1UL << start;                                                    //
+                reply = 6;                                                                  //      The reply echoes the request
+            }                                                                               //
+            break;                                                                          //
+        }                                                                                   //
+        case 16:                                                                            // Write multiple holding registers
+        {                                                                                   //
+            if (length < 9 || length != 9 + data[6] || count < 1 || count > 123 || data[6] != count*2) //
+            {                                                                               //
+                error = MODBUS_ILLEGAL_VALUE;                                               //
+                break;                                                                      //
+            }                                                                               //
+            if (start + count > MODBUS_HOLDING_COUNT)                                       //
+            {                                                                               //
+                error = MODBUS_ILLEGAL_ADDRESS;                                             //
+                break;                                                                      //
+            }                                                                               //
+            for (uint16_t i = 0; i < count; i++)                                            //      Check every value before writing any
+            {                                                                               //
+                if (((data[7 + 2*i] << 8) | data[8 + 2*i]) > holding_max[start + i])        //
+                {                                                                           //
+                    error = MODBUS_ILLEGAL_VALUE;                                           //
+                }                                                                           //
+            }                                                                               //
+            if (error)                                                                      //
+            {                                                                               //
+                break;                                                                      //
+            }                                                                               //
+            for (uint16_t i = 0; i < count; i++)                                            //
+            {                                                                               //
+                holding[start + i] = (data[7 + 2*i] << 8) | data[8 + 2*i];                  //
+                written |= 1UL << (start + i);                                              //
+            }                                                                               //
+            reply = 6;                                                                      //      Address, function, start and count
+            break;                                                                          //
+        }                                                                                   //
+        default:                                                                            //
+        {                                                                                   //
+            error = MODBUS_ILLEGAL_FUNCTION;                                                //
+            break;                                                                          //
+        }                                                                                   //
+    }                                                                                       //
+    if (data[0] == 0)                                                                       // If it was a broadcast...
+    {                                                                                       //
+        return 0;                                                                           //      Then, nobody is listening for a reply
+    }                                                                                       //
+    if (error)                                                                              // If it couldn't be carried out...
+    {                                                                                       //
+        data[1] = function | 0x80;                                                          //      Then, say why
+        data[2] = error;                                                                    //
+        reply = 3;                                                                          //
+        exceptions ++;                                                                      //
+    }                                                                                       //
+    uint16_t crc = crc16(data, reply);                                                      // Add the CRC, low byte first
+    data[reply] = crc & 0xFF;                                                               //
+    data[reply + 1] = crc >> 8;                                                             //
+    return reply + 2;
+}
+
+/** @brief   Function that sends the reply in @c frame.
+ *  @details The reply goes into the port's transmit buffer and is sent by its interrupt, so
+ *           this returns at once. The time since the end of the request is kept if it's the
+ *           longest so far.
+ *  @param   length The length of the reply
+ */
+void modbusSlave::send (uint16_t length)
+{
+    port->write(frame, length);                                                             // Queue the reply
+    uint32_t latency = micros() - frame_end;                                                // Time since the silence was found
+    if (latency > max_latency) { max_latency = latency; }                                   //
+}
+
+/** @brief   Function that prints the slave's statistics.
+ *  @param   printer The stream to print to
+ */
+void modbusSlave::print (Print& printer)
+{
+    printer << "Modbus slave " << address << " at " << baud << " baud: " << frames << " frames, "   //
+            << crc_errors << " CRC errors, " << exceptions << " exceptions, " << overruns          //
+            << " overruns, " << max_latency << " us longest reply" << endl;                        //
+}
+
+/** @brief   Task which runs the Modbus slave.
+ *  @details The task sleeps until a frame has been received. It then fills the input
+ *           registers and the set point register from the shares, so a read gets the latest
+ *           values, has the frame carried out, and puts a set point which was written into the
+ *           set point share before sending the reply. The set point can't be written above the
+ *           maximum speed.
+ *  @param   p_params A pointer to function parameters which we don't use.
+ */
+void task_Modbus (void* p_params)
+{
+    (void)p_params;                                                             // Does nothing but shut up a compiler warning
+    myModbusSlave.begin();                                                      // Start listening
+    for (;;)
+    {
+        uint16_t length = myModbusSlave.receive();                              // Sleep until a frame comes in
+        int value;                                                              // Fill the registers from the shares
+        speed_SP.get(value);                                                    //
+        int32_t setpoint = value;                                               //
+        myModbusSlave.holding[MODBUS_HR_SETPOINT] = constrain(setpoint, 0, 0xFFFF); //
+        maxMotorSpeed.get(value);                                               //
+        myModbusSlave.set_limit(MODBUS_HR_SETPOINT, constrain(value, 0, 0xFFFF)); //
+        myModbusSlave.input[MODBUS_IR_MAX_SPEED] = constrain(value, 0, 0xFFFF); //
+        actualMotorSpeed.get(value);                                            //
+        myModbusSlave.input[MODBUS_IR_MEASURED] = constrain(value, 0, 0xFFFF);  //
+        filteredMotorSpeed.get(value);                                          //
+        myModbusSlave.input[MODBUS_IR_FILTERED] = constrain(value, 0, 0xFFFF);  //
+        speedReference.get(value);                                              //
+        int32_t reference = value;                                              //
+        myModbusSlave.input[MODBUS_IR_REFERENCE] = constrain(reference, 0, 0xFFFF); //
+        motorDuty.get(value);                                                   //
+        int32_t duty = value;                                                   //
+        myModbusSlave.input[MODBUS_IR_DUTY] = constrain(duty, 0, 0xFFFF);       //
+        estimatedLoad.get(value);                                               //
+        myModbusSlave.input[MODBUS_IR_LOAD] = constrain(value, 0, 0xFFFF);      //
+        bool stopped;                                                           //
+        spindleStopped.get(stopped);                                            //
+        uint8_t tune;                                                           //
+        autotuneState.get(tune);                                                //
+        uint16_t faults = 0;                                                    // Work out the faults
+        if (stopped && setpoint > 0 && duty >= 255)                             //
+        {                                                                       //
+            faults |= MODBUS_FAULT_STALL;                                       //
+        }                                                                       //
+        if (tune == TUNE_FAILED)                                                //
+        {                                                                       //
+            faults |= MODBUS_FAULT_TUNE;                                        //
+        }                                                                       //
+        uint16_t status = 0;                                                    // Work out the status
+        if (stopped) { status |= MODBUS_STATUS_STOPPED; }                       //
+        if (!stopped && setpoint > 0 && reference == setpoint) { status |= MODBUS_STATUS_AT_SPEED; }
+        if (tune == TUNE_RUNNING) { status |= MODBUS_STATUS_TUNING; }           //
+        if (faults) { status |= MODBUS_STATUS_FAULT; }                          //
+        myModbusSlave.input[MODBUS_IR_STATUS] = status;                         //
+        myModbusSlave.input[MODBUS_IR_FAULTS] = faults;                         //
+
+        length = myModbusSlave.handle(myModbusSlave.frame, length);             // Carry out the frame
+        if (myModbusSlave.written & (1UL << MODBUS_HR_SETPOINT))                // If the set point was written...
+        {                                                                       //
+            speed_SP.put(myModbusSlave.holding[MODBUS_HR_SETPOINT]);            //      Then, pass it on
+        }                                                                       //
+        myModbusSlave.written = 0;                                              //
+        if (length)                                                             // If there's a reply...
+        {                                                                       //
+            myModbusSlave.send(length);                                         //      Then, send it
+        }                                                                       //
+    }
+}
@@ -0,0 +1,113 @@
+/** @file modbus.h
+ *    This file contains the class definition for a Modbus RTU slave, which lets a
+ *    PLC set the spindle speed and read its state like a VFD, and the task which runs it.
+ *  @date 2026-Oct-16
+ */
+
+#ifndef MODBUS_H
+#define MODBUS_H
+#include <Arduino.h>
+#include <PrintStream.h>
+#if (defined STM32L4xx || defined STM32F4xx)
+    #include <STM32FreeRTOS.h>
+#endif
+
+#define MODBUS_FRAME_SIZE        256            // Longest RTU frame, address to CRC
+#define MODBUS_SILENCE_TICKS     7              // Timer ticks of half a character in the 3.5 character silence
+#define MODBUS_HOLDING_COUNT     1              // Holding registers, read with 03 and written with 06 and 16
+#define MODBUS_INPUT_COUNT       8              // Input registers, read with 04
+
+#define MODBUS_HR_SETPOINT       0              // Speed set point [RPM]; 0 stops the spindle
+
+#define MODBUS_IR_MEASURED       0              // Measured speed [RPM]
+#define MODBUS_IR_FILTERED       1              // Filtered speed from the observer [RPM]
+#define MODBUS_IR_REFERENCE      2              // Profiled set point the controller is following [RPM]
+#define MODBUS_IR_STATUS         3              // Status bits, MODBUS_STATUS_...
+#define MODBUS_IR_FAULTS         4              // Fault bits, MODBUS_FAULT_...
+#define MODBUS_IR_DUTY           5              // Duty cycle output by the controller, 0 to 255
+#define MODBUS_IR_LOAD           6              // Estimated load [% of full duty]
+#define MODBUS_IR_MAX_SPEED      7              // Highest set point allowed [RPM]
+
+#define MODBUS_STATUS_STOPPED    0x0001         // No encoder edges are arriving
+#define MODBUS_STATUS_AT_SPEED   0x0002         // Running, and the profile has reached the set point
+#define MODBUS_STATUS_TUNING     0x0004         // The auto-tuner is running
+#define MODBUS_STATUS_FAULT      0x0008         // Any fault bit is set
+
+#define MODBUS_FAULT_STALL       0x0001         // Full duty cycle with a set point, but the spindle isn't turning
+#define MODBUS_FAULT_TUNE        0x0002         // The last auto-tune was stopped before it found gains
+
+#define MODBUS_ILLEGAL_FUNCTION  1              // Exception: function code not supported
+#define MODBUS_ILLEGAL_ADDRESS   2              // Exception: register outside the map
+#define MODBUS_ILLEGAL_VALUE     3              // Exception: bad count, length or register value
+
+/** @brief   Defines the class for a Modbus RTU slave.
+ *  @details A PLC talks to a VFD over Modbus RTU, so this slave gives it the same kind of
+ *           interface: one holding register for the speed set point, and input registers for
+ *           the measured speed, status and faults. Function codes 03 and 04 read holding and
+ *           input registers, and 06 and 16 write holding registers. A write above the limit set
+ *           with @c set_limit() is refused with an illegal value exception. Frames addressed to
+ *           0 are broadcasts, which are carried out without a reply.
+ *
+ *           In RTU mode a frame ends with 3.5 character times of silence on the line, fixed at
+ *           1.75 ms above 19200 baud. The serial port's interrupt puts received characters in
+ *           its buffer, and a hardware timer ticks every half character time and looks at how
+ *           many are waiting. Once the count has not changed for @c MODBUS_SILENCE_TICKS ticks,
+ *           the frame is complete, and the timer interrupt wakes the Modbus task with a task
+ *           notification. The task sleeps the rest of the time, so no processor time is spent
+ *           polling the port. The silence is found between 3.5 and 4 character times after the
+ *           last character, and the task, which has a higher priority than the others, has the
+ *           reply on its way within tens of microseconds after that.
+ *
+ *           The registers themselves are plain arrays. @c handle() checks a frame, carries it
+ *           out on the arrays, and builds the reply in the same buffer; it doesn't touch the
+ *           port or any shares, so it can be run on a PC as well, with a pseudo-terminal in
+ *           place of the serial port. The task copies the shares into the input registers
+ *           before each frame is handled, and copies holding registers which were written back
+ *           out after.
+ *
+ *           For RS-485, the transceiver's driver enable goes on the UART's RTS pin, which the
+ *           UART then drives itself, high from the start of the first character of a reply to
+ *           the end of the last.
+ */
+class modbusSlave {
+    protected:
+        uint32_t rx_pin;                                            // Pin the port receives on
+        uint32_t tx_pin;                                            // Pin the port transmits on
+        uint32_t de_pin;                                            // RS-485 driver enable on the UART's RTS pin, or NC
+        TIM_TypeDef* timer_instance;                                // Timer which times the silence
+        uint32_t baud;                                              // Bits per second
+        uint8_t address;                                            // Slave address, 1 to 247
+        HardwareSerial* port;                                       // Serial port, created in begin()
+        HardwareTimer* timer;                                       // Silence timer, created in begin()
+        TaskHandle_t task;                                          // Task woken at the end of each frame
+        int last_count;                                             // Characters waiting at the last tick
+        uint8_t quiet_ticks;                                        // Ticks since the count last changed
+        uint32_t frame_end;                                         // Time the last frame's silence was found [us]
+        uint16_t holding_max[MODBUS_HOLDING_COUNT];                 // Largest value each holding register accepts
+        void tick (void);                                           // Function called by the timer interrupt
+    public:
+        uint8_t frame[MODBUS_FRAME_SIZE];                           // Frame received, then the reply
+        uint16_t holding[MODBUS_HOLDING_COUNT];                     // Holding registers
+        uint16_t input[MODBUS_INPUT_COUNT];                         // Input registers
+        uint32_t written;                                           // Bit for each holding register written, cleared by the user
+        volatile uint32_t frames;                                   // Frames for this slave carried out
+        volatile uint32_t crc_errors;                               // Frames thrown away for a bad CRC
+        volatile uint32_t exceptions;                               // Exception replies sent
+        volatile uint32_t overruns;                                 // Frames too long for the buffer
+        volatile uint32_t max_latency;                              // Longest time from silence to reply queued [us]
+        modbusSlave (uint32_t rx_GPIO, uint32_t tx_GPIO,            // Format for instantiating a Modbus slave object
+                     uint32_t de_GPIO, TIM_TypeDef* silence_timer,  //
+                     uint32_t bits_per_second, uint8_t slave_address); //
+        static uint16_t crc16 (const uint8_t* data, uint16_t length); // Function format for the Modbus CRC of a block of bytes
+        void set_limit (uint16_t reg, uint16_t maximum);            // Function format for setting the largest value a holding register accepts
+        void begin (void);                                          // Function format for starting the port and timer
+        uint16_t receive (void);                                    // Function format for waiting for a frame
+        uint16_t handle (uint8_t* data, uint16_t length);           // Function format for carrying out a frame and building the reply
+        void send (uint16_t length);                                // Function format for sending the reply
+        void print (Print& printer);                                // Function format for printing the statistics
+};
+
+/// Task functions
+void task_Modbus (void* params);                                            // The Modbus slave task function
+
+#endif // MODBUS_H
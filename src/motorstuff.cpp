@@ -12,17 +12,123 @@
 #include "userInterface.h"                                              // Include user interface files
 #include "motorstuff.h"                                                 // Include corresponding header file
 #include "taskshare.h"                                                  // Include task sharing library
+#include "seqshare.h"                                                   // Include sequence-locked share library
 #include "taskqueue.h"                                                  // Include taskqueue library
+#include "speedcapture.h"                                               // Include input-capture timer library
+#include "speedestimator.h"                                             // Include M/T speed estimator library
+#include "ringbuffer.h"                                                 // Include lock-free ring buffer library
+#include "speedobserver.h"                                              // Include speed observer library
+#include "disccalibration.h"                                            // Include encoder disc calibration table
+#include "pidcontroller.h"                                              // Include PID controller library
+#include "controltimer.h"                                               // Include control loop timer library
+#include "feedforward.h"                                                // Include feed-forward table library
+#include "autotune.h"                                                   // Include relay auto-tuner library
+#include "setpointprofile.h"                                            // Include set point profile library
+#include "gainschedule.h"                                               // Include gain schedule library
+#include "disturbanceobserver.h"                                        // Include load disturbance observer library
+#include "triacdriver.h"                                                // Include phase-angle triac driver library
+#include "pwmdriver.h"                                                  // Include high-resolution PWM driver library
+#include "pwminput.h"                                                   // Include PWM spindle speed input library
+#include "analoginput.h"                                                // Include 0-10 V spindle speed input library
+#include "timingprobe.h"                                                // Include timing probe library
 
 #define motorEncoderPinA 7
 #define motorEncoderPinB 8
 #define motorPWMpin      A3
 #define motorDIRpin      2
+#define motorTriacDrive       0                                         // 1 -> phase-angle triac on AC mains, 0 -> PWM
+#define motorFinePWM          1                                         // 1 -> PWM compare register at full timer resolution, 0 -> analogWrite()
+#define motorPWMFrequency     1000                                      // PWM carrier frequency for motorFinePWM, the same as analogWrite() [Hz]
+#define motorGatePin          5                                         // Triac gate output
+#define motorZeroCrossPin     6                                         // Zero-cross detector input
+#define motorTriacTimer       TIM16                                     // Timer which times the triac gate
+#define motorMainsFrequency   60                                        // Mains frequency, 50 or 60 [Hz]
+#define motorTriacMode        TRIAC_PHASE_ANGLE                         // TRIAC_PHASE_ANGLE or TRIAC_BURST; can be changed with $AC=
+#define motorSpeedCapture     0                                         // 1 -> time encoder edges with timer input capture, 0 -> micros()
+#define motorCaptureFrequency 10000000                                  // Input-capture timer count rate [ticks/second]
+#define motorPWMInput         0                                         // 1 -> a CNC controller sets the speed with a PWM signal, 0 -> the user does
+#define motorPWMInputPin      A0                                        // PWM speed input, on channel 1 or 2 of a timer
+#define motorPWMInputRate     10000000                                  // PWM input timer count rate, at least 154 Hz signal at 10 MHz [ticks/second]
+#define motorPWMInputMaxRPM   30000                                     // Speed at 100% PWM input duty cycle, from 0 at 0% [RPM]
+                                                                        // motorAnalogInput, for a 0-10 V speed input, is in analoginput.h
+#define motorAnalogInputPin   A1                                        // 0-10 V speed input, divided down to 3.3 V, on ADC1
+#define motorAnalogMaxRPM     30000                                     // Speed at 10 V, from 0 at 0 V [RPM]
+#define motorAnalogDeadband   500                                       // Speeds asked for below this are off, about 0.17 V at 30000 RPM [RPM]
+#define motorEncoderDecode    1                                         // 1 -> count rising edges of A, 4 -> count every edge of A and B
+#define motorEncoderSlots     1                                         // Slots on the encoder disc
+#define motorCountsPerRev     (motorEncoderDecode*motorEncoderSlots)    // Encoder counts per revolution after decoding
+#define motorEdgeBufferSize   256                                       // Encoder edges the ISR can store between task runs
+#define motorControlISR       0                                         // 1 -> run the control loop from a timer interrupt, 0 -> from the motor task
+#define motorControlTimer     TIM7                                      // Timer which runs the control loop interrupt
+#define motorControlFrequency 2000                                      // Control loop interrupt rate, 1000 to 10000 [Hz]
+                                                                        //      The PID keeps ki*dt in Q32, so ki/frequency
+                                                                        //      must be at least 256/2^32 (6e-8) to keep 8
+                                                                        //      bits of the integral gain
+#if motorControlISR                                                     // If the control loop runs from the timer interrupt...
+    #define motorControlPeriod (1000000/motorControlFrequency)          //      Control loop period [us]
+    #define motorObserverMode  OBSERVER_ALPHA_BETA                      //      Fixed-point observer, cheap enough for the ISR
+#else                                                                   // Otherwise...
+    #define motorControlPeriod (update_period*portTICK_PERIOD_MS*1000)  //      Control loop period [us]
+    #define motorObserverMode  OBSERVER_KALMAN                          //      OBSERVER_ALPHA_BETA or OBSERVER_KALMAN
+#endif
+#define motorKp               0.005                                     // Speed controller proportional gain [duty/RPM]
+#define motorKi               0.05                                      // Speed controller integral gain [duty/(RPM*s)]
+#define motorKd               0.0                                       // Speed controller derivative gain [duty*s/RPM]
+#if motorControlISR                                                     // The interrupt rate must leave ki*dt enough bits
+    static_assert (motorKi == 0 || motorKi/motorControlFrequency >= 256.0/4294967296.0,
+                   "motorKi is too small for motorControlFrequency: ki*dt needs at least 8 bits in Q32");
+#endif
+#define motorTuneRelay        30                                        // Auto-tune relay duty cycle on each side of the bias
+#define motorTuneBand         50                                        // Auto-tune hysteresis on each side of the set point [RPM]
+#define motorTuneRule         TUNE_ZIEGLER_NICHOLS                      // Default auto-tune rule
+#define motorMaxAccel         20000                                     // Largest set point acceleration [RPM/s]
+#define motorMaxJerk          100000                                    // Largest set point jerk [RPM/s^2]
+#define motorAccelFF          0.002                                     // Duty cycle needed per RPM/s of acceleration [duty*s/RPM]
+#define motorLoadCutoff       5                                         // Load observer filter cutoff [Hz]
+#define motorLoadGain         1.0                                       // Fraction of the estimated load compensated, 0 to turn it off
+#define motorReverseHold      5                                         // Task runs stopped at zero duty before the direction changes
 
-Queue <int> actualMotorSpeed (30,"Buffer");                             // Create Queue to store current speed calculations
-extern Share <int> speed_SP;                                            // Point to Queue created by user interface tasks
-extern Share <int> maxMotorSpeed;
+SeqShare <int> actualMotorSpeed ("Motor Speed");                        // Create share to store current speed calculations
+SeqShare <int> filteredMotorSpeed ("Filt Speed");                       // Create share to store the observer's filtered speed
+SeqShare <int> motorAcceleration ("Motor Accel");                       // Create share to store the observer's acceleration in RPM/s
+SeqShare <bool> spindleStopped ("Spindle Stop");                        // Create share to flag that no encoder edges are arriving
+Share <bool> discCalibrate ("Disc Cal");                                // Create share for the console to start disc calibration
+SeqShare <int> motorDuty ("Motor Duty");                                // Create share to store the duty cycle output by the controller
+Share <bool> feedForwardSweep ("FF Sweep");                             // Create share for the console to start a feed-forward sweep
+Share <bool> autotuneStart ("Tune Start");                              // Create share for the UI or console to start auto-tuning
+SeqShare <uint8_t> autotuneState ("Tune State");                        // Create share to store the auto-tuner state for the UI
+SeqShare <int> speedReference ("Speed Ref");                            // Create share to store the profiled set point in RPM
+SeqShare <int> timeToSpeed ("Time To Speed");                           // Create share to store the time until at speed in ms
+SeqShare <int> estimatedLoad ("Load Est");                              // Create share to store the estimated load in percent of full duty
+Share <bool> spindleReverse ("Spindle Rev");                            // Create share for the direction, put together with speed_SP
+RingBuffer <encoderEdge, motorEdgeBufferSize> motorEdges ("Motor Edges");   // Create ring buffer of edges from the encoder ISR
+TIMING_PROBE (encoderProbe, "Encoder ISR");                             // Times whichever encoder ISR is attached; $PROBE prints it
+TIMING_PROBE (controlProbe, "Control step");                            // Times each run of the control loop
+TIMING_PROBE (motorTaskProbe, "Motor task");                            // Times each run of the motor task
+extern Share <int> speed_SP;                                            // Point to Share created by user interface tasks
 motorEncoder myMotorEncoder(motorEncoderPinA, motorEncoderPinB);
+captureTimer myCaptureTimer(motorEncoderPinA, motorCaptureFrequency);
+speedEstimator mySpeedEstimator(motorCountsPerRev);
+discCalibration myDiscCalibration(motorCountsPerRev);
+speedObserver mySpeedObserver(motorObserverMode, motorControlPeriod);
+pidController mySpeedController(motorControlPeriod);
+controlTimer myControlTimer(motorControlTimer, motorControlFrequency);
+feedForward myFeedForward(motorControlPeriod);
+relayTuner mySpeedTuner(motorControlPeriod);
+setpointProfile mySetpointProfile(motorControlPeriod);
+gainSchedule myGainSchedule(&mySpeedController);
+disturbanceObserver myLoadObserver(motorControlPeriod);
+pwmInput mySpindleInput(motorPWMInputPin, motorPWMInputRate);
+analogInput myAnalogInput(motorAnalogInputPin);
+MotorDriver* controlDriver = NULL;                                      // Motor driver used by the control loop, set by the motor task
+volatile int32_t controlSetpoint = 0;                                   // Set point in RPM, handed to the control loop by the motor task
+volatile bool controlReverse = false;                                   // Direction, only changed by the motor task while stopped
+volatile bool controlLearnDisc = false;                                 // Set by the motor task to start learning the disc calibration
+volatile bool controlSweep = false;                                     // Set by the motor task to start a feed-forward sweep
+volatile bool controlTune = false;                                      // Set by the motor task to start auto-tuning
+motorTelemetry controlTelemetry;                                        // Results of the control loop step being run
+SeqShare <motorTelemetry> controlResults ("Control Out");               // Results of the latest whole step, for the motor task
+triacDriver* mainsDriver = NULL;                                        // Triac driver, if driving from the mains, for the console
 
 /** @brief   Function called to instantiate a MotorDriver object.
  *  @details This function requires two parameters to instantiate a MotorDriver object.
@@ -37,6 +143,15 @@ MotorDriver::MotorDriver (uint8_t PWM_GPIO, uint8_t direction_GPIO)
     pinMode(direction_pin, OUTPUT);           // Configure the direction pin for output.
 }
 
+/** @brief   Function called by derived motor drivers which set up their own outputs.
+ *  @details The PWM and direction pins aren't used, so they are left unconfigured.
+ */
+MotorDriver::MotorDriver (void)
+{
+    PWM_pin = 0xFF;                           // No PWM pin
+    direction_pin = 0xFF;                     // No direction pin
+}
+
 /** @brief   Function file to output a duty cycle and direction to the motor driver.
  *  @details This function outputs the user-specified PWM duty cycle and direction
  *           to the motor using analogWrite() and digitalWrite(). The direction pin is 
@@ -59,7 +174,18 @@ void MotorDriver::run (int32_t DUTYCYCLE, int32_t DIRECTION)
     }                                           //
 }
 
-/** @brief   An interrupt service routine for calculating the speed of the motor.
+/** @brief   Function to output a duty cycle with a fractional part.
+ *  @details @c analogWrite() only has 256 steps, so the duty cycle is rounded to the
+ *           nearest one. Drivers with finer steps replace this function.
+ *  @param   DUTY_Q8   Fraction of full power, 0 to 255 in 8.8 fixed point
+ *  @param   DIRECTION Level for the direction pin; 0 only while the spindle is reversed
+ */
+void MotorDriver::run_fine (int32_t DUTY_Q8, int32_t DIRECTION)
+{
+    run((DUTY_Q8 + 0x80) >> 8, DIRECTION);      // Round to a whole step
+}
+
+/** @brief   An interrupt service routine for recording edges of the motor encoder.
  *  @details This ISR is triggered by the rising edge of one of the encoder signals.
  *           Each encoder signal outputs a square wave, and each square wave is 90 degrees out of phase.
  *           We determine the direction that the motor is spinning by checking which wave is leading.
@@ -69,23 +195,271 @@ void MotorDriver::run (int32_t DUTYCYCLE, int32_t DIRECTION)
  *           then B should be low, because B toggles HIGH after A does in clockwise rotation.
  *           Therefore, if we read signal B using digitalRead(), then a returned value of 0 would mean that
  *           the motor is in clockwise (forward) rotation, and if it returns a 1, the motor is in counterclockwise
- *           rotation (reverse). After determining the direction of the motor, the ISR updates the encoder to calculate
- *           its speed. The timestamp at the current interrupt is also necessary for this calculation. The Arduino function,
- *           micros() returns the number of microseconds elapsed since the program started. This value is stored in an unsigned
- *           32-bit integer, which means it has the capacity to overflow. In this case, it resets to 0, and we would not want
- *           to calculate the speed of the motor in this case. 
+ *           rotation (reverse). The timestamp at the current interrupt is also necessary for calculating the speed.
+ *           The Arduino function, micros() returns the number of microseconds elapsed since the program started.
+ *           This ISR only puts the timestamp and the state of the signals into a lock-free ring buffer. It never
+ *           blocks, and all of the decoding and speed math is done by the motor task, which drains the buffer
+ *           each time it runs. If the task falls so far behind that the buffer fills, edges are dropped and
+ *           counted rather than blocking the ISR.
  */
 void motorISR ()
 {    
-    uint32_t current_time_stamp = micros();            // Get the current time stamp in microseconds
-    bool direction = digitalRead(motorEncoderPinB);           // Determine the motor's direction by checking signal B
-    myMotorEncoder.update(current_time_stamp, direction);   // Update the encoder to calculate the speed of the motor
-    actualMotorSpeed.put(myMotorEncoder.motorSpeed);
+    PROBE_START(encoderProbe);                              // Time this ISR
+    encoderEdge edge;                                       // Create local variable for the edge
+    edge.timestamp = micros();                              // Get the current time stamp in microseconds
+    edge.signals = digitalRead(motorEncoderPinB)*2 + 1;     // A has just risen; B gives the direction
+    motorEdges.put(edge);                                   // Hand the edge to the motor task
+    PROBE_STOP(encoderProbe);                               //
+}
+
+/** @brief   An interrupt service routine for recording every edge of both encoder signals.
+ *  @details This ISR is attached to both rising and falling edges of A and B when the encoder
+ *           is decoded in 4x mode. Instead of reading B to find the direction, it records both
+ *           signals, so the motor task can compare them with their previous state, which gives
+ *           the direction and four counts for every slot of the encoder disc.
+ */
+void motorQuadratureISR ()
+{
+    PROBE_START(encoderProbe);                                                         // Time this ISR
+    encoderEdge edge;                                                                  // Create local variable for the edge
+    edge.timestamp = micros();                                                         // Get the current time stamp in microseconds
+    edge.signals = digitalRead(motorEncoderPinB)*2 + digitalRead(motorEncoderPinA);    // Read both encoder signals
+    motorEdges.put(edge);                                                              // Hand the edge to the motor task
+    PROBE_STOP(encoderProbe);                                                          //
+}
+
+/** @brief   An interrupt service routine for recording hardware-captured edges of the motor encoder.
+ *  @details This ISR does the same job as @c motorISR(), but it is run by the capture timer
+ *           after the timer has already latched the time of the rising edge of signal A.
+ *           Because the timestamp is taken by hardware, it does not depend on how long the
+ *           processor took to respond to the interrupt. The timestamp is in ticks of the
+ *           capture timer, which the encoder was told about when the timer was started.
+ */
+void motorCaptureISR ()
+{
+    PROBE_START(encoderProbe);                              // Time this ISR
+    encoderEdge edge;                                       // Create local variable for the edge
+    edge.timestamp = myCaptureTimer.read();                 // Get the latched time stamp in timer ticks
+    edge.signals = digitalRead(motorEncoderPinB)*2 + 1;     // A has just risen; B gives the direction
+    motorEdges.put(edge);                                   // Hand the edge to the motor task
+    PROBE_STOP(encoderProbe);                               //
+}
+
+/** @brief   Function that returns the current time in the same ticks as the encoder edges.
+ *  @details Edges are timed either by @c micros() or by the capture timer, and the time
+ *           since the last edge is only meaningful if "now" comes from the same clock.
+ *  @returns The current time, in encoder timestamp ticks
+ */
+uint32_t motorClock ()
+{
+    #if motorSpeedCapture && motorEncoderDecode != 4                                // If edges are timed in hardware...
+        return myCaptureTimer.now();                                                //      Then, read the capture timer
+    #else                                                                           // Otherwise...
+        return micros();                                                            //      Edges are timed by micros()
+    #endif                                                                          //
+}
+
+/** @brief   Function that processes the encoder edges recorded since the last run of the task.
+ *  @details This function takes every edge out of the ring buffer in the order they happened,
+ *           decodes it into the encoder position, and records it for the M/T speed estimate.
+ *           It then closes the M/T window and returns the new speed estimate. It is called
+ *           from the motor task, so none of this work adds to the time spent in the ISR.
+ *           The time is read before the buffer is drained, so every edge taken out is older
+ *           than it; an edge which the ISR adds while draining can only make the time since
+ *           the last edge look negative, which the estimator ignores. If the ISR had to drop
+ *           edges because the buffer was full, the count has slipped against the encoder disc,
+ *           so the disc calibration table is aligned again.
+ *  @returns The estimated speed in RPM, negative in reverse
+ */
+int32_t processMotorEdges ()
+{
+    static uint32_t dropped = 0;                                                    // Edges the ring had dropped by the last run
+    uint32_t now = motorClock();                                                    // Time the window closes, before draining
+    if (motorEdges.dropped() != dropped)                                            // If edges were lost since the last run...
+    {                                                                               //
+        dropped = motorEdges.dropped();                                             //      Then, the count no longer lines up with the disc
+        myDiscCalibration.realign();                                                //
+    }                                                                               //
+    encoderEdge edge;                                                               // Create local variable for each edge
+    while (motorEdges.get(edge))                                                    // While there are edges waiting...
+    {                                                                               //
+        #if motorEncoderDecode == 4                                                 //      If decoding every edge of both signals...
+            myMotorEncoder.update_quadrature(edge.signals);                         //          Then, decode the transition
+        #else                                                                       //      Otherwise...
+            myMotorEncoder.update(edge.signals >> 1);                               //          B gives the direction
+        #endif                                                                      //
+        mySpeedEstimator.edge(edge.timestamp, myMotorEncoder.position());           //      Record the edge for the M/T estimate
+    }                                                                               //
+    return mySpeedEstimator.sample(now);                                            // Estimate the speed over the last window
 }
 
-/** @brief   Task which interacts with a user. 
- *  @details This task demonstrates how to use a FreeRTOS task for interacting
- *           with some user while other more important things are going on.
+/** @brief   Function that runs one step of the spindle speed control loop.
+ *  @details Each step measures the speed, moves the reference speed toward the set point
+ *           and works out the duty cycle, in that order; the comments at each stage below
+ *           say how. The motor is driven in direction 1, its usual direction, or in
+ *           direction 0 while @c controlReverse is set. Which way direction 1 counts
+ *           depends on how the encoder is wired, so the stages after the measurement only
+ *           deal with the magnitude of the speed.
+ *
+ *           This is run either by the motor task or by the control timer interrupt, so it
+ *           doesn't touch any shares which disable interrupts. The set point comes in
+ *           through @c controlSetpoint, and the results are gathered in
+ *           @c controlTelemetry and put whole into @c controlResults, a sequence-locked
+ *           share which is safe to write from an ISR; the motor task copies both to and
+ *           from the other shares.
+ */
+void motorControlStep ()
+{
+    PROBE_START(controlProbe);                                                  // Time this step
+    if (controlLearnDisc)                                                       // If the disc calibration should start...
+    {                                                                           //
+        controlLearnDisc = false;                                               //      Then, start it here, between edges
+        myDiscCalibration.learn();                                              //
+    }                                                                           //
+    if (controlSweep)                                                           // If a feed-forward sweep should start...
+    {                                                                           //
+        controlSweep = false;                                                   //      Then, sweep the whole duty cycle range
+        myFeedForward.start_sweep(255, FF_MAX_POINTS);                          //
+    }                                                                           //
+    // While a CNC controller is setting the speed, its set point is read straight from
+    // the input, so it takes effect at this step rather than after the next task run
+    int32_t setpoint = controlSetpoint;                                         // Read the set point in RPM once
+    #if motorPWMInput                                                           // If a CNC controller can set the speed...
+        if (mySpindleInput.state == PWM_IN_OK)                                  //      Then, if it is, take it straight from the input
+        {                                                                       //
+            setpoint = mySpindleInput.setpoint;                                 //
+        }                                                                       //
+        else if (mySpindleInput.state == PWM_IN_LOST)                           //      If its signal has been lost...
+        {                                                                       //
+            setpoint = 0;                                                       //          Stop until the motor task has caught up
+        }                                                                       //
+    #elif motorAnalogInput                                                      // Else if it sets the speed with a voltage...
+        setpoint = myAnalogInput.setpoint;                                      //      Then, take it straight from the input
+    #endif                                                                      //
+    if (controlTune)                                                            // If auto-tuning should start...
+    {                                                                           //
+        controlTune = false;                                                    //      Then, run the relay around the last duty cycle
+        mySpeedTuner.start(setpoint, controlTelemetry.duty, motorTuneRelay, motorTuneBand, 255);
+    }                                                                           //
+
+    // The encoder edges are processed in one batch and the M/T window is closed once per
+    // step, so the estimate is updated at the loop rate however fast the edges arrive.
+    // The observer filters it and estimates the acceleration; once the edges stop, it is
+    // started over at rest, so its speed drops to zero as quickly as the raw estimate
+    int32_t measuredSpeed = processMotorEdges();                                // Measure the speed over the last window
+    if (mySpeedEstimator.stopped)                                               // If the spindle has stopped...
+    {                                                                           //
+        mySpeedObserver.reset(0);                                               //      Then, the observer is at rest too
+    }                                                                           //
+    else                                                                        // Otherwise...
+    {                                                                           //
+        mySpeedObserver.update(measuredSpeed, mySpeedEstimator.updated);        //      Run the observer, with or without a new measurement
+    }                                                                           //
+
+    // The profile moves the reference toward the set point within the acceleration and
+    // jerk limits, so a step in the set point becomes an S-curve. Whenever it isn't in
+    // use it starts over at the present speed, so the next ramp starts from there
+    int32_t speed = abs(mySpeedObserver.speed);                                 // Speed in the direction being driven
+    int32_t acceleration = (mySpeedObserver.speed < 0) ? -mySpeedObserver.acceleration // Acceleration in the direction being driven
+                                                       : mySpeedObserver.acceleration; //
+    int32_t reference = setpoint;                                               // Reference speed for the controller
+    if (myFeedForward.sweeping || mySpeedTuner.state == TUNE_RUNNING || setpoint <= 0) // If the profile isn't in use...
+    {                                                                           //
+        mySetpointProfile.reset(speed);                                         //      Then, ramp from the present speed later
+    }                                                                           //
+    else                                                                        // Otherwise...
+    {                                                                           //
+        reference = mySetpointProfile.update(setpoint);                         //      Move the reference toward the set point
+    }                                                                           //
+
+    // The feed-forward table gives the duty cycle which should hold the reference speed,
+    // plus motorAccelFF times the reference acceleration for the torque needed to change
+    // speed. A sweep or the auto-tuner's relay can set the duty cycle instead, and a zero
+    // set point switches the motor off; the controller and the load observer are held
+    // reset meanwhile, so they carry on without a bump when the controller takes over
+    int32_t accel_ff = ((int64_t)mySetpointProfile.acceleration()               // Duty cycle for the reference acceleration
+                        *(int32_t)(motorAccelFF*65536)) >> 16;                  //
+    int32_t feed_forward = constrain(myFeedForward.duty(reference) + accel_ff, 0, 255); // Duty cycle which should follow the reference
+    int32_t duty;                                                               //
+    int32_t fraction = 0;                                                       // Part of a step finer drivers can add to the duty cycle, 1/256ths
+    if (myFeedForward.sweeping)                                                 // If a feed-forward sweep is running...
+    {                                                                           //
+        duty = myFeedForward.sweep(speed);                                      //      Then, it sets the duty cycle
+        myLoadObserver.reset();                                                 //      The load can't be told from the sweep
+        mySpeedController.reset(0, speed, 0);                                   //      The controller starts over afterwards
+    }                                                                           //
+    else if (setpoint <= 0)                                                     // Else if the motor should be off...
+    {                                                                           //
+        mySpeedTuner.abort();                                                   //      Then, there is nothing to tune around
+        mySpeedController.reset(0, speed, 0);                                   //      Hold the controller at zero output
+        myLoadObserver.reset();                                                 //      Nothing to push back against
+        duty = 0;                                                               //
+    }                                                                           //
+    else if (mySpeedTuner.state == TUNE_RUNNING)                                // Else if auto-tuning...
+    {                                                                           //
+        duty = mySpeedTuner.step(speed);                                        //      Then, the relay sets the duty cycle
+        if (mySpeedTuner.state == TUNE_DONE)                                    //      If it has just found new gains...
+        {                                                                       //
+            mySpeedController.set_gains(mySpeedTuner.kp, mySpeedTuner.ki, mySpeedTuner.kd); //  Then, use them
+            myGainSchedule.set_fallback(mySpeedTuner.kp, mySpeedTuner.ki, mySpeedTuner.kd); //  Whenever there's no schedule
+        }                                                                       //
+        mySpeedController.set_limits(-feed_forward, 255 - feed_forward);        //      Carry on from the relay afterwards
+        mySpeedController.reset(setpoint, speed, duty - feed_forward);          //
+        myLoadObserver.reset();                                                 //      Tune without the load observer
+    }                                                                           //
+    else                                                                        // Otherwise...
+    {                                                                           //
+        // The load observer compares the duty cycle applied over the last step with
+        // what the table and the acceleration account for, and its compensation is
+        // added to the feed-forward duty cycle, so a cutting load is pushed back against
+        // before the speed error builds up. The PID controller, with gains looked up
+        // from the schedule at this speed, corrects whatever is left, within limits that
+        // keep the sum within the range of the driver
+        if (myFeedForward.ready)                                                //      If there is a table to compare against...
+        {                                                                       //
+            myLoadObserver.update(controlTelemetry.duty, myFeedForward.duty(speed), acceleration); // Estimate the load
+        }                                                                       //
+        else                                                                    //      Otherwise...
+        {                                                                       //
+            myLoadObserver.reset();                                             //          The whole duty cycle would look like load
+        }                                                                       //
+        int32_t bias = constrain(feed_forward + myLoadObserver.compensation(), 0, 255); //  Cancel it
+        mySpeedController.set_gains(myGainSchedule.lookup(speed));              //      Use the gains for this speed
+        mySpeedController.set_limits(-bias, 255 - bias);                        //      Leave the controller the rest of the range
+        duty = bias + mySpeedController.update(reference, speed);               //      Add the controller's correction
+        fraction = (mySpeedController.output_q16 >> 8)                          //      Keep what rounding the correction left off
+                   - mySpeedController.output*256;                              //
+    }                                                                           //
+    controlDriver->run_fine(duty*256 + fraction, controlReverse ? 0 : 1);       // Drive the motor; 0 only while reversed
+
+    controlTelemetry.measured = measuredSpeed;                                  // Hand the results to the motor task
+    controlTelemetry.filtered = mySpeedObserver.speed;                          //
+    controlTelemetry.acceleration = mySpeedObserver.acceleration;               //
+    controlTelemetry.duty = duty;                                               //
+    controlTelemetry.stopped = mySpeedEstimator.stopped;                        //
+    controlTelemetry.reference = reference;                                     //
+    controlTelemetry.reference_accel = mySetpointProfile.acceleration();        //
+    controlTelemetry.load = myLoadObserver.load;                                //
+    controlResults.ISR_put(controlTelemetry);                                   // Publish them all at once
+    PROBE_STOP(controlProbe);                                                   //
+}
+
+/** @brief   Task which runs the motor.
+ *  @details This task sets up the encoder, the speed measurement and the motor driver.
+ *           Then, each time it runs, it passes the set point and any request to calibrate
+ *           the encoder disc, sweep the feed-forward table or auto-tune to the control
+ *           loop, and copies the control loop's results into shares for the other tasks,
+ *           along with the estimated time until the spindle is at speed.
+ *
+ *           If @c motorControlISR is 0, this task also runs the control loop itself, at
+ *           the task rate. If it is 1, the control loop is run by a hardware timer
+ *           interrupt at @c motorControlFrequency instead, so its period doesn't depend on
+ *           the RTOS tick or on what other tasks are doing.
+ *
+ *           The direction is only changed with the spindle at rest. When a new direction
+ *           is asked for, the set point is held at zero until the spindle has stopped with
+ *           the motor off for @c motorReverseHold task runs in a row, so the motor is never
+ *           driven against a spindle which is still coasting.
  *  @param   p_params A pointer to function parameters which we don't use.
  */
 void task_MotorStuff (void* p_params)
@@ -94,26 +468,152 @@ void task_MotorStuff (void* p_params)
     // Initialise the xLastWakeTime variable with the current time.
     // It will be used to run the task at precise intervals
     TickType_t xLastWakeTime = xTaskGetTickCount();  
+    uint8_t reverse_hold = 0;                                                   // Task runs at rest since a new direction was asked for
     // Set the timeout for reading from the serial port to the maximum
     // possible value, essentially forever for a real-time control program
-    attachInterrupt(digitalPinToInterrupt(motorEncoderPinA), motorISR, RISING); // Attach interrupt for change of A
-    int currentSpeedSP;
-    int maxSpeed;
-
-    maxMotorSpeed.get(maxSpeed);
-    MotorDriver myMotorDriver(motorPWMpin, motorDIRpin);                        // Instantiate MotorDriver object with desired pins
+    #if motorEncoderDecode == 4                                                 // If decoding every edge of both signals...
+        myMotorEncoder.reset_quadrature(digitalRead(motorEncoderPinB)*2         //      Then, start from the current state
+                                        + digitalRead(motorEncoderPinA));       //
+        attachInterrupt(digitalPinToInterrupt(motorEncoderPinA), motorQuadratureISR, CHANGE); // Attach interrupt for change of A
+        attachInterrupt(digitalPinToInterrupt(motorEncoderPinB), motorQuadratureISR, CHANGE); // Attach interrupt for change of B
+    #elif motorSpeedCapture                                                     // Else if edges are timed in hardware...
+        myCaptureTimer.begin(motorCaptureISR);                                  //      Then, start the capture timer on A
+        mySpeedEstimator.configure(motorCountsPerRev, myCaptureTimer.frequency()); //   Tell the estimator what its timestamps mean
+    #else                                                                       // Otherwise...
+        attachInterrupt(digitalPinToInterrupt(motorEncoderPinA), motorISR, RISING); //  Attach interrupt for change of A
+    #endif
+    myDiscCalibration.load();                                                   // Use the saved disc calibration, if there is one
+    mySpeedEstimator.use_calibration(&myDiscCalibration);                       // Correct each edge period for its slot width
+    discCalibrate.put(false);                                                   // Not calibrating yet
+    #if motorTriacDrive                                                         // If running from AC mains...
+        triacDriver myMotorDriver(motorGatePin, motorZeroCrossPin, motorTriacTimer, motorMainsFrequency); // Then, fire a triac
+        myMotorDriver.set_mode(motorTriacMode);                                 //      Choose how to fire it
+        myMotorDriver.begin();                                                  //      Start following the zero crossings
+        mainsDriver = &myMotorDriver;                                           //      Let the console see it
+    #elif motorFinePWM                                                          // Else if writing the compare register directly...
+        pwmDriver myMotorDriver(motorPWMpin, motorDIRpin, motorPWMFrequency);   //      Then, set up the timer once
+    #else                                                                       // Otherwise...
+        MotorDriver myMotorDriver(motorPWMpin, motorDIRpin);                    //      Instantiate MotorDriver object with desired pins
+    #endif                                                                      //
     myMotorDriver.run(0,0);
+    mySpeedController.set_gains(motorKp, motorKi, motorKd);                     // Set up the speed controller
+    mySpeedController.set_limits(0, 255);                                       // Same range as MotorDriver::run()
+    myGainSchedule.set_fallback(motorKp, motorKi, motorKd);                     // Fixed gains for when there's no schedule
+    myGainSchedule.load();                                                      // Use the saved gain schedule, if there is one
+    myLoadObserver.set_inertia(motorAccelFF);                                   // Set up the load observer
+    myLoadObserver.set_cutoff(motorLoadCutoff);                                 //
+    myLoadObserver.set_gain(motorLoadGain);                                     //
+    myFeedForward.load();                                                       // Use the saved feed-forward table, if there is one
+    feedForwardSweep.put(false);                                                // Not sweeping yet
+    mySetpointProfile.set_limits(motorMaxAccel, motorMaxJerk);                  // Set up the set point profile
+    mySpeedTuner.rule = motorTuneRule;                                          // Choose the default tuning rule
+    autotuneStart.put(false);                                                   // Not tuning yet
+    #if motorPWMInput                                                           // If a CNC controller can set the speed...
+        mySpindleInput.set_point(0, 0);                                         //      Then, map its duty cycle to speed
+        mySpindleInput.set_point(1000, motorPWMInputMaxRPM);                    //
+        mySpindleInput.begin();                                                 //      Start following its signal
+    #elif motorAnalogInput                                                      // Else if it sets the speed with a voltage...
+        myAnalogInput.set_scale(motorAnalogMaxRPM);                             //      Then, map the voltage to speed
+        myAnalogInput.set_deadband(motorAnalogDeadband);                        //
+        if (!myAnalogInput.begin())                                             //      Start converting; if it didn't start...
+        {                                                                       //
+            Serial << "Analog input didn't start; its pin must be on ADC1" << endl; //  Then, say so
+        }                                                                       //
+    #endif                                                                      //
+    controlDriver = &myMotorDriver;                                             // Give the control loop the motor driver
+    controlResults.put(controlTelemetry);                                       // No step has run yet; start from all zeros
+    #if motorControlISR                                                         // If the control loop runs from the timer...
+        myControlTimer.begin(motorControlStep);                                 //      Then, start the timer
+    #endif                                                                      //
     Serial.setTimeout (0xFFFFFFFF);
     // The task's infinite loop goes here
     for (;;)
     {
-        speed_SP.get(currentSpeedSP);
-        currentSpeedSP = currentSpeedSP*255/325;
-        myMotorDriver.run(currentSpeedSP,1);
+        PROBE_START(motorTaskProbe);                                            // Time this run, and how late it started
+        bool calibrate;                                                         // Pass on a request to learn the disc
+        discCalibrate.get(calibrate);                                           //
+        if (calibrate)                                                          //
+        {                                                                       //
+            discCalibrate.put(false);                                           //
+            controlLearnDisc = true;                                            //
+        }                                                                       //
+        bool sweep;                                                             // Pass on a request to sweep the duty cycle
+        feedForwardSweep.get(sweep);                                            //
+        if (sweep)                                                              //
+        {                                                                       //
+            feedForwardSweep.put(false);                                        //
+            controlSweep = true;                                                //
+        }                                                                       //
+        bool tune;                                                              // Pass on a request to auto-tune
+        autotuneStart.get(tune);                                                //
+        if (tune)                                                               //
+        {                                                                       //
+            autotuneStart.put(false);                                           //
+            controlTune = true;                                                 //
+        }                                                                       //
+        #if motorPWMInput                                                       // If a CNC controller can set the speed...
+            if (mySpindleInput.state == PWM_IN_OK)                              //      Then, if it is, show its set point
+            {                                                                   //
+                speed_SP.put(mySpindleInput.setpoint);                          //
+            }                                                                   //
+            else if (mySpindleInput.state == PWM_IN_LOST)                       //      If its signal has been lost...
+            {                                                                   //
+                speed_SP.put(0);                                                //          Stop the spindle
+                controlSetpoint = 0;                                            //
+                mySpindleInput.clear();                                         //          Give the set point back to the user
+            }                                                                   //
+        #elif motorAnalogInput                                                  // Else if it sets the speed with a voltage...
+            speed_SP.put(myAnalogInput.setpoint);                               //      Then, show its set point
+        #endif                                                                  //
+        int currentSpeedSP;                                                     // Pass on the set point
+        bool reverse;                                                           //
+        portENTER_CRITICAL();                                                   // Take the direction with the set point it came with
+        speed_SP.get(currentSpeedSP);                                           //
+        spindleReverse.get(reverse);                                            //
+        portEXIT_CRITICAL();                                                    //
+        motorTelemetry telemetry;                                               // Results of the latest whole control step
+        controlResults.get(telemetry);                                          //
+        if (reverse != controlReverse)                                          // If the direction has changed...
+        {                                                                       //
+            currentSpeedSP = 0;                                                 //      Then, stop the spindle first
+            if (telemetry.stopped && telemetry.duty == 0)                       //      If it has stopped with the motor off...
+            {                                                                   //
+                reverse_hold ++;                                                //          Count how long it has stayed that way
+            }                                                                   //
+            else                                                                //      Otherwise...
+            {                                                                   //
+                reverse_hold = 0;                                               //          Start counting over
+            }                                                                   //
+            if (reverse_hold >= motorReverseHold)                               //      Once it has been at rest long enough...
+            {                                                                   //
+                controlReverse = reverse;                                       //          Turn it around, still at zero this run
+                reverse_hold = 0;                                               //
+            }                                                                   //
+        }                                                                       //
+        else                                                                    //
+        {                                                                       //
+            reverse_hold = 0;                                                   //
+        }                                                                       //
+        controlSetpoint = currentSpeedSP;                                       //
+        #if !motorControlISR                                                    // If the control loop runs from this task...
+            motorControlStep();                                                 //      Then, measure the speed and drive the motor
+        #endif                                                                  //
+
+        controlResults.get(telemetry);                                          // Take the results of one whole step
+        spindleStopped.put(telemetry.stopped);                                  // Share the stopped flag before the speeds
+        actualMotorSpeed.put(telemetry.measured);                               // Share the results with other tasks
+        filteredMotorSpeed.put(telemetry.filtered);                             //
+        motorAcceleration.put(telemetry.acceleration);                          //
+        motorDuty.put(telemetry.duty);                                          //
+        autotuneState.put(controlTune ? TUNE_RUNNING : mySpeedTuner.state);     // A tune which hasn't started yet counts as running
+        speedReference.put(telemetry.reference);                                // Share the profiled set point
+        timeToSpeed.put(mySetpointProfile.time_remaining(currentSpeedSP, telemetry.reference, telemetry.reference_accel));
+        estimatedLoad.put(telemetry.load*100/255);                              // Share the load as a percentage
+        PROBE_STOP(motorTaskProbe);                                             //
 
         // This type of delay waits until the given number of RTOS ticks have
         // elapsed since the task previously began running. This prevents 
         // inaccuracy due to not accounting for how long the task took to run
         vTaskDelayUntil (&xLastWakeTime, update_period);
     }
-}
\ No newline at end of file
+}
@@ -14,7 +14,11 @@
 
 /// Class Definitions
 /** @brief   Defines the class for the MotorDriver.
- *  @details This class has 2 protected attributes and two public functions.
+ *  @details This class has 2 protected attributes and two public functions. It drives
+ *           the motor with PWM; other ways of driving it, such as phase-angle control of a
+ *           triac, are derived from it and replace @c run(), so the control loop can use any
+ *           of them through a pointer to this class. Drivers with more than 256 duty cycle
+ *           steps also replace @c run_fine().
  */
 class MotorDriver {
     protected:
@@ -22,9 +26,28 @@ class MotorDriver {
         uint8_t PWM_pin;
         /// Direction pin
         uint8_t direction_pin;
+        MotorDriver (void);                                         // Format for derived drivers which don't use the pins
     public:
         MotorDriver (uint8_t PWM_GPIO, uint8_t direction_GPIO);     // Format for instantiating a motor driver object
-        void run (int32_t DUTYCYCLE, int32_t DIRECTION);            // Function format for getting the signal status
+        virtual void run (int32_t DUTYCYCLE, int32_t DIRECTION);    // Function format for getting the signal status
+        virtual void run_fine (int32_t DUTY_Q8, int32_t DIRECTION); // Function format for a duty cycle with 8 fractional bits
+};
+
+/** @brief   Results of one step of the motor control loop.
+ *  @details The control loop may run in an ISR, so it fills one of these in and puts
+ *           the whole thing in a sequence-locked share, which never disables interrupts.
+ *           The motor task gets it back and copies it into the other shares, so every
+ *           result it hands on comes from the same step.
+ */
+struct motorTelemetry {
+    int32_t measured;                                                       // Speed measured by the M/T estimator [RPM]
+    int32_t filtered;                                                       // Speed filtered by the observer [RPM]
+    int32_t acceleration;                                                   // Acceleration from the observer [RPM/s]
+    int32_t duty;                                                           // Duty cycle output to the motor driver
+    bool stopped;                                                           // True if the encoder edges have stopped
+    int32_t reference;                                                      // Reference speed from the set point profile [RPM]
+    int32_t reference_accel;                                                // Reference acceleration from the profile [RPM/s]
+    int32_t load;                                                           // Load estimated by the disturbance observer [duty cycle]
 };
 
 /// Task functions
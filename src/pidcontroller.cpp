@@ -0,0 +1,128 @@
+/** @file pidcontroller.cpp
+ *    This file contains the implementation of the fixed-point PID controller.
+ *
+ *  @date 2026-Oct-16
+ */
+
+#include "pidcontroller.h"                                              // Include corresponding header file
+
+/** @brief   Function called to instantiate a PID controller object.
+ *  @details The controller starts with all gains zero and an output range of 0 to 255,
+ *           which is the range of @c MotorDriver::run().
+ *  @param   update_period_us Time between calls to @c update(), in microseconds
+ */
+pidController::pidController (uint32_t update_period_us)
+{
+    dt = update_period_us/1000000.0f;           // Period in seconds
+    kp_q16 = 0;                                 // Initialize to 0
+    ki_dt_q32 = 0;                              // Initialize to 0
+    kd_dt_q16 = 0;                              // Initialize to 0
+    error = 0;                                  // Initialize to 0
+    set_limits(0, 255);                         // Default to the range of MotorDriver::run()
+    reset(0, 0, 0);                             // Start at rest
+}
+
+/** @brief   Function that converts gains into the form the controller uses.
+ *  @details The gains are converted to fixed point here, with the period folded into the
+ *           integral and derivative gains, so @c update() doesn't use floats. Each is rounded
+ *           to the nearest step rather than truncated. The integral gain times the period is
+ *           far below one, 0.05 times 100 us for example, so it gets Q32 instead of Q16. This
+ *           doesn't change the controller, so gains can be converted ahead of time, for
+ *           example for a table.
+ *  @param   kp Proportional gain, in output units per input unit
+ *  @param   ki Integral gain, in output units per input unit per second
+ *  @param   kd Derivative gain, in output units per input unit per second of change
+ *  @returns The gains in controller form
+ */
+pidGains pidController::scale (float kp, float ki, float kd)
+{
+    pidGains gains;                                                 //
+    gains.kp_q16 = lround(kp*65536.0);                              // Convert to Q16
+    gains.ki_dt_q32 = llround(ki*(double)dt*4294967296.0);          // Multiply by the period once, here, in Q32
+    gains.kd_dt_q16 = lround(kd/(double)dt*65536.0);                // Divide by the period once, here
+    return gains;
+}
+
+/** @brief   Function that sets the gains of the controller.
+ *  @param   kp Proportional gain, in output units per input unit
+ *  @param   ki Integral gain, in output units per input unit per second
+ *  @param   kd Derivative gain, in output units per input unit per second of change
+ */
+void pidController::set_gains (float kp, float ki, float kd)
+{
+    set_gains(scale(kp, ki, kd));                                   // Convert, then use them
+}
+
+/** @brief   Function that sets the gains of the controller from gains in controller form.
+ *  @details The proportional part of the output changes with the new gain, so the integral
+ *           is changed by the opposite amount, and the output doesn't jump. The integral is
+ *           kept in output units, so a new integral gain only changes how fast it grows from
+ *           now on. This only uses integer math, so it can be called every step, for example
+ *           to follow a gain schedule.
+ *  @param   gains The gains, from @c scale()
+ */
+void pidController::set_gains (const pidGains& gains)
+{
+    integral_q32 += (int64_t)(kp_q16 - gains.kp_q16)*error*65536;   // Keep the output where it was
+    kp_q16 = gains.kp_q16;                                          //
+    ki_dt_q32 = gains.ki_dt_q32;                                    //
+    kd_dt_q16 = gains.kd_dt_q16;                                    //
+}
+
+/** @brief   Function that sets the range of the output.
+ *  @param   minimum Smallest output allowed
+ *  @param   maximum Largest output allowed
+ */
+void pidController::set_limits (int32_t minimum, int32_t maximum)
+{
+    output_min = minimum;                       // Save the parameter, which will evaporate when the function exits
+    output_max = maximum;                       // Save the parameter, which will evaporate when the function exits
+}
+
+/** @brief   Function that starts the controller without bumping the output.
+ *  @details The integral is set so that the first update, with the same set point and
+ *           measurement, gives exactly @c current_output. Call this when switching from
+ *           open-loop to closed-loop control, with the duty cycle that was being output.
+ *  @param   setpoint       The set point the controller will start with
+ *  @param   measurement    The measurement the controller will start with
+ *  @param   current_output The output to carry on from
+ */
+void pidController::reset (int32_t setpoint, int32_t measurement, int32_t current_output)
+{
+    error = setpoint - measurement;                                         // Units of input
+    previous_measurement = measurement;                                     // No change in measurement yet
+    integral_q32 = (int64_t)current_output*Q32_ONE - (int64_t)kp_q16*error*65536; // Make up what the proportional term doesn't give
+    integral_q32 = constrain(integral_q32, (int64_t)output_min*Q32_ONE, (int64_t)output_max*Q32_ONE); //
+    output = constrain(current_output, output_min, output_max);             //
+    output_q16 = output*65536;                                              //
+}
+
+/** @brief   Function that runs one step of the controller.
+ *  @details This function must be called once per period. If the output would be past a
+ *           limit and the error is pushing it further, the integral is left alone for this
+ *           step, which is the clamping kind of anti-windup.
+ *  @param   setpoint    The speed wanted
+ *  @param   measurement The measured speed
+ *  @returns The output, between the limits
+ */
+int32_t pidController::update (int32_t setpoint, int32_t measurement)
+{
+    error = setpoint - measurement;                                             // Units of input
+    int64_t proportional = (int64_t)kp_q16*error*65536;                         // Q32 output units
+    int64_t derivative = -(int64_t)kd_dt_q16*(measurement - previous_measurement)*65536; // Derivative on measurement, not error
+    previous_measurement = measurement;                                         //
+    int64_t min_q32 = (int64_t)output_min*Q32_ONE;                              // Limits in Q32
+    int64_t max_q32 = (int64_t)output_max*Q32_ONE;                              //
+    int64_t step = ki_dt_q32*error;                                             // Change in the integral this period
+    int64_t total = proportional + integral_q32 + step + derivative;            // Output if the integral is updated
+    if (!((total > max_q32 && step > 0) || (total < min_q32 && step < 0)))      // Unless that winds up against a limit...
+    {                                                                           //
+        integral_q32 += step;                                                   //      Update the integral
+        integral_q32 = constrain(integral_q32, min_q32, max_q32);               //      Keep it within the limits on its own
+    }                                                                           //
+    total = proportional + integral_q32 + derivative;                           // Add up the terms
+    output_q16 = constrain(total, min_q32, max_q32) >> 16;                      // Clamp to the limits, keeping the fraction
+    total = (total + Q32_ONE/2) >> 32;                                          // Round back to output units
+    output = constrain(total, (int64_t)output_min, (int64_t)output_max);        // Clamp to the limits
+    return output;
+}
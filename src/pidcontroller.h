@@ -0,0 +1,70 @@
+/** @file pidcontroller.h
+ *    This file contains the class definition for a fixed-point PID controller
+ *    which holds the spindle speed at its set point.
+ *  @date 2026-Oct-16
+ */
+
+#ifndef PIDCONTROLLER_H
+#define PIDCONTROLLER_H
+#include <Arduino.h>
+#include <PrintStream.h>
+#if (defined STM32L4xx || defined STM32F4xx)
+    #include <STM32FreeRTOS.h>
+#endif
+
+#define Q32_ONE 4294967296LL                    // 1.0 in Q32
+
+/** @brief   Holds a set of PID gains in the form the controller uses them.
+ *  @details The gains are fixed point, with the period already folded into the integral and
+ *           derivative gains, so handing a set to the controller needs no floats. The integral
+ *           gain times the period is tiny at high control rates, so it is kept in Q32.
+ */
+struct pidGains {
+    int32_t kp_q16;                                                 // Proportional gain, Q16
+    int64_t ki_dt_q32;                                              // Integral gain times the period, Q32
+    int32_t kd_dt_q16;                                              // Derivative gain divided by the period, Q16
+};
+
+/** @brief   Defines the class for a fixed-point PID controller.
+ *  @details The controller compares the set point with the measured speed and works out
+ *           the duty cycle that drives the error to zero. It runs at a fixed period, so the
+ *           integral and derivative gains are multiplied and divided by the period once, when
+ *           they are set, and each update is only integer multiplies and adds. The gains are
+ *           rounded to Q16, except the integral gain times the period, which is rounded to
+ *           Q32 so that it keeps its precision even at 10 kHz, and the integral is kept in Q32
+ *           output units, so even when the output only has 256 steps, small errors still add
+ *           up in the integral. The output is also kept unrounded in @c output_q16, for
+ *           drivers which can use the fraction.
+ *
+ *           Three details keep the output well behaved. The derivative is taken of the
+ *           measurement rather than the error, so a step in the set point doesn't kick the
+ *           output. The integral stops growing while the output is clamped at a limit in the
+ *           direction the error is pushing it, and is itself kept within the limits, so it
+ *           doesn't wind up while the motor can't keep up. And @c reset() and @c set_gains()
+ *           adjust the integral so that the output carries on from where it was, so switching
+ *           the controller on or changing its gains doesn't bump the motor.
+ */
+class pidController {
+    protected:
+        int32_t kp_q16;                                             // Proportional gain, output units per input unit, Q16
+        int64_t ki_dt_q32;                                          // Integral gain times the period, Q32
+        int32_t kd_dt_q16;                                          // Derivative gain divided by the period, Q16
+        int64_t integral_q32;                                       // Integral term in output units, Q32
+        int32_t previous_measurement;                               // Measurement at the last update
+        int32_t output_min;                                         // Smallest output allowed
+        int32_t output_max;                                         // Largest output allowed
+        float dt;                                                   // The period in seconds
+    public:
+        int32_t error;                                              // Set point minus measurement at the last update
+        int32_t output;                                             // Output from the last update
+        int32_t output_q16;                                         // Output from the last update before rounding, Q16
+        pidController (uint32_t update_period_us);                  // Format for instantiating a PID controller object
+        pidGains scale (float kp, float ki, float kd);              // Function format for converting gains to controller form
+        void set_gains (float kp, float ki, float kd);              // Function format for setting the gains
+        void set_gains (const pidGains& gains);                     // Function format for setting gains in controller form
+        void set_limits (int32_t minimum, int32_t maximum);         // Function format for setting the output range
+        void reset (int32_t setpoint, int32_t measurement, int32_t current_output); // Function format for a bumpless start
+        int32_t update (int32_t setpoint, int32_t measurement);     // Function format for running one controller step
+};
+
+#endif // PIDCONTROLLER_H
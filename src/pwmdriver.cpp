@@ -0,0 +1,89 @@
+/** @file pwmdriver.cpp
+ *    This file contains the implementation of the high-resolution PWM motor driver.
+ *
+ *  @date 2026-Oct-16
+ */
+
+#include "pwmdriver.h"                                                  // Include corresponding header file
+
+/** @brief   Function called to instantiate a PWM driver object.
+ *  @details This function finds the timer and channel the PWM pin belongs to, puts the
+ *           channel in PWM mode on the pin, sets the carrier frequency and starts the timer
+ *           with the motor off. The motor task instantiates the driver, so the timer library
+ *           is only used once the scheduler has started.
+ *  @param   PWM_GPIO       The PWM output pin, which must be connected to a timer channel
+ *  @param   direction_GPIO The direction output pin
+ *  @param   frequency_hz   The PWM carrier frequency
+ */
+pwmDriver::pwmDriver (uint8_t PWM_GPIO, uint8_t direction_GPIO, uint32_t frequency_hz)
+    : MotorDriver(PWM_GPIO, direction_GPIO)
+{
+    PinName pin_name = digitalPinToPinName(PWM_pin);                                        // Convert the Arduino pin to an STM32 pin name
+    TIM_TypeDef* instance = (TIM_TypeDef*)pinmap_peripheral(pin_name, PinMap_PWM);          // Find the timer connected to the pin
+    channel = STM_PIN_CHANNEL(pinmap_function(pin_name, PinMap_PWM));                       // Find the channel connected to the pin
+    compare = &instance->CCR1 + (channel - 1);                                              // The compare registers are in channel order
+    direction = -1;                                                                         // Direction not written yet
+    duty_q8 = 0;                                                                            // Off
+    timer = new HardwareTimer(instance);                                                    // Create the timer object
+    timer->setMode(channel, TIMER_OUTPUT_COMPARE_PWM1, PWM_pin);                            // High until the compare value, then low
+    set_frequency(frequency_hz);                                                            // Set the period
+    timer->resume();                                                                        // Start counting
+}
+
+/** @brief   Function that sets the PWM carrier frequency.
+ *  @details The timer library picks the smallest prescaler that fits the period into 16
+ *           bits, which leaves the most counts, and so the finest duty cycle, in a period.
+ *           The duty cycle being output is kept.
+ *  @param   frequency_hz The PWM carrier frequency
+ */
+void pwmDriver::set_frequency (uint32_t frequency_hz)
+{
+    timer->setOverflow(frequency_hz, HERTZ_FORMAT);                                         // Set the prescaler and the period
+    top = timer->getOverflow(TICK_FORMAT);                                                  // Counts in one period
+    *compare = (duty_q8*top + PWM_DUTY_FULL/2)/PWM_DUTY_FULL;                               // Rescale the duty cycle being output
+}
+
+/** @brief   Function that returns the number of duty cycle steps in one period.
+ *  @returns The timer counts in one PWM period
+ */
+uint32_t pwmDriver::steps (void)
+{
+    return top;
+}
+
+/** @brief   Function that returns the resolution of the duty cycle.
+ *  @returns The number of whole bits of duty cycle resolution
+ */
+uint8_t pwmDriver::bits (void)
+{
+    return 31 - __builtin_clz(top);
+}
+
+/** @brief   Function that sets the duty cycle and direction, in the same units as @c MotorDriver::run().
+ *  @param   DUTYCYCLE Fraction of full power, 0 to 255
+ *  @param   DIRECTION Level for the direction pin; 0 only while the spindle is reversed
+ */
+void pwmDriver::run (int32_t DUTYCYCLE, int32_t DIRECTION)
+{
+    run_fine(DUTYCYCLE*256, DIRECTION);
+}
+
+/** @brief   Function that sets the duty cycle at full resolution.
+ *  @details The duty cycle is scaled to timer counts and written straight to the compare
+ *           register; the timer loads it at the start of the next period. The product of the
+ *           duty cycle and a 16-bit period fits in 32 bits, so this is one multiply and one
+ *           hardware divide, and can be called from the control loop interrupt.
+ *  @param   DUTY_Q8   Fraction of full power, 0 to @c PWM_DUTY_FULL
+ *  @param   DIRECTION Level for the direction pin; 0 only while the spindle is reversed
+ */
+void pwmDriver::run_fine (int32_t DUTY_Q8, int32_t DIRECTION)
+{
+    duty_q8 = constrain(DUTY_Q8, 0, PWM_DUTY_FULL);                                         // Keep it within a period
+    *compare = (duty_q8*top + PWM_DUTY_FULL/2)/PWM_DUTY_FULL;                               // Scale to counts and output it
+    int8_t level = DIRECTION ? 1 : 0;                                                       //
+    if (level != direction)                                                                 // If the direction has changed...
+    {                                                                                       //
+        digitalWrite(direction_pin, level ? HIGH : LOW);                                    //      Then, output it
+        direction = level;                                                                  //
+    }                                                                                       //
+}
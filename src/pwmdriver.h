@@ -0,0 +1,56 @@
+/** @file pwmdriver.h
+ *    This file contains the class definition for a motor driver which sets the
+ *    PWM duty cycle directly in a timer's compare register, at high resolution.
+ *  @date 2026-Oct-16
+ */
+
+#ifndef PWMDRIVER_H
+#define PWMDRIVER_H
+#include <Arduino.h>
+#include <PrintStream.h>
+#if (defined STM32L4xx || defined STM32F4xx)
+    #include <STM32FreeRTOS.h>
+#endif
+#include "motorstuff.h"                         // Base class for motor drivers
+
+#define PWM_DUTY_FULL      (255 << 8)           // Fine duty cycle for full power, 8.8 fixed point like run() << 8
+
+
+/** @brief   Defines the class for a high-resolution PWM motor driver.
+ *  @details @c MotorDriver::run() uses @c analogWrite(), which only takes 256 duty cycles,
+ *           so on a router which tops out near 32000 RPM each step of the duty cycle is worth
+ *           well over 100 RPM, far coarser than the speed measurement. Each call also looks up
+ *           the pin's timer and channel again and goes through the timer library to set the
+ *           compare value.
+ *
+ *           This driver looks the timer and channel up once, when it is instantiated, sets the
+ *           carrier frequency, and keeps a pointer to the channel's compare register. Setting
+ *           the duty cycle is then a multiply, a divide and a single register write. The timer
+ *           counts at the full timer clock, divided down only as far as is needed to fit a
+ *           period into 16 bits, so at 1 kHz the period is 40000 counts and at 20 kHz it is
+ *           4000, about 15 and 12 bits. @c run_fine() takes the duty cycle in 8.8 fixed point,
+ *           so the fraction the PID controller works out between steps of @c run() reaches the
+ *           motor; @c run() still takes 0 to 255 and is the same as @c run_fine() with the duty
+ *           cycle times 256. The direction pin is only written when the direction changes.
+ *
+ *           The PWM pin must be connected to a timer channel, and nothing else may use that
+ *           timer, or call @c analogWrite() on the pin, once the driver has been set up.
+ */
+class pwmDriver : public MotorDriver {
+    protected:
+        HardwareTimer* timer;                                       // Timer that the PWM pin belongs to
+        uint32_t channel;                                           // Timer channel connected to the PWM pin
+        volatile uint32_t* compare;                                 // The channel's compare register
+        uint32_t top;                                               // Timer counts in one PWM period
+        uint32_t duty_q8;                                           // Fine duty cycle being output
+        int8_t direction;                                           // Level on the direction pin, -1 if not yet written
+    public:
+        pwmDriver (uint8_t PWM_GPIO, uint8_t direction_GPIO, uint32_t frequency_hz); // Format for instantiating a PWM driver object
+        void set_frequency (uint32_t frequency_hz);                 // Function format for setting the carrier frequency
+        uint32_t steps (void);                                      // Function format for getting the number of duty cycle steps
+        uint8_t bits (void);                                        // Function format for getting the resolution in bits
+        void run (int32_t DUTYCYCLE, int32_t DIRECTION);            // Function format for setting the duty cycle, 0 to 255
+        void run_fine (int32_t DUTY_Q8, int32_t DIRECTION);         // Function format for setting the duty cycle in 8.8 fixed point
+};
+
+#endif // PWMDRIVER_H
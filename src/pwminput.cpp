@@ -0,0 +1,206 @@
+/** @file pwminput.cpp
+ *    This file contains the implementation of the PWM spindle speed input.
+ *
+ *  @date 2026-Oct-16
+ */
+
+#include "pwminput.h"                                                   // Include corresponding header file
+
+/** @brief   Function called to instantiate a PWM input object.
+ *  @details This function saves the input pin and the desired tick rate of the timer. The
+ *           curve starts empty, so every duty cycle means off until @c set_point() is called.
+ *           The hardware timer itself is not touched until @c begin() is called from a task.
+ *  @param   input_GPIO The pin the PWM signal comes in on, on channel 1 or 2 of a timer
+ *  @param   frequency  The desired timer count rate in ticks per second
+ */
+pwmInput::pwmInput (uint8_t input_GPIO, uint32_t frequency)
+{
+    input_pin = input_GPIO;                     // Save the parameter, which will evaporate when the constructor exits
+    tick_frequency = frequency;                 // Save the parameter, which will evaporate when the constructor exits
+    timer = NULL;                               // Created in begin()
+    channel_rising = 0;                         // Found from the pin map in begin()
+    channel_falling = 0;                        // Found from the pin map in begin()
+    points = 0;                                 // No curve yet
+    previous_period = 0;                        // No period yet
+    overflows = 1;                              // The first edge only starts the timing
+    timeout_overflows = 1;                      // Worked out in begin()
+    state = PWM_IN_NONE;                        // No signal yet
+    period = 0;                                 // Initialize to 0
+    duty_q16 = 0;                               // Initialize to 0
+    setpoint = 0;                               // Off
+    glitches = 0;                               // Initialize to 0
+}
+
+/** @brief   Function that adds a point to the duty cycle to speed curve.
+ *  @details Points must be added in order of increasing duty cycle. The curve is read by the
+ *           capture interrupt, so it should be set up before @c begin() is called.
+ *  @param   permille The duty cycle, in tenths of a percent
+ *  @param   rpm      The speed at that duty cycle [RPM]
+ *  @returns True if the point was added, false if the curve was full or out of order
+ */
+bool pwmInput::set_point (uint16_t permille, int32_t rpm)
+{
+    uint32_t duty = ((uint32_t)constrain(permille, 0, 1000) << 16)/1000;               // Convert to Q16
+    if (points == PWM_IN_MAX_POINTS || (points > 0 && duty <= curve_duty[points - 1])) // If there's no room, or it's out of order...
+    {                                                                                   //
+        return false;                                                                   //      Then, leave the curve alone
+    }                                                                                   //
+    curve_duty[points] = duty;                                                          // Add the point
+    curve_rpm[points] = rpm;                                                            //
+    curve_slope_q16[points] = 0;                                                        // Flat past the last point
+    if (points > 0)                                                                     // If there's a point before it...
+    {                                                                                   //
+        uint8_t i = points - 1;                                                         //      Then, work out the slope between them
+        curve_slope_q16[i] = (int64_t)(rpm - curve_rpm[i])*65536/(int32_t)(duty - curve_duty[i]); //
+    }                                                                                   //
+    points ++;                                                                          //
+    return true;
+}
+
+/** @brief   Function that looks up the speed for a duty cycle on the curve.
+ *  @param   duty The duty cycle, Q16
+ *  @returns The speed [RPM], or 0 below the first point
+ */
+int32_t pwmInput::lookup (uint32_t duty)
+{
+    if (points == 0 || duty < curve_duty[0])                                            // If below the curve...
+    {                                                                                   //
+        return 0;                                                                       //      Then, the spindle is off
+    }                                                                                   //
+    uint8_t i = points - 1;                                                             // Find the point at or below the duty cycle
+    while (duty < curve_duty[i])                                                        //
+    {                                                                                   //
+        i --;                                                                           //
+    }                                                                                   //
+    return curve_rpm[i] + (int32_t)(((int64_t)(duty - curve_duty[i])*curve_slope_q16[i]) >> 16);
+}
+
+/** @brief   Function that configures the timer and starts following the signal.
+ *  @details This function looks up which timer and channel the input pin belongs to, and
+ *           sets the channel up to capture the period on rising edges with its partner
+ *           capturing the high time on falling edges. The update interrupt is set to come
+ *           only from real overflows, and not from the counter being reset by each edge.
+ */
+void pwmInput::begin (void)
+{
+    PinName pin_name = digitalPinToPinName(input_pin);                                      // Convert the Arduino pin to an STM32 pin name
+    TIM_TypeDef* instance = (TIM_TypeDef*)pinmap_peripheral(pin_name, PinMap_PWM);          // Find the timer connected to the pin
+    channel_rising = STM_PIN_CHANNEL(pinmap_function(pin_name, PinMap_PWM));                // Find the channel connected to the pin
+    channel_falling = (channel_rising == 1) ? 2 : 1;                                        // Its partner latches the falling edges
+    timer = new HardwareTimer(instance);                                                    // Create the timer object
+    timer->setMode(channel_rising, TIMER_INPUT_FREQ_DUTY_MEASUREMENT, input_pin);           // Measure the period and high time
+    uint32_t prescale = timer->getTimerClkFreq()/tick_frequency;                            // Find the prescaler for the requested rate
+    timer->setPrescaleFactor(prescale ? prescale : 1);                                      // A prescaler of 0 is not allowed
+    tick_frequency = timer->getTimerClkFreq()/timer->getPrescaleFactor();                   // Store the rate the timer actually counts at
+    timer->setOverflow(0x10000);                                                            // Let the counter use its full 16 bits
+    __HAL_TIM_URS_ENABLE(timer->getHandle());                                               // Only overflows raise the update interrupt
+    uint32_t timeout = (uint64_t)tick_frequency*PWM_IN_TIMEOUT_MS/1000/0x10000 + 1;         // Overflows in the timeout
+    timeout_overflows = constrain(timeout, 2u, 255u);                                       //
+    timer->attachInterrupt(channel_rising, std::bind(&pwmInput::captured, this));           // Work out the duty cycle at each rising edge
+    timer->attachInterrupt(std::bind(&pwmInput::rollover, this));                           // Watch for the signal stopping
+    timer->resume();                                                                        // Start counting
+}
+
+/** @brief   Function that sets the speed from a new duty cycle.
+ *  @details The speed is only changed if it has moved by more than the deadband, or if it is
+ *           going to or from zero, which must never be held off.
+ *  @param   duty The duty cycle, Q16
+ */
+void pwmInput::output (uint32_t duty)
+{
+    duty_q16 = duty;                                                                        // Keep the duty cycle for printing
+    int32_t rpm = lookup(duty);                                                             // Find the speed asked for
+    if (state != PWM_IN_OK || rpm == 0 || setpoint == 0 || abs(rpm - setpoint) > PWM_IN_DEADBAND_RPM) // If it has really changed...
+    {                                                                                       //
+        setpoint = rpm;                                                                     //      Then, pass it on
+    }                                                                                       //
+    state = PWM_IN_OK;                                                                      // Following the signal
+}
+
+/** @brief   Function called by the capture interrupt at each rising edge.
+ *  @details The period of the cycle which has just ended is in the rising channel's
+ *           capture register, and its high time is in the falling channel's. A cycle which
+ *           overflowed the counter is the first edge after the signal stopped, and there is
+ *           no period to go with it. A change in duty cycle of more than @c PWM_IN_STEP is
+ *           passed on at once; smaller ones go through a first-order filter.
+ */
+void pwmInput::captured (void)
+{
+    uint32_t cycle = timer->getCaptureCompare(channel_rising);                              // Period of the cycle just ended
+    uint32_t high = timer->getCaptureCompare(channel_falling);                              // High time of the cycle
+    if (overflows)                                                                          // If the signal has just come back...
+    {                                                                                       //
+        overflows = 0;                                                                      //      Then, start timing from this edge
+        previous_period = 0;                                                                //
+        return;                                                                             //
+    }                                                                                       //
+    bool first = previous_period == 0;                                                      // The first period since the signal came back
+    bool steady = first || (uint32_t)abs((int32_t)(cycle - previous_period)) <= previous_period/4; // Or one close to the last
+    previous_period = cycle;                                                                //
+    if (cycle == 0 || high > cycle || !steady)                                              // If the edge was noise...
+    {                                                                                       //
+        glitches ++;                                                                        //      Then, don't use it
+        return;                                                                             //
+    }                                                                                       //
+    period = cycle;                                                                         //
+    int32_t duty = (high << 16)/cycle;                                                      // Duty cycle, Q16
+    int32_t change = duty - (int32_t)duty_q16;                                              // Change from the filtered duty cycle
+    if (first || state != PWM_IN_OK || abs(change) > PWM_IN_STEP)                           // If it's new or a real step...
+    {                                                                                       //
+        output(duty);                                                                       //      Then, follow it at once
+    }                                                                                       //
+    else                                                                                    // Otherwise...
+    {                                                                                       //
+        output(duty_q16 + (change >> PWM_IN_FILTER_SHIFT));                                 //      Smooth out the jitter
+    }                                                                                       //
+}
+
+/** @brief   Function called by the overflow interrupt.
+ *  @details The counter is reset by every rising edge, so it only overflows if there hasn't
+ *           been one for 65536 ticks. After @c PWM_IN_TIMEOUT_MS of overflows the signal is
+ *           lost, unless the pin is held high after a duty cycle close to full.
+ */
+void pwmInput::rollover (void)
+{
+    if (overflows < 255)                                                                    // Count overflows, without wrapping
+    {                                                                                       //
+        overflows ++;                                                                       //
+    }                                                                                       //
+    if (overflows < timeout_overflows || state != PWM_IN_OK)                                // If not timed out, or not following a signal...
+    {                                                                                       //
+        return;                                                                             //      Then, there's nothing to do
+    }                                                                                       //
+    if (digitalRead(input_pin) == HIGH && duty_q16 >= PWM_IN_FULL_DUTY)                     // If the controller is asking for full speed...
+    {                                                                                       //
+        output(0x10000);                                                                    //      Then, give it full speed
+    }                                                                                       //
+    else                                                                                    // Otherwise...
+    {                                                                                       //
+        state = PWM_IN_LOST;                                                                //      The signal is gone
+    }                                                                                       //
+}
+
+/** @brief   Function that gives the set point back to the user after the signal was lost.
+ *  @details The motor task calls this once it has stopped the spindle. If the signal comes
+ *           back, it takes over again at the next rising edge after that.
+ */
+void pwmInput::clear (void)
+{
+    setpoint = 0;                               // Off
+    state = PWM_IN_NONE;                        // Not following a signal
+}
+
+/** @brief   Function that prints the state of the signal and the curve.
+ *  @param   printer The stream to print to
+ */
+void pwmInput::print (Print& printer)
+{
+    const char* names[] = {"no signal", "following", "lost"};                                     //
+    printer << "PWM input " << names[state] << ", " << (period ? tick_frequency/period : 0)       //
+            << " Hz, duty " << ((duty_q16*1000) >> 16) << "/1000, " << setpoint << " RPM, "         //
+            << glitches << " glitches" << endl;                                                   //
+    for (uint8_t i = 0; i < points; i++)                                                          // Show each point
+    {                                                                                             //
+        printer << ((curve_duty[i]*1000 + 0x8000) >> 16) << "/1000: " << curve_rpm[i] << " RPM" << endl; //
+    }                                                                                             //
+}
@@ -0,0 +1,85 @@
+/** @file pwminput.h
+ *    This file contains the class definition for a reader which follows the PWM
+ *    spindle speed output of a CNC controller with a timer in input-capture mode.
+ *  @date 2026-Oct-16
+ */
+
+#ifndef PWMINPUT_H
+#define PWMINPUT_H
+#include <Arduino.h>
+#include <PrintStream.h>
+#if (defined STM32L4xx || defined STM32F4xx)
+    #include <STM32FreeRTOS.h>
+#endif
+
+#define PWM_IN_MAX_POINTS   8                   // Most points on the duty cycle to speed curve
+#define PWM_IN_TIMEOUT_MS   50                  // Time without an edge before the signal counts as lost
+#define PWM_IN_FULL_DUTY    (65536*95/100)      // Duty cycle, Q16, above which a steady high input counts as full
+#define PWM_IN_STEP         (65536*2/100)       // Change in duty cycle, Q16, which is followed without filtering
+#define PWM_IN_FILTER_SHIFT 3                   // Smaller changes are filtered with a time constant of 2^3 periods
+#define PWM_IN_DEADBAND_RPM 20                  // Smallest change in speed passed on, so the set point doesn't dither
+
+#define PWM_IN_NONE         0                   // No signal has been seen; the set point is up to the user
+#define PWM_IN_OK           1                   // Following the signal
+#define PWM_IN_LOST         2                   // The signal was followed, then stopped
+
+/** @brief   Defines the class for a PWM spindle speed input.
+ *  @details A CNC controller sets the spindle speed with a PWM signal whose duty cycle is the
+ *           fraction of full speed. The input pin is put on a timer channel in frequency and
+ *           duty cycle measurement mode: each rising edge resets the counter, and the count it
+ *           reached is latched in that channel's capture register, while the paired channel
+ *           latches the count at each falling edge. The period and the high time of the last
+ *           cycle are then both measured by the hardware, and the capture interrupt only has
+ *           to divide one by the other, so the set point is updated at the end of every PWM
+ *           period, without waiting for a task to run. The input pin must be on channel 1 or
+ *           2 of its timer, since only those can reset the counter.
+ *
+ *           Electrical noise on a long cable shows up as extra edges, which cut a period
+ *           short, so a period more than a quarter away from the one before is not used. The
+ *           duty cycle also jitters by a count or two from cycle to cycle, which would make the
+ *           set point wander. Changes of less than @c PWM_IN_STEP are put through a first-order
+ *           filter, but larger ones are taken as they are, so a real change in speed still
+ *           reaches the set point by the end of the first period at the new duty cycle. The
+ *           duty cycle is turned into a speed by a curve of up to @c PWM_IN_MAX_POINTS points,
+ *           with straight lines between them; below the first point the spindle is off, and
+ *           above the last it runs at the last point's speed. The speed is only changed when
+ *           it moves by more than @c PWM_IN_DEADBAND_RPM, or to or from zero.
+ *
+ *           If there are no edges for @c PWM_IN_TIMEOUT_MS, counted by the timer's overflow
+ *           interrupt, the signal is lost, unless the pin is high and the duty cycle was
+ *           already close to full, which is how a controller asks for full speed. A constant
+ *           low input, a cut wire and a controller which has been switched off all look the
+ *           same, so they are all lost, and the motor task stops the spindle.
+ */
+class pwmInput {
+    protected:
+        uint8_t input_pin;                                          // Pin the PWM signal comes in on
+        uint32_t tick_frequency;                                    // Timer count rate in ticks per second
+        uint32_t channel_rising;                                    // Timer channel that latches the period
+        uint32_t channel_falling;                                   // Timer channel that latches the high time
+        HardwareTimer* timer;                                       // Timer that the input pin belongs to
+        uint8_t points;                                             // Points on the curve
+        uint32_t curve_duty[PWM_IN_MAX_POINTS];                     // Duty cycle at each point, increasing, Q16
+        int32_t curve_rpm[PWM_IN_MAX_POINTS];                       // Speed at each point
+        int32_t curve_slope_q16[PWM_IN_MAX_POINTS];                 // Speed per unit of duty cycle to the next point, Q16
+        uint32_t previous_period;                                   // Period of the last cycle
+        volatile uint8_t overflows;                                 // Counter overflows since the last rising edge
+        uint8_t timeout_overflows;                                  // Overflows in @c PWM_IN_TIMEOUT_MS
+        void captured (void);                                       // Function called at each rising edge
+        void rollover (void);                                       // Function called when the counter overflows
+        void output (uint32_t duty);                                // Function format for setting the speed from a duty cycle
+    public:
+        volatile uint8_t state;                                     // PWM_IN_NONE, PWM_IN_OK or PWM_IN_LOST
+        volatile uint32_t period;                                   // Period of the signal, in ticks
+        volatile uint32_t duty_q16;                                 // Filtered duty cycle, Q16
+        volatile int32_t setpoint;                                  // Speed asked for [RPM]
+        volatile uint32_t glitches;                                 // Edges thrown away as noise
+        pwmInput (uint8_t input_GPIO, uint32_t frequency);          // Format for instantiating a PWM input object
+        bool set_point (uint16_t permille, int32_t rpm);            // Function format for adding a point to the curve
+        int32_t lookup (uint32_t duty);                             // Function format for looking up the speed for a duty cycle
+        void begin (void);                                          // Function format for starting the timer
+        void clear (void);                                          // Function format for giving the set point back to the user
+        void print (Print& printer);                                // Function format for printing the signal and curve
+};
+
+#endif // PWMINPUT_H
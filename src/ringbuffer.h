@@ -0,0 +1,193 @@
+//*****************************************************************************
+/** @file    ringbuffer.h
+ *  @brief   A lock-free ring buffer for passing data from one ISR to one task.
+ *  @details This file contains a template class for a single-producer,
+ *           single-consumer ring buffer. Unlike a @c Queue, it doesn't use
+ *           FreeRTOS at all, so putting an item in never blocks and never
+ *           enters a critical section. That makes it safe and cheap to fill
+ *           from an interrupt service routine which runs very often, such as
+ *           the motor encoder ISR.
+ *
+ *  @date 2026-Oct-16 Original file
+ */
+//*****************************************************************************
+
+// This define prevents this .h file from being included more than once
+#ifndef _RINGBUFFER_H_
+#define _RINGBUFFER_H_
+
+#include <atomic>                           // Atomic indices shared by both sides
+#include <PrintStream.h>                    // Streaming output for status printouts
+#include "baseshare.h"                      // Base class for shared data items
+
+
+/** @brief   Class for a lock-free ring buffer with one writer and one reader.
+ *  @details This class implements a fixed-size circular buffer which one
+ *           producer (usually an ISR) fills and one consumer (usually a task)
+ *           empties. The producer only ever writes the @c head index and the
+ *           consumer only ever writes the @c tail index, so neither side ever
+ *           has to lock the other out. Each index is stored with release
+ *           ordering after the data it covers has been written, and loaded
+ *           with acquire ordering before that data is read, so the consumer
+ *           can never see an index before the item it points past.
+ *
+ *           The indices run freely and wrap at 65536, and the slot is found by
+ *           masking off the low bits, so the size must be a power of two no
+ *           larger than 32768. When the buffer is full, new items are dropped
+ *           rather than overwriting old ones the consumer may be reading, and
+ *           the number of dropped items is counted in @c overruns.
+ *
+ *           @section usage_ring Usage
+ *           The ISR and the task each use only their own half of the class:
+ *           @code{.cpp}
+ *           #include "ringbuffer.h"
+ *           ...
+ *           RingBuffer<uint32_t, 64> edge_times ("Edges");
+ *           ...
+ *           void an_ISR ()                             // Producer
+ *           {
+ *               edge_times.put (micros ());
+ *           }
+ *           ...
+ *           uint32_t a_time;                           // Consumer, in a task
+ *           while (edge_times.get (a_time))
+ *           {
+ *               ...
+ *           }
+ *           @endcode
+ */
+template <class dataType, uint16_t size> class RingBuffer : public BaseShare
+{
+    static_assert (size && !(size & (size - 1)) && size <= 32768,
+                   "RingBuffer size must be a power of two up to 32768");
+
+    protected:
+        dataType buffer[size];                ///< Storage for the items
+        std::atomic<uint16_t> head;           ///< Items put so far; written by producer
+        std::atomic<uint16_t> tail;           ///< Items taken so far; written by consumer
+        uint16_t max_full;                    ///< Most items ever waiting at once
+        uint32_t overruns;                    ///< Items dropped because the buffer was full
+
+    public:
+        /** @brief   Construct a ring buffer.
+         *  @details The buffer is statically sized, so nothing is allocated.
+         *  @param   p_name A name to be shown in the list of task shares
+         *           (default @c NULL)
+         */
+        RingBuffer (const char* p_name = NULL) : BaseShare (p_name)
+        {
+            head = 0;
+            tail = 0;
+            max_full = 0;
+            overruns = 0;
+        }
+
+        // Put an item into the buffer; called only by the producer
+        bool put (const dataType& item);
+
+        // Take the oldest item out of the buffer; called only by the consumer
+        bool get (dataType& item);
+
+        /** @brief   Return the number of items waiting in the buffer.
+         *  @details This number is only a snapshot; the producer may add more
+         *           at any time.
+         */
+        uint16_t available (void)
+        {
+            return (uint16_t)(head.load (std::memory_order_acquire)
+                              - tail.load (std::memory_order_relaxed));
+        }
+
+        /** @brief   Return the number of items dropped because the buffer was
+         *           full.
+         */
+        uint32_t dropped (void)
+        {
+            return (overruns);
+        }
+
+        // Print the buffer's status within a list of all shares' statuses
+        void print_in_list (Print& printer);
+};
+
+
+/** @brief   Put an item into the ring buffer.
+ *  @details This method copies an item into the next free slot and then
+ *           publishes it by advancing @c head. It must only be called by the
+ *           one producer, which may be an ISR. It never blocks; if the buffer
+ *           is full, the item is dropped and counted instead.
+ *  @param   item Reference to the item which is going to be put into the buffer
+ *  @return  True if the item was stored, false if the buffer was full
+ */
+template <class dataType, uint16_t size>
+inline bool RingBuffer<dataType, size>::put (const dataType& item)
+{
+    uint16_t next = head.load (std::memory_order_relaxed);
+    uint16_t fillage = next - tail.load (std::memory_order_acquire);
+
+    if (fillage >= size)
+    {
+        overruns++;
+        return (false);
+    }
+    buffer[next & (size - 1)] = item;
+    head.store (next + 1, std::memory_order_release);
+
+    // Keep track of the maximum fillage of the buffer
+    if (fillage + 1 > max_full)
+    {
+        max_full = fillage + 1;
+    }
+    return (true);
+}
+
+
+/** @brief   Take the oldest item out of the ring buffer.
+ *  @details This method copies the oldest item out of the buffer and then
+ *           frees its slot by advancing @c tail. It must only be called by the
+ *           one consumer. It never blocks; if the buffer is empty it returns
+ *           false right away, so a task can drain everything waiting with a
+ *           @c while loop.
+ *  @param   item Reference to the variable in which to put the item
+ *  @return  True if an item was taken, false if the buffer was empty
+ */
+template <class dataType, uint16_t size>
+inline bool RingBuffer<dataType, size>::get (dataType& item)
+{
+    uint16_t next = tail.load (std::memory_order_relaxed);
+
+    if (next == head.load (std::memory_order_acquire))
+    {
+        return (false);
+    }
+    item = buffer[next & (size - 1)];
+    tail.store (next + 1, std::memory_order_release);
+    return (true);
+}
+
+
+/** @brief   Print the ring buffer's status to a serial device.
+ *  @details This method prints the most items that were ever waiting in the
+ *           buffer, its size, and how many items were dropped, then calls this
+ *           same method for the next item in the linked list of shared data.
+ *  @param   printer Reference to the serial device on which to print
+ */
+template <class dataType, uint16_t size>
+void RingBuffer<dataType, size>::print_in_list (Print& printer)
+{
+    // Print this buffer's name and pad it to 16 characters
+    printer.printf ("%-16sring\t", name);
+
+    // Print the maximum fillage, the size, and any dropped items
+    printer << max_full << '/' << size << " (" << overruns << " dropped)"
+            << endl;
+
+    // Call the next item
+    if (p_next != NULL)
+    {
+        p_next->print_in_list (printer);
+    }
+}
+
+
+#endif  // _RINGBUFFER_H_
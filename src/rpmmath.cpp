@@ -0,0 +1,85 @@
+/** @file rpmmath.cpp
+ *    This file contains the implementation of the integer RPM calculator.
+ *
+ *  @date 2026-Oct-16
+ */
+
+#include "rpmmath.h"                                                    // Include corresponding header file
+
+uint32_t rpmCalculator::reciprocal_table[256];                          // Filled by the first call to configure()
+bool rpmCalculator::table_ready = false;                                // Not filled yet
+
+/** @brief   Function called to instantiate an RPM calculator object.
+ *  @details The calculator returns 0 until @c configure() has been called.
+ */
+rpmCalculator::rpmCalculator (void)
+{
+    scale = 0;                                  // Initialize to 0 until configured
+}
+
+/** @brief   Function that computes the constants used by every speed calculation.
+ *  @details This function does the only divisions. It computes the scale from the encoder
+ *           resolution and the timestamp rate, and the first time it is called it also fills
+ *           the reciprocal table, which is shared by all calculators. Entry @c i is 1/x in Q30
+ *           format for x in the middle of the range [0.5 + i/512, 0.5 + (i+1)/512), which works
+ *           out to 2^40/(513 + 2i). It must not be called from an ISR.
+ *  @param   counts_per_rev   How many encoder counts per revolution
+ *  @param   ticks_per_second Rate of the clock that timestamps are taken in
+ */
+void rpmCalculator::configure (uint8_t counts_per_rev, uint32_t ticks_per_second)
+{
+    if (!table_ready)                                                   // If the table hasn't been filled yet...
+    {                                                                   //
+        for (uint16_t i = 0; i < 256; i++)                              //      Then, fill in each entry
+        {                                                               //
+            reciprocal_table[i] = (1ULL << 40)/(513 + 2*i);             //      1/x in Q30 at the middle of the interval
+        }                                                               //
+        table_ready = true;                                             //
+    }                                                                   //
+    scale = counts_per_rev ? (uint64_t)ticks_per_second*60/counts_per_rev : 0;  // Zero counts per rev would divide by zero
+}
+
+/** @brief   Function that calculates the speed in RPM.
+ *  @details The elapsed time is shifted left until its top bit is set, so as a Q32 fraction
+ *           it is a number d in [0.5, 1). The table gives y, about 1/d in Q30, and one Newton
+ *           step y = y*(2 - d*y) squares the error. The numerator counts*scale may be wider
+ *           than 32 bits, so it is shifted right to fit. The result is numerator*y, shifted
+ *           back down by the amount that undoes both normalizations. Everything uses 32x32-bit
+ *           multiplies to 64-bit results, which are single instructions on a Cortex-M4.
+ *  @param   counts  The change in encoder position, negative in reverse
+ *  @param   elapsed The time taken for that change, in ticks
+ *  @returns The speed in RPM, negative in reverse, or 0 if no time has elapsed
+ */
+int32_t rpmCalculator::rpm (int32_t counts, uint32_t elapsed)
+{
+    if (elapsed == 0 || counts == 0)                                    // If there is nothing to divide...
+    {                                                                   //
+        return 0;                                                       //      Then, the speed can't be calculated
+    }                                                                   //
+    uint32_t magnitude = counts < 0 ? -(uint32_t)counts : counts;      // Work with the size of the count
+    uint64_t numerator = scale*magnitude;                               // Units of counts*ticks*RPM
+    uint8_t numerator_shift = 0;                                        // Shift that fits the numerator in 32 bits
+    if (numerator >> 32)                                                // If it is wider than 32 bits...
+    {                                                                   //
+        numerator_shift = 32 - __builtin_clz((uint32_t)(numerator >> 32)); //  Then, find how far to shift it down
+    }                                                                   //
+    uint32_t top = numerator >> numerator_shift;                        // Top 32 bits of the numerator
+    uint8_t elapsed_shift = __builtin_clz(elapsed);                     // Shift that sets the top bit of the time
+    uint32_t d = elapsed << elapsed_shift;                              // Elapsed time as a Q32 fraction in [0.5, 1)
+    uint32_t y = reciprocal_table[(d >> 23) & 0xFF];                    // Starting guess for 1/d in Q30
+    uint32_t dy = ((uint64_t)d*y) >> 32;                                // d*y in Q30, very close to 1
+    y = ((uint64_t)y*((1UL << 31) - dy)) >> 30;                         // Newton step: y = y*(2 - d*y)
+    int8_t shift = 62 - elapsed_shift - numerator_shift;                // Undo both normalizations
+    uint64_t result;                                                    //
+    if (shift < 0)                                                      // If the result can't fit at all...
+    {                                                                   //
+        result = INT32_MAX;                                             //      Then, saturate
+    }                                                                   //
+    else                                                                // Otherwise...
+    {                                                                   //
+        uint64_t half = (1ULL << shift) >> 1;                           //      Half of the last bit, for rounding
+        result = ((uint64_t)top*y + half) >> shift;                     //      Multiply by the reciprocal and round
+        if (result > INT32_MAX) { result = INT32_MAX; }                 //      Saturate anything too fast to be real
+    }                                                                   //
+    return counts < 0 ? -(int32_t)result : (int32_t)result;             // Put the direction back
+}
@@ -0,0 +1,176 @@
+//*****************************************************************************
+/** @file    seqshare.h
+ *  @brief   A share which one writer updates without a critical section.
+ *  @details This file contains a template class for data which one task or
+ *           ISR writes and any number of tasks and ISRs read. Unlike a
+ *           @c Share, it never disables interrupts, so reading or writing it
+ *           doesn't add to the time the encoder ISRs have to wait. Instead,
+ *           each update bumps a sequence number, and a reader which finds the
+ *           number changed while it was copying the data copies it again.
+ *
+ *  @date 2026-Oct-16 Original file
+ */
+//*****************************************************************************
+
+// This define prevents this .h file from being included more than once
+#ifndef _SEQSHARE_H_
+#define _SEQSHARE_H_
+
+#include <atomic>                           // Atomic sequence number and fences
+#include <PrintStream.h>                    // Streaming output for status printouts
+#include "baseshare.h"                      // Base class for shared data items
+
+
+/** @brief   Class for a sequence-locked share with one writer.
+ *  @details This class keeps two copies of the data and a sequence number
+ *           which counts half-updates. The writer first makes the number odd,
+ *           which sends readers to copy 1, and rewrites copy 0; then it makes
+ *           the number even, which sends readers back to copy 0, and rewrites
+ *           copy 1. A reader loads the number, copies the copy it points to,
+ *           and loads the number again; if it has changed, the copy may have
+ *           been written partway through, so the reader tries again. Fences
+ *           keep the processor and compiler from moving the data across the
+ *           number, so a reader can never keep a torn copy.
+ *
+ *           Because the writer never touches the copy readers are sent to,
+ *           a reader doesn't have to wait for an update to finish. An ISR
+ *           which interrupts the writer halfway reads the other copy, and
+ *           gets it right the first time, since the writer can't run until
+ *           the ISR returns. A reader only tries again if an update starts
+ *           while it is copying, so in a task it is rarely more than twice.
+ *           Writing never waits for anything.
+ *
+ *           Only one task or ISR may write a given share; two writers could
+ *           both update the same copy at once. Reads and writes look the same
+ *           from tasks and ISRs, but @c ISR_put() and @c ISR_get() are given
+ *           so that code written for a @c Share only needs its type changed.
+ *
+ *           @section usage_seqshare Usage
+ *           @code{.cpp}
+ *           #include "seqshare.h"
+ *           ...
+ *           SeqShare<int32_t> motor_speed ("Speed");
+ *           ...
+ *           motor_speed.put (speed);           // In the one writing task
+ *           ...
+ *           int32_t speed;                     // In any other task or ISR
+ *           motor_speed.get (speed);
+ *           @endcode
+ */
+template <class DataType> class SeqShare : public BaseShare
+{
+    protected:
+        DataType copies[2];                   ///< Two copies of the data, one always whole
+        std::atomic<uint32_t> sequence;       ///< Half-updates so far; low bit picks the copy to read
+
+    public:
+        /** @brief   Construct a sequence-locked share.
+         *  @details As with a @c Share, the data is @b not initialized.
+         *  @param   p_name A name to be shown in the list of task shares
+         *           (default @c NULL)
+         */
+        SeqShare (const char* p_name = NULL) : BaseShare (p_name)
+        {
+            sequence = 0;
+        }
+
+        // Write data into the share; called only by the one writer
+        void put (const DataType& new_data);
+
+        /** @brief   Write data into the share from within an ISR.
+         *  @details This is the same as @c put(), which is safe in an ISR.
+         *  @param   new_data The data which is to be written
+         */
+        void ISR_put (const DataType& new_data)
+        {
+            put (new_data);
+        }
+
+        // Read data from the share
+        void get (DataType& recv_data);
+
+        /** @brief   Read data from the share from within an ISR.
+         *  @details This is the same as @c get(), which is safe in an ISR.
+         *  @param   recv_data A reference to the variable in which to put
+         *           received data
+         */
+        void ISR_get (DataType& recv_data)
+        {
+            get (recv_data);
+        }
+
+        // Print the share's status within a list of all shares' statuses
+        void print_in_list (Print& printer);
+};
+
+
+/** @brief   Write data into the sequence-locked share.
+ *  @details This method writes both copies of the data, moving readers away
+ *           from each copy before it is written. It never waits and never
+ *           disables interrupts. It must only be called by the one writer.
+ *  @param   new_data The data which is to be written
+ */
+template <class DataType>
+inline void SeqShare<DataType>::put (const DataType& new_data)
+{
+    uint32_t seq = sequence.load (std::memory_order_relaxed);
+
+    sequence.store (seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence (std::memory_order_release);
+    copies[0] = new_data;
+
+    std::atomic_thread_fence (std::memory_order_release);
+    sequence.store (seq + 2, std::memory_order_relaxed);
+    std::atomic_thread_fence (std::memory_order_release);
+    copies[1] = new_data;
+}
+
+
+/** @brief   Read data from the sequence-locked share.
+ *  @details This method copies whichever copy isn't being written, then
+ *           checks that no update started while it was copying, and copies
+ *           again if one did. The variable given may be written more than
+ *           once, but it holds one whole update when this method returns.
+ *  @param   recv_data A reference to the variable in which to put received
+ *           data
+ */
+template <class DataType>
+inline void SeqShare<DataType>::get (DataType& recv_data)
+{
+    uint32_t seq;
+
+    do
+    {
+        seq = sequence.load (std::memory_order_acquire);
+        recv_data = copies[seq & 1];
+        std::atomic_thread_fence (std::memory_order_acquire);
+    }
+    while (sequence.load (std::memory_order_relaxed) != seq);
+}
+
+
+/** @brief   Print the name and type of this share, and how often it changed.
+ *  @details Each update bumps the sequence number twice, so the number of
+ *           updates is half of it. After printing, this method calls the next
+ *           item in the linked list of shared data.
+ *  @param   printer Reference to the serial device on which to print
+ */
+template <class DataType>
+void SeqShare<DataType>::print_in_list (Print& printer)
+{
+    // Print this share's name and pad it to 16 characters
+    printer.printf ("%-16sseqlock\t", name);
+
+    // Print the number of updates
+    printer << (sequence.load (std::memory_order_relaxed) >> 1) << " puts"
+            << endl;
+
+    // Call the next item
+    if (p_next != NULL)
+    {
+        p_next->print_in_list (printer);
+    }
+}
+
+
+#endif  // _SEQSHARE_H_
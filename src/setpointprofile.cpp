@@ -0,0 +1,160 @@
+/** @file setpointprofile.cpp
+ *    This file contains the implementation of the jerk-limited set point profile.
+ *
+ *  @date 2026-Oct-16
+ */
+
+#include "setpointprofile.h"                                            // Include corresponding header file
+
+/** @brief   Function called to instantiate a set point profile object.
+ *  @details The profile starts at rest, with limits which let the spindle reach full
+ *           speed in a little under two seconds.
+ *  @param   update_period_us Time between calls to @c update(), in microseconds
+ */
+setpointProfile::setpointProfile (uint32_t update_period_us)
+{
+    steps_per_second = 1000000/update_period_us;    // Control steps per second
+    set_limits(20000, 100000);                      // Default limits [RPM/s] and [RPM/s^2]
+    reset(0);                                       // Start at rest
+}
+
+/** @brief   Function that sets the acceleration and jerk limits.
+ *  @details The limits are converted once, here, into Q16 RPM per step and per step squared.
+ *  @param   accel_limit Largest acceleration [RPM/s]
+ *  @param   jerk_limit  Largest rate of change of acceleration [RPM/s^2]
+ */
+void setpointProfile::set_limits (float accel_limit, float jerk_limit)
+{
+    max_accel = accel_limit;                                                // Save the parameter, which will evaporate when the function exits
+    max_jerk = jerk_limit;                                                  // Save the parameter, which will evaporate when the function exits
+    float dt = 1.0f/steps_per_second;                                       // The period in seconds
+    accel_max_q16 = max(accel_limit*dt*65536, 1.0f);                        // Q16 RPM per step
+    jerk_q16 = max(jerk_limit*dt*dt*65536, 1.0f);                           // Q16 RPM per step per step
+}
+
+/** @brief   Function that restarts the profile at a known speed, with no acceleration.
+ *  @param   speed The speed to start from [RPM]
+ */
+void setpointProfile::reset (int32_t speed)
+{
+    speed_q16 = (int64_t)speed*65536;           // Convert to Q16
+    accel_q16 = 0;                              // Initialize to 0
+}
+
+/** @brief   Function that finds how much the speed changes while a ramp is ended.
+ *  @details If the acceleration is brought back to zero one jerk step at a time, the speed
+ *           changes by a*(|a| - j)/(2j), in the direction of the acceleration.
+ *  @param   accel The acceleration, Q16 RPM per step
+ *  @returns The change in speed, Q16 RPM
+ */
+int64_t setpointProfile::stopping (int64_t accel)
+{
+    int64_t magnitude = accel < 0 ? -accel : accel;                         //
+    return accel*(magnitude - jerk_q16)/(2*jerk_q16);                       //
+}
+
+/** @brief   Function that runs one step of the profile.
+ *  @details The work is done as if the set point were above the reference; if it is below,
+ *           the error and acceleration are flipped first and flipped back after. The first
+ *           acceleration, of one step higher, the same, or one step lower, which still leaves
+ *           room to stop at the set point is used. When the reference is within one jerk step
+ *           of the set point with next to no acceleration, it lands on it exactly.
+ *  @param   setpoint The speed wanted [RPM]
+ *  @returns The reference speed for this step [RPM]
+ */
+int32_t setpointProfile::update (int32_t setpoint)
+{
+    int64_t error = (int64_t)setpoint*65536 - speed_q16;                    // How far there is to go
+    int64_t direction = (error < 0) ? -1 : 1;                               // Work as if going up
+    error *= direction;                                                     //
+    int64_t accel = accel_q16*direction;                                    //
+    if (error <= jerk_q16 && accel <= jerk_q16 && accel >= -jerk_q16)       // If it is there already...
+    {                                                                       //
+        reset(setpoint);                                                    //      Then, land on it exactly
+        return setpoint;                                                    //
+    }                                                                       //
+    int64_t faster = min(accel + jerk_q16, accel_max_q16);                  // Acceleration one jerk step higher
+    int64_t same = min(accel, accel_max_q16);                               // Acceleration held
+    if (faster + stopping(faster) <= error)                                 // If it can speed up and still stop in time...
+    {                                                                       //
+        accel = faster;                                                     //      Then, do so
+    }                                                                       //
+    else if (same + stopping(same) <= error)                                // Else if it can hold and still stop in time...
+    {                                                                       //
+        accel = same;                                                       //      Then, do so
+    }                                                                       //
+    else                                                                    // Otherwise...
+    {                                                                       //
+        accel = max(accel - jerk_q16, -accel_max_q16);                      //      Start ending the ramp
+    }                                                                       //
+    accel_q16 = accel*direction;                                            // Flip back
+    speed_q16 += accel_q16;                                                 // Move the reference
+    return speed();
+}
+
+/** @brief   Function that returns the reference speed.
+ *  @returns The reference speed [RPM]
+ */
+int32_t setpointProfile::speed (void)
+{
+    return speed_q16 >> 16;
+}
+
+/** @brief   Function that returns the reference acceleration.
+ *  @details This is what the motor must be accelerating at to follow the reference, so
+ *           it can be used as a feed-forward term for the torque needed to accelerate.
+ *  @returns The reference acceleration [RPM/s]
+ */
+int32_t setpointProfile::acceleration (void)
+{
+    return (accel_q16*steps_per_second) >> 16;
+}
+
+/** @brief   Function that estimates the time until the reference reaches the set point.
+ *  @details This takes the reference and its acceleration as arguments rather than reading
+ *           the profile's own state, so a task can use a copy published by the control loop
+ *           while the control loop keeps running. If the reference is already speeding up
+ *           toward the set point, it is part way along an S-curve which started when its
+ *           acceleration was zero, so the time already spent on that curve is taken off the
+ *           curve's full time. Otherwise, the time to bring the acceleration back to zero is
+ *           added to the time of a fresh S-curve over whatever is left after that. An S-curve
+ *           over a speed change @c d takes 2*sqrt(d/J) if it never reaches the acceleration
+ *           limit @c A, and d/A + A/J if it does. It uses floats, so it should not be called
+ *           from an ISR.
+ *  @param   setpoint        The speed wanted [RPM]
+ *  @param   reference       The reference speed [RPM]
+ *  @param   reference_accel The reference acceleration [RPM/s]
+ *  @returns The estimated time until at speed [ms]
+ */
+uint32_t setpointProfile::time_remaining (int32_t setpoint, int32_t reference, int32_t reference_accel)
+{
+    float error = setpoint - reference;                                     // Speed change left [RPM]
+    float accel = reference_accel;                                          // [RPM/s]
+    if (error < 0)                                                          // Work as if going up
+    {                                                                       //
+        error = -error;                                                     //
+        accel = -accel;                                                     //
+    }                                                                       //
+    float wind_down = fabsf(accel)/max_jerk;                                // Time to bring the acceleration to zero [s]
+    float left;                                                             // Speed change of the S-curve [RPM]
+    if (accel > 0)                                                          // If already speeding up toward it...
+    {                                                                       //
+        left = error + accel*wind_down/2;                                   //      Then, it is part way along a curve which
+    }                                                                       //      started wind_down ago, that much slower
+    else                                                                    // Otherwise...
+    {                                                                       //
+        left = error - accel*wind_down/2;                                   //      It must stop accelerating away first
+    }                                                                       //
+    float curve;                                                            // Time of the S-curve [s]
+    if (left >= max_accel*max_accel/max_jerk)                               // If it reaches the acceleration limit...
+    {                                                                       //
+        curve = left/max_accel + max_accel/max_jerk;                        //      Then, it ramps, holds, and ramps back
+    }                                                                       //
+    else                                                                    // Otherwise...
+    {                                                                       //
+        curve = 2*sqrtf(left/max_jerk);                                     //      It only ramps up and back down
+    }                                                                       //
+    float total = (accel > 0) ? max(curve - wind_down, wind_down)           // Take off the part already done
+                              : wind_down + curve;                          // Or add on the time to stop
+    return total*1000;                                                      // Convert to milliseconds
+}
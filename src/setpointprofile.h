@@ -0,0 +1,50 @@
+/** @file setpointprofile.h
+ *    This file contains the class definition for a jerk-limited S-curve profile
+ *    which moves the speed reference smoothly to a new set point.
+ *  @date 2026-Oct-16
+ */
+
+#ifndef SETPOINTPROFILE_H
+#define SETPOINTPROFILE_H
+#include <Arduino.h>
+#include <PrintStream.h>
+#if (defined STM32L4xx || defined STM32F4xx)
+    #include <STM32FreeRTOS.h>
+#endif
+
+/** @brief   Defines the class for a jerk-limited speed set point profile.
+ *  @details When the set point jumps, handing the jump straight to the controller asks
+ *           for as much current as the motor will take, which can trip a breaker. This class
+ *           turns each new set point into a reference speed which changes with at most
+ *           @c max_accel, and whose acceleration changes with at most @c max_jerk, so the
+ *           speed follows an S-curve: the acceleration ramps up, holds, then ramps back down
+ *           to land on the set point with no overshoot.
+ *
+ *           The profile is worked out one step at a time, so the set point can change at any
+ *           moment, even in the middle of a ramp. Each step it tries, in order, to raise the
+ *           acceleration by one jerk step, to hold it, or to lower it, and takes the first of
+ *           those after which the acceleration could still be brought back to zero without
+ *           passing the set point. The state is kept in Q16, in RPM and RPM per step, so a
+ *           step is a few integer multiplies and one division.
+ */
+class setpointProfile {
+    protected:
+        int64_t speed_q16;                                          // Reference speed, Q16 RPM
+        int64_t accel_q16;                                          // Reference acceleration, Q16 RPM per step
+        int64_t accel_max_q16;                                      // Largest acceleration, Q16 RPM per step
+        int64_t jerk_q16;                                           // Largest change in acceleration, Q16 RPM per step per step
+        uint32_t steps_per_second;                                  // Control steps per second
+        float max_accel;                                            // Largest acceleration [RPM/s]
+        float max_jerk;                                             // Largest jerk [RPM/s^2]
+        int64_t stopping (int64_t accel);                           // Function format for the speed change while ending a ramp
+    public:
+        setpointProfile (uint32_t update_period_us);                // Format for instantiating a profile object
+        void set_limits (float accel_limit, float jerk_limit);      // Function format for setting the limits
+        void reset (int32_t speed);                                 // Function format for starting from a known speed
+        int32_t update (int32_t setpoint);                          // Function format for running one step
+        int32_t speed (void);                                       // Function format for getting the reference speed
+        int32_t acceleration (void);                                // Function format for getting the reference acceleration
+        uint32_t time_remaining (int32_t setpoint, int32_t reference, int32_t reference_accel); // Function format for the time to reach speed
+};
+
+#endif // SETPOINTPROFILE_H
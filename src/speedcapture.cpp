@@ -0,0 +1,114 @@
+/** @file speedcapture.cpp
+ *    This file contains the implementation of the input-capture timer used to
+ *    timestamp motor encoder edges in hardware.
+ *
+ *  @date 2026-Oct-16
+ */
+
+#include "speedcapture.h"                                               // Include corresponding header file
+
+/** @brief   Function called to instantiate a capture timer object.
+ *  @details This function saves the encoder pin and the desired tick rate of the timer.
+ *           The hardware timer itself is not touched until @c begin() is called from a
+ *           task, because the timer library should not be used before the scheduler starts.
+ *  @param   capture_GPIO The encoder pin, which must be connected to a timer channel
+ *  @param   frequency    The desired timer count rate in ticks per second
+ */
+captureTimer::captureTimer (uint8_t capture_GPIO, uint32_t frequency)
+{
+    capture_pin = capture_GPIO;                 // Save the parameter, which will evaporate when the constructor exits
+    tick_frequency = frequency;                 // Save the parameter, which will evaporate when the constructor exits
+    overflows = 0;                              // Initialize to 0
+    channel = 0;                                // Found from the pin map in begin()
+    timer = NULL;                               // Created in begin()
+}
+
+/** @brief   Function that configures the timer and starts capturing edges.
+ *  @details This function looks up which timer and channel the capture pin belongs to,
+ *           sets the prescaler as close as possible to the requested tick rate, and lets
+ *           the counter run freely over its full 16-bit range. The channel is set up to
+ *           capture on rising edges, which matches the rising-edge interrupt used by the
+ *           @c micros() backend.
+ *  @param   callback The ISR to run after each edge has been captured
+ */
+void captureTimer::begin (callback_function_t callback)
+{
+    PinName pin_name = digitalPinToPinName(capture_pin);                                    // Convert the Arduino pin to an STM32 pin name
+    TIM_TypeDef* instance = (TIM_TypeDef*)pinmap_peripheral(pin_name, PinMap_PWM);          // Find the timer connected to the pin
+    channel = STM_PIN_CHANNEL(pinmap_function(pin_name, PinMap_PWM));                       // Find the channel connected to the pin
+    timer = new HardwareTimer(instance);                                                    // Create the timer object
+    timer->setMode(channel, TIMER_INPUT_CAPTURE_RISING, capture_pin);                       // Capture the counter on each rising edge
+    uint32_t prescale = timer->getTimerClkFreq()/tick_frequency;                            // Find the prescaler for the requested rate
+    timer->setPrescaleFactor(prescale ? prescale : 1);                                      // A prescaler of 0 is not allowed
+    tick_frequency = timer->getTimerClkFreq()/timer->getPrescaleFactor();                   // Store the rate the timer actually counts at
+    timer->setOverflow(0x10000);                                                            // Let the counter use its full 16 bits
+    timer->attachInterrupt(std::bind(&captureTimer::rollover, this));                       // Count wraps in the overflow interrupt
+    timer->attachInterrupt(channel, callback);                                              // Run the callback after each capture
+    timer->resume();                                                                        // Start counting
+}
+
+/** @brief   Function called by the overflow interrupt.
+ *  @details Each time the 16-bit counter wraps, the upper half of the timestamp
+ *           is increased by one.
+ */
+void captureTimer::rollover (void)
+{
+    overflows ++;                               // The counter has wrapped once more
+}
+
+/** @brief   Function that returns the timestamp of the most recent edge.
+ *  @details This function must be called from the capture ISR. It joins the number of
+ *           counter wraps with the 16-bit value latched in the capture register. If the
+ *           counter wrapped shortly before the edge, the overflow interrupt may still be
+ *           pending behind this one. In that case the overflow flag is still set and the
+ *           captured value is small, so one more wrap is added here. If the captured value
+ *           is large, the edge happened before the wrap and the count is already correct.
+ *  @returns The edge time, in ticks of @c frequency()
+ */
+uint32_t captureTimer::read (void)
+{
+    uint32_t captured = timer->getCaptureCompare(channel);                                  // Counter value latched at the edge
+    uint32_t wraps = overflows;                                                             // Number of wraps serviced so far
+    if (__HAL_TIM_GET_FLAG(timer->getHandle(), TIM_FLAG_UPDATE) && captured < 0x8000)       // If a wrap is pending and happened before the edge...
+    {                                                                                       //
+        wraps ++;                                                                           //      Then, count it now
+    }                                                                                       //
+    return (wraps << 16) | captured;                                                        // Join the two halves of the timestamp
+}
+
+/** @brief   Function that returns the current time of the timer.
+ *  @details This gives "now" in the same ticks as the edge timestamps, so the time since
+ *           the last edge can be found without mixing clocks. It doesn't lock anything, so
+ *           it can be called from a task or from the control loop ISR. If the overflow
+ *           interrupt runs while the counter is being read, the wrap count changes and the
+ *           read is tried again; a wrap which hasn't been serviced yet is caught by the same
+ *           pending-flag test as in @c read().
+ *  @returns The current time, in ticks of @c frequency()
+ */
+uint32_t captureTimer::now (void)
+{
+    uint32_t wraps;                                                                         // Number of wraps serviced so far
+    uint32_t count;                                                                         // Current counter value
+    bool pending;                                                                           // If a wrap hasn't been serviced yet
+    do                                                                                      // Read everything...
+    {                                                                                       //
+        wraps = overflows;                                                                  //
+        count = timer->getCount();                                                          //
+        pending = __HAL_TIM_GET_FLAG(timer->getHandle(), TIM_FLAG_UPDATE);                  //
+    } while (wraps != overflows);                                                           // ...until no wrap was serviced in between
+    if (pending && count < 0x8000)                                                          // If a wrap is pending and happened before the read...
+    {                                                                                       //
+        wraps ++;                                                                           //      Then, count it now
+    }                                                                                       //
+    return (wraps << 16) | count;                                                           // Join the two halves of the time
+}
+
+/** @brief   Function that returns the rate that the timer counts at.
+ *  @details The prescaler is an integer, so the actual rate may differ slightly
+ *           from the one requested. This value is only valid after @c begin().
+ *  @returns The timer count rate in ticks per second
+ */
+uint32_t captureTimer::frequency (void)
+{
+    return tick_frequency;
+}
@@ -0,0 +1,42 @@
+/** @file speedcapture.h
+ *    This file contains the class definition for a hardware input-capture
+ *    timer which latches the time of each motor encoder edge in hardware.
+ *  @date 2026-Oct-16
+ */
+
+#ifndef SPEEDCAPTURE_H
+#define SPEEDCAPTURE_H
+#include <Arduino.h>
+#include <PrintStream.h>
+#if (defined STM32L4xx || defined STM32F4xx)
+    #include <STM32FreeRTOS.h>
+#endif
+
+/** @brief   Defines the class for an input-capture timer.
+ *  @details When the encoder is timed with @c attachInterrupt() and @c micros(), the
+ *           timestamp is taken whenever the ISR gets around to running, so interrupt
+ *           latency shows up as jitter in the measured speed. This class instead puts the
+ *           encoder pin on a hardware timer channel in input-capture mode. The timer copies
+ *           its counter into the capture register the instant the edge arrives, and the ISR
+ *           only has to read it back afterwards. The capture register is 16 bits wide, so
+ *           the timer's overflow interrupt counts wraps and @c read() joins the two into a
+ *           32-bit timestamp. These timestamps are passed to @c speedEstimator::edge() in
+ *           place of @c micros(), with the estimator configured for @c frequency().
+ */
+class captureTimer {
+    protected:
+        uint8_t capture_pin;                                        // Encoder pin wired to a timer channel
+        uint32_t channel;                                           // Timer channel that latches the edge time
+        uint32_t tick_frequency;                                    // Timer count rate in ticks per second
+        volatile uint32_t overflows;                                // Number of times the 16-bit counter has wrapped
+        HardwareTimer* timer;                                       // Timer that the capture pin belongs to
+        void rollover (void);                                       // Function called when the counter wraps
+    public:
+        captureTimer (uint8_t capture_GPIO, uint32_t frequency);    // Format for instantiating a capture timer object
+        void begin (callback_function_t callback);                  // Function format for starting the timer
+        uint32_t read (void);                                       // Function format for reading the latest capture
+        uint32_t now (void);                                        // Function format for reading the current time
+        uint32_t frequency (void);                                  // Function format for getting the actual tick rate
+};
+
+#endif // SPEEDCAPTURE_H
@@ -0,0 +1,148 @@
+/** @file speedestimator.cpp
+ *    This file contains the implementation of the M/T-method speed estimator.
+ *
+ *  @date 2026-Oct-16
+ */
+
+#include "speedestimator.h"                                             // Include corresponding header file
+
+/** @brief   Function called to instantiate a speed estimator object.
+ *  @details Timestamps are assumed to be in microseconds; if they come from a
+ *           hardware capture timer instead, call @c configure() with its rate.
+ *  @param   counts_per_revolution How many encoder counts the motor makes per revolution
+ */
+speedEstimator::speedEstimator (uint8_t counts_per_revolution)
+{
+    configure(counts_per_revolution, 1000000);  // Default to micros() timestamps
+    window_position = 0;                        // Initialize to 0
+    window_time = 0;                            // Initialize to 0
+    last_position = 0;                          // Initialize to 0
+    last_time = 0;                              // Initialize to 0
+    last_period = 0;                            // Initialize to 0
+    window_corrected = 0;                       // Initialize to 0
+    calibration = NULL;                         // Slot widths aren't corrected by default
+    window_edges = 0;                           // Initialize to 0
+    started = false;                            // No edge has been seen yet
+    speed = 0;                                  // Initialize to 0
+    period_mode = true;                         // Nothing has been counted yet
+    updated = false;                            // Nothing has been measured yet
+    stopped = true;                             // No edges have been seen yet
+    stall_periods = 4;                          // A few missing edges in a row means a stall
+}
+
+/** @brief   Function that sets the encoder resolution and the rate of its timestamps.
+ *  @details These are combined into the constant part of the speed equation once, here,
+ *           rather than every time a window is closed, and the stall timeout limits are
+ *           converted into ticks. The longest timeout is the time for @c STALL_MIN_PERIODS
+ *           counts at @c STALL_MIN_RPM, which is longer the fewer counts the encoder makes
+ *           per revolution. It must not be called from an ISR.
+ *  @param   counts_per_revolution How many encoder counts the motor makes per revolution
+ *  @param   tick_rate Rate of the clock that timestamps are taken in, in ticks per second
+ */
+void speedEstimator::configure (uint8_t counts_per_revolution, uint32_t tick_rate)
+{
+    rpm_math.configure(counts_per_revolution, tick_rate);   // Work out the constant part of the speed equation
+    uint32_t counts = max(counts_per_revolution, (uint8_t)1);                   // Don't divide by an unset resolution
+    stall_min_ticks = (uint64_t)tick_rate*STALL_MIN_US/1000000;                 // Convert the stall timeout limits to ticks
+    stall_max_ticks = (uint64_t)tick_rate*60*STALL_MIN_PERIODS/(STALL_MIN_RPM*counts); // Time for a few counts at the slowest speed
+    stall_max_ticks = max(stall_max_ticks, stall_min_ticks);                    //
+}
+
+/** @brief   Function that gives the estimator a table to correct slot widths with.
+ *  @details The table only changes the periods once it is ready, so it can be given here
+ *           before it has been learned or loaded.
+ *  @param   table The disc calibration table, or NULL to stop correcting
+ */
+void speedEstimator::use_calibration (discCalibration* table)
+{
+    calibration = table;                        // Save the parameter, which will evaporate when the function exits
+}
+
+/** @brief   Function that records one encoder edge.
+ *  @details This function only stores the time and position of the edge. The motor task
+ *           calls it for each edge it drains from the encoder ring, in the same batch as
+ *           @c sample(), so it never runs in an ISR. The very first edge opens the first
+ *           window. Every other edge adds its period to the window time, after correcting it
+ *           for the width of its slot if there is a calibration table.
+ *  @param   timestamp The time of the edge, in ticks of the rate given to @c configure()
+ *  @param   position  The encoder count after the edge
+ */
+void speedEstimator::edge (uint32_t timestamp, int32_t position)
+{
+    if (!started)                               // If this is the first edge, or the first since a stop...
+    {                                           //
+        window_time = timestamp;                //      Then, it opens the first window
+        window_position = position;             //
+        started = true;                         //
+    }                                           //
+    else                                        // Otherwise...
+    {                                           //
+        window_edges ++;                        //      Count it as part of the window
+        last_period = timestamp - last_time;    //      Time it since the previous edge
+        window_corrected += calibration         //      Add it to the window, corrected if there is a table
+            ? calibration->correct(last_period, last_position, position)
+            : last_period;                      //
+    }                                           //
+    last_time = timestamp;                      // Save the time of the latest edge
+    last_position = position;                   // Save the position at the latest edge
+}
+
+/** @brief   Function that closes the window and estimates the speed.
+ *  @details This function should be called at a fixed rate, such as once per run of the
+ *           motor task. If any edges arrived since the window opened, the speed is the
+ *           change in position divided by the time between the edges at each end of the
+ *           window, scaled to RPM by @c rpmCalculator. The latest edge then opens the next
+ *           window. If no edges arrived, the window stays open. In that case the time since
+ *           the last edge is used to lower the estimate, or to declare the motor stopped, as
+ *           described for the class. Until a period has been timed since the first edge, there
+ *           is nothing to scale the stall timeout from, so the longest one is used; otherwise
+ *           a slow motor would be declared stopped before its second edge. A window that closes
+ *           with exactly one edge has timed a single period, which is what happens at crawl
+ *           speeds. Timestamps are subtracted as unsigned numbers, so a wrap of the timer
+ *           between the two edges does not matter.
+ *  @param   now The current time, read before any edges waiting to be recorded were taken
+ *           out of the encoder ring buffer, in the same ticks as the edge timestamps
+ *  @returns The speed in RPM, negative in reverse
+ */
+int32_t speedEstimator::sample (uint32_t now)
+{
+    updated = (window_edges != 0);                                          // Only a window with edges is a new measurement
+    if (!updated)                                                           // If no edges arrived in this window...
+    {                                                                       //
+        int32_t quiet = now - last_time;                                    //      Time since the last edge; negative if it came after now
+        if (started && quiet > 0)                                           //      If the motor has been turning...
+        {                                                                   //
+            uint64_t timeout = stall_max_ticks;                             //          Wait as long as allowed for a second edge
+            if (last_period)                                                //          If a period has been timed since the start...
+            {                                                               //
+                timeout = (uint64_t)last_period*stall_periods;              //              Then, allow a few edge periods without an edge
+                timeout = constrain(timeout, stall_min_ticks, stall_max_ticks); //          But keep the timeout within its limits
+            }                                                               //
+            int32_t bound = rpm_math.rpm(1, quiet);                         //          Fastest speed that could give no edge since
+            if ((uint32_t)quiet > timeout)                                  //          If the timeout has passed...
+            {                                                               //
+                speed = 0;                                                  //              Then, the motor has stopped
+                stopped = true;                                             //
+                started = false;                                            //              The next edge opens a fresh window
+                last_period = 0;                                            //              And has no period to time out from
+                updated = true;                                             //
+            }                                                               //
+            else if (abs(speed) > bound)                                    //          Else if the estimate is above the bound...
+            {                                                               //
+                speed = speed < 0 ? -bound : bound;                         //              Then, lower it to the bound
+                updated = true;                                             //
+            }                                                               //
+        }                                                                   //
+        return speed;                                                       //      Keep the window open
+    }                                                                       //
+    stopped = false;                                                        // Edges are arriving, so the motor is turning
+    uint32_t elapsed = window_corrected;                                    // Units of ticks; last_time - window_time if uncorrected
+    int32_t counts = last_position - window_position;                       // Units of counts
+    speed = rpm_math.rpm(counts, elapsed);                                  // Calculate speed in RPM
+    period_mode = (window_edges == 1);                                      // One edge means a single period was timed
+    window_time = last_time;                                                // The latest edge opens the next window
+    window_position = last_position;                                        //
+    window_edges = 0;                                                       // Begin counting edges in the new window
+    window_corrected = 0;                                                   //
+    return speed;
+}
@@ -0,0 +1,83 @@
+/** @file speedestimator.h
+ *    This file contains the class definition for an M/T-method speed estimator,
+ *    which measures the motor speed over a fixed time window.
+ *  @date 2026-Oct-16
+ */
+
+#ifndef SPEEDESTIMATOR_H
+#define SPEEDESTIMATOR_H
+#include <Arduino.h>
+#include <PrintStream.h>
+#if (defined STM32L4xx || defined STM32F4xx)
+    #include <STM32FreeRTOS.h>
+#endif
+#include "rpmmath.h"                                                    // Include integer RPM calculator
+#include "disccalibration.h"                                            // Include encoder disc calibration table
+
+#define STALL_MIN_US      2000                  // Shortest time without edges before the motor counts as stopped
+#define STALL_MIN_RPM     100                   // Slowest speed which must not read as stopped
+#define STALL_MIN_PERIODS 2                     // Count periods at STALL_MIN_RPM without an edge before a stop
+
+/** @brief   Defines the class for an M/T-method speed estimator.
+ *  @details Calculating the speed every few edges means that at low speed it hardly ever
+ *           updates, and at high speed it updates far more often than anything reads it.
+ *           This estimator is sampled at a fixed rate instead. Each sample counts the edges
+ *           since the previous sample (the "M" part), and divides by the time between the
+ *           first and last of those edges (the "T" part). Because both ends of the window are
+ *           exact edge times, there is no error from a partial slot at either end. The edge
+ *           that closes one window opens the next.
+ *
+ *           At crawl speeds, a window may hold one edge or none at all. If there are none,
+ *           the window is simply held open until an edge arrives, and the last speed is kept.
+ *           When an edge does arrive, it is the only one since the start of the window, so the
+ *           estimate is the period of that single slot. The estimator therefore switches from
+ *           counting over a window to timing a single period on its own, and @c period_mode
+ *           tells which one the latest estimate came from.
+ *
+ *           While the window is held open, the time since the last edge still says something:
+ *           the next edge can't come any sooner than now, so the motor must be turning no
+ *           faster than one count in that time. Each sample without edges lowers the estimate
+ *           to that bound if it is smaller, so a stopping motor decays toward zero instead of
+ *           showing its last speed forever. Once no edge has arrived for @c stall_periods times
+ *           the last edge period, the motor is taken to be stopped, the speed is set to zero
+ *           and @c stopped is raised. That timeout is kept between @c STALL_MIN_US and
+ *           @c STALL_MIN_PERIODS count periods at @c STALL_MIN_RPM, so a stall from full speed
+ *           is caught within a few milliseconds, while the slowest supported speed never reads
+ *           as stopped. The upper limit depends on the counts per revolution: with one count
+ *           per revolution a count at 100 RPM takes 600 ms, so the limit is 1.2 s.
+ *           After the first edge, and after a stop, no period has been timed yet, so the
+ *           timeout is the upper limit until the second edge arrives.
+ *
+ *           If a disc calibration table is given to @c use_calibration(), each edge period is
+ *           corrected for the width of its slot as it is recorded, and the window time is the
+ *           sum of the corrected periods rather than the raw time between its end edges. That
+ *           lets a window of only a few edges be used without ripple from uneven slots.
+ */
+class speedEstimator {
+    protected:
+        int32_t window_position;                                    // Encoder position at the edge that opened the window
+        uint32_t window_time;                                       // Time of the edge that opened the window
+        int32_t last_position;                                      // Encoder position at the latest edge
+        uint32_t last_time;                                         // Time of the latest edge
+        uint32_t last_period;                                       // Time between the latest two edges
+        uint32_t window_corrected;                                  // Sum of the corrected edge periods in the window
+        discCalibration* calibration;                               // Slot width corrections, or NULL for none
+        uint32_t stall_min_ticks;                                   // STALL_MIN_US in ticks
+        uint32_t stall_max_ticks;                                   // STALL_MIN_PERIODS count periods at STALL_MIN_RPM in ticks
+        uint16_t window_edges;                                      // Number of edges since the window opened
+        bool started;                                               // If the first edge has been seen yet
+        rpmCalculator rpm_math;                                     // Converts counts and ticks into RPM
+    public:
+        int32_t speed;                                              // Latest estimate in RPM, negative in reverse
+        bool period_mode;                                           // True if the latest estimate timed a single period
+        bool updated;                                               // True if the latest sample changed the estimate
+        bool stopped;                                               // True if no edges have arrived for the stall timeout
+        uint8_t stall_periods;                                      // Edge periods without an edge before the motor is stopped
+        speedEstimator (uint8_t counts_per_revolution);             // Format for instantiating an estimator object
+        void configure (uint8_t counts_per_revolution, uint32_t tick_rate); // Function format for setting the resolution and clock
+        void use_calibration (discCalibration* table);              // Function format for correcting slot widths
+        void edge (uint32_t timestamp, int32_t position);           // Function format for recording an encoder edge
+        int32_t sample (uint32_t now);                              // Function format for closing the window
+};
+
+#endif // SPEEDESTIMATOR_H
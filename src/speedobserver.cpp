@@ -0,0 +1,119 @@
+/** @file speedobserver.cpp
+ *    This file contains the implementation of the speed and acceleration observer.
+ *
+ *  @date 2026-Oct-16
+ */
+
+#include "speedobserver.h"                                              // Include corresponding header file
+
+/** @brief   Function called to instantiate a speed observer object.
+ *  @details The observer starts at rest with default gains. The alpha-beta gains of
+ *           0.5 and 0.15 are underdamped, since beta = 2 - alpha - 2*sqrt(1 - alpha), about
+ *           0.086, would be critical. The higher beta settles faster after a change of
+ *           acceleration, at the cost of ringing slightly below a step. The Kalman noise
+ *           levels assume about 20 RPM of measurement noise and a spindle that can change
+ *           its acceleration by a few thousand RPM/s within a single period.
+ *  @param   observer_mode     @c OBSERVER_ALPHA_BETA or @c OBSERVER_KALMAN
+ *  @param   update_period_us  Time between calls to @c update(), in microseconds
+ */
+speedObserver::speedObserver (uint8_t observer_mode, uint32_t update_period_us)
+{
+    mode = observer_mode;                       // Save the parameter, which will evaporate when the constructor exits
+    period_us = update_period_us;               // Save the parameter, which will evaporate when the constructor exits
+    dt = period_us/1000000.0f;                  // Period in seconds
+    dt_q16 = ((uint64_t)period_us << 16)/1000000; // Period in seconds, Q16
+    set_gains(0.5f, 0.15f);                     // Default alpha-beta gains
+    set_noise(1.0e7f, 400.0f);                  // Default Kalman noise levels
+    reset(0);                                   // Start at rest
+}
+
+/** @brief   Function that sets the gains of the alpha-beta filter.
+ *  @details Alpha is the fraction of the speed residual added to the speed, and beta is
+ *           the fraction of the residual, per period, added to the acceleration. Both are
+ *           converted to fixed point here so that @c update() doesn't use floats.
+ *  @param   alpha Speed gain, between 0 and 1
+ *  @param   beta  Acceleration gain, between 0 and 2
+ */
+void speedObserver::set_gains (float alpha, float beta)
+{
+    alpha_q16 = alpha*65536;                    // Convert to Q16
+    beta_dt_q16 = beta/dt*65536;                // Divide by the period once, here
+}
+
+/** @brief   Function that sets the noise levels assumed by the Kalman filter.
+ *  @param   process_noise     Jerk spectral density, in (RPM/s^2)^2/Hz
+ *  @param   measurement_noise Variance of the measured speed, in RPM^2
+ */
+void speedObserver::set_noise (float process_noise, float measurement_noise)
+{
+    q = process_noise;                          // Save the parameter, which will evaporate when the function exits
+    r = measurement_noise;                      // Save the parameter, which will evaporate when the function exits
+}
+
+/** @brief   Function that restarts the observer at a known speed.
+ *  @details The acceleration is set to zero, and the Kalman covariance is set to the
+ *           measurement noise, since the starting speed is only as good as one measurement.
+ *  @param   measured_speed The speed to start from, in RPM
+ */
+void speedObserver::reset (int32_t measured_speed)
+{
+    speed_q8 = measured_speed*256;              // Convert to Q8
+    accel_q8 = 0;                               // Initialize to 0
+    x_speed = measured_speed;                   // Start from the given speed
+    x_accel = 0;                                // Initialize to 0
+    P[0][0] = r;  P[0][1] = 0;                  // Speed is as uncertain as one measurement
+    P[1][0] = 0;  P[1][1] = r/dt;               // Acceleration is not known at all yet
+    speed = measured_speed;                     // Initialize output
+    acceleration = 0;                           // Initialize output
+}
+
+/** @brief   Function that runs one step of the observer.
+ *  @details This function must be called once per period. First the speed is predicted by
+ *           adding the acceleration times the period. If @c valid is true, the residual between
+ *           the measurement and the prediction is then used to correct both estimates; if no
+ *           new measurement was available (for example no encoder edges arrived), the
+ *           prediction is kept on its own. The results are copied to @c speed and
+ *           @c acceleration.
+ *  @param   measured_speed The latest measured speed in RPM
+ *  @param   valid          True if @c measured_speed is a new measurement
+ */
+void speedObserver::update (int32_t measured_speed, bool valid)
+{
+    if (mode == OBSERVER_ALPHA_BETA)                                                // If using the alpha-beta filter...
+    {                                                                               //
+        speed_q8 += ((int64_t)accel_q8*dt_q16) >> 16;                               //      Predict: speed += accel*dt
+        if (valid)                                                                  //      If there is a new measurement...
+        {                                                                           //
+            int32_t residual = measured_speed*256 - speed_q8;                       //          Then, find the residual in Q8
+            speed_q8 += ((int64_t)alpha_q16*residual) >> 16;                        //          Correct the speed
+            accel_q8 += ((int64_t)beta_dt_q16*residual) >> 16;                      //          Correct the acceleration
+        }                                                                           //
+        speed = speed_q8/256;                                                       //      Convert back to RPM
+        acceleration = accel_q8/256;                                                //      Convert back to RPM/s
+    }                                                                               //
+    else                                                                            // Otherwise, use the Kalman filter...
+    {                                                                               //
+        x_speed += x_accel*dt;                                                      //      Predict: speed += accel*dt
+        float dt2 = dt*dt;                                                          //
+        P[0][0] += dt*(P[0][1] + P[1][0]) + dt2*P[1][1] + q*dt2*dt/3;               //      Predict covariance: F*P*F' + Q
+        P[0][1] += dt*P[1][1] + q*dt2/2;                                            //
+        P[1][0] += dt*P[1][1] + q*dt2/2;                                            //
+        P[1][1] += q*dt;                                                            //
+        if (valid)                                                                  //      If there is a new measurement...
+        {                                                                           //
+            float residual = measured_speed - x_speed;                              //          Then, find the residual
+            float S = P[0][0] + r;                                                  //          Residual variance
+            float K0 = P[0][0]/S;                                                   //          Kalman gain for speed
+            float K1 = P[1][0]/S;                                                   //          Kalman gain for acceleration
+            x_speed += K0*residual;                                                 //          Correct the speed
+            x_accel += K1*residual;                                                 //          Correct the acceleration
+            float P00 = P[0][0], P01 = P[0][1];                                     //          Update covariance: (I - K*H)*P
+            P[0][0] -= K0*P00;                                                      //
+            P[0][1] -= K0*P01;                                                      //
+            P[1][0] -= K1*P00;                                                      //
+            P[1][1] -= K1*P01;                                                      //
+        }                                                                           //
+        speed = (int32_t)x_speed;                                                   //      Copy to the outputs
+        acceleration = (int32_t)x_accel;                                            //
+    }
+}
@@ -0,0 +1,60 @@
+/** @file speedobserver.h
+ *    This file contains the class definition for a state observer which filters
+ *    the measured motor speed and estimates its acceleration.
+ *  @date 2026-Oct-16
+ */
+
+#ifndef SPEEDOBSERVER_H
+#define SPEEDOBSERVER_H
+#include <Arduino.h>
+#include <PrintStream.h>
+#if (defined STM32L4xx || defined STM32F4xx)
+    #include <STM32FreeRTOS.h>
+#endif
+
+#define OBSERVER_ALPHA_BETA 0                   // Fixed-point alpha-beta filter
+#define OBSERVER_KALMAN     1                   // Two-state Kalman filter
+
+/** @brief   Defines the class for a speed and acceleration observer.
+ *  @details The speed measured from the encoder is noisy, and averaging it to remove the
+ *           noise makes it lag behind the motor during ramps. This observer models the
+ *           spindle as a speed that changes at a steady acceleration between samples. Each
+ *           time it runs, it predicts the new speed from the last speed and acceleration, then
+ *           corrects both by a fraction of the difference between the prediction and the new
+ *           measurement. Because the acceleration is tracked, the filtered speed keeps up with
+ *           a ramp instead of lagging behind it.
+ *
+ *           Two ways of choosing the correction are available. The alpha-beta filter uses fixed
+ *           gains and runs entirely in fixed-point math: speed and acceleration are kept in Q8
+ *           RPM and Q8 RPM/s, and the gains are in Q16. The Kalman filter tracks how uncertain
+ *           its estimate is and picks the gains that minimize the error, given how noisy the
+ *           measurement is (@c r, in RPM^2) and how quickly the acceleration can change (@c q,
+ *           the jerk spectral density in (RPM/s^2)^2/Hz). It runs in floats, so it should be
+ *           called from a task rather than an ISR.
+ */
+class speedObserver {
+    protected:
+        uint8_t mode;                                               // OBSERVER_ALPHA_BETA or OBSERVER_KALMAN
+        uint32_t period_us;                                         // Time between updates in microseconds
+        int32_t speed_q8;                                           // Alpha-beta speed estimate in Q8 RPM
+        int32_t accel_q8;                                           // Alpha-beta acceleration estimate in Q8 RPM/s
+        int32_t alpha_q16;                                          // Fraction of the residual added to the speed, Q16
+        int32_t beta_dt_q16;                                        // beta/period, for the acceleration correction, Q16 1/s
+        int32_t dt_q16;                                             // The period in seconds, Q16
+        float x_speed;                                              // Kalman speed estimate in RPM
+        float x_accel;                                              // Kalman acceleration estimate in RPM/s
+        float P[2][2];                                              // Kalman estimate covariance
+        float q;                                                    // Kalman process noise (jerk spectral density)
+        float r;                                                    // Kalman measurement noise variance
+        float dt;                                                   // The period in seconds
+    public:
+        int32_t speed;                                              // Filtered speed in RPM
+        int32_t acceleration;                                       // Estimated acceleration in RPM/s
+        speedObserver (uint8_t observer_mode, uint32_t update_period_us); // Format for instantiating an observer object
+        void set_gains (float alpha, float beta);                   // Function format for setting alpha-beta gains
+        void set_noise (float process_noise, float measurement_noise); // Function format for setting Kalman noise levels
+        void reset (int32_t measured_speed);                        // Function format for starting from a known speed
+        void update (int32_t measured_speed, bool valid);           // Function format for running one observer step
+};
+
+#endif // SPEEDOBSERVER_H
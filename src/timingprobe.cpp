@@ -0,0 +1,156 @@
+//*****************************************************************************
+/** @file    timingprobe.cpp
+ *  @brief   Source code for the timing probes.
+ *  @details This file contains the parts of the timing probe class which are
+ *           not needed quickly: setting up, clearing and printing. Starting
+ *           and stopping are inline, in the header.
+ *
+ *  @date 2026-Oct-16 Original file
+ */
+//*****************************************************************************
+
+#include "timingprobe.h"                    // Header for the timing probe class
+
+
+// Set pointer to most recently created probe to initially be NULL
+timingProbe* timingProbe::p_newest = NULL;
+
+
+/** @brief   Construct a timing probe.
+ *  @details This constructor saves the probe's name, clears its statistics and
+ *           installs it in the linked list of probes. On the STM32, it also
+ *           makes sure the cycle counter is running; the debug unit is set up
+ *           by hardware registers alone, so this is safe before the scheduler
+ *           starts.
+ *  @param   p_name The name for the probe, in a character string which must
+ *           last as long as the probe, such as a string literal
+ */
+timingProbe::timingProbe (const char* p_name)
+{
+    name = (p_name != NULL) ? p_name : "(No Name)";
+    clear ();
+
+    #if (defined STM32L4xx || defined STM32F4xx)
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk; // Turn on the debug unit
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;            // Start the cycle counter
+    #endif
+
+    // Install this probe in the linked list of probes
+    p_next = p_newest;
+    p_newest = this;
+}
+
+
+/** @brief   Return the number of clock ticks per second.
+ *  @returns The CPU clock frequency on the STM32, or 10^9 on a PC
+ */
+uint32_t timingProbe::rate (void)
+{
+    #if (defined STM32L4xx || defined STM32F4xx)
+        return SystemCoreClock;
+    #else
+        return 1000000000UL;
+    #endif
+}
+
+
+/** @brief   Clear the probe's statistics.
+ *  @details The next start only begins a period, so a period which was partly
+ *           timed before clearing isn't counted.
+ */
+void timingProbe::clear (void)
+{
+    started = false;
+    last_start = 0;
+    count = 0;
+    busy_min = 0xFFFFFFFF;
+    busy_max = 0;
+    busy_total = 0;
+    periods = 0;
+    period_min = 0xFFFFFFFF;
+    period_max = 0;
+    period_total = 0;
+}
+
+
+/** @brief   Print a time in microseconds with two decimal places.
+ *  @param   printer Reference to the serial device on which to print
+ *  @param   ticks   The time in probe clock ticks
+ */
+static void print_us (Print& printer, uint64_t ticks)
+{
+    uint64_t hundredths = ticks * 100000000ULL / timingProbe::rate ();
+    printer.printf ("%8lu.%02u", (unsigned long)(hundredths / 100),
+                    (unsigned)(hundredths % 100));
+}
+
+
+/** @brief   Print one probe's statistics within the table, then the rest.
+ *  @details The statistics are copied inside a critical section, so a probe in
+ *           an ISR can't change them halfway through being printed. Times are
+ *           printed in microseconds. The jitter is the difference between the
+ *           longest and shortest period.
+ *  @param   printer Reference to the serial device on which to print
+ */
+void timingProbe::print_in_list (Print& printer)
+{
+    portENTER_CRITICAL ();
+    timingProbe copy = *this;
+    portEXIT_CRITICAL ();
+
+    // Print this probe's name and pad it to 16 characters
+    printer.printf ("%-16s%8lu", name, (unsigned long)copy.count);
+    if (copy.count)
+    {
+        print_us (printer, copy.busy_min);
+        print_us (printer, copy.busy_total / copy.count);
+        print_us (printer, copy.busy_max);
+    }
+    if (copy.periods)
+    {
+        print_us (printer, copy.period_min);
+        print_us (printer, copy.period_total / copy.periods);
+        print_us (printer, copy.period_max);
+        print_us (printer, copy.period_max - copy.period_min);
+    }
+    printer << endl;
+
+    // Call the next item
+    if (p_next != NULL)
+    {
+        p_next->print_in_list (printer);
+    }
+}
+
+
+/** @brief   Print a table showing the statistics of every probe.
+ *  @details The most recently created probe is printed first, followed by the
+ *           others in reverse order of creation, as with the shares.
+ *  @param   printer Reference to the serial device on which to print
+ */
+void print_all_probes (Print& printer)
+{
+    printer.println ("Probe              Count     Busy us (min/mean/max)     "
+                     "  Period us (min/mean/max), jitter");
+    printer.println ("-----              -----     ----------------------     "
+                     "  ----------------------------------");
+
+    if (timingProbe::p_newest != NULL)
+    {
+        timingProbe::p_newest->print_in_list (printer);
+    }
+}
+
+
+/** @brief   Clear the statistics of every probe.
+ */
+void clear_all_probes (void)
+{
+    for (timingProbe* probe = timingProbe::p_newest; probe != NULL;
+         probe = probe->p_next)
+    {
+        portENTER_CRITICAL ();
+        probe->clear ();
+        portEXIT_CRITICAL ();
+    }
+}
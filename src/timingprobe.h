@@ -0,0 +1,162 @@
+//*****************************************************************************
+/** @file    timingprobe.h
+ *  @brief   Named probes which time ISRs, task loops and the control step.
+ *  @details This file contains a class for a timing probe, which records how
+ *           long a piece of code takes and how steady the period between its
+ *           starts is, and macros which put probes into the code. Like shares,
+ *           every probe is put in a linked list when it is created, and
+ *           @c print_all_probes() prints them all in one table.
+ *
+ *  @date 2026-Oct-16 Original file
+ */
+//*****************************************************************************
+
+// This define prevents this .h file from being included more than once
+#ifndef _TIMINGPROBE_H_
+#define _TIMINGPROBE_H_
+
+#include <Arduino.h>
+#include <PrintStream.h>
+#if (defined STM32L4xx || defined STM32F4xx)
+    #include <STM32FreeRTOS.h>
+#else
+    #include <chrono>                       // Monotonic clock on a PC
+    #ifndef portENTER_CRITICAL              // No interrupts to shut out on a PC
+        #define portENTER_CRITICAL()
+        #define portEXIT_CRITICAL()
+    #endif
+#endif
+
+#ifndef TIMING_PROBES
+    #define TIMING_PROBES 1                 // 1 -> probes are compiled in, 0 -> they compile to nothing
+#endif
+
+
+/** @brief   Class for a timing probe.
+ *  @details A probe is started at the top of the code it times and stopped at
+ *           the bottom. Each start and stop reads a free-running clock, which
+ *           on the STM32 is the CPU cycle counter in the debug unit, so a probe
+ *           costs a few register reads and compares and never blocks. The time
+ *           between start and stop goes into the minimum, maximum and total
+ *           busy time, and the time between one start and the next goes into
+ *           the minimum, maximum and total period, so a task loop or ISR which
+ *           starts late shows up as a spread between the shortest and longest
+ *           period. Everything is kept in fixed fields in the probe itself.
+ *
+ *           Each probe must only be started and stopped from one place, such
+ *           as one ISR or one task, and the code it times must not call itself.
+ *
+ *           On a PC, where there is no cycle counter, the clock is the C++
+ *           monotonic clock in nanoseconds, so the same code and the same
+ *           printout can be used in a simulation.
+ *
+ *           @section usage_probe Usage
+ *           Probes are put in with macros, so that when @c TIMING_PROBES is 0
+ *           they, and all their overhead, disappear:
+ *           @code{.cpp}
+ *           #include "timingprobe.h"
+ *           ...
+ *           TIMING_PROBE (isr_probe, "Encoder ISR");
+ *           ...
+ *           void an_ISR ()
+ *           {
+ *               PROBE_START (isr_probe);
+ *               ...
+ *               PROBE_STOP (isr_probe);
+ *           }
+ *           @endcode
+ */
+class timingProbe
+{
+    protected:
+        const char* name;                     ///< Name shown in the printout
+        timingProbe* p_next;                  ///< Next probe in the list
+        static timingProbe* p_newest;         ///< Most recently created probe
+        bool started;                         ///< If there's a start to time a period from
+        uint32_t last_start;                  ///< Clock reading at the last start
+        uint32_t count;                       ///< Number of times stopped
+        uint32_t busy_min;                    ///< Shortest time from start to stop
+        uint32_t busy_max;                    ///< Longest time from start to stop
+        uint64_t busy_total;                  ///< Total time from start to stop
+        uint32_t periods;                     ///< Number of periods timed
+        uint32_t period_min;                  ///< Shortest time from one start to the next
+        uint32_t period_max;                  ///< Longest time from one start to the next
+        uint64_t period_total;                ///< Total time from one start to the next
+
+    public:
+        // Construct a probe and put it in the list
+        timingProbe (const char* p_name);
+
+        /** @brief   Read the clock the probes use.
+         *  @returns CPU cycles on the STM32, or nanoseconds on a PC
+         */
+        static inline uint32_t ticks (void)
+        {
+            #if (defined STM32L4xx || defined STM32F4xx)
+                return DWT->CYCCNT;
+            #else
+                return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>
+                       (std::chrono::steady_clock::now ().time_since_epoch ()).count ();
+            #endif
+        }
+
+        // Return the number of clock ticks per second
+        static uint32_t rate (void);
+
+        /** @brief   Start timing, and time the period since the last start.
+         */
+        inline void start (void)
+        {
+            uint32_t now = ticks ();
+            if (started)
+            {
+                uint32_t period = now - last_start;
+                if (period < period_min) { period_min = period; }
+                if (period > period_max) { period_max = period; }
+                period_total += period;
+                periods++;
+            }
+            started = true;
+            last_start = now;
+        }
+
+        /** @brief   Stop timing, and record the time since the start.
+         */
+        inline void stop (void)
+        {
+            uint32_t busy = ticks () - last_start;
+            if (busy < busy_min) { busy_min = busy; }
+            if (busy > busy_max) { busy_max = busy; }
+            busy_total += busy;
+            count++;
+        }
+
+        // Clear the statistics
+        void clear (void);
+
+        // Print this probe, then the rest of the list
+        void print_in_list (Print& printer);
+
+        friend void print_all_probes (Print& printer);
+        friend void clear_all_probes (void);
+};
+
+
+// Function that prints a table of all the probes
+void print_all_probes (Print& printer);
+
+// Function that clears all the probes
+void clear_all_probes (void);
+
+
+#if TIMING_PROBES
+    #define TIMING_PROBE(probe, name)   timingProbe probe (name)
+    #define PROBE_START(probe)          probe.start ()
+    #define PROBE_STOP(probe)           probe.stop ()
+#else
+    #define TIMING_PROBE(probe, name)   extern int probe ## _unused
+    #define PROBE_START(probe)          do { } while (0)
+    #define PROBE_STOP(probe)           do { } while (0)
+#endif
+
+#endif // _TIMINGPROBE_H_
@@ -0,0 +1,225 @@
+/** @file triacdriver.cpp
+ *    This file contains the implementation of the phase-angle triac motor driver.
+ *
+ *  @date 2026-Oct-16
+ */
+
+#include "triacdriver.h"                                                // Include corresponding header file
+
+/** @brief   Function called to instantiate a triac driver object.
+ *  @details This function saves the pins and timer and works out the firing delay table.
+ *           The gate is held low, but the timer and interrupts are not touched until
+ *           @c begin() is called from a task.
+ *  @param   gate_GPIO       The pin driving the triac gate
+ *  @param   zero_cross_GPIO The pin from the zero-cross detector, which must support interrupts
+ *  @param   timer_instance  A timer with a compare channel, not used for anything else
+ *  @param   mains_hz        The mains frequency, 50 or 60 Hz
+ */
+triacDriver::triacDriver (uint8_t gate_GPIO, uint8_t zero_cross_GPIO,
+                          TIM_TypeDef* timer_instance, uint8_t mains_hz)
+    : pll(500000/mains_hz)
+{
+    gate_pin = gate_GPIO;                       // Save the parameter, which will evaporate when the constructor exits
+    zero_cross_pin = zero_cross_GPIO;           // Save the parameter, which will evaporate when the constructor exits
+    instance = timer_instance;                  // Save the parameter, which will evaporate when the constructor exits
+    timer = NULL;                               // Created in begin()
+    firing_delay = 0;                           // Off
+    power = 0;                                  // Off
+    sigma = 0;                                  // Initialize to 0
+    mode = TRIAC_PHASE_ANGLE;                   // Phase-angle firing by default
+    state = TRIAC_IDLE;                         // Not firing
+    pinMode(gate_pin, OUTPUT);                  // Configure the gate pin for output
+    digitalWrite(gate_pin, LOW);                // Hold the triac off
+    set_mains(mains_hz);                        // Work out the firing delays
+}
+
+/** @brief   Function that works out the firing delay table for a mains frequency.
+ *  @details For each duty cycle, the firing angle which gives that fraction of full power
+ *           is found, starting from the arccos approximation and refining it with Newton's
+ *           method. The power falls off slowly near the ends of the half cycle, where
+ *           Newton's method would overshoot, so each step is kept within 0 to pi. Delays are
+ *           kept between @c TRIAC_MIN_DELAY_US and @c TRIAC_MARGIN_US before the end of the
+ *           half cycle. The phase-locked loop is started over at the new frequency. This uses
+ *           floats and should be called before the driver is running.
+ *  @param   mains_hz The mains frequency, 50 or 60 Hz
+ */
+void triacDriver::set_mains (uint8_t mains_hz)
+{
+    half_period_us = 500000/mains_hz;                                               // Length of a half cycle
+    pll.set_period(half_period_us);                                                 // Track the new frequency
+    delay_us[0] = 0;                                                                // Duty cycle 0 never fires
+    for (uint16_t duty = 1; duty < 256; duty++)                                     // For each other duty cycle...
+    {                                                                               //
+        float power = duty/255.0f;                                                  //      Fraction of full power wanted
+        float angle = acosf(2*power - 1);                                           //      Start close
+        for (uint8_t i = 0; i < 6; i++)                                             //      Refine it
+        {                                                                           //
+            float error = 1 - angle/PI + sinf(2*angle)/(2*PI) - power;              //          Power at this angle, less the power wanted
+            float slope = -2*sinf(angle)*sinf(angle)/PI;                            //          Change in power per radian
+            if (slope > -1e-4f) { break; }                                          //          Too flat to improve on
+            angle = constrain(angle - error/slope, 0.0f, (float)PI);                //
+        }                                                                           //
+        int32_t delay = angle/PI*half_period_us;                                    //      Convert to a delay
+        delay_us[duty] = constrain(delay, TRIAC_MIN_DELAY_US, half_period_us - TRIAC_MARGIN_US); //
+    }                                                                               //
+}
+
+/** @brief   Function that starts the timer and the zero-cross interrupt.
+ *  @details The timer counts microseconds over its full 16 bits and never stops; each
+ *           firing is timed by moving its compare channel, so the counter is never reset.
+ */
+void triacDriver::begin (void)
+{
+    timer = new HardwareTimer(instance);                                                    // Create the timer object
+    uint32_t prescale = timer->getTimerClkFreq()/TRIAC_TICK_HZ;                             // Find the prescaler for microseconds
+    timer->setPrescaleFactor(prescale ? prescale : 1);                                      // A prescaler of 0 is not allowed
+    timer->setOverflow(0x10000);                                                            // Let the counter use its full 16 bits
+    timer->setMode(TRIAC_CHANNEL, TIMER_OUTPUT_COMPARE);                                    // Compare without driving a pin
+    timer->attachInterrupt(TRIAC_CHANNEL, std::bind(&triacDriver::compare, this));          // Time the gate in the compare interrupt
+    timer->resume();                                                                        // Start counting
+    pinMode(zero_cross_pin, INPUT);                                                         // Configure the zero-cross pin for input
+    attachInterrupt(digitalPinToInterrupt(zero_cross_pin),                                  // Start each half cycle on a zero crossing
+                    std::bind(&triacDriver::zero_cross, this), RISING);                     //
+}
+
+/** @brief   Function that chooses how the triac is fired.
+ *  @details The change takes effect from the next half cycle. The sigma-delta accumulator
+ *           is cleared, so burst mode starts from a skipped half cycle.
+ *  @param   drive_mode @c TRIAC_PHASE_ANGLE or @c TRIAC_BURST
+ */
+void triacDriver::set_mode (uint8_t drive_mode)
+{
+    sigma = 0;                                  // Start the modulator over
+    mode = drive_mode;                          // Save the parameter, which will evaporate when the function exits
+}
+
+/** @brief   Function that sets the compare channel for the next firing.
+ *  @details This is called once per half cycle. In burst mode, the sigma-delta modulator
+ *           decides here whether the half cycle is conducted, and if it is, the triac is
+ *           fired as early as it will latch. A skipped half cycle still sets the compare
+ *           channel, without raising the gate, so that a locked loop goes on to the next
+ *           half cycle even if a zero-crossing edge goes missing. If the firing time has
+ *           already passed, or is about to, the channel is set a little ahead instead, since
+ *           a compare value just behind the counter wouldn't go off until the counter had
+ *           wrapped all the way around.
+ *  @param   crossing The timer count of the zero crossing to fire after [us]
+ *  @param   now      The timer count now [us]
+ */
+void triacDriver::arm (uint16_t crossing, uint16_t now)
+{
+    uint16_t wait = firing_delay;                                                   // Read the delay once
+    uint8_t next_state = TRIAC_ARMED;                                               //
+    if (mode == TRIAC_BURST && power > 0)                                           // If firing whole half cycles...
+    {                                                                               //
+        sigma += power;                                                             //      Then, add up the power wanted
+        wait = TRIAC_MIN_DELAY_US;                                                  //
+        if (sigma >= 255)                                                           //      If a whole half cycle is owed...
+        {                                                                           //
+            sigma -= 255;                                                           //          Then, conduct this one
+        }                                                                           //
+        else                                                                        //      Otherwise...
+        {                                                                           //
+            next_state = TRIAC_SKIPPING;                                            //          Skip it, but keep the time
+        }                                                                           //
+    }                                                                               //
+    else if (mode == TRIAC_BURST || wait == 0)                                      // Else if the motor is off...
+    {                                                                               //
+        state = TRIAC_IDLE;                                                         //      Then, don't fire this half cycle
+        return;                                                                     //
+    }                                                                               //
+    uint16_t fire = crossing + wait;                                                // Fire after the delay
+    if ((int16_t)(fire - now) < TRIAC_MIN_LEAD_US)                                  // If that is too soon...
+    {                                                                               //
+        fire = now + TRIAC_MIN_LEAD_US;                                             //      Then, fire as soon as possible
+    }                                                                               //
+    timer->setCaptureCompare(TRIAC_CHANNEL, fire);                                  //
+    state = next_state;                                                             //
+}
+
+/** @brief   Function called by the zero-cross interrupt at the start of each half cycle.
+ *  @details The edge is given to the phase-locked loop. If the loop is locked, the firing
+ *           is timed from its prediction, so the edge is only used to start firing again
+ *           after the motor has been off, or on the edge which locks the loop. Firing then
+ *           starts in the half cycle the edge began, from the loop's estimate of its crossing,
+ *           so that half cycle isn't lost. Otherwise, unless the loop rejected the edge as a
+ *           glitch, the compare channel is set to go off after the firing delay, and a gate
+ *           pulse which is somehow still on is ended, so the triac can't be left firing into
+ *           the next half cycle.
+ */
+void triacDriver::zero_cross (void)
+{
+    uint16_t now = timer->getCount();                                               // Time of the zero crossing
+    bool glitch = !pll.edge(now);                                                   // Track the mains
+    if (pll.locked)                                                                 // If the loop is following the mains...
+    {                                                                               //
+        if (state == TRIAC_IDLE && !glitch)                                         //      Then, if nothing is armed...
+        {                                                                           //
+            arm(pll.current(), now);                                                //          Fire in this half cycle
+        }                                                                           //
+        else if (state == TRIAC_IDLE)                                               //      Else if a glitch came first...
+        {                                                                           //
+            arm(pll.next_after(now), now);                                          //          Fire after the next crossing
+        }                                                                           //
+        return;                                                                     //
+    }                                                                               //
+    if (glitch)                                                                     // If the edge was too far off to be real...
+    {                                                                               //
+        return;                                                                     //      Then, leave the firing alone
+    }                                                                               //
+    if (state == TRIAC_FIRING)                                                      // If the last pulse is still on...
+    {                                                                               //
+        digitalWrite(gate_pin, LOW);                                                //      Then, end it
+    }                                                                               //
+    arm(now, now);                                                                  // Fire after the delay
+}
+
+/** @brief   Function called by the compare interrupt.
+ *  @details The first compare after a zero crossing raises the gate and moves the compare
+ *           to the end of the pulse; the second lowers it and, if the phase-locked loop is
+ *           locked, sets the compare for the next half cycle from its prediction. A half cycle
+ *           skipped in burst mode has only the one compare, which sets up the next. The counter
+ *           passes the compare value once per wrap even when nothing is armed, and those are
+ *           ignored.
+ */
+void triacDriver::compare (void)
+{
+    if (state == TRIAC_ARMED)                                                       // If the firing delay has passed...
+    {                                                                               //
+        digitalWrite(gate_pin, HIGH);                                               //      Then, fire the triac
+        uint16_t end = timer->getCaptureCompare(TRIAC_CHANNEL) + TRIAC_PULSE_US;    //      End the pulse later
+        timer->setCaptureCompare(TRIAC_CHANNEL, end);                               //
+        state = TRIAC_FIRING;                                                       //
+    }                                                                               //
+    else if (state == TRIAC_FIRING || state == TRIAC_SKIPPING)                      // Else if the pulse or the skipped firing is over...
+    {                                                                               //
+        digitalWrite(gate_pin, LOW);                                                //      Then, end it; the triac stays on by itself
+        state = TRIAC_IDLE;                                                         //
+        if (pll.locked)                                                             //      If the loop is following the mains...
+        {                                                                           //
+            uint16_t now = timer->getCount();                                       //          Then, fire after the next crossing
+            arm(pll.next_after(now), now);                                          //
+        }                                                                           //
+    }                                                                               //
+}
+
+/** @brief   Function that returns the firing delay for a duty cycle.
+ *  @param   duty The duty cycle, 0 to 255
+ *  @returns The delay after the zero crossing [us], or 0 if the triac isn't fired
+ */
+uint16_t triacDriver::delay (int32_t duty)
+{
+    return delay_us[constrain(duty, 0, 255)];
+}
+
+/** @brief   Function that sets the power sent to the motor.
+ *  @details The new firing delay or burst power is used from the next half cycle on.
+ *           Each is written in one word, so this can be called from the control loop interrupt.
+ *  @param   DUTYCYCLE Fraction of full power, 0 to 255, as for PWM
+ *  @param   DIRECTION Ignored, since the motor can't be reversed from the mains
+ */
+void triacDriver::run (int32_t DUTYCYCLE, int32_t DIRECTION)
+{
+    (void)DIRECTION;                            // The triac can't reverse the motor
+    firing_delay = delay(DUTYCYCLE);            // Used from the next zero crossing
+    power = constrain(DUTYCYCLE, 0, 255);       // Used by burst mode instead
+}
@@ -0,0 +1,101 @@
+/** @file triacdriver.h
+ *    This file contains the class definition for a motor driver which runs the
+ *    spindle from AC mains through a triac, using phase-angle control.
+ *  @date 2026-Oct-16
+ */
+
+#ifndef TRIACDRIVER_H
+#define TRIACDRIVER_H
+#include <Arduino.h>
+#include <PrintStream.h>
+#if (defined STM32L4xx || defined STM32F4xx)
+    #include <STM32FreeRTOS.h>
+#endif
+#include "motorstuff.h"                         // Base class for motor drivers
+#include "mainspll.h"                           // Phase-locked loop on the zero crossings
+
+#define TRIAC_TICK_HZ      1000000              // Timer count rate, so delays are in microseconds
+#define TRIAC_CHANNEL      1                    // Timer channel whose compare interrupt times the gate
+#define TRIAC_PULSE_US     100                  // Length of the gate pulse
+#define TRIAC_MIN_DELAY_US 150                  // Earliest firing, so there is enough voltage for the triac to latch
+#define TRIAC_MARGIN_US    250                  // Latest firing before the next zero crossing, so the pulse ends in time
+#define TRIAC_MIN_LEAD_US  20                   // Soonest the compare channel is set to go off
+
+#define TRIAC_PHASE_ANGLE  0                    // Fire part way through every half cycle
+#define TRIAC_BURST        1                    // Fire whole half cycles, chosen by a sigma-delta modulator
+
+#define TRIAC_IDLE         0                    // Not firing this half cycle
+#define TRIAC_ARMED        1                    // Waiting for the firing delay to pass
+#define TRIAC_FIRING       2                    // Gate pulse on
+#define TRIAC_SKIPPING     3                    // Burst mode is skipping this half cycle
+
+/** @brief   Defines the class for a phase-angle triac motor driver.
+ *  @details A router's universal motor runs straight from the mains, so its power can't be
+ *           set with @c analogWrite(). Instead, a triac is switched on part way through each
+ *           half cycle and conducts until the current falls to zero at the end of it. The later
+ *           it is fired, the less of the half cycle reaches the motor.
+ *
+ *           A zero-cross detector interrupts at the start of each half cycle. The interrupt
+ *           reads a free-running timer, which counts microseconds, and sets a compare channel
+ *           to go off after the firing delay. The compare interrupt raises the gate, and sets
+ *           the compare channel again to lower it @c TRIAC_PULSE_US later. The time is kept
+ *           by the timer hardware, so the firing delay doesn't depend on how long the
+ *           interrupts take to respond.
+ *
+ *           The raw zero-cross edges jitter, so once the mains phase-locked loop has locked
+ *           onto them, the edges only feed the loop, and the firing is timed from its
+ *           prediction instead: when each gate pulse ends, the compare channel is set for the
+ *           firing delay after the next predicted crossing. A lost or extra edge then doesn't
+ *           change the firing at all. Until the loop locks, and if it unlocks, each half cycle
+ *           is fired from its raw edge as before.
+ *
+ *           The power reaching the motor is not proportional to the firing delay. For a
+ *           resistive load fired at angle a, it is 1 - a/pi + sin(2a)/(2 pi) of full power. So
+ *           that the duty cycle given to @c run() sets the power in proportion, as it does for
+ *           PWM, a table of 256 firing delays, one for each duty cycle, is worked out when the
+ *           mains frequency is set. Each angle starts from arccos(2p - 1), which is close, and
+ *           is refined with a few steps of Newton's method on the power curve. Looking up the
+ *           delay is then one array read in the interrupt.
+ *
+ *           Phase-angle control switches the triac on with the mains voltage high, which puts
+ *           a fast current step, and the interference that comes with it, into every half
+ *           cycle. In burst mode, whole half cycles are conducted or skipped instead, and the
+ *           triac is only ever fired just after a zero crossing. Which half cycles to conduct
+ *           is chosen by a first-order sigma-delta modulator: each half cycle, the duty cycle
+ *           is added to an accumulator, and if the accumulator reaches 255, the half cycle is
+ *           conducted and 255 is taken off. The fraction of half cycles conducted is then
+ *           exactly the duty cycle over 255 on average, and the conducted half cycles are
+ *           spread as evenly as they can be, so the torque pulses are as small and as frequent
+ *           as possible. The mode can be changed at any time with @c set_mode().
+ *
+ *           The motor can't be reversed this way, so the direction given to @c run() is
+ *           ignored.
+ */
+class triacDriver : public MotorDriver {
+    protected:
+        uint8_t gate_pin;                                           // Pin driving the triac gate
+        uint8_t zero_cross_pin;                                     // Pin from the zero-cross detector
+        TIM_TypeDef* instance;                                      // Timer peripheral to use
+        HardwareTimer* timer;                                       // Timer object, created in begin()
+        uint16_t half_period_us;                                    // Length of a mains half cycle
+        uint16_t delay_us[256];                                     // Firing delay for each duty cycle
+        volatile uint16_t firing_delay;                             // Firing delay being output, 0 for off
+        volatile uint8_t power;                                     // Duty cycle being output, for burst mode
+        uint16_t sigma;                                             // Burst mode sigma-delta accumulator
+        volatile uint8_t state;                                     // TRIAC_IDLE, TRIAC_ARMED, TRIAC_FIRING or TRIAC_SKIPPING
+        void zero_cross (void);                                     // Function called by the zero-cross interrupt
+        void compare (void);                                        // Function called by the compare interrupt
+        void arm (uint16_t crossing, uint16_t now);                 // Function format for timing the next firing
+    public:
+        mainsPLL pll;                                               // Phase-locked loop on the zero crossings
+        volatile uint8_t mode;                                      // TRIAC_PHASE_ANGLE or TRIAC_BURST
+        triacDriver (uint8_t gate_GPIO, uint8_t zero_cross_GPIO,    // Format for instantiating a triac driver object
+                     TIM_TypeDef* timer_instance, uint8_t mains_hz); //
+        void set_mains (uint8_t mains_hz);                          // Function format for setting the mains frequency
+        void begin (void);                                          // Function format for starting the timer and interrupts
+        void set_mode (uint8_t drive_mode);                         // Function format for choosing phase-angle or burst firing
+        uint16_t delay (int32_t duty);                              // Function format for looking up a firing delay
+        void run (int32_t DUTYCYCLE, int32_t DIRECTION);            // Function format for setting the power
+};
+
+#endif // TRIACDRIVER_H
@@ -11,11 +11,14 @@
 #include "userInterface.h"                                              // Include the motor driver header file created for this lab
 #include "encoder.h"                                                    // Include encoder library
 #include "taskshare.h"                                                  // Include task sharing library
+#include "seqshare.h"                                                   // Include sequence-locked share library
 #include "Wire.h"                                                       // Include I2C connection library
 #include "Adafruit_GFX.h"                                               // Include Adafruit general graphics library
 #include "Adafruit_SSD1306.h"                                           // Include Adafruit_SSD1306 library
 #include "FreeMono9pt7b.h"                                              // Include custom font
 #include "taskqueue.h"                                                  // Include taskqueue library
+#include "autotune.h"                                                   // Include auto-tuner states
+#include "timingprobe.h"                                                // Include timing probe library
 #define Encoder_press 11                                                // Define press hardware pin on the encoder
 #define Encoder_A     3                                                 // Define the hardware pins used for the encoder 
 #define Encoder_B     4                                                 // On all Nucleo and Arduino dev boards, digital pins 2 & 3 support hardware interrupts
@@ -26,15 +29,21 @@ Share <int> speed_SP;                                                   // Creat
 Share <int> maxMotorSpeed;                                              // Create share for storing maxMotorSpeed
 String RES_TEXT;                                                        // Create global variable for resolution text
 bool motorEncoderRun = false;                                           // Global flag to run motor encoder ISR
+TIMING_PROBE (knobProbe, "Knob ISR");                                   // Times the knob's encoder ISR; $PROBE prints it
 
-extern Queue <int> actualMotorSpeed;                                    // Points to Queue created by motor control tasks
+extern SeqShare <int> actualMotorSpeed;                                 // Points to Share created by motor control tasks
+extern SeqShare <bool> spindleStopped;                                  // Points to Share created by motor control tasks
+extern Share <bool> autotuneStart;                                      // Points to Share created by motor control tasks
+extern SeqShare <uint8_t> autotuneState;                                // Points to Share created by motor control tasks
 /** @brief   ISR that triggers when the encoder is spun.
  *  @details This ISR updates the encoder's internal count. Count
  *           is also stored as a global variable.
  */
 void A_pin_ISR ()
 {   
+    PROBE_START(knobProbe);                                           // Time this ISR
     int count = myEncoder.update_spin();                              // Update the encoder 
+    PROBE_STOP(knobProbe);                                            //
     //Serial << "Encoder count: " << count << "        " << endl;       // Display to the serial monitor
 }
 
@@ -202,6 +211,8 @@ routerInterface::routerInterface(bool init)
     RES = new screenButton("RES.....1",2,35,EXTENDED);                                      // Create RES button   
     SPEED = new screenButton("RPM:" + String(0),2,60,EXTENDED);                             // Create SPEED button 
     MES = new screenButton("RPM:",2,35,EXTENDED);                                           // Create MES button
+    TUNE = new screenButton("Auto tune",2,35,EXTENDED);                                     // Create TUNE button, in the same place as RES
+    TUNE->state = OFF;                                                                      // Only shown when it is hovered over
     display = new Adafruit_SSD1306(128,64);                                                 // Create new display object
     static_disp_done = false;                                                               // Default to false
     page_state = 0;                                                                         // Default to zero
@@ -227,9 +238,10 @@ routerInterface::routerInterface(bool init)
 
 /** @brief   Function that is called in precise intervals by the user interface task
  *           to refresh the display.
- *  @details This function updates the display using a state machine. There are 5 possible
+ *  @details This function updates the display using a state machine. There are 6 possible
  *           display states. The user can either be: choosing whether to adjust the resolution or speed,
- *           viewing the current measured speed, adjusting the resolution, adjusting the speed, or neutral.
+ *           viewing the current measured speed, adjusting the resolution, adjusting the speed, auto-tuning
+ *           the speed controller, or neutral.
  *           First, this function updates all button objects. Not every button is displayed on the screen at
  *           any given time, so many of these update() calls will return 0; only the buttons that are not "off",
  *           are refreshed. Next, the function checks if the encoder has been pressed. Because the user can
@@ -243,6 +255,7 @@ void routerInterface::refresh(Encoder &encoder)
 {     
     SET->update(display);                                      // Refresh the appearance of the SET button if needed
     VIEW->update(display);                                     // Refresh the appearance of the VIEW button if needed
+    TUNE->update(display);                                     // Refresh the appearance of the TUNE button if needed, before RES which shares its place
     RES->update(display);                                      // Refresh the appearance of the RES button if needed
     SPEED->update(display);                                    // Refresh the appearance of the SPEED button if needed
     MES->update(display);                                      // Refresh the appearance of the MES button if needed
@@ -253,6 +266,7 @@ void routerInterface::refresh(Encoder &encoder)
         else if (button_state == 2)  {manageView(encoder); }   //      Else if state = 2... then run the VIEW state code
         else if (button_state == 3)  {manageRes(encoder);  }   //      Else if state = 3... then run the RES state code
         else if (button_state == 4)  {manageSpeed(encoder);}   //      Else if state = 4... then run the SPEED state code
+        else if (button_state == 5)  {manageTune(encoder); }   //      Else if state = 5... then run the TUNE state code
         else                         {manageSpin(encoder); }   //      Else... then run the neutral state code
     }
 }
@@ -275,7 +289,7 @@ void routerInterface::managePress(Encoder &encoder)
             RES->state = UNPRESSED; RES->refresh = true;                    // Update RES as unpressed
             SPEED->state = UNPRESSED; SPEED->refresh = true;                // Update SPEED as unpressed
             button_state = 1;                                               // Switch to button state 1
-            encoder.max_count = 3*encoder.resolution;                       // Set the max count to 3x resolution
+            encoder.max_count = 4*encoder.resolution;                       // Set the max count to 4x resolution
         }                                                                   //
         else if (VIEW->state == HOVER)                                      // If the VIEW button was pressed...
         {                                                                   //
@@ -293,6 +307,7 @@ void routerInterface::managePress(Encoder &encoder)
         if (VIEW->state == HOVER)                                           // If the VIEW button was pressed...
         {                                                                   // 
             RES->state = OFF; RES->refresh = true;                          // Update RES appearance as off
+            TUNE->state = OFF;                                              // Erasing RES erases TUNE too
             SPEED->state = OFF; SPEED->refresh = true;                      // Update SPEED appearance as off
             SET->state = UNPRESSED; SET->refresh = true;                    // Update SET appearance as unpressed
             button_state = 0;                                               // Return to neutral state
@@ -324,9 +339,17 @@ void routerInterface::managePress(Encoder &encoder)
             maxMotorSpeed.get(encoder.max_count);                           // Store the maxMotorSpeed as the maximum count
             speed_SP.get(encoder.count);                                    // Store the current set point as the current count
         }                                                                   //
+        else if (TUNE->state == HOVER)                                      // If the TUNE button was pressed...
+        {                                                                   //
+            TUNE->text = "TUNE:RUN";                                        // Show that tuning has started
+            TUNE->state = PRESSED; TUNE->refresh = true;                    // Update TUNE appearance as pressed
+            autotuneStart.put(true);                                        // Ask the motor task to start auto-tuning
+            button_state = 5;                                               // Switch to button state 5
+        }                                                                   //
         else                                                                // Otherwise...
         {                                                                   //  
             RES->state = OFF; RES->refresh = true;                          // Turn RES appearance off
+            TUNE->state = OFF;                                              // Erasing RES erases TUNE too
             SPEED->state = OFF; SPEED->refresh = true;                      // Turn SPEED appearance off
             SET->state = UNPRESSED; SET->refresh = true;                    // Turn SET appearance off
             button_state = 0;                                               // Return to neutral state
@@ -354,7 +377,7 @@ void routerInterface::managePress(Encoder &encoder)
         button_state = 1;                                                   // Switch to button state 1
         encoder.resolution = pow(10,encoder.count/encoder.resolution);      // Set the encoder resolution based on current count
         encoder.count = 2*(int)encoder.resolution;                          // Set count to 2x resolution
-        encoder.max_count = 3*(int)encoder.resolution;                      // Set max count to 3x resolution
+        encoder.max_count = 4*(int)encoder.resolution;                      // Set max count to 4x resolution
         //Serial << "Resolution: " << encoder.resolution << endl;             // Print to serial for debugging
         //Serial << "Encoder Count: " << encoder.count << endl;               // Print to serial for debugging
     }                                                                       //
@@ -365,7 +388,13 @@ void routerInterface::managePress(Encoder &encoder)
         speed_SP.put(encoder.count);                                          // Update the speed setpoint with current encoder count
         //Serial << "Speed SP: " << encoder.count << endl;                    // Print to serial for debugging
         encoder.count = 3*encoder.resolution;                               // Set count to 3x resolution
-        encoder.max_count = 3*encoder.resolution;                           // Set max count to 3x resolution
+        encoder.max_count = 4*encoder.resolution;                           // Set max count to 4x resolution
+    }                                                                       //
+    else if (button_state == 5)                                             // Else if we're in the TUNE state...
+    {                                                                       //
+        TUNE->text = "Auto tune";                                           // Put the label back
+        TUNE->state = HOVER; TUNE->refresh = true;                          // Update TUNE appearance to hovered over
+        button_state = 1;                                                   // Switch to state 1; tuning carries on until it is done
     }                                                                       //
     //Serial << "Button State: " << button_state << endl;                     // Print to serial for debugging
     encoder.pressed = false;                                                // Lower the encoder pressed flag
@@ -424,12 +453,16 @@ void routerInterface::manageRes(Encoder &encoder)
  *           meaning that they want to adjust the speed set point in increments of 10. When 
  *           they return to this state, as they twist the encoder to select another option 
  *           on the screen, the encoder's count will continue to increase or decrease by 10. 
+ *           The TUNE button has no room of its own on the screen, so at 4x resolution it is
+ *           drawn in place of the RES button, and turning back draws RES over it again. Only
+ *           one of the two is ever refreshed at a time, so neither erases the other.
  *           In this state, the SET button will always be pressed. Therefore, its appearance
  *           on the display will never need to be updated, as it is static.
  *  @param   encoder The encoder object that we're using.
  */
 void routerInterface::manageSet(Encoder &encoder)   
 {
+    TUNE->state = OFF;                                          // TUNE is only on screen at 4x resolution, below
     if ((int)encoder.count == 0)                                // If the encoder count is 0, then...
     {                                                           //
         VIEW->state = UNPRESSED;  VIEW->refresh = true;         //      Set the VIEW button as unpressed
@@ -453,6 +486,13 @@ void routerInterface::manageSet(Encoder &encoder)
         VIEW->state = UNPRESSED;  VIEW->refresh = true;         //      Set the VIEW button as unpressed
         RES->state = UNPRESSED;   RES->refresh = true;          //      Set the RES button as unpressed
         SPEED->state = HOVER;     SPEED->refresh = true;        //      Set the SPEED button as hovered over
+    }                                                           //
+    else if ((int)encoder.count == 4*(int)encoder.resolution)   // Else if the encoder count = 4x encoder resolution...
+    {                                                           //
+        VIEW->state = UNPRESSED;  VIEW->refresh = true;         //      Set the VIEW button as unpressed
+        RES->refresh = false;                                   //      Leave RES alone; TUNE is drawn over it
+        TUNE->state = HOVER;      TUNE->refresh = true;         //      Set the TUNE button as hovered over
+        SPEED->state = UNPRESSED; SPEED->refresh = true;        //      Set the SPEED button as unpressed
     }
 }
 
@@ -461,8 +501,9 @@ void routerInterface::manageSet(Encoder &encoder)
  *  @details The user interface enters this state when the user selects
  *           "View" on the display. Here, the current measured RPM of the motor
  *           is displayed, along with the current set point. To display the current
- *           speed, it retreives the current speed from the queue, and updates the 
- *           text attribute of the MES button object with the current speed. 
+ *           speed, it retreives the current speed from the share, and updates the 
+ *           text attribute of the MES button object with the current speed, or with
+ *           "STOP" if the motor task has found that the spindle has stopped turning.
  *           Since the speed set point will never change in this state, it does not 
  *           need to be updated here, as it is static. Finally, the state raises the 
  *           button's "refresh" flag, indicating that it needs to be updated on the screen.
@@ -471,8 +512,17 @@ void routerInterface::manageSet(Encoder &encoder)
 void routerInterface::manageView(Encoder &encoder)
 {
     int currentSpeed;                               // Create local variable for current speed
-    actualMotorSpeed.get(currentSpeed);             // Pull a value from the queue and store in the local variable
-    MES->text = "RPM:"+String(currentSpeed);        // Update the text attribute of the button 
+    bool stopped;                                   // Create local variable for the stopped flag
+    actualMotorSpeed.get(currentSpeed);             // Read the latest value from the share into the local variable
+    spindleStopped.get(stopped);                    // Read the stopped flag too
+    if (stopped)                                    // If the spindle has stopped...
+    {                                               //
+        MES->text = "RPM:STOP";                     //      Then, say so instead of showing a number
+    }                                               //
+    else                                            // Otherwise...
+    {                                               //
+        MES->text = "RPM:"+String(currentSpeed);    //      Update the text attribute of the button
+    }                                               //
     MES->refresh = true;                            // Raise the refresh flag
 }
 
@@ -492,6 +542,23 @@ void routerInterface::manageSpeed(Encoder &encoder)
     SPEED->refresh = true;                           // Raise the refresh flag
 }
 
+/** @brief   State of the user interface FSM while the speed controller is 
+ *           being auto-tuned.
+ *  @details This state shows whether the motor task's auto-tuner is still running,
+ *           has found new gains, or has given up, by reading its state from the share
+ *           and updating the text of the TUNE button.
+ *  @param   encoder The encoder object that we're using.
+ */
+void routerInterface::manageTune(Encoder &encoder)
+{
+    uint8_t state;                                  // Create local variable for the tuner state
+    autotuneState.get(state);                       // Read the latest value from the share
+    if      (state == TUNE_RUNNING) {TUNE->text = "TUNE:RUN"; } // If it is still running, say so
+    else if (state == TUNE_DONE)    {TUNE->text = "TUNE:DONE";} // Else if it found new gains, say so
+    else                            {TUNE->text = "TUNE:FAIL";} // Otherwise, it gave up
+    TUNE->refresh = true;                           // Raise the refresh flag
+}
+
 /** @brief   Task which interacts with a user. 
  *  @details This task demonstrates how to use a FreeRTOS task for interacting
  *           with some user while other more important things are going on.
@@ -507,7 +574,7 @@ void task_UI (void* p_params)
     attachInterrupt(digitalPinToInterrupt(Encoder_press), press_ISR, CHANGE);   // Attach interrupt for change of press pin
     routerInterface myInterface(0);                                             // Create new interface object
     myEncoder.count = 0;                                                        // Initialize to 0
-    int maxSpeed = 325;                                                         // Set max motor RPM to 30000, default
+    int maxSpeed = 30000;                                                       // Set max motor RPM to 30000, default
     maxMotorSpeed.put(maxSpeed);                                                // Store in shared task variable   
     speed_SP.put(0);                                                            // Set default speed set point to 0, default
     // Initialise the xLastWakeTime variable with the current time.
@@ -71,6 +71,7 @@ class routerInterface {
         screenButton* RES;          // Create pointer for RES button
         screenButton* SPEED;        // Create pointer for SPEED button
         screenButton* MES;          // Create point for MES button
+        screenButton* TUNE;         // Create pointer for TUNE button
         Adafruit_SSD1306* display;  // Create pointer for display
     public:                                                                 
         int currentSP;
@@ -82,6 +83,7 @@ class routerInterface {
         void manageSpin(Encoder &encoder);   // Function format for neutral state
         void manageRes(Encoder &encoder);    // Function format for RES state
         void manageSpeed(Encoder &encoder);  // Function format for SPEED state
+        void manageTune(Encoder &encoder);   // Function format for TUNE state
 };
 
 /// Task functions
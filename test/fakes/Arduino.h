@@ -0,0 +1,473 @@
+/** @file Arduino.h
+ *    This file contains a fake of the parts of the Arduino core and the STM32 HAL which
+ *    the spindle code uses, so that its classes can be unit tested on a PC with the
+ *    native environment. Everything is inline, so a test only has to include the source
+ *    files it tests. Pins, time and the timer and ADC registers are plain variables which
+ *    a test sets and reads back to play the part of the hardware.
+ *  @date 2026-Oct-16
+ */
+
+#ifndef FAKE_ARDUINO_H
+#define FAKE_ARDUINO_H
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <string>
+
+using std::min;
+using std::max;
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define HIGH            1
+#define LOW             0
+#define INPUT           0
+#define OUTPUT          1
+#define INPUT_PULLUP    2
+#define RISING          3
+#define FALLING         4
+#define CHANGE          5
+#define A0              0xC0
+#define A1              0xC1
+#define A2              0xC2
+#define A3              0xC3
+#define PC10            0xD0
+#define PC11            0xD1
+#define PD2             0xD2
+#define NC              0xFFFFFFFF
+#define PI              3.1415926535897932384626433832795
+#define SERIAL_8N1      0x06
+#define SERIAL_8E1      0x26
+
+typedef uint32_t PinName;
+typedef std::function<void(void)> callback_function_t;
+
+template <class T, class L, class H> T constrain (T x, L low, H high)
+{
+    return (x < low) ? low : ((x > high) ? high : x);
+}
+
+// Time; tests move it along by hand
+inline uint32_t fake_micros = 0;                                        // The time micros() returns [us]
+inline uint32_t micros (void) { return fake_micros; }
+inline uint32_t millis (void) { return fake_micros/1000; }
+inline void delayMicroseconds (uint32_t us) { fake_micros += us; }
+inline void delay (uint32_t ms) { fake_micros += ms*1000; }
+
+// Pins; reads come from fake_pin_level, writes go to it, and interrupts are only saved
+inline uint8_t fake_pin_level[256];                                     // Level of each digital pin
+inline uint32_t fake_pin_mode[256];                                     // Mode each pin was last given
+inline uint32_t fake_analog_write[256];                                 // Last analogWrite() value on each pin
+inline uint16_t fake_analog_read[256];                                  // What analogRead() returns on each pin
+inline callback_function_t fake_pin_isr[256];                           // Interrupt attached to each pin
+inline uint32_t fake_pin_isr_mode[256];                                 // Edge the interrupt was attached for
+inline void pinMode (uint32_t pin, uint32_t mode) { fake_pin_mode[pin & 0xFF] = mode; }
+inline int digitalRead (uint32_t pin) { return fake_pin_level[pin & 0xFF]; }
+inline void digitalWrite (uint32_t pin, uint32_t level) { fake_pin_level[pin & 0xFF] = level ? HIGH : LOW; }
+inline uint32_t digitalReadFast (PinName pin) { return fake_pin_level[pin & 0xFF]; }
+inline void analogWrite (uint32_t pin, uint32_t value) { fake_analog_write[pin & 0xFF] = value; }
+inline uint32_t analogRead (uint32_t pin) { return fake_analog_read[pin & 0xFF]; }
+inline uint32_t digitalPinToInterrupt (uint32_t pin) { return pin; }
+inline PinName digitalPinToPinName (uint32_t pin) { return pin; }
+inline void attachInterrupt (uint32_t pin, callback_function_t isr, uint32_t mode)
+{
+    fake_pin_isr[pin & 0xFF] = isr;
+    fake_pin_isr_mode[pin & 0xFF] = mode;
+}
+inline void detachInterrupt (uint32_t pin) { fake_pin_isr[pin & 0xFF] = nullptr; }
+inline void noInterrupts (void) { }
+inline void interrupts (void) { }
+#define __disable_irq()
+#define __enable_irq()
+#define __DMB()
+#define __get_PRIMASK() 0u
+#define __set_PRIMASK(x) (void)(x)
+
+
+/** @brief   Fake of the Arduino Print class.
+ *  @details Only @c write(uint8_t) has to be given by a child class; everything else is
+ *           formatted with @c snprintf(), much as the Arduino core does.
+ */
+class Print
+{
+    public:
+        virtual ~Print () { }
+        virtual size_t write (uint8_t character) = 0;
+        virtual size_t write (const uint8_t* buffer, size_t size)
+        {
+            size_t written = 0;
+            while (size--)
+            {
+                written += write (*buffer++);
+            }
+            return written;
+        }
+        size_t write (const char* text) { return write ((const uint8_t*)text, strlen (text)); }
+        size_t print (const char* text) { return write (text); }
+        size_t print (const std::string& text) { return write (text.c_str ()); }
+        size_t print (char character) { return write ((uint8_t)character); }
+        size_t print (long long number) { return printf ("%lld", number); }
+        size_t print (unsigned long long number) { return printf ("%llu", number); }
+        size_t print (int number) { return print ((long long)number); }
+        size_t print (long number) { return print ((long long)number); }
+        size_t print (unsigned char number) { return print ((unsigned long long)number); }
+        size_t print (unsigned int number) { return print ((unsigned long long)number); }
+        size_t print (unsigned long number) { return print ((unsigned long long)number); }
+        size_t print (double number, int digits = 2) { return printf ("%.*f", digits, number); }
+        size_t println (void) { return write ("\r\n"); }
+        template <class T> size_t println (T thing) { size_t n = print (thing); return n + println (); }
+        size_t printf (const char* format, ...)
+        {
+            char buffer[256];
+            va_list args;
+            va_start (args, format);
+            int length = vsnprintf (buffer, sizeof (buffer), format, args);
+            va_end (args);
+            return write ((const uint8_t*)buffer, std::min ((size_t)std::max (length, 0), sizeof (buffer) - 1));
+        }
+        void flush (void) { }
+};
+
+
+/** @brief   Fake of the Arduino Stream class, which adds reading to Print.
+ */
+class Stream : public Print
+{
+    public:
+        virtual int available (void) = 0;
+        virtual int read (void) = 0;
+        virtual int peek (void) { return -1; }
+        void setTimeout (unsigned long) { }
+        size_t readBytes (char* buffer, size_t length)
+        {
+            size_t count = 0;
+            while (count < length && available ())
+            {
+                buffer[count++] = (char)read ();
+            }
+            return count;
+        }
+};
+
+
+/** @brief   Fake serial port which keeps what is written and hands out what a test queued.
+ */
+class HardwareSerial : public Stream
+{
+    public:
+        std::deque<uint8_t> received;                                   // Characters waiting to be read
+        std::string sent;                                               // Everything written so far
+        unsigned long baud = 0;                                         // Rate given to begin()
+        uint32_t config = 0;                                            // Format given to begin()
+        HardwareSerial (uint32_t rx = NC, uint32_t tx = NC) { (void)rx; (void)tx; }
+        void begin (unsigned long rate, uint32_t format = SERIAL_8N1) { baud = rate; config = format; }
+        using Print::write;
+        size_t write (uint8_t character) override { sent += (char)character; return 1; }
+        int available (void) override { return (int)received.size (); }
+        int availableForWrite (void) { return 64; }
+        int read (void) override
+        {
+            if (received.empty ())
+            {
+                return -1;
+            }
+            int character = received.front ();
+            received.pop_front ();
+            return character;
+        }
+        int peek (void) override { return received.empty () ? -1 : received.front (); }
+        void receive (const uint8_t* data, size_t length) { received.insert (received.end (), data, data + length); }
+        void receive (const char* text) { receive ((const uint8_t*)text, strlen (text)); }
+        void setRx (uint32_t) { }
+        void setTx (uint32_t) { }
+};
+
+inline HardwareSerial Serial;
+
+
+// Timer registers, one block per timer, and what the pin map says each pin is wired to
+typedef struct
+{
+    volatile uint32_t CR1, CR2, SMCR, DIER, SR, EGR, CCMR1, CCMR2, CCER, CNT, PSC, ARR, RCR, CCR1, CCR2, CCR3, CCR4;
+} TIM_TypeDef;
+
+inline TIM_TypeDef fake_tim[8];
+#define TIM1                  (&fake_tim[0])
+#define TIM2                  (&fake_tim[1])
+#define TIM3                  (&fake_tim[2])
+#define TIM6                  (&fake_tim[3])
+#define TIM7                  (&fake_tim[4])
+#define TIM15                 (&fake_tim[5])
+#define TIM16                 (&fake_tim[6])
+#define TIM17                 (&fake_tim[7])
+#define TIM_SR_UIF            0x0001u
+#define TIM_SR_CC1IF          0x0002u
+#define TIM_SR_CC2IF          0x0004u
+#define TIM_FLAG_UPDATE       TIM_SR_UIF
+#define TIM_CR1_CEN           0x0001u
+#define TIM_CR1_URS           0x0004u
+#define TIM_CR1_ARPE          0x0080u
+#define TIM_EGR_UG            0x0001u
+#define TIM_CCMR1_OC1PE       0x0008u
+#define TIM_CCMR1_OC2PE       0x0800u
+#define TIM_CCMR2_OC3PE       0x0008u
+#define TIM_CCMR2_OC4PE       0x0800u
+
+typedef struct
+{
+    TIM_TypeDef* Instance;
+} TIM_HandleTypeDef;
+
+#define __HAL_TIM_GET_FLAG(h, f)    (((h)->Instance->SR & (f)) == (f))
+#define __HAL_TIM_CLEAR_FLAG(h, f)  ((h)->Instance->SR = ~(f))
+#define __HAL_TIM_URS_ENABLE(h)     ((h)->Instance->CR1 |= TIM_CR1_URS)
+
+inline const int PinMap_PWM[1] = { 0 };
+inline const int PinMap_ADC[1] = { 0 };
+inline const int PinMap_UART_TX[1] = { 0 };
+inline const int PinMap_UART_RTS[1] = { 0 };
+inline void* fake_pin_peripheral = TIM2;                                // What pinmap_peripheral() finds on any pin
+inline uint32_t fake_pin_function = 1;                                  // What pinmap_function() finds, the channel here
+inline void* pinmap_peripheral (PinName, const void*) { return fake_pin_peripheral; }
+inline uint32_t pinmap_function (PinName, const void*) { return fake_pin_function; }
+inline void pinmap_pinout (PinName, const void*) { }
+#define STM_PIN_CHANNEL(x)    (x)
+#define STM_PIN_INVERTED(x)   0
+
+typedef enum
+{
+    TIMER_DISABLED, TIMER_OUTPUT_COMPARE, TIMER_OUTPUT_COMPARE_ACTIVE, TIMER_OUTPUT_COMPARE_INACTIVE,
+    TIMER_OUTPUT_COMPARE_TOGGLE, TIMER_OUTPUT_COMPARE_PWM1, TIMER_OUTPUT_COMPARE_PWM2,
+    TIMER_OUTPUT_COMPARE_FORCED_ACTIVE, TIMER_OUTPUT_COMPARE_FORCED_INACTIVE, TIMER_INPUT_CAPTURE_RISING,
+    TIMER_INPUT_CAPTURE_FALLING, TIMER_INPUT_CAPTURE_BOTHEDGE, TIMER_INPUT_FREQ_DUTY_MEASUREMENT
+} TimerModes_t;
+typedef enum { TICK_FORMAT, MICROSEC_FORMAT, HERTZ_FORMAT } TimerFormat_t;
+typedef enum
+{
+    TICK_COMPARE_FORMAT, MICROSEC_COMPARE_FORMAT, HERTZ_COMPARE_FORMAT, PERCENT_COMPARE_FORMAT,
+    RESOLUTION_1B_COMPARE_FORMAT, RESOLUTION_8B_COMPARE_FORMAT = RESOLUTION_1B_COMPARE_FORMAT + 7,
+    RESOLUTION_12B_COMPARE_FORMAT = RESOLUTION_1B_COMPARE_FORMAT + 11,
+    RESOLUTION_16B_COMPARE_FORMAT = RESOLUTION_1B_COMPARE_FORMAT + 15
+} TimerCompareFormat_t;
+
+// CPU cycle counter in the debug unit; the counter doesn't run by itself, a test sets CYCCNT
+typedef struct { volatile uint32_t CTRL, CYCCNT; } DWT_Type;
+typedef struct { volatile uint32_t DEMCR; } CoreDebug_Type;
+inline DWT_Type fake_dwt;
+inline CoreDebug_Type fake_core_debug;
+#define DWT                         (&fake_dwt)
+#define CoreDebug                   (&fake_core_debug)
+#define DWT_CTRL_CYCCNTENA_Msk      0x00000001u
+#define CoreDebug_DEMCR_TRCENA_Msk  0x01000000u
+inline uint32_t SystemCoreClock = 80000000;                             // CPU clock [Hz]
+
+class HardwareTimer;
+inline HardwareTimer* fake_last_timer = nullptr;                        // The timer most recently created
+
+
+/** @brief   Fake of the STM32duino HardwareTimer class.
+ *  @details Settings go into the fake registers, as the real class puts them in the real
+ *           ones, and the interrupt callbacks are kept so a test can call them as the
+ *           hardware would, with @c fire_update() and @c fire_channel(). The counter doesn't
+ *           run by itself; a test sets @c CNT and the capture registers.
+ */
+class HardwareTimer
+{
+    public:
+        TIM_HandleTypeDef handle;                                       // Handle pointing at the fake registers
+        uint32_t clock = 80000000;                                      // Timer input clock [Hz]
+        uint32_t prescale = 1;                                          // Prescaler factor
+        TimerModes_t mode[5] = { };                                     // Mode of each channel, 1 to 4
+        uint32_t mode_pin[5] = { };                                     // Pin given with each channel's mode
+        callback_function_t update_callback;                            // Overflow interrupt
+        callback_function_t channel_callback[5];                        // Capture/compare interrupt of each channel
+        bool running = false;                                           // True between resume() and pause()
+        uint32_t priority = 0;                                          // Preemption priority given
+
+        HardwareTimer (TIM_TypeDef* instance)
+        {
+            handle.Instance = instance;
+            memset ((void*)instance, 0, sizeof (TIM_TypeDef));
+            instance->ARR = 0xFFFF;
+            fake_last_timer = this;
+        }
+        static uint32_t slot (uint32_t channel) { return (channel >= 1 && channel <= 4) ? channel : 0; }
+        volatile uint32_t* ccr (uint32_t channel)
+        {
+            volatile uint32_t* registers[4] = { &handle.Instance->CCR1, &handle.Instance->CCR2,
+                                                &handle.Instance->CCR3, &handle.Instance->CCR4 };
+            return registers[(channel - 1) & 3];
+        }
+        uint32_t tick_rate (void) { return clock/prescale; }
+        void pause (void) { running = false; handle.Instance->CR1 &= ~TIM_CR1_CEN; }
+        void resume (void) { running = true; handle.Instance->CR1 |= TIM_CR1_CEN; }
+        bool isRunning (void) { return running; }
+        void refresh (void) { handle.Instance->CNT = 0; }
+        void setPrescaleFactor (uint32_t factor) { prescale = factor; handle.Instance->PSC = factor - 1; }
+        uint32_t getPrescaleFactor (void) { return prescale; }
+        /// Like the library, a period in microseconds or hertz also picks the smallest prescaler that fits it
+        void setOverflow (uint32_t value, TimerFormat_t format = TICK_FORMAT)
+        {
+            uint32_t ticks = value;
+            if (format != TICK_FORMAT)
+            {
+                uint64_t cycles = (format == MICROSEC_FORMAT) ? (uint64_t)value*clock/1000000 : clock/value;
+                setPrescaleFactor (cycles/0x10000 + 1);
+                ticks = cycles/prescale;
+            }
+            handle.Instance->ARR = ticks - 1;
+        }
+        uint32_t getOverflow (TimerFormat_t format = TICK_FORMAT)
+        {
+            uint32_t ticks = handle.Instance->ARR + 1;
+            if (format == MICROSEC_FORMAT)
+            {
+                return (uint64_t)ticks*1000000/tick_rate ();
+            }
+            if (format == HERTZ_FORMAT)
+            {
+                return tick_rate ()/ticks;
+            }
+            return ticks;
+        }
+        void setMode (uint32_t channel, TimerModes_t new_mode, uint32_t pin = NC)
+        {
+            mode[slot (channel)] = new_mode;
+            mode_pin[slot (channel)] = pin;
+        }
+        uint32_t getCaptureCompare (uint32_t channel, TimerCompareFormat_t format = TICK_COMPARE_FORMAT)
+        {
+            (void)format;
+            return *ccr (channel);
+        }
+        void setCaptureCompare (uint32_t channel, uint32_t value, TimerCompareFormat_t format = TICK_COMPARE_FORMAT)
+        {
+            uint32_t ticks = value;
+            if (format == PERCENT_COMPARE_FORMAT)
+            {
+                ticks = (uint64_t)value*(handle.Instance->ARR + 1)/100;
+            }
+            else if (format == MICROSEC_COMPARE_FORMAT)
+            {
+                ticks = (uint64_t)value*tick_rate ()/1000000;
+            }
+            else if (format >= RESOLUTION_1B_COMPARE_FORMAT && format <= RESOLUTION_16B_COMPARE_FORMAT)
+            {
+                uint32_t bits = format - RESOLUTION_1B_COMPARE_FORMAT + 1;
+                ticks = ((uint64_t)value*(handle.Instance->ARR + 1)) >> bits;
+            }
+            *ccr (channel) = ticks;
+        }
+        void setPWM (uint32_t channel, uint32_t pin, uint32_t frequency, uint32_t percent)
+        {
+            setMode (channel, TIMER_OUTPUT_COMPARE_PWM1, pin);
+            setOverflow (frequency, HERTZ_FORMAT);
+            setCaptureCompare (channel, percent, PERCENT_COMPARE_FORMAT);
+            resume ();
+        }
+        void setCount (uint32_t count, TimerFormat_t format = TICK_FORMAT) { (void)format; handle.Instance->CNT = count; }
+        uint32_t getCount (TimerFormat_t format = TICK_FORMAT) { (void)format; return handle.Instance->CNT; }
+        void attachInterrupt (callback_function_t callback) { update_callback = callback; }
+        void attachInterrupt (uint32_t channel, callback_function_t callback) { channel_callback[slot (channel)] = callback; }
+        void detachInterrupt (void) { update_callback = nullptr; }
+        void detachInterrupt (uint32_t channel) { channel_callback[slot (channel)] = nullptr; }
+        void setInterruptPriority (uint32_t preempt, uint32_t sub) { priority = preempt; (void)sub; }
+        uint32_t getTimerClkFreq (void) { return clock; }
+        TIM_HandleTypeDef* getHandle (void) { return &handle; }
+
+        /// Run the overflow interrupt as the hardware would, clearing its flag first
+        void fire_update (void)
+        {
+            handle.Instance->SR &= ~TIM_SR_UIF;
+            if (update_callback)
+            {
+                update_callback ();
+            }
+        }
+        /// Latch @c value into a channel and run its interrupt, as an input capture would
+        void fire_channel (uint32_t channel, uint32_t value)
+        {
+            *ccr (channel) = value;
+            if (channel_callback[slot (channel)])
+            {
+                channel_callback[slot (channel)] ();
+            }
+        }
+};
+
+
+// ADC, DMA and NVIC, for the analog input; the HAL calls only record what they were given
+typedef struct { volatile uint32_t ISR; } ADC_TypeDef;
+typedef struct { volatile uint32_t CCR; } DMA_Channel_TypeDef;
+inline ADC_TypeDef fake_adc1;
+inline ADC_TypeDef fake_adc2;
+inline DMA_Channel_TypeDef fake_dma1_channel1;
+#define ADC1                  (&fake_adc1)
+#define ADC2                  (&fake_adc2)
+#define DMA1_Channel1         (&fake_dma1_channel1)
+
+typedef struct { uint32_t Request, Direction, PeriphInc, MemInc, PeriphDataAlignment, MemDataAlignment, Mode, Priority; } DMA_InitTypeDef;
+typedef struct __DMA { DMA_Channel_TypeDef* Instance; DMA_InitTypeDef Init; void* Parent; } DMA_HandleTypeDef;
+typedef struct { uint32_t Ratio, RightBitShift, TriggeredMode, OversamplingStopReset; } ADC_OversamplingTypeDef;
+typedef struct
+{
+    uint32_t ClockPrescaler, Resolution, DataAlign, ScanConvMode, EOCSelection, LowPowerAutoWait, ContinuousConvMode,
+             NbrOfConversion, DiscontinuousConvMode, ExternalTrigConv, ExternalTrigConvEdge, DMAContinuousRequests,
+             Overrun, OversamplingMode;
+    ADC_OversamplingTypeDef Oversampling;
+} ADC_InitTypeDef;
+typedef struct { ADC_TypeDef* Instance; ADC_InitTypeDef Init; DMA_HandleTypeDef* DMA_Handle; } ADC_HandleTypeDef;
+typedef struct { uint32_t Channel, Rank, SamplingTime, SingleDiff, OffsetNumber, Offset; } ADC_ChannelConfTypeDef;
+typedef int HAL_StatusTypeDef;
+enum { HAL_OK = 0, HAL_ERROR = 1 };
+enum
+{
+    DMA_REQUEST_0, DMA_PERIPH_TO_MEMORY, DMA_PINC_DISABLE, DMA_MINC_ENABLE, DMA_PDATAALIGN_HALFWORD,
+    DMA_MDATAALIGN_HALFWORD, DMA_CIRCULAR, DMA_PRIORITY_LOW, ADC_CLOCK_SYNC_PCLK_DIV4, ADC_RESOLUTION_12B,
+    ADC_DATAALIGN_RIGHT, ADC_SCAN_DISABLE, ADC_EOC_SINGLE_CONV, ADC_SOFTWARE_START, ADC_EXTERNALTRIGCONVEDGE_NONE,
+    ADC_OVR_DATA_OVERWRITTEN, ADC_OVERSAMPLING_RATIO_64, ADC_RIGHTBITSHIFT_2, ADC_TRIGGEREDMODE_SINGLE_TRIGGER,
+    ADC_REGOVERSAMPLING_CONTINUED_MODE, ADC_REGULAR_RANK_1, ADC_SAMPLETIME_92CYCLES_5, ADC_SINGLE_ENDED,
+    ADC_OFFSET_NONE, DMA1_Channel1_IRQn
+};
+#ifndef ENABLE
+    #define ENABLE  1
+    #define DISABLE 0
+#endif
+#define __HAL_RCC_ADC_CLK_ENABLE()          do { } while (0)
+#define __HAL_RCC_DMA1_CLK_ENABLE()         do { } while (0)
+#define __HAL_LINKDMA(h, f, d)              do { (h)->f = &(d); (d).Parent = (h); } while (0)
+#define __LL_ADC_DECIMAL_NB_TO_CHANNEL(n)   ((uint32_t)(n) << 26)
+
+inline int fake_hal_status = HAL_OK;                                    // What the ADC and DMA setup calls return
+inline uint32_t* fake_dma_buffer = nullptr;                             // Buffer given to HAL_ADC_Start_DMA()
+inline uint32_t fake_dma_length = 0;                                    // Its length in conversions
+inline uint32_t fake_dma_irqs = 0;                                      // Calls to HAL_DMA_IRQHandler()
+inline int HAL_DMA_Init (DMA_HandleTypeDef*) { return fake_hal_status; }
+inline void HAL_DMA_IRQHandler (DMA_HandleTypeDef*) { fake_dma_irqs++; }
+inline void HAL_NVIC_SetPriority (int, uint32_t, uint32_t) { }
+inline void HAL_NVIC_EnableIRQ (int) { }
+inline int HAL_ADC_Init (ADC_HandleTypeDef*) { return fake_hal_status; }
+inline int HAL_ADC_ConfigChannel (ADC_HandleTypeDef*, ADC_ChannelConfTypeDef*) { return fake_hal_status; }
+inline int HAL_ADCEx_Calibration_Start (ADC_HandleTypeDef*, uint32_t) { return fake_hal_status; }
+inline int HAL_ADC_Start_DMA (ADC_HandleTypeDef*, uint32_t* buffer, uint32_t length)
+{
+    fake_dma_buffer = buffer;
+    fake_dma_length = length;
+    return fake_hal_status;
+}
+
+
+// USART registers, for the RS-485 driver enable
+typedef struct { volatile uint32_t CR1, CR2, CR3; } USART_TypeDef;
+#define USART_CR1_UE          0x0001u
+#define USART_CR3_DEM         0x4000u
+
+#endif // FAKE_ARDUINO_H
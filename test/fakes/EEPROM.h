@@ -0,0 +1,22 @@
+/** @file EEPROM.h
+ *    This file contains a fake of the STM32 emulated EEPROM for the native unit tests.
+ *    The buffer is a plain array, and a flush only counts, so a test can check what was
+ *    saved and load it back.
+ *  @date 2026-Oct-16
+ */
+
+#ifndef FAKE_EEPROM_H
+#define FAKE_EEPROM_H
+#include <Arduino.h>
+
+#define E2END 0x7FF
+
+inline uint8_t fake_eeprom[E2END + 1];                                  // Contents of the emulated EEPROM
+inline uint32_t fake_eeprom_flushes = 0;                                // Times the buffer was written to flash
+
+inline void eeprom_buffer_fill (void) { }
+inline void eeprom_buffer_flush (void) { fake_eeprom_flushes++; }
+inline uint8_t eeprom_buffered_read_byte (uint32_t address) { return fake_eeprom[address & E2END]; }
+inline void eeprom_buffered_write_byte (uint32_t address, uint8_t data) { fake_eeprom[address & E2END] = data; }
+
+#endif // FAKE_EEPROM_H
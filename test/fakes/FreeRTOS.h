@@ -0,0 +1,120 @@
+/** @file FreeRTOS.h
+ *    This file contains a fake of the parts of FreeRTOS which the spindle code uses, for
+ *    the native unit tests. There is no scheduler: critical sections do nothing, delays
+ *    move @c fake_micros along, notifications are counted, and queues are plain
+ *    first-in, first-out lists which never block.
+ *  @date 2026-Oct-16
+ */
+
+#ifndef FAKE_FREERTOS_H
+#define FAKE_FREERTOS_H
+#include <Arduino.h>
+#include <vector>
+
+typedef uint32_t TickType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef void* TaskHandle_t;
+
+#define portBASE_TYPE                   long
+#define portMAX_DELAY                   0xFFFFFFFFUL
+#define portTICK_PERIOD_MS              1
+#define pdFALSE                         0
+#define pdTRUE                          1
+#define pdPASS                          1
+#define pdMS_TO_TICKS(ms)               (ms)
+#define portENTER_CRITICAL()
+#define portEXIT_CRITICAL()
+#define taskENTER_CRITICAL_FROM_ISR()   0
+#define taskEXIT_CRITICAL_FROM_ISR(x)   (void)(x)
+#define portYIELD_FROM_ISR(x)           (void)(x)
+
+// Time is kept by fake_micros, one tick per millisecond
+inline TickType_t xTaskGetTickCount (void) { return fake_micros/1000; }
+inline void vTaskDelay (TickType_t ticks) { fake_micros += ticks*1000; }
+inline void vTaskDelayUntil (TickType_t* previous, TickType_t ticks)
+{
+    *previous += ticks;
+    if (fake_micros < *previous*1000)
+    {
+        fake_micros = *previous*1000;
+    }
+}
+
+// Tasks are never created; notifications are counted and taken without waiting
+inline uint32_t fake_notifications = 0;                                 // Notifications given and not yet taken
+inline TaskHandle_t xTaskGetCurrentTaskHandle (void) { return (TaskHandle_t)&fake_notifications; }
+inline void vTaskNotifyGiveFromISR (TaskHandle_t, BaseType_t* woken)
+{
+    fake_notifications++;
+    if (woken)
+    {
+        *woken = pdTRUE;
+    }
+}
+inline uint32_t ulTaskNotifyTake (BaseType_t clear, TickType_t)
+{
+    uint32_t count = fake_notifications;
+    fake_notifications = clear ? 0 : (count ? count - 1 : 0);
+    return count;
+}
+inline BaseType_t xTaskCreate (void (*)(void*), const char*, uint32_t, void*, UBaseType_t, TaskHandle_t*) { return pdPASS; }
+inline void vTaskStartScheduler (void) { }
+
+
+/** @brief   A queue of fixed-size items, copied in and out as bytes like FreeRTOS does.
+ */
+struct fakeQueue
+{
+    size_t item_size;                                                   // Bytes in each item
+    size_t capacity;                                                    // Items which fit
+    std::deque<std::vector<uint8_t>> items;                             // Items waiting, oldest first
+};
+typedef fakeQueue* QueueHandle_t;
+
+inline QueueHandle_t xQueueCreate (UBaseType_t length, UBaseType_t item_size)
+{
+    return new fakeQueue { item_size, length, { } };
+}
+inline BaseType_t fake_queue_put (QueueHandle_t queue, const void* item, bool front)
+{
+    if (queue->items.size () >= queue->capacity)
+    {
+        return pdFALSE;
+    }
+    std::vector<uint8_t> copy ((const uint8_t*)item, (const uint8_t*)item + queue->item_size);
+    if (front)
+    {
+        queue->items.push_front (copy);
+    }
+    else
+    {
+        queue->items.push_back (copy);
+    }
+    return pdTRUE;
+}
+inline BaseType_t fake_queue_get (QueueHandle_t queue, void* item, bool remove)
+{
+    if (queue->items.empty ())
+    {
+        return pdFALSE;
+    }
+    memcpy (item, queue->items.front ().data (), queue->item_size);
+    if (remove)
+    {
+        queue->items.pop_front ();
+    }
+    return pdTRUE;
+}
+inline BaseType_t xQueueSendToBack (QueueHandle_t q, const void* item, TickType_t) { return fake_queue_put (q, item, false); }
+inline BaseType_t xQueueSendToFront (QueueHandle_t q, const void* item, TickType_t) { return fake_queue_put (q, item, true); }
+inline BaseType_t xQueueSendToBackFromISR (QueueHandle_t q, const void* item, BaseType_t*) { return fake_queue_put (q, item, false); }
+inline BaseType_t xQueueSendToFrontFromISR (QueueHandle_t q, const void* item, BaseType_t*) { return fake_queue_put (q, item, true); }
+inline BaseType_t xQueueReceive (QueueHandle_t q, void* item, TickType_t) { return fake_queue_get (q, item, true); }
+inline BaseType_t xQueueReceiveFromISR (QueueHandle_t q, void* item, BaseType_t*) { return fake_queue_get (q, item, true); }
+inline BaseType_t xQueuePeek (QueueHandle_t q, void* item, TickType_t) { return fake_queue_get (q, item, false); }
+inline BaseType_t xQueuePeekFromISR (QueueHandle_t q, void* item) { return fake_queue_get (q, item, false); }
+inline UBaseType_t uxQueueMessagesWaiting (QueueHandle_t q) { return q->items.size (); }
+inline UBaseType_t uxQueueMessagesWaitingFromISR (QueueHandle_t q) { return q->items.size (); }
+
+#endif // FAKE_FREERTOS_H
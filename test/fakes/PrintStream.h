@@ -0,0 +1,25 @@
+/** @file PrintStream.h
+ *    This file contains a fake of the PrintStream library for the native unit tests,
+ *    which streams anything @c Print can print.
+ *  @date 2026-Oct-16
+ */
+
+#ifndef FAKE_PRINTSTREAM_H
+#define FAKE_PRINTSTREAM_H
+#include <Arduino.h>
+
+enum _EndLineCode { endl };
+
+inline Print& operator<< (Print& printer, _EndLineCode)
+{
+    printer.println ();
+    return printer;
+}
+
+template <class T> Print& operator<< (Print& printer, const T& thing)
+{
+    printer.print (thing);
+    return printer;
+}
+
+#endif // FAKE_PRINTSTREAM_H
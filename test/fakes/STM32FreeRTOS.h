@@ -0,0 +1,10 @@
+/** @file STM32FreeRTOS.h
+ *    This file stands in for the STM32 FreeRTOS library in the native unit tests.
+ *  @date 2026-Oct-16
+ */
+
+#ifndef FAKE_STM32FREERTOS_H
+#define FAKE_STM32FREERTOS_H
+#include "FreeRTOS.h"
+
+#endif // FAKE_STM32FREERTOS_H
@@ -0,0 +1,260 @@
+/** @file test_main.cpp
+ *    This file contains the unit tests for the 0-10 V analog spindle speed input.
+ *    Synthetic DMA buffers are filled the way the ADC fills them, each result the sum of
+ *    64 noisy 12-bit conversions shifted down by 2, and the half-buffer callbacks are run
+ *    as the DMA interrupt would run them. The tests check the effective resolution, the
+ *    scale and deadband, how steady the set point is and how fast it follows a step.
+ *  @date 2026-Oct-16
+ */
+
+#include <unity.h>
+#include "analoginput.cpp"
+
+#define INPUT_PIN       8                       // Pin the reference comes in on
+#define FULL_SCALE_RPM  24000                   // Speed at 10 V
+#define NOISE_LSB       1.5                     // RMS noise on each 12-bit conversion
+#define HALF            (ANALOG_BUFFER_SIZE/2)  // Results in each half of the buffer
+
+static analogInput* input;                      // Input under test
+static uint32_t seed;                           // Pseudo-random state for the noise
+static bool second_half;                        // True if DMA fills the second half next
+
+/** @brief   Returns a pseudo-random number with a roughly normal spread and an RMS of one.
+ */
+static double noise (void)
+{
+    double sum = 0;
+    for (int i = 0; i < 12; i++)
+    {
+        seed = seed*1103515245 + 12345;
+        sum += ((seed >> 8) & 0xFFFF)/65536.0;
+    }
+    return sum - 6;
+}
+
+/** @brief   Returns one 12-bit conversion of an input voltage, with noise.
+ */
+static uint16_t convert (double volts)
+{
+    double counts = volts/10*4095 + NOISE_LSB*noise ();
+    return constrain (lround (counts), 0L, 4095L);
+}
+
+/** @brief   Returns one oversampled result, as the ADC's hardware oversampler makes it.
+ */
+static uint16_t oversample (double volts)
+{
+    uint32_t sum = 0;
+    for (int i = 0; i < 64; i++)
+    {
+        sum += convert (volts);
+    }
+    return sum >> 2;
+}
+
+/** @brief   Fills the next half of the DMA buffer and runs its callback.
+ */
+static void fill_half (double volts)
+{
+    uint16_t* buffer = (uint16_t*)fake_dma_buffer;
+    uint16_t* half = buffer + (second_half ? HALF : 0);
+    for (int i = 0; i < HALF; i++)
+    {
+        half[i] = oversample (volts);
+    }
+    if (second_half)
+    {
+        input->full ();
+    }
+    else
+    {
+        input->half_full ();
+    }
+    second_half = !second_half;
+}
+
+/** @brief   Returns the speed a voltage should give.
+ */
+static int32_t rpm_for (double volts)
+{
+    return lround (volts/10*FULL_SCALE_RPM);
+}
+
+void setUp (void)
+{
+    fake_pin_peripheral = ADC1;
+    fake_pin_function = 5;
+    fake_hal_status = HAL_OK;
+    seed = 42;
+    second_half = false;
+    input = new analogInput (INPUT_PIN);
+    input->set_scale (FULL_SCALE_RPM);
+    TEST_ASSERT_TRUE (input->begin ());
+}
+
+void tearDown (void)
+{
+    delete input;
+    analogInput::active = NULL;
+}
+
+void test_begin_starts_circular_dma (void)
+{
+    TEST_ASSERT_EQUAL_PTR (input, analogInput::active);
+    TEST_ASSERT_NOT_NULL (fake_dma_buffer);
+    TEST_ASSERT_EQUAL_UINT32 (ANALOG_BUFFER_SIZE, fake_dma_length);
+    uint32_t irqs = fake_dma_irqs;
+    input->interrupt ();
+    TEST_ASSERT_EQUAL_UINT32 (irqs + 1, fake_dma_irqs);
+}
+
+void test_begin_fails_off_adc1_or_on_a_hal_error (void)
+{
+    static analogInput other (INPUT_PIN);       // Left as the active input, so it must outlive the test
+    fake_pin_peripheral = ADC2;
+    TEST_ASSERT_FALSE (other.begin ());
+    fake_pin_peripheral = ADC1;
+    fake_hal_status = HAL_ERROR;
+    TEST_ASSERT_FALSE (other.begin ());
+}
+
+void test_oversampling_gives_about_14_bits (void)
+{
+    for (int i = 0; i < 50; i++)
+    {
+        fill_half (6.18);
+    }
+    double sum = 0, squares = 0, raw_sum = 0, raw_squares = 0;
+    int count = 2000;
+    for (int i = 0; i < count; i++)
+    {
+        fill_half (6.18);
+        double value = input->filtered/65520.0;
+        sum += value;
+        squares += value*value;
+        double raw = convert (6.18)/4095.0;     // What one analogRead() would have given
+        raw_sum += raw;
+        raw_squares += raw*raw;
+    }
+    double rms = sqrt (squares/count - (sum/count)*(sum/count));
+    double raw_rms = sqrt (raw_squares/count - (raw_sum/count)*(raw_sum/count));
+    double bits = log2 (1/(rms*sqrt (12.0)));
+    double raw_bits = log2 (1/(raw_rms*sqrt (12.0)));
+    char message[96];
+    snprintf (message, sizeof (message), "Effective bits %.1f, against %.1f from single conversions",
+              bits, raw_bits);
+    TEST_MESSAGE (message);
+    TEST_ASSERT_TRUE (bits >= 14);
+    TEST_ASSERT_TRUE (fabs (sum/count - 0.618) < 0.0005);
+}
+
+void test_speed_follows_the_scale (void)
+{
+    for (double volts = 0.5; volts <= 10; volts += 0.5)
+    {
+        for (int i = 0; i < 40; i++)
+        {
+            fill_half (volts);
+        }
+        TEST_ASSERT_INT32_WITHIN (ANALOG_HYSTERESIS_RPM + 10, rpm_for (volts), input->setpoint);
+    }
+}
+
+void test_deadband_keeps_the_spindle_off (void)
+{
+    input->set_deadband (1000);
+    for (int i = 0; i < 20; i++)
+    {
+        fill_half (0.3);                        // 720 RPM, below the deadband
+    }
+    TEST_ASSERT_EQUAL_INT32 (0, input->setpoint);
+    for (int i = 0; i < 20; i++)
+    {
+        fill_half (0.5);
+    }
+    TEST_ASSERT_INT32_WITHIN (ANALOG_HYSTERESIS_RPM + 10, rpm_for (0.5), input->setpoint);
+}
+
+void test_set_point_holds_steady (void)
+{
+    for (int i = 0; i < 20; i++)
+    {
+        fill_half (4.37);
+    }
+    int32_t previous = input->setpoint;
+    uint32_t changes = 0;
+    for (int i = 0; i < 2000; i++)
+    {
+        fill_half (4.37);
+        changes += (input->setpoint != previous) ? 1 : 0;
+        previous = input->setpoint;
+    }
+    TEST_ASSERT_EQUAL_UINT32 (0, changes);
+}
+
+void test_step_is_followed_within_tens_of_milliseconds (void)
+{
+    for (int i = 0; i < 20; i++)
+    {
+        fill_half (2.0);
+    }
+    uint32_t updates = 0;
+    while (abs (input->setpoint - rpm_for (8.0)) > rpm_for (8.0)/100 && updates < 1000)
+    {
+        fill_half (8.0);
+        updates++;
+    }
+    char message[64];
+    snprintf (message, sizeof (message), "Within 1%% after %u half buffers (%.1f ms)",
+              (unsigned)updates, updates*HALF*0.34);
+    TEST_MESSAGE (message);
+    TEST_ASSERT_LESS_OR_EQUAL (20, updates);
+    TEST_ASSERT_GREATER_OR_EQUAL (10, updates); // About 4 ln 75 with the filter, 1 without
+}
+
+void test_first_average_is_taken_as_it_is (void)
+{
+    fill_half (5.0);
+    TEST_ASSERT_EQUAL_UINT32 (1, input->updates);
+    TEST_ASSERT_INT32_WITHIN (30, 32760, input->filtered);
+    TEST_ASSERT_INT32_WITHIN (20, rpm_for (5.0), input->setpoint);
+}
+
+void test_each_callback_reads_its_own_half (void)
+{
+    uint16_t* buffer = (uint16_t*)fake_dma_buffer;
+    for (int i = 0; i < HALF; i++)
+    {
+        buffer[i] = 1000;
+        buffer[HALF + i] = 60000;
+    }
+    input->half_full ();
+    TEST_ASSERT_EQUAL_UINT32 (1000, input->filtered);
+    input->full ();
+    TEST_ASSERT_EQUAL_UINT32 (1000 + (59000 >> ANALOG_FILTER_SHIFT), input->filtered);
+}
+
+void test_print_shows_the_input (void)
+{
+    input->filtered = 32760;
+    input->setpoint = 12000;
+    Serial.sent.clear ();
+    input->print (Serial);
+    TEST_ASSERT_EQUAL_STRING ("Analog input 5000 mV of 10 V, 12000 RPM, 0 updates\r\n", Serial.sent.c_str ());
+}
+
+int main (void)
+{
+    UNITY_BEGIN ();
+    RUN_TEST (test_begin_starts_circular_dma);
+    RUN_TEST (test_begin_fails_off_adc1_or_on_a_hal_error);
+    RUN_TEST (test_oversampling_gives_about_14_bits);
+    RUN_TEST (test_speed_follows_the_scale);
+    RUN_TEST (test_deadband_keeps_the_spindle_off);
+    RUN_TEST (test_set_point_holds_steady);
+    RUN_TEST (test_step_is_followed_within_tens_of_milliseconds);
+    RUN_TEST (test_first_average_is_taken_as_it_is);
+    RUN_TEST (test_each_callback_reads_its_own_half);
+    RUN_TEST (test_print_shows_the_input);
+    return UNITY_END ();
+}
@@ -0,0 +1,186 @@
+/** @file test_main.cpp
+ *    This file contains the unit tests for the relay-feedback auto-tuner. The relay is
+ *    run against a simulated spindle with a first-order lag and a dead time, whose ultimate
+ *    gain and period are worked out exactly from its frequency response, and the tuner's
+ *    estimates are compared with them. The tuning rules and the ways tuning can fail are
+ *    checked as well.
+ *  @date 2026-Oct-16
+ */
+
+#include <unity.h>
+#include "autotune.cpp"
+
+#define PERIOD_US       1000                    // Control period
+#define PLANT_GAIN      80.0                    // Steady speed per unit of duty cycle [RPM]
+#define PLANT_TAU       0.3                     // Time constant of the spindle [s]
+#define DEAD_STEPS      20                      // Dead time, in control steps
+#define SETPOINT        10000                   // Speed to tune at [RPM]
+
+static relayTuner* tuner;                       // Tuner under test
+
+/** @brief   Works out the exact ultimate gain and period of the simulated spindle.
+ *  @details The phase of K e^(-Ls)/(tau s + 1) is -wL - atan(w tau); the frequency where
+ *           it reaches -180 degrees is found by bisection, and the ultimate gain is one over
+ *           the plant's gain there.
+ */
+static void exact_ultimate (double& ku, double& tu)
+{
+    double dead = DEAD_STEPS*PERIOD_US/1e6;
+    double low = 0.1, high = 10000;
+    for (int i = 0; i < 100; i++)
+    {
+        double w = (low + high)/2;
+        if (w*dead + atan (w*PLANT_TAU) < M_PI)
+        {
+            low = w;
+        }
+        else
+        {
+            high = w;
+        }
+    }
+    ku = sqrt (1 + low*PLANT_TAU*low*PLANT_TAU)/PLANT_GAIN;
+    tu = 2*M_PI/low;
+}
+
+/** @brief   Runs the tuner against the simulated spindle until it stops.
+ *  @details The spindle starts at the set point, and the duty cycle reaches it after the
+ *           dead time.
+ *  @returns The number of control steps it took
+ */
+static uint32_t run_tuner (double gain = PLANT_GAIN)
+{
+    int32_t delayed[DEAD_STEPS];
+    for (int32_t& duty : delayed)
+    {
+        duty = SETPOINT/PLANT_GAIN;
+    }
+    double speed = SETPOINT;
+    uint32_t steps = 0;
+    while (tuner->state == TUNE_RUNNING)
+    {
+        int32_t duty = tuner->step (lround (speed));
+        int32_t applied = delayed[steps % DEAD_STEPS];
+        delayed[steps % DEAD_STEPS] = duty;
+        speed += (gain*applied - speed)*PERIOD_US/1e6/PLANT_TAU;
+        steps++;
+    }
+    return steps;
+}
+
+void setUp (void)
+{
+    tuner = new relayTuner (PERIOD_US);
+}
+
+void tearDown (void)
+{
+    delete tuner;
+}
+
+/** @brief   Checks the estimates against the exact ultimate gain and period.
+ *  @details With one dominant lag the speed's swing is closer to a triangle than a sine
+ *           wave. Its peak is higher than its fundamental's by about a quarter, so a gain
+ *           worked out from the peaks would read that much low; from the fundamental, both
+ *           the gain and the period should be within 10%.
+ */
+void test_finds_the_ultimate_gain_and_period (void)
+{
+    double ku, tu;
+    exact_ultimate (ku, tu);
+    tuner->start (SETPOINT, SETPOINT/PLANT_GAIN, 20, 5, 255);
+    run_tuner ();
+    TEST_ASSERT_EQUAL_UINT8 (TUNE_DONE, tuner->state);
+    char message[96];
+    snprintf (message, sizeof (message), "Ku %.4f (exact %.4f), Tu %.4f s (exact %.4f s)",
+              tuner->ku, ku, tuner->tu, tu);
+    TEST_MESSAGE (message);
+    TEST_ASSERT_TRUE (fabs (tuner->ku - ku)/ku < 0.10);
+    TEST_ASSERT_TRUE (fabs (tuner->tu - tu)/tu < 0.10);
+}
+
+void test_rules_turn_ku_and_tu_into_gains (void)
+{
+    uint8_t rules[] = { TUNE_ZIEGLER_NICHOLS, TUNE_TYREUS_LUYBEN, TUNE_NO_OVERSHOOT, TUNE_PI };
+    float kp_ratio[] = { 0.6f, 1/2.2f, 0.2f, 0.45f };
+    float ti_ratio[] = { 0.5f, 2.2f, 0.5f, 1/1.2f };
+    float td_ratio[] = { 1/8.0f, 1/6.3f, 1/3.0f, 0 };
+    for (int i = 0; i < 4; i++)
+    {
+        tuner->rule = rules[i];
+        tuner->start (SETPOINT, SETPOINT/PLANT_GAIN, 20, 20, 255);
+        run_tuner ();
+        TEST_ASSERT_EQUAL_UINT8 (TUNE_DONE, tuner->state);
+        TEST_ASSERT_FLOAT_WITHIN (1e-5, kp_ratio[i]*tuner->ku, tuner->kp);
+        TEST_ASSERT_FLOAT_WITHIN (1e-4, tuner->kp/(ti_ratio[i]*tuner->tu), tuner->ki);
+        TEST_ASSERT_FLOAT_WITHIN (1e-6, tuner->kp*td_ratio[i]*tuner->tu, tuner->kd);
+    }
+}
+
+void test_relay_stays_within_its_band (void)
+{
+    tuner->start (SETPOINT, 250, 20, 20, 255);  // Only 5 counts of room above the bias
+    int32_t lowest = 255, highest = 0;
+    for (int i = 0; i < 1000 && tuner->state == TUNE_RUNNING; i++)
+    {
+        int32_t duty = tuner->step (i % 2 ? SETPOINT + 100 : SETPOINT - 100);
+        lowest = min (lowest, duty);
+        highest = max (highest, duty);
+    }
+    TEST_ASSERT_EQUAL_INT32 (245, lowest);
+    TEST_ASSERT_EQUAL_INT32 (255, highest);
+}
+
+void test_fails_without_a_set_point_or_room (void)
+{
+    tuner->start (0, 125, 20, 20, 255);
+    TEST_ASSERT_EQUAL_UINT8 (TUNE_FAILED, tuner->state);
+    tuner->start (SETPOINT, 0, 20, 20, 255);
+    TEST_ASSERT_EQUAL_UINT8 (TUNE_FAILED, tuner->state);
+    TEST_ASSERT_EQUAL_INT32 (0, tuner->step (SETPOINT));
+}
+
+void test_fails_when_too_fast_or_too_slow (void)
+{
+    tuner->start (SETPOINT, 125, 20, 20, 255);
+    tuner->step (SETPOINT);
+    TEST_ASSERT_EQUAL_INT32 (125, tuner->step (SETPOINT*3/2 + 1));
+    TEST_ASSERT_EQUAL_UINT8 (TUNE_FAILED, tuner->state);
+    tuner->start (SETPOINT, 125, 20, 20, 255);
+    uint32_t steps = run_tuner (0);             // A motor which never turns
+    TEST_ASSERT_EQUAL_UINT8 (TUNE_FAILED, tuner->state);
+    TEST_ASSERT_EQUAL_UINT32 (TUNE_TIMEOUT_US/PERIOD_US + 1, steps);
+}
+
+void test_abort_keeps_the_gains (void)
+{
+    tuner->start (SETPOINT, SETPOINT/PLANT_GAIN, 20, 20, 255);
+    run_tuner ();
+    float kp = tuner->kp;
+    tuner->abort ();
+    TEST_ASSERT_EQUAL_UINT8 (TUNE_DONE, tuner->state);
+    tuner->start (SETPOINT, 125, 20, 20, 255);
+    tuner->abort ();
+    TEST_ASSERT_EQUAL_UINT8 (TUNE_FAILED, tuner->state);
+    TEST_ASSERT_EQUAL_FLOAT (kp, tuner->kp);
+}
+
+void test_print_shows_the_state (void)
+{
+    Serial.sent.clear ();
+    tuner->print (Serial);
+    TEST_ASSERT_EQUAL_STRING ("Auto-tune idle, rule 0\r\n", Serial.sent.c_str ());
+}
+
+int main (void)
+{
+    UNITY_BEGIN ();
+    RUN_TEST (test_finds_the_ultimate_gain_and_period);
+    RUN_TEST (test_rules_turn_ku_and_tu_into_gains);
+    RUN_TEST (test_relay_stays_within_its_band);
+    RUN_TEST (test_fails_without_a_set_point_or_room);
+    RUN_TEST (test_fails_when_too_fast_or_too_slow);
+    RUN_TEST (test_abort_keeps_the_gains);
+    RUN_TEST (test_print_shows_the_state);
+    return UNITY_END ();
+}
@@ -0,0 +1,261 @@
+/** @file test_main.cpp
+ *    This file contains the unit tests for the triac driver's burst mode. The driver is
+ *    run on simulated mains with a fake zero-cross detector, as in the phase-angle tests,
+ *    and each gate pulse is matched to the half cycle it fires in. The sigma-delta
+ *    modulator must conduct exactly the right fraction of half cycles, spread as evenly as
+ *    possible, and a simulated motor run from the half cycles must reach the same speed as
+ *    it does in phase-angle mode, with far less ripple than if they were conducted in blocks.
+ *  @date 2026-Oct-16
+ */
+
+#include <unity.h>
+#include "mainspll.cpp"
+#include "triacdriver.cpp"
+
+#define GATE_PIN        10                      // Pin driving the triac gate
+#define ZC_PIN          11                      // Pin from the zero-cross detector
+#define HALF_PERIOD     10000                   // 50 Hz mains [us]
+#define FIRST_CROSSING  1000                    // Time of the first zero crossing [us]
+#define MAX_HALF_CYCLES 1100                    // Longest run the record holds
+#define MOTOR_TAU       0.3                     // Time constant of the simulated motor [s]
+
+// The base class is in motorstuff.cpp, which brings the whole user interface with it
+MotorDriver::MotorDriver (void) { PWM_pin = 0xFF; direction_pin = 0xFF; }
+void MotorDriver::run (int32_t DUTYCYCLE, int32_t DIRECTION) { (void)DUTYCYCLE; (void)DIRECTION; }
+void MotorDriver::run_fine (int32_t DUTY_Q8, int32_t DIRECTION) { run((DUTY_Q8 + 0x80) >> 8, DIRECTION); }
+
+static HardwareTimer* timer;                    // The driver's timer
+static uint32_t now_us;                         // Simulated time [us]
+static int32_t fired[MAX_HALF_CYCLES];          // Delay after the crossing each half cycle fired at, or -1 [us]
+
+/** @brief   Runs an interrupt and records the half cycle of any gate pulse it starts.
+ */
+static void run_isr (callback_function_t& isr)
+{
+    uint8_t before = fake_pin_level[GATE_PIN];
+    isr ();
+    if (fake_pin_level[GATE_PIN] && !before)
+    {
+        uint32_t half_cycle = (now_us - FIRST_CROSSING)/HALF_PERIOD;
+        if (half_cycle < MAX_HALF_CYCLES)
+        {
+            fired[half_cycle] = (now_us - FIRST_CROSSING) % HALF_PERIOD;
+        }
+    }
+}
+
+/** @brief   Steps the timer's counter up to a time, running the compare interrupt on the way.
+ */
+static void advance_to (uint32_t time)
+{
+    while (now_us < time)
+    {
+        now_us++;
+        TIM16->CNT = now_us & 0xFFFF;
+        if (TIM16->CNT == TIM16->CCR1)
+        {
+            run_isr (timer->channel_callback[TRIAC_CHANNEL]);
+        }
+    }
+}
+
+/** @brief   Runs the mains from one half cycle to before another, with an edge at each crossing.
+ */
+static void run_mains (uint32_t from, uint32_t to)
+{
+    for (uint32_t n = from; n < to; n++)
+    {
+        advance_to (FIRST_CROSSING + n*HALF_PERIOD);
+        run_isr (fake_pin_isr[ZC_PIN]);
+    }
+    advance_to (FIRST_CROSSING + to*HALF_PERIOD - 1);
+}
+
+/** @brief   Starts a driver's timer and interrupts, with the simulated time at 0.
+ */
+static void start (triacDriver& driver)
+{
+    driver.begin ();
+    timer = fake_last_timer;
+    now_us = 0;
+    for (int32_t& delay : fired)
+    {
+        delay = -1;
+    }
+}
+
+/** @brief   Returns the fraction of full power a resistive load gets when fired at a delay.
+ */
+static double power_at (int32_t delay)
+{
+    if (delay < 0)
+    {
+        return 0;
+    }
+    double angle = delay*M_PI/HALF_PERIOD;
+    return 1 - angle/M_PI + sin (2*angle)/(2*M_PI);
+}
+
+/** @brief   Runs a simulated motor from a record of which half cycles fired.
+ *  @details The motor's speed, as a fraction of full speed, follows the power of each half
+ *           cycle with a first-order lag.
+ *  @param   delays The firing delay of each half cycle, or -1 where it didn't fire
+ *  @param   ripple Set to the speed's peak-to-peak ripple over the second half of the run
+ *  @returns The average speed over the second half of the run
+ */
+static double run_motor (const int32_t* delays, double& ripple)
+{
+    double speed = 0, lowest = 1, highest = 0, total = 0;
+    for (uint32_t n = 0; n < MAX_HALF_CYCLES; n++)
+    {
+        speed += (power_at (delays[n]) - speed)*HALF_PERIOD/1e6/MOTOR_TAU;
+        if (n >= MAX_HALF_CYCLES/2)
+        {
+            lowest = min (lowest, speed);
+            highest = max (highest, speed);
+            total += speed;
+        }
+    }
+    ripple = highest - lowest;
+    return total/(MAX_HALF_CYCLES - MAX_HALF_CYCLES/2);
+}
+
+void setUp (void)
+{
+}
+
+void tearDown (void)
+{
+}
+
+void test_conducts_the_right_fraction_of_half_cycles (void)
+{
+    for (int32_t duty = 0; duty < 256; duty += 17)
+    {
+        triacDriver driver (GATE_PIN, ZC_PIN, TIM16, 50);
+        start (driver);
+        driver.set_mode (TRIAC_BURST);
+        driver.run (duty, 0);
+        run_mains (0, 40 + 255);
+        TEST_ASSERT_TRUE (driver.pll.locked);
+        uint32_t conducted = 0;
+        for (uint32_t n = 40; n < 40 + 255; n++)  // Any 255 half cycles
+        {
+            conducted += fired[n] >= 0 ? 1 : 0;
+        }
+        TEST_ASSERT_UINT32_WITHIN (1, duty, conducted);
+    }
+}
+
+void test_conducted_half_cycles_are_spread_evenly (void)
+{
+    int32_t duties[] = { 1, 3, 50, 100, 128, 200, 254 };
+    for (int32_t duty : duties)
+    {
+        triacDriver driver (GATE_PIN, ZC_PIN, TIM16, 50);
+        start (driver);
+        driver.set_mode (TRIAC_BURST);
+        driver.run (duty, 0);
+        run_mains (0, MAX_HALF_CYCLES);
+        uint32_t shortest = MAX_HALF_CYCLES, longest = 0, last = 0, runs = 0;
+        for (uint32_t n = 0; n < MAX_HALF_CYCLES; n++)
+        {
+            if (fired[n] >= 0)
+            {
+                if (runs++)
+                {
+                    shortest = min (shortest, n - last);
+                    longest = max (longest, n - last);
+                }
+                last = n;
+            }
+        }
+        TEST_ASSERT_GREATER_THAN (1, runs);
+        TEST_ASSERT_LESS_OR_EQUAL (shortest + 1, longest);   // A first-order modulator's gaps differ by one
+        TEST_ASSERT_EQUAL_UINT32 (255/duty, shortest);
+    }
+}
+
+void test_fires_just_after_the_crossing (void)
+{
+    triacDriver driver (GATE_PIN, ZC_PIN, TIM16, 50);
+    start (driver);
+    driver.set_mode (TRIAC_BURST);
+    driver.run (255, 0);
+    run_mains (0, 60);                          // Before and after the loop locks
+    TEST_ASSERT_TRUE (driver.pll.locked);
+    for (uint32_t n = 0; n < 60; n++)
+    {
+        TEST_ASSERT_INT32_WITHIN (1, TRIAC_MIN_DELAY_US, fired[n]);
+    }
+    TEST_ASSERT_EQUAL_UINT8 (LOW, fake_pin_level[GATE_PIN]);
+}
+
+void test_motor_reaches_the_same_speed_as_with_phase_angle (void)
+{
+    int32_t duties[] = { 30, 128, 220 };
+    for (int32_t duty : duties)
+    {
+        double speeds[2], ripples[2];
+        uint8_t modes[] = { TRIAC_PHASE_ANGLE, TRIAC_BURST };
+        for (int i = 0; i < 2; i++)
+        {
+            triacDriver driver (GATE_PIN, ZC_PIN, TIM16, 50);
+            start (driver);
+            driver.set_mode (modes[i]);
+            driver.run (duty, 0);
+            run_mains (0, MAX_HALF_CYCLES);
+            speeds[i] = run_motor (fired, ripples[i]);
+        }
+        static int32_t grouped[MAX_HALF_CYCLES];   // The same half cycles, conducted together
+        for (uint32_t n = 0; n < MAX_HALF_CYCLES; n++)
+        {
+            grouped[n] = (int32_t)(n % 255) < duty ? TRIAC_MIN_DELAY_US : -1;
+        }
+        double grouped_ripple;
+        run_motor (grouped, grouped_ripple);
+        char message[128];
+        snprintf (message, sizeof (message), "Duty %d: speed %.3f phase angle, %.3f burst; ripple "
+                  "%.3f burst, %.3f grouped", (int)duty, speeds[0], speeds[1], ripples[1], grouped_ripple);
+        TEST_MESSAGE (message);
+        TEST_ASSERT_TRUE (fabs (speeds[0] - duty/255.0) < 0.01);
+        TEST_ASSERT_TRUE (fabs (speeds[1] - duty/255.0) < 0.01);
+        TEST_ASSERT_TRUE (ripples[1] < 0.05);
+        TEST_ASSERT_TRUE (ripples[1] < grouped_ripple/5);
+    }
+}
+
+void test_mode_can_be_changed_while_running (void)
+{
+    triacDriver driver (GATE_PIN, ZC_PIN, TIM16, 50);
+    start (driver);
+    driver.run (51, 0);                         // One half cycle in five in burst mode
+    run_mains (0, 40);
+    TEST_ASSERT_TRUE (fired[39] > 5000);        // Phase angle fires late in every half cycle
+    driver.set_mode (TRIAC_BURST);
+    run_mains (40, 100);
+    uint32_t conducted = 0;
+    for (uint32_t n = 50; n < 100; n++)
+    {
+        conducted += fired[n] >= 0 ? 1 : 0;
+        TEST_ASSERT_TRUE (fired[n] < 0 || fired[n] <= TRIAC_MIN_DELAY_US + 1);
+    }
+    TEST_ASSERT_EQUAL_UINT32 (10, conducted);
+    driver.set_mode (TRIAC_PHASE_ANGLE);
+    run_mains (100, 110);
+    for (uint32_t n = 102; n < 110; n++)
+    {
+        TEST_ASSERT_EQUAL_INT32 (driver.delay (51), fired[n]);
+    }
+}
+
+int main (void)
+{
+    UNITY_BEGIN ();
+    RUN_TEST (test_conducts_the_right_fraction_of_half_cycles);
+    RUN_TEST (test_conducted_half_cycles_are_spread_evenly);
+    RUN_TEST (test_fires_just_after_the_crossing);
+    RUN_TEST (test_motor_reaches_the_same_speed_as_with_phase_angle);
+    RUN_TEST (test_mode_can_be_changed_while_running);
+    return UNITY_END ();
+}
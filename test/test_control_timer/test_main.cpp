@@ -0,0 +1,126 @@
+/** @file test_main.cpp
+ *    This file contains the unit tests for the control loop timer. The timer's update
+ *    interrupt is fired by hand with the CPU cycle counter set to chosen times, and the
+ *    jitter histogram, the maximums and the printout are checked against them.
+ *  @date 2026-Oct-16
+ */
+
+#include <unity.h>
+#include "controltimer.cpp"
+
+#define RATE        2000                        // Control loop rate [Hz]
+#define NOMINAL     (80000000/RATE)             // CPU cycles in one period
+
+static uint32_t step_cycles;                    // Cycles each step takes
+static uint32_t steps;                          // Steps run so far
+
+/** @brief   Stands in for the control loop step, taking @c step_cycles to run.
+ */
+static void step (void)
+{
+    steps++;
+    fake_dwt.CYCCNT += step_cycles;
+}
+
+/** @brief   Fires the update interrupt with the cycle counter at a given time.
+ */
+static void tick_at (uint32_t cycles)
+{
+    fake_dwt.CYCCNT = cycles;
+    fake_last_timer->fire_update ();
+}
+
+void setUp (void)
+{
+    fake_dwt.CTRL = 0;
+    fake_core_debug.DEMCR = 0;
+    step_cycles = 0;
+    steps = 0;
+}
+
+void tearDown (void)
+{
+}
+
+void test_begin_starts_the_cycle_counter_and_the_timer (void)
+{
+    static controlTimer timer (TIM7, RATE);
+    timer.begin (step);
+    TEST_ASSERT_TRUE (fake_dwt.CTRL & DWT_CTRL_CYCCNTENA_Msk);
+    TEST_ASSERT_TRUE (fake_core_debug.DEMCR & CoreDebug_DEMCR_TRCENA_Msk);
+    TEST_ASSERT_TRUE (fake_last_timer->isRunning ());
+    TEST_ASSERT_EQUAL_UINT32 (RATE, fake_last_timer->getOverflow (HERTZ_FORMAT));
+    TEST_ASSERT_EQUAL_UINT32 (500, timer.period_us ());
+}
+
+void test_steady_periods_land_in_the_first_bin (void)
+{
+    static controlTimer timer (TIM7, RATE);
+    timer.begin (step);
+    for (uint32_t n = 0; n < 100; n++)          // Across a wrap of the cycle counter
+    {
+        tick_at (0xFFF00000u + n*NOMINAL);
+    }
+    TEST_ASSERT_EQUAL_UINT32 (100, steps);
+    TEST_ASSERT_EQUAL_UINT32 (99, timer.samples);   // The first step only starts a period
+    TEST_ASSERT_EQUAL_UINT32 (99, timer.histogram[0]);
+    TEST_ASSERT_EQUAL_UINT32 (0, timer.max_jitter);
+}
+
+void test_jitter_either_way_is_binned_and_kept (void)
+{
+    static controlTimer timer (TIM7, RATE);
+    timer.begin (step);
+    step_cycles = 1234;
+    uint32_t now = 1000;
+    tick_at (now);
+    tick_at (now += NOMINAL + 40);              // 40 cycles late
+    tick_at (now += NOMINAL - 40);              // 40 cycles early
+    tick_at (now += NOMINAL + 15);              // Still inside the first bin
+    tick_at (now += NOMINAL + 5000);            // Far past the last bin
+    TEST_ASSERT_EQUAL_UINT32 (4, timer.samples);
+    TEST_ASSERT_EQUAL_UINT32 (1, timer.histogram[0]);
+    TEST_ASSERT_EQUAL_UINT32 (2, timer.histogram[40 >> CONTROL_JITTER_SHIFT]);
+    TEST_ASSERT_EQUAL_UINT32 (1, timer.histogram[CONTROL_JITTER_BINS - 1]);
+    TEST_ASSERT_EQUAL_UINT32 (5000, timer.max_jitter);
+    TEST_ASSERT_EQUAL_UINT32 (1234, timer.max_busy);
+}
+
+void test_clear_starts_timing_over (void)
+{
+    static controlTimer timer (TIM7, RATE);
+    timer.begin (step);
+    tick_at (0);
+    tick_at (NOMINAL + 300);
+    timer.clear ();
+    tick_at (10*NOMINAL);                       // Only starts a new period
+    tick_at (11*NOMINAL);
+    TEST_ASSERT_EQUAL_UINT32 (1, timer.samples);
+    TEST_ASSERT_EQUAL_UINT32 (1, timer.histogram[0]);
+    TEST_ASSERT_EQUAL_UINT32 (0, timer.max_jitter);
+}
+
+void test_print_shows_nanoseconds (void)
+{
+    static controlTimer timer (TIM7, RATE);
+    timer.begin (step);
+    step_cycles = 8000;                         // 100 us at 80 MHz
+    tick_at (0);
+    tick_at (NOMINAL + 80);                     // 1 us late
+    Serial.sent.clear ();
+    timer.print (Serial);
+    TEST_ASSERT_TRUE (Serial.sent.find ("Control loop 2000 Hz, 1 periods") != std::string::npos);
+    TEST_ASSERT_TRUE (Serial.sent.find ("Max jitter 1000 ns, max step 100000 ns of 500000 ns") != std::string::npos);
+    TEST_ASSERT_TRUE (Serial.sent.find ("  1000 ns: 1") != std::string::npos);
+}
+
+int main (void)
+{
+    UNITY_BEGIN ();
+    RUN_TEST (test_begin_starts_the_cycle_counter_and_the_timer);
+    RUN_TEST (test_steady_periods_land_in_the_first_bin);
+    RUN_TEST (test_jitter_either_way_is_binned_and_kept);
+    RUN_TEST (test_clear_starts_timing_over);
+    RUN_TEST (test_print_shows_nanoseconds);
+    return UNITY_END ();
+}
@@ -0,0 +1,207 @@
+/** @file test_main.cpp
+ *    This file contains the unit tests for the encoder disc calibration table. A simulated
+ *    disc with unevenly spaced slots is turned at a steady speed, and the periods between
+ *    its edges are fed to the table as the speed estimator does. Once learned, the corrected
+ *    periods must be even. The table must only be applied in the direction it was learned
+ *    in, must line itself up again after the count slips against the disc, and must come
+ *    back from the emulated EEPROM.
+ *  @date 2026-Oct-16
+ */
+
+#include <unity.h>
+#include "disccalibration.cpp"
+
+#define COUNTS      16                          // Counts per revolution of the simulated disc
+#define NOMINAL     3750                        // Period of an even slot at 1000 RPM, 1 MHz ticks
+
+static uint32_t width[COUNTS];                  // Period of each physical slot [ticks]
+static int32_t position;                        // Count the simulated encoder is at
+static int32_t slip;                            // Counts the encoder has lost against the disc
+
+/** @brief   Returns the physical slot the encoder is in at a count.
+ */
+static uint32_t physical (int32_t count)
+{
+    int32_t index = (count + slip) % COUNTS;
+    return index < 0 ? index + COUNTS : index;
+}
+
+/** @brief   Returns how far the widest or narrowest slot is from the nominal period.
+ */
+static uint32_t uneven (void)
+{
+    uint32_t worst = 0;
+    for (uint8_t i = 0; i < COUNTS; i++)
+    {
+        worst = max (worst, (uint32_t)abs ((int32_t)width[i] - NOMINAL));
+    }
+    return worst;
+}
+
+/** @brief   Turns the simulated disc by whole revolutions.
+ *  @details The period ending at each edge is the width of the slot the encoder was in
+ *           before it. Every period is corrected, and the largest difference of a corrected
+ *           period from the nominal one is returned.
+ */
+static uint32_t turn (discCalibration& table, int8_t step, uint32_t revolutions)
+{
+    uint32_t worst = 0;
+    for (uint32_t n = 0; n < revolutions*COUNTS; n++)
+    {
+        int32_t from = position;
+        position += step;
+        uint32_t corrected = table.correct (width[physical (from)], from, position);
+        worst = max (worst, (uint32_t)abs ((int32_t)corrected - NOMINAL));
+    }
+    return worst;
+}
+
+void setUp (void)
+{
+    for (uint8_t i = 0; i < COUNTS; i++)        // Slots up to 10% wide or narrow, summing to 16 nominal
+    {
+        width[i] = NOMINAL + lround (NOMINAL*0.1*sin (2*M_PI*i/COUNTS) + NOMINAL*0.04*cos (6*M_PI*i/COUNTS));
+    }
+    position = 1000;
+    slip = 0;
+    memset (fake_eeprom, 0xFF, sizeof (fake_eeprom));
+}
+
+void tearDown (void)
+{
+}
+
+void test_periods_pass_through_without_a_table (void)
+{
+    discCalibration table (COUNTS);
+    TEST_ASSERT_EQUAL_UINT8 (DISC_OFF, table.state);
+    TEST_ASSERT_EQUAL_UINT32 (width[3], table.correct (width[3], 3, 4));
+    TEST_ASSERT_EQUAL_UINT32 (uneven (), turn (table, 1, 2));
+}
+
+void test_learned_table_evens_out_the_slots (void)
+{
+    discCalibration table (COUNTS);
+    table.learn ();
+    turn (table, 1, DISC_LEARN_REVS);
+    TEST_ASSERT_EQUAL_UINT8 (DISC_LEARNING, table.state);   // The first revolution has nothing to compare with
+    turn (table, 1, 1);
+    TEST_ASSERT_EQUAL_UINT8 (DISC_READY, table.state);
+    TEST_ASSERT_TRUE (table.needs_saving);
+    TEST_ASSERT_LESS_OR_EQUAL (1, turn (table, 1, 4));
+}
+
+void test_unsteady_revolutions_are_not_learned (void)
+{
+    discCalibration table (COUNTS);
+    table.learn ();
+    for (uint32_t n = 0; n < 4*DISC_LEARN_REVS; n++)        // Speed up by 5% every revolution
+    {
+        for (uint8_t i = 0; i < COUNTS; i++)
+        {
+            width[i] = width[i]*20/21;
+        }
+        turn (table, 1, 1);
+        if (width[0] < 400)
+        {
+            setUp ();
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT8 (DISC_LEARNING, table.state);
+}
+
+void test_table_is_only_used_in_the_direction_it_was_learned (void)
+{
+    discCalibration forward (COUNTS);
+    forward.learn ();
+    turn (forward, 1, DISC_LEARN_REVS + 1);
+    TEST_ASSERT_EQUAL_UINT8 (DISC_READY, forward.state);
+    TEST_ASSERT_EQUAL_UINT32 (uneven (), turn (forward, -1, 2));   // Reverse periods are passed through
+    TEST_ASSERT_LESS_OR_EQUAL (1, turn (forward, 1, 2));
+
+    discCalibration reverse (COUNTS);
+    reverse.learn ();
+    turn (reverse, -1, DISC_LEARN_REVS + 1);
+    TEST_ASSERT_EQUAL_UINT8 (DISC_READY, reverse.state);
+    TEST_ASSERT_LESS_OR_EQUAL (1, turn (reverse, -1, 2));
+    TEST_ASSERT_EQUAL_UINT32 (uneven (), turn (reverse, 1, 2));
+}
+
+void test_turning_back_while_learning_starts_over (void)
+{
+    discCalibration table (COUNTS);
+    table.learn ();
+    turn (table, 1, DISC_LEARN_REVS/2);
+    turn (table, -1, DISC_LEARN_REVS);
+    TEST_ASSERT_EQUAL_UINT8 (DISC_LEARNING, table.state);
+    turn (table, -1, 1);
+    TEST_ASSERT_EQUAL_UINT8 (DISC_READY, table.state);
+    TEST_ASSERT_LESS_OR_EQUAL (1, turn (table, -1, 2));
+}
+
+void test_count_jump_aligns_the_table_again (void)
+{
+    discCalibration table (COUNTS);
+    table.learn ();
+    turn (table, 1, DISC_LEARN_REVS + 1);
+    TEST_ASSERT_EQUAL_UINT8 (DISC_READY, table.state);
+
+    table.correct (width[physical (position)], position, position + 2);   // Two counts for one slot
+    position += 2;
+    slip = -1;
+    TEST_ASSERT_EQUAL_UINT8 (DISC_ALIGNING, table.state);
+    TEST_ASSERT_EQUAL_UINT32 (uneven (), turn (table, 1, DISC_ALIGN_REVS));    // Uncorrected while aligning
+    turn (table, 1, 1);
+    TEST_ASSERT_EQUAL_UINT8 (DISC_READY, table.state);
+    TEST_ASSERT_LESS_OR_EQUAL (1, turn (table, 1, 2));
+
+    table.correct (width[physical (position)], position, position);       // An illegal transition doesn't count
+    slip = -3;
+    TEST_ASSERT_EQUAL_UINT8 (DISC_ALIGNING, table.state);
+    turn (table, 1, DISC_ALIGN_REVS + 1);
+    TEST_ASSERT_EQUAL_UINT8 (DISC_READY, table.state);
+    TEST_ASSERT_LESS_OR_EQUAL (1, turn (table, 1, 2));
+
+    table.realign ();                           // As the motor task does when the ring dropped edges
+    TEST_ASSERT_EQUAL_UINT8 (DISC_ALIGNING, table.state);
+}
+
+void test_saved_table_loads_and_aligns_after_a_restart (void)
+{
+    discCalibration learned (COUNTS);
+    TEST_ASSERT_FALSE (learned.load ());        // Nothing saved yet
+    learned.learn ();
+    turn (learned, -1, DISC_LEARN_REVS + 1);
+    uint32_t flushes = fake_eeprom_flushes;
+    learned.save ();
+    TEST_ASSERT_FALSE (learned.needs_saving);
+    TEST_ASSERT_EQUAL_UINT32 (flushes + 1, fake_eeprom_flushes);
+
+    discCalibration restarted (COUNTS);         // Powered up with the disc somewhere else
+    slip = 5;
+    position = -37;
+    TEST_ASSERT_TRUE (restarted.load ());
+    TEST_ASSERT_EQUAL_UINT8 (DISC_ALIGNING, restarted.state);
+    turn (restarted, -1, DISC_ALIGN_REVS + 1);
+    TEST_ASSERT_EQUAL_UINT8 (DISC_READY, restarted.state);
+    TEST_ASSERT_LESS_OR_EQUAL (1, turn (restarted, -1, 2));
+    TEST_ASSERT_EQUAL_UINT32 (uneven (), turn (restarted, 1, 1));  // Still only in reverse
+
+    discCalibration other (COUNTS/2);           // Another resolution doesn't use it
+    TEST_ASSERT_FALSE (other.load ());
+    fake_eeprom[DISC_EEPROM_ADDRESS + 6] ^= 0x01;   // Nor does a corrupted table
+    TEST_ASSERT_FALSE (restarted.load ());
+}
+
+int main (void)
+{
+    UNITY_BEGIN ();
+    RUN_TEST (test_periods_pass_through_without_a_table);
+    RUN_TEST (test_learned_table_evens_out_the_slots);
+    RUN_TEST (test_unsteady_revolutions_are_not_learned);
+    RUN_TEST (test_table_is_only_used_in_the_direction_it_was_learned);
+    RUN_TEST (test_turning_back_while_learning_starts_over);
+    RUN_TEST (test_count_jump_aligns_the_table_again);
+    RUN_TEST (test_saved_table_loads_and_aligns_after_a_restart);
+    return UNITY_END ();
+}
@@ -0,0 +1,152 @@
+/** @file test_main.cpp
+ *    This file contains the unit tests for the load disturbance observer. A simulated
+ *    spindle is held at speed by feed-forward and a PID controller, combined the way the
+ *    control step combines them, and a cutting load is applied as a step. The area of the
+ *    speed dip is reported with and without the observer's compensation.
+ *  @date 2026-Oct-16
+ */
+
+#include <unity.h>
+#include "pidcontroller.cpp"
+#include "disturbanceobserver.cpp"
+
+#define PERIOD_US       1000                    // Control period
+#define PLANT_GAIN      80.0                    // Steady speed per unit of duty cycle [RPM]
+#define PLANT_TAU       0.3                     // Time constant of the spindle [s]
+#define INERTIA         (PLANT_TAU/PLANT_GAIN)  // Duty cycle per RPM/s of acceleration
+#define SETPOINT        10000                   // Speed held [RPM]
+#define LOAD_DUTY       30                      // Size of the load step, in duty cycle units
+#define LOAD_START      0.5                     // Time the load is applied [s]
+
+/** @brief   Results of a simulated load step.
+ */
+struct loadResult
+{
+    double dip_area;                            // Integral of the speed lost after the load step [RPM*s]
+    double deepest;                             // Largest speed lost [RPM]
+    int32_t final_load;                         // Observer's load estimate at the end [duty cycle]
+    double final_speed;                         // Speed at the end [RPM]
+};
+
+/** @brief   Runs a load step with the observer compensating @c gain of the load.
+ *  @details The feed-forward table is exact, so the model duty cycle for a speed is just
+ *           the speed over the plant gain. The acceleration is the change in speed over one
+ *           step. The observer sees the duty cycle applied over the last step, as it does
+ *           in the control step.
+ */
+static loadResult run_load_step (float gain)
+{
+    pidController pid (PERIOD_US);
+    disturbanceObserver observer (PERIOD_US);
+    observer.set_inertia (INERTIA);
+    observer.set_gain (gain);
+    pid.set_gains (0.02, 0.02/PLANT_TAU, 0);
+    double dt = PERIOD_US/1e6;
+    double speed = SETPOINT;
+    int32_t previous_speed = SETPOINT;
+    int32_t duty = lround (SETPOINT/PLANT_GAIN);
+    loadResult result = { 0, 0, 0, 0 };
+    for (double t = 0; t < 3.0; t += dt)
+    {
+        int32_t measured = lround (speed);
+        int32_t acceleration = (measured - previous_speed)/dt;
+        previous_speed = measured;
+        observer.update (duty, lround (measured/PLANT_GAIN), acceleration);
+        int32_t feed_forward = lround (SETPOINT/PLANT_GAIN);
+        int32_t bias = constrain (feed_forward + observer.compensation (), 0, 255);
+        pid.set_limits (-bias, 255 - bias);
+        duty = bias + pid.update (SETPOINT, measured);
+        double load = t >= LOAD_START ? LOAD_DUTY : 0;
+        speed += (PLANT_GAIN*(duty - load) - speed)*dt/PLANT_TAU;
+        if (t >= LOAD_START)
+        {
+            result.dip_area += max (0.0, SETPOINT - speed)*dt;
+            result.deepest = max (result.deepest, SETPOINT - speed);
+        }
+    }
+    result.final_load = observer.load;
+    result.final_speed = speed;
+    return result;
+}
+
+void setUp (void)
+{
+}
+
+void tearDown (void)
+{
+}
+
+void test_compensation_shrinks_the_speed_dip (void)
+{
+    loadResult baseline = run_load_step (0);
+    loadResult compensated = run_load_step (1);
+    char message[128];
+    snprintf (message, sizeof (message), "Dip area %.1f RPM*s with the observer, %.1f RPM*s "
+              "without; deepest %.0f and %.0f RPM", compensated.dip_area, baseline.dip_area,
+              compensated.deepest, baseline.deepest);
+    TEST_MESSAGE (message);
+    TEST_ASSERT_TRUE (compensated.dip_area < 0.5*baseline.dip_area);
+    TEST_ASSERT_TRUE (compensated.deepest < baseline.deepest);
+    TEST_ASSERT_TRUE (fabs (compensated.final_speed - SETPOINT) < PLANT_GAIN);
+}
+
+void test_estimate_settles_at_the_load (void)
+{
+    loadResult estimated = run_load_step (0);   // Estimated, but not compensated
+    TEST_ASSERT_INT32_WITHIN (1, LOAD_DUTY, estimated.final_load);
+    loadResult compensated = run_load_step (1);
+    TEST_ASSERT_INT32_WITHIN (1, LOAD_DUTY, compensated.final_load);
+}
+
+void test_acceleration_alone_is_not_load (void)
+{
+    disturbanceObserver observer (PERIOD_US);
+    observer.set_inertia (INERTIA);
+    for (int i = 0; i < 2000; i++)              // Accelerating at 8000 RPM/s takes 30 more duty
+    {
+        observer.update (130, 100, 8000);
+    }
+    TEST_ASSERT_INT32_WITHIN (1, 0, observer.load);
+}
+
+void test_cutoff_sets_how_fast_it_follows (void)
+{
+    disturbanceObserver slow (PERIOD_US);
+    disturbanceObserver fast (PERIOD_US);
+    slow.set_cutoff (1);
+    fast.set_cutoff (20);
+    for (int i = 0; i < 1000/(2*M_PI*5); i++)   // One time constant of a 5 Hz filter
+    {
+        slow.update (200, 100, 0);
+        fast.update (200, 100, 0);
+    }
+    TEST_ASSERT_LESS_THAN (30, slow.load);
+    TEST_ASSERT_GREATER_THAN (90, fast.load);
+}
+
+void test_gain_and_reset (void)
+{
+    disturbanceObserver observer (PERIOD_US);
+    observer.set_gain (0.5f);
+    for (int i = 0; i < 5000; i++)
+    {
+        observer.update (140, 100, 0);
+    }
+    TEST_ASSERT_INT32_WITHIN (1, 40, observer.load);
+    TEST_ASSERT_INT32_WITHIN (1, 20, observer.compensation ());
+    observer.reset ();
+    TEST_ASSERT_EQUAL_INT32 (0, observer.load);
+    TEST_ASSERT_EQUAL_INT32 (0, observer.compensation ());
+}
+
+int main (void)
+{
+    UNITY_BEGIN ();
+    RUN_TEST (test_compensation_shrinks_the_speed_dip);
+    RUN_TEST (test_estimate_settles_at_the_load);
+    RUN_TEST (test_acceleration_alone_is_not_load);
+    RUN_TEST (test_cutoff_sets_how_fast_it_follows);
+    RUN_TEST (test_gain_and_reset);
+    return UNITY_END ();
+}
@@ -0,0 +1,179 @@
+/** @file test_main.cpp
+ *    This file contains the unit tests for the feed-forward table. A calibration sweep
+ *    is run against a simulated universal motor whose speed is far from proportional to
+ *    the duty cycle, with a dead band below breakaway and noise on the measured speed. The
+ *    table it builds must be monotonic and must give duty cycles which land the motor
+ *    close to each set point in one step. Saving and loading the table are checked too.
+ *  @date 2026-Oct-16
+ */
+
+#include <unity.h>
+#include "feedforward.cpp"
+
+#define PERIOD_US       1000                    // Control period
+#define PLANT_TAU       0.2                     // Time constant of the motor [s]
+#define BREAKAWAY       30                      // Duty cycle below which the motor doesn't turn
+#define NOISE_RPM       50                      // Largest noise on the measured speed
+
+static uint32_t seed;                           // Pseudo-random state for the noise
+static feedForward* table;                      // Table under test
+
+/** @brief   Returns the speed the simulated motor settles at for a duty cycle.
+ *  @details The speed rises steeply after breakaway and flattens out toward full duty,
+ *           roughly as a universal motor with a fan load does.
+ */
+static double steady_speed (int32_t duty)
+{
+    if (duty <= BREAKAWAY)
+    {
+        return 0;
+    }
+    return 25000*(1 - exp (-(duty - BREAKAWAY)/60.0));
+}
+
+/** @brief   Returns the duty cycle which the simulated motor needs to settle at a speed.
+ */
+static double exact_duty (double speed)
+{
+    return BREAKAWAY - 60*log (1 - speed/25000);
+}
+
+/** @brief   Runs a whole sweep against the simulated motor.
+ *  @returns The number of control steps the sweep took
+ */
+static uint32_t run_sweep (void)
+{
+    double speed = 0;
+    uint32_t steps = 0;
+    table->start_sweep (255, FF_MAX_POINTS);
+    int32_t duty = 0;
+    while (table->sweeping && steps < 10000000)
+    {
+        speed += (steady_speed (duty) - speed)*PERIOD_US/1e6/PLANT_TAU;
+        seed = seed*1103515245 + 12345;
+        int32_t noise = (int32_t)((seed >> 8) % (2*NOISE_RPM + 1)) - NOISE_RPM;
+        duty = table->sweep (lround (speed) + (speed > 0 ? noise : 0));
+        steps++;
+    }
+    return steps;
+}
+
+void setUp (void)
+{
+    seed = 42;
+    table = new feedForward (PERIOD_US);
+}
+
+void tearDown (void)
+{
+    delete table;
+}
+
+void test_no_table_leaves_it_to_the_controller (void)
+{
+    TEST_ASSERT_FALSE (table->ready);
+    TEST_ASSERT_EQUAL_INT32 (0, table->duty (10000));
+    TEST_ASSERT_EQUAL_INT32 (0, table->sweep (1000));
+}
+
+void test_sweep_finishes_and_switches_the_motor_off (void)
+{
+    uint32_t steps = run_sweep ();
+    TEST_ASSERT_FALSE (table->sweeping);
+    TEST_ASSERT_TRUE (table->ready);
+    TEST_ASSERT_TRUE (table->needs_saving);
+    TEST_ASSERT_LESS_THAN (FF_MAX_POINTS*FF_MAX_WINDOWS*FF_WINDOW_US/PERIOD_US, steps);
+    TEST_ASSERT_EQUAL_INT32 (0, table->sweep (0));
+}
+
+void test_table_is_monotonic_and_starts_at_breakaway (void)
+{
+    run_sweep ();
+    int32_t previous = -1;
+    for (int32_t setpoint = 0; setpoint <= 30000; setpoint += 100)
+    {
+        int32_t duty = table->duty (setpoint);
+        TEST_ASSERT_GREATER_OR_EQUAL (previous, duty);
+        previous = duty;
+    }
+    int32_t first = table->duty (0);            // The highest duty cycle visited which doesn't turn it
+    TEST_ASSERT_TRUE (first <= BREAKAWAY && first >= BREAKAWAY - 255/(FF_MAX_POINTS - 1));
+    TEST_ASSERT_EQUAL_INT32 (255, table->duty (30000));
+}
+
+void test_feed_forward_lands_near_the_set_point (void)
+{
+    run_sweep ();
+    double worst = 0;
+    for (int32_t setpoint = 2000; setpoint <= 20000; setpoint += 500)
+    {
+        double error = fabs (steady_speed (table->duty (setpoint)) - setpoint)/setpoint;
+        worst = max (worst, error);
+        TEST_ASSERT_INT32_WITHIN (3, lround (exact_duty (setpoint)), table->duty (setpoint));
+    }
+    char message[64];
+    snprintf (message, sizeof (message), "Worst steady speed error %.1f%%", worst*100);
+    TEST_MESSAGE (message);
+    TEST_ASSERT_TRUE (worst < 0.06);
+
+    double linear = 0;                          // The old fixed mapping, for comparison
+    for (int32_t setpoint = 2000; setpoint <= 20000; setpoint += 500)
+    {
+        int32_t duty = min (255, setpoint*255/25000);
+        linear = max (linear, fabs (steady_speed (duty) - setpoint)/setpoint);
+    }
+    TEST_ASSERT_TRUE (linear > 4*worst);
+}
+
+void test_save_and_load_round_trip (void)
+{
+    run_sweep ();
+    uint32_t flushes = fake_eeprom_flushes;
+    table->save ();
+    TEST_ASSERT_FALSE (table->needs_saving);
+    TEST_ASSERT_EQUAL_UINT32 (flushes + 1, fake_eeprom_flushes);
+    feedForward loaded (PERIOD_US);
+    TEST_ASSERT_TRUE (loaded.load ());
+    TEST_ASSERT_TRUE (loaded.ready);
+    TEST_ASSERT_FALSE (loaded.needs_saving);
+    for (int32_t setpoint = 0; setpoint <= 30000; setpoint += 250)
+    {
+        TEST_ASSERT_EQUAL_INT32 (table->duty (setpoint), loaded.duty (setpoint));
+    }
+}
+
+void test_corrupted_table_is_not_loaded (void)
+{
+    run_sweep ();
+    table->save ();
+    fake_eeprom[FF_EEPROM_ADDRESS + 4] ^= 0x10; // Flip a bit in the first speed
+    feedForward loaded (PERIOD_US);
+    TEST_ASSERT_FALSE (loaded.load ());
+    TEST_ASSERT_FALSE (loaded.ready);
+    fake_eeprom[FF_EEPROM_ADDRESS] = 0;         // And with no marker at all
+    TEST_ASSERT_FALSE (loaded.load ());
+}
+
+void test_print_shows_the_table (void)
+{
+    Serial.sent.clear ();
+    table->print (Serial);
+    TEST_ASSERT_EQUAL_STRING ("No feed-forward table\r\n", Serial.sent.c_str ());
+    table->start_sweep (255, 5);
+    Serial.sent.clear ();
+    table->print (Serial);
+    TEST_ASSERT_EQUAL_STRING ("Feed-forward sweep at duty 0\r\n", Serial.sent.c_str ());
+}
+
+int main (void)
+{
+    UNITY_BEGIN ();
+    RUN_TEST (test_no_table_leaves_it_to_the_controller);
+    RUN_TEST (test_sweep_finishes_and_switches_the_motor_off);
+    RUN_TEST (test_table_is_monotonic_and_starts_at_breakaway);
+    RUN_TEST (test_feed_forward_lands_near_the_set_point);
+    RUN_TEST (test_save_and_load_round_trip);
+    RUN_TEST (test_corrupted_table_is_not_loaded);
+    RUN_TEST (test_print_shows_the_table);
+    return UNITY_END ();
+}
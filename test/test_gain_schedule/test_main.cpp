@@ -0,0 +1,227 @@
+/** @file test_main.cpp
+ *    This file contains the regression tests for the speed controller gain schedule. A
+ *    simulated universal motor, whose speed gains less and less from each step of duty
+ *    cycle as it speeds up, is stepped to set points across the speed range, once with a
+ *    schedule and once with fixed gains. The schedule must settle every step within a
+ *    narrow range of times; the fixed gains, tuned for the bottom of the range, are
+ *    sluggish at the top. The lookup, the two copies of the table and saving and loading
+ *    are checked too.
+ *  @date 2026-Oct-16
+ */
+
+#include <unity.h>
+#include "pidcontroller.cpp"
+#include "gainschedule.cpp"
+
+#define PERIOD_US       1000                    // Control period
+#define PLANT_TAU       0.2                     // Time constant of the motor [s]
+#define TOP_RPM         25000.0                 // Speed the motor approaches at full duty
+#define DUTY_SCALE      60.0                    // Duty cycle over which the speed rises by 1 - 1/e
+#define LOOP_GAIN       4.0                     // Wanted kp times the motor's local gain
+
+static pidController* pid;                      // Controller the schedule is for
+static gainSchedule* schedule;                  // Schedule under test
+
+/** @brief   Returns the speed the simulated motor settles at for a duty cycle.
+ */
+static double steady_speed (double duty)
+{
+    return TOP_RPM*(1 - exp (-duty/DUTY_SCALE));
+}
+
+/** @brief   Returns the duty cycle which holds the simulated motor at a speed.
+ */
+static double duty_for (double speed)
+{
+    return -DUTY_SCALE*log (1 - speed/TOP_RPM);
+}
+
+/** @brief   Returns the proportional gain which gives the same loop gain at any speed.
+ *  @details Near a speed, each unit of duty cycle adds (TOP_RPM - speed)/DUTY_SCALE RPM.
+ */
+static float kp_for (double speed)
+{
+    return LOOP_GAIN*DUTY_SCALE/(TOP_RPM - speed);
+}
+
+/** @brief   Fills the schedule with gains tuned at a few speeds across the range.
+ */
+static void fill_schedule (void)
+{
+    int32_t speeds[] = { 5000, 10000, 15000, 20000, 23000 };
+    for (int32_t rpm : speeds)
+    {
+        float kp = kp_for (rpm);
+        TEST_ASSERT_TRUE (schedule->set_point (rpm, kp, kp/PLANT_TAU, 0));
+    }
+}
+
+/** @brief   Steps the motor up by 1000 RPM to a set point and times how long it takes to settle.
+ *  @details The motor starts steady 1000 RPM below the set point, with the controller reset
+ *           to hold it there. Each step, the gains are looked up at the measured speed and
+ *           handed to the controller, and the controller's unrounded output drives the motor.
+ *  @param   overshoot Set to the highest speed past the set point [RPM]
+ *  @returns The last time the speed was more than 2% of the step away from the set point [s]
+ */
+static double step_to (int32_t setpoint, double& overshoot)
+{
+    double speed = setpoint - 1000;
+    pid->set_gains (schedule->lookup (lround (speed)));
+    pid->reset (setpoint - 1000, lround (speed), lround (duty_for (speed)));
+    double settle = 0;
+    overshoot = 0;
+    for (uint32_t n = 1; n <= 2000; n++)
+    {
+        pid->set_gains (schedule->lookup (lround (speed)));
+        pid->update (setpoint, lround (speed));
+        speed += (steady_speed (pid->output_q16/65536.0) - speed)*PERIOD_US/1e6/PLANT_TAU;
+        overshoot = max (overshoot, speed - setpoint);
+        if (fabs (speed - setpoint) > 20)
+        {
+            settle = n*PERIOD_US/1e6;
+        }
+    }
+    return settle;
+}
+
+void setUp (void)
+{
+    pid = new pidController (PERIOD_US);
+    schedule = new gainSchedule (pid);
+}
+
+void tearDown (void)
+{
+    delete schedule;
+    delete pid;
+}
+
+void test_schedule_settles_alike_across_the_range (void)
+{
+    fill_schedule ();
+    double fastest = 1e9, slowest = 0, worst_overshoot = 0;
+    for (int32_t setpoint = 6000; setpoint <= 22000; setpoint += 1000)
+    {
+        double overshoot;
+        double settle = step_to (setpoint, overshoot);
+        fastest = min (fastest, settle);
+        slowest = max (slowest, settle);
+        worst_overshoot = max (worst_overshoot, overshoot);
+    }
+    char message[96];
+    snprintf (message, sizeof (message), "Scheduled: settled in %.3f to %.3f s, overshoot %.1f RPM",
+              fastest, slowest, worst_overshoot);
+    TEST_MESSAGE (message);
+    TEST_ASSERT_TRUE (slowest < 2.5*fastest);  // Fixed gains spread over five times as much
+    TEST_ASSERT_TRUE (slowest < 0.5);
+    TEST_ASSERT_TRUE (worst_overshoot < 20);
+}
+
+void test_fixed_gains_are_sluggish_at_the_top (void)
+{
+    float kp = kp_for (5000);
+    schedule->set_fallback (kp, kp/PLANT_TAU, 0);
+    double overshoot;
+    double bottom = step_to (6000, overshoot);
+    double top = step_to (22000, overshoot);
+    char message[96];
+    snprintf (message, sizeof (message), "Fixed: settled in %.3f s at 6000 RPM, %.3f s at 22000 RPM",
+              bottom, top);
+    TEST_MESSAGE (message);
+    TEST_ASSERT_TRUE (top > 3*bottom);
+}
+
+void test_lookup_interpolates_between_points (void)
+{
+    schedule->set_point (10000, 0.01f, 0.1f, 0.0001f);
+    schedule->set_point (20000, 0.03f, 0.3f, 0.0003f);
+    pidGains middle = pid->scale (0.02f, 0.2f, 0.0002f);
+    pidGains found = schedule->lookup (15000);
+    TEST_ASSERT_INT32_WITHIN (2, middle.kp_q16, found.kp_q16);
+    TEST_ASSERT_TRUE (llabs (found.ki_dt_q32 - middle.ki_dt_q32) < 1000);
+    TEST_ASSERT_INT32_WITHIN (20, middle.kd_dt_q16, found.kd_dt_q16);
+    TEST_ASSERT_EQUAL_INT32 (pid->scale (0.01f, 0.1f, 0.0001f).kp_q16, schedule->lookup (0).kp_q16);
+    TEST_ASSERT_EQUAL_INT32 (pid->scale (0.03f, 0.3f, 0.0003f).kp_q16, schedule->lookup (40000).kp_q16);
+}
+
+void test_gains_change_smoothly_with_speed (void)
+{
+    fill_schedule ();
+    int32_t previous = schedule->lookup (4000).kp_q16;
+    for (int32_t rpm = 4001; rpm <= 24000; rpm++)
+    {
+        int32_t kp = schedule->lookup (rpm).kp_q16;
+        TEST_ASSERT_TRUE (kp >= previous);
+        TEST_ASSERT_LESS_OR_EQUAL (previous + 32, kp);  // No more than 0.0005 per RPM
+        previous = kp;
+    }
+}
+
+void test_empty_schedule_uses_the_fallback (void)
+{
+    schedule->set_fallback (0.02f, 0.1f, 0);
+    TEST_ASSERT_EQUAL_INT32 (pid->scale (0.02f, 0.1f, 0).kp_q16, schedule->lookup (12000).kp_q16);
+    fill_schedule ();
+    schedule->clear ();
+    TEST_ASSERT_EQUAL_UINT8 (0, schedule->points ());
+    TEST_ASSERT_EQUAL_INT32 (pid->scale (0.02f, 0.1f, 0).kp_q16, schedule->lookup (12000).kp_q16);
+}
+
+void test_set_point_replaces_and_fills_up (void)
+{
+    TEST_ASSERT_FALSE (schedule->set_point (0, 0.01f, 0, 0));
+    schedule->set_point (5000, 0.01f, 0, 0);
+    schedule->set_point (5000, 0.02f, 0, 0);
+    TEST_ASSERT_EQUAL_UINT8 (1, schedule->points ());
+    TEST_ASSERT_EQUAL_INT32 (pid->scale (0.02f, 0, 0).kp_q16, schedule->lookup (5000).kp_q16);
+    for (int32_t i = 1; i < GS_MAX_POINTS; i++)
+    {
+        TEST_ASSERT_TRUE (schedule->set_point (5000 + i*1000, 0.01f, 0, 0));
+    }
+    TEST_ASSERT_FALSE (schedule->set_point (30000, 0.01f, 0, 0));
+    TEST_ASSERT_EQUAL_UINT8 (GS_MAX_POINTS, schedule->points ());
+}
+
+void test_save_and_load_round_trip (void)
+{
+    fill_schedule ();
+    TEST_ASSERT_TRUE (schedule->needs_saving);
+    schedule->save ();
+    TEST_ASSERT_FALSE (schedule->needs_saving);
+    gainSchedule loaded (pid);
+    TEST_ASSERT_TRUE (loaded.load ());
+    TEST_ASSERT_EQUAL_UINT8 (5, loaded.points ());
+    for (int32_t rpm = 0; rpm <= 30000; rpm += 250)
+    {
+        TEST_ASSERT_EQUAL_INT32 (schedule->lookup (rpm).kp_q16, loaded.lookup (rpm).kp_q16);
+    }
+    fake_eeprom[GS_EEPROM_ADDRESS + 4] ^= 0x01; // Corrupt the first speed
+    gainSchedule corrupted (pid);
+    TEST_ASSERT_FALSE (corrupted.load ());
+    TEST_ASSERT_EQUAL_UINT8 (0, corrupted.points ());
+}
+
+void test_print_shows_each_point (void)
+{
+    Serial.sent.clear ();
+    schedule->print (Serial);
+    TEST_ASSERT_EQUAL_STRING ("No gain schedule; using fixed gains\r\n", Serial.sent.c_str ());
+    schedule->set_point (5000, 0.5f, 0.25f, 0);
+    Serial.sent.clear ();
+    schedule->print (Serial);
+    TEST_ASSERT_EQUAL_STRING ("5000 RPM: Kp 0.50 Ki 0.25 Kd 0.00\r\n", Serial.sent.c_str ());
+}
+
+int main (void)
+{
+    UNITY_BEGIN ();
+    RUN_TEST (test_schedule_settles_alike_across_the_range);
+    RUN_TEST (test_fixed_gains_are_sluggish_at_the_top);
+    RUN_TEST (test_lookup_interpolates_between_points);
+    RUN_TEST (test_gains_change_smoothly_with_speed);
+    RUN_TEST (test_empty_schedule_uses_the_fallback);
+    RUN_TEST (test_set_point_replaces_and_fills_up);
+    RUN_TEST (test_save_and_load_round_trip);
+    RUN_TEST (test_print_shows_each_point);
+    return UNITY_END ();
+}
@@ -0,0 +1,280 @@
+/** @file test_main.cpp
+ *    This file contains the unit tests for the streaming G-code spindle command parser.
+ *    Besides lines picked to show each rule, the parser is fuzzed two ways: with random
+ *    lines of valid G-code, in mixed case, spacing and with comments, whose spindle words
+ *    are worked out alongside so every result can be checked; and with random bytes, after
+ *    which it must still be in a sane state and read the next good line. Last, a
+ *    typical program is streamed through it to measure how many lines a second it reads.
+ *  @date 2026-Oct-16
+ */
+
+#include <unity.h>
+#include <chrono>
+#include "gcode.cpp"
+
+static uint32_t seed;                           // Pseudo-random state for the fuzzing
+
+/** @brief   Returns a pseudo-random number from 0 to one less than @c range.
+ */
+static uint32_t random_below (uint32_t range)
+{
+    seed = seed*1103515245 + 12345;
+    return (seed >> 8) % range;
+}
+
+/** @brief   Feeds a string to a parser a character at a time.
+ *  @returns How many lines with spindle words were used
+ */
+static uint32_t feed (gcodeParser& parser, const char* text)
+{
+    uint32_t used = 0;
+    while (*text)
+    {
+        used += parser.feed (*text++) ? 1 : 0;
+    }
+    return used;
+}
+
+/** @brief   Adds a number to a line, in one of the forms G-code allows.
+ *  @param   line The line to add to
+ *  @param   thousandths The number, which is exact to thousandths
+ *  @param   fraction If the number may be written with a point
+ *  @returns The number as written, in thousandths
+ */
+static int32_t add_number (std::string& line, int32_t thousandths, bool fraction)
+{
+    char text[24];
+    if (fraction && random_below (2))
+    {
+        snprintf (text, sizeof (text), "%d.%03d", (int)(thousandths/1000), (int)(thousandths % 1000));
+    }
+    else
+    {
+        snprintf (text, sizeof (text), random_below (4) ? "%d" : "%03d", (int)(thousandths/1000));
+        thousandths -= thousandths % 1000;
+    }
+    line += text;
+    return thousandths;
+}
+
+/** @brief   Adds a word to a line, with the letter in either case and perhaps spaces.
+ */
+static void add_word (std::string& line, char letter)
+{
+    line += random_below (2) ? letter : (char)(letter | 0x20);
+    if (random_below (4) == 0)
+    {
+        line += ' ';
+    }
+}
+
+void setUp (void)
+{
+    seed = 42;
+}
+
+void tearDown (void)
+{
+}
+
+void test_spindle_words_are_used (void)
+{
+    gcodeParser parser;
+    TEST_ASSERT_EQUAL_UINT8 (GCODE_STOPPED, parser.mode);
+    TEST_ASSERT_EQUAL_INT32 (0, parser.setpoint ());
+    TEST_ASSERT_EQUAL_UINT32 (1, feed (parser, "M3 S12000\n"));
+    TEST_ASSERT_EQUAL_INT32 (12000, parser.setpoint ());
+    TEST_ASSERT_FALSE (parser.reverse ());
+    TEST_ASSERT_EQUAL_UINT32 (1, feed (parser, "m4s8000.6\r\n"));   // The \n after \r is an empty line
+    TEST_ASSERT_EQUAL_INT32 (8001, parser.setpoint ());
+    TEST_ASSERT_TRUE (parser.reverse ());
+    TEST_ASSERT_EQUAL_UINT32 (1, feed (parser, "M5\n"));
+    TEST_ASSERT_EQUAL_INT32 (0, parser.setpoint ());
+    TEST_ASSERT_EQUAL_INT32 (8001, parser.speed);   // Kept while it's off
+    TEST_ASSERT_EQUAL_UINT32 (1, feed (parser, "S 9 5 0 0\n"));     // Spaces inside a number
+    TEST_ASSERT_EQUAL_INT32 (0, parser.setpoint ());
+    TEST_ASSERT_EQUAL_UINT32 (1, feed (parser, "M03\n"));
+    TEST_ASSERT_EQUAL_INT32 (9500, parser.setpoint ());
+    TEST_ASSERT_EQUAL_UINT32 (1, feed (parser, "M30\n"));           // Ending the program stops it
+    TEST_ASSERT_EQUAL_UINT8 (GCODE_STOPPED, parser.mode);
+    TEST_ASSERT_EQUAL_UINT32 (6, parser.lines);
+    TEST_ASSERT_EQUAL_UINT32 (6, parser.commands);
+    TEST_ASSERT_EQUAL_UINT32 (0, parser.errors);
+}
+
+void test_other_words_and_comments_are_skipped (void)
+{
+    gcodeParser parser;
+    TEST_ASSERT_EQUAL_UINT32 (0, feed (parser, "G1 X10.5 Y-3 F600\n"));
+    TEST_ASSERT_EQUAL_UINT32 (0, feed (parser, "M8 (coolant, M3 S100)\n"));
+    TEST_ASSERT_EQUAL_UINT32 (0, feed (parser, "G0 Z5 ; M3 S100\n"));
+    TEST_ASSERT_EQUAL_UINT32 (0, feed (parser, "$H\n%\n"));
+    TEST_ASSERT_EQUAL_UINT32 (0, feed (parser, "M3.5\n"));          // Not a spindle word
+    TEST_ASSERT_EQUAL_UINT8 (GCODE_STOPPED, parser.mode);
+    TEST_ASSERT_EQUAL_INT32 (0, parser.speed);
+    TEST_ASSERT_EQUAL_UINT32 (1, feed (parser, "N10 G1 X1 (M5) M3 S1000 *71\n"));
+    TEST_ASSERT_EQUAL_INT32 (1000, parser.setpoint ());
+    TEST_ASSERT_EQUAL_UINT32 (0, feed (parser, "\n  \n\t\n"));
+    TEST_ASSERT_EQUAL_UINT32 (7, parser.lines);     // Blank lines aren't counted
+    TEST_ASSERT_EQUAL_UINT32 (0, parser.errors);
+}
+
+void test_bad_lines_change_nothing (void)
+{
+    gcodeParser parser;
+    feed (parser, "M3 S10000\n");
+    const char* bad[] = { "M3 M4 S5000\n", "S-5000\n", "S\n", "M4 S5000 #\n", "S5000 X1.2.3\n",
+                          "M4 S--5\n", "S5000 M\n" };
+    for (const char* line : bad)
+    {
+        TEST_ASSERT_EQUAL_UINT32 (0, feed (parser, line));
+        TEST_ASSERT_EQUAL_INT32 (10000, parser.setpoint ());
+        TEST_ASSERT_FALSE (parser.reverse ());
+    }
+    TEST_ASSERT_EQUAL_UINT32 (7, parser.errors);
+    TEST_ASSERT_EQUAL_UINT32 (1, feed (parser, "M4 S5000\n"));      // And the next good line works
+    TEST_ASSERT_EQUAL_INT32 (5000, parser.setpoint ());
+    TEST_ASSERT_TRUE (parser.reverse ());
+}
+
+void test_numbers_are_read_to_thousandths (void)
+{
+    gcodeParser parser;
+    feed (parser, "M3\n");
+    const char* lines[] = { "S0.4999\n", "S0.5\n", "S+24000\n", "S1.\n", "S.7\n", "S00012000.0\n",
+                            "S999999999999\n" };
+    int32_t speeds[] = { 0, 1, 24000, 1, 1, 12000, (GCODE_MAX_NUMBER + 500)/1000 };
+    for (int i = 0; i < 7; i++)
+    {
+        feed (parser, lines[i]);
+        TEST_ASSERT_EQUAL_INT32 (speeds[i], parser.speed);
+    }
+    TEST_ASSERT_EQUAL_UINT32 (0, parser.errors);
+}
+
+void test_fuzzed_valid_lines_are_read_right (void)
+{
+    gcodeParser parser;
+    int32_t speed = 0;
+    uint8_t mode = GCODE_STOPPED;
+    uint32_t commands = 0;
+    for (uint32_t n = 0; n < 20000; n++)
+    {
+        std::string line;
+        bool has_speed = false, has_mode = false;
+        int32_t line_speed = 0;
+        uint8_t line_mode = 0;
+        uint32_t words = random_below (6);
+        for (uint32_t w = 0; w < words; w++)
+        {
+            uint32_t pick = random_below (8);
+            if (pick == 0 && !has_speed)
+            {
+                add_word (line, 'S');
+                line_speed = (add_number (line, random_below (30000000), true) + 500)/1000;
+                has_speed = true;
+            }
+            else if (pick == 1 && !has_mode)
+            {
+                uint8_t codes[] = { 3, 4, 5, 2, 30 };
+                uint8_t code = codes[random_below (5)];
+                add_word (line, 'M');
+                add_number (line, code*1000, false);
+                line_mode = (code == 3 || code == 4) ? code : GCODE_STOPPED;
+                has_mode = true;
+            }
+            else if (pick == 2)
+            {
+                line += "(a comment, M3 S1)";
+            }
+            else
+            {
+                const char letters[] = "GXYZFNM";
+                char letter = letters[random_below (7)];
+                add_word (line, letter);
+                int32_t value = (letter == 'M') ? (6 + random_below (3))*1000 : random_below (200000);
+                add_number (line, value, letter != 'M' && letter != 'N');
+            }
+            line += random_below (2) ? " " : "";
+        }
+        if (random_below (10) == 0)
+        {
+            line += "; M5 S0";
+        }
+        line += random_below (3) ? "\n" : "\r\n";
+        if (has_speed) { speed = line_speed; }
+        if (has_mode) { mode = line_mode; }
+        commands += (has_speed || has_mode) ? 1 : 0;
+        feed (parser, line.c_str ());
+        TEST_ASSERT_EQUAL_INT32 (speed, parser.speed);
+        TEST_ASSERT_EQUAL_UINT8 (mode, parser.mode);
+    }
+    TEST_ASSERT_EQUAL_UINT32 (commands, parser.commands);
+    TEST_ASSERT_EQUAL_UINT32 (0, parser.errors);
+}
+
+void test_random_bytes_leave_it_sane (void)
+{
+    gcodeParser parser;
+    uint32_t newlines = 0;
+    for (uint32_t n = 0; n < 1000000; n++)
+    {
+        char character = random_below (8) ? (char)random_below (256) : "MS3450.-\n("[random_below (10)];
+        newlines += (character == '\n' || character == '\r') ? 1 : 0;
+        parser.feed (character);
+        TEST_ASSERT_TRUE (parser.speed >= 0 && parser.speed <= (GCODE_MAX_NUMBER + 500)/1000);
+        TEST_ASSERT_TRUE (parser.mode >= GCODE_CLOCKWISE && parser.mode <= GCODE_STOPPED);
+    }
+    TEST_ASSERT_LESS_OR_EQUAL (newlines, parser.lines);
+    TEST_ASSERT_LESS_OR_EQUAL (parser.lines, parser.commands + parser.errors);
+    TEST_ASSERT_GREATER_THAN (0, parser.commands);
+    TEST_ASSERT_EQUAL_UINT32 (1, feed (parser, "\nM4 S7000\n"));
+    TEST_ASSERT_EQUAL_INT32 (7000, parser.setpoint ());
+    TEST_ASSERT_TRUE (parser.reverse ());
+}
+
+void test_throughput_in_lines_per_second (void)
+{
+    const char* program[] = { "G0 Z5.000\n", "G0 X12.345 Y-6.789\n", "G1 Z-1.000 F300\n",
+                              "G1 X25.400 Y12.700 F1200 ; pocket\n", "G2 X30 Y20 I5 J0\n",
+                              "M3 S18000 (rough)\n", "G1 X0 Y0\n", "M5\n" };
+    gcodeParser parser;
+    uint32_t lines = 0;
+    auto start = std::chrono::steady_clock::now ();
+    for (uint32_t n = 0; n < 200000; n++)
+    {
+        feed (parser, program[n % 8]);
+        lines++;
+    }
+    double seconds = std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+    char message[96];
+    snprintf (message, sizeof (message), "%.1f million lines a second; 115200 baud brings at most %u",
+              lines/seconds/1e6, 11520u/20);
+    TEST_MESSAGE (message);
+    TEST_ASSERT_EQUAL_UINT32 (lines, parser.lines);
+    TEST_ASSERT_EQUAL_UINT32 (lines/4, parser.commands);
+    TEST_ASSERT_TRUE (lines/seconds > 11520/20);
+}
+
+void test_print_shows_the_state (void)
+{
+    gcodeParser parser;
+    feed (parser, "M4 S6000\nS-1\n");
+    Serial.sent.clear ();
+    parser.print (Serial);
+    TEST_ASSERT_EQUAL_STRING ("G-code M4 S6000, 2 lines, 1 spindle commands, 1 errors\r\n", Serial.sent.c_str ());
+}
+
+int main (void)
+{
+    UNITY_BEGIN ();
+    RUN_TEST (test_spindle_words_are_used);
+    RUN_TEST (test_other_words_and_comments_are_skipped);
+    RUN_TEST (test_bad_lines_change_nothing);
+    RUN_TEST (test_numbers_are_read_to_thousandths);
+    RUN_TEST (test_fuzzed_valid_lines_are_read_right);
+    RUN_TEST (test_random_bytes_leave_it_sane);
+    RUN_TEST (test_throughput_in_lines_per_second);
+    RUN_TEST (test_print_shows_the_state);
+    return UNITY_END ();
+}
@@ -0,0 +1,223 @@
+/** @file test_main.cpp
+ *    This file contains the unit tests for the mains zero-crossing phase-locked loop.
+ *    Synthetic zero-cross edges, from mains a little off its nominal frequency, are given
+ *    to the loop with jitter on every edge, with extra edges from spikes and with edges
+ *    lost. Once per half cycle, as the triac driver does, the loop is asked for the next
+ *    crossing, and its predictions are compared with the true crossings and with how far
+ *    the raw edges are from them.
+ *  @date 2026-Oct-16
+ */
+
+#include <unity.h>
+#include "mainspll.cpp"
+
+static uint32_t seed;                           // Pseudo-random state for the jitter
+
+/** @brief   Returns a pseudo-random number spread evenly from -@c size to @c size.
+ */
+static double uniform (double size)
+{
+    seed = seed*1103515245 + 12345;
+    return ((int32_t)((seed >> 8) % 20001) - 10000)/10000.0*size;
+}
+
+/** @brief   Ways of spoiling the synthetic zero-cross edges.
+ */
+struct edgeStream
+{
+    double half_period;                         // True time between crossings [us]
+    double jitter;                              // Largest error of an edge [us]
+    uint32_t glitch_every;                      // Add a spike half way through every this many half cycles, 0 for none
+    uint32_t lose_every;                        // Lose the edge of every this many half cycles, 0 for none
+};
+
+/** @brief   Results of running the loop on a stream of edges.
+ */
+struct pllResult
+{
+    double prediction_rms;                      // RMS error of the predicted crossings once locked [us]
+    double edge_rms;                            // RMS error of the raw edges over the same half cycles [us]
+    int32_t worst;                              // Largest prediction error once locked [us]
+    uint32_t lock_edge;                         // Half cycle on which the loop first locked
+    uint32_t unlocked;                          // Half cycles after the first lock with the loop not locked
+    uint32_t glitches;                          // Spikes added
+    uint32_t lost;                              // Edges lost
+};
+
+/** @brief   Runs a stream of edges through the loop.
+ *  @details Before each crossing, at a time a quarter of the way through the half cycle
+ *           before it, the loop is asked for the next crossing, as the triac driver asks when
+ *           a gate pulse ends. The times wrap in 16 bits, as the timer does.
+ *  @param   pll The loop, which is given every edge
+ *  @param   stream How the edges are made
+ *  @param   half_cycles How many crossings to run for
+ */
+static pllResult run_stream (mainsPLL& pll, const edgeStream& stream, uint32_t half_cycles)
+{
+    pllResult result = { 0, 0, 0, 0, 0, 0, 0 };
+    uint32_t count = 0;
+    bool was_locked = false;
+    double crossing = 1234;
+    for (uint32_t n = 0; n < half_cycles; n++)
+    {
+        uint16_t truth = lround (crossing);
+        uint16_t predicted = pll.next_after (lround (crossing - 0.75*stream.half_period));
+        double edge = crossing + uniform (stream.jitter);
+        if (was_locked)
+        {
+            int32_t error = (int16_t)(predicted - truth);
+            result.prediction_rms += (double)error*error;
+            result.edge_rms += (edge - crossing)*(edge - crossing);
+            result.worst = max (result.worst, abs (error));
+            count++;
+            result.unlocked += pll.locked ? 0 : 1;
+        }
+        if (stream.lose_every && n % stream.lose_every == stream.lose_every - 1)
+        {
+            result.lost++;
+        }
+        else
+        {
+            pll.edge (lround (edge));
+        }
+        if (stream.glitch_every && n % stream.glitch_every == stream.glitch_every - 1)
+        {
+            pll.edge (lround (crossing + stream.half_period*(0.3 + uniform (0.1))));
+            result.glitches++;
+        }
+        if (pll.locked && !was_locked)
+        {
+            result.lock_edge = n;
+            was_locked = true;
+        }
+        crossing += stream.half_period;
+    }
+    result.prediction_rms = sqrt (result.prediction_rms/max (count, 1u));
+    result.edge_rms = sqrt (result.edge_rms/max (count, 1u));
+    return result;
+}
+
+void setUp (void)
+{
+    seed = 42;
+}
+
+void tearDown (void)
+{
+}
+
+void test_locks_onto_clean_mains_at_50_and_60_hz (void)
+{
+    double frequencies[] = { 49.5, 50.5, 59.4, 60.6 };  // Up to 1% off
+    for (double hz : frequencies)
+    {
+        mainsPLL pll (hz < 55 ? 10000 : 8333);
+        edgeStream stream = { 5e5/hz, 0, 0, 0 };
+        pllResult result = run_stream (pll, stream, 200);
+        TEST_ASSERT_TRUE (result.lock_edge > 0 && result.lock_edge < 40);
+        TEST_ASSERT_EQUAL_UINT32 (0, result.unlocked);
+        TEST_ASSERT_INT32_WITHIN (1, lround (5e5/hz), pll.period ());
+        TEST_ASSERT_LESS_OR_EQUAL (2, result.worst);  // Rounding the truth and the prediction
+        TEST_ASSERT_EQUAL_UINT32 (0, pll.glitches);
+        TEST_ASSERT_EQUAL_UINT32 (0, pll.missed);
+    }
+}
+
+void test_prediction_is_steadier_than_the_edges (void)
+{
+    mainsPLL pll (10000);
+    edgeStream stream = { 5e5/50.3, 60, 0, 0 };
+    pllResult result = run_stream (pll, stream, 2000);
+    char message[96];
+    snprintf (message, sizeof (message), "Jitter %.1f us RMS on the edges, %.1f us RMS on the "
+              "predictions, worst %d us", result.edge_rms, result.prediction_rms, (int)result.worst);
+    TEST_MESSAGE (message);
+    TEST_ASSERT_TRUE (result.lock_edge < 100);
+    TEST_ASSERT_EQUAL_UINT32 (0, result.unlocked);
+    TEST_ASSERT_TRUE (result.prediction_rms < 0.5*result.edge_rms);
+    TEST_ASSERT_LESS_THAN (90, result.worst);
+}
+
+void test_glitches_are_rejected (void)
+{
+    mainsPLL pll (8333);
+    edgeStream stream = { 5e5/60, 30, 7, 0 };
+    pllResult result = run_stream (pll, stream, 2000);
+    TEST_ASSERT_TRUE (result.lock_edge < 100);
+    TEST_ASSERT_EQUAL_UINT32 (0, result.unlocked);
+    TEST_ASSERT_EQUAL_UINT32 (result.glitches, pll.glitches);
+    TEST_ASSERT_EQUAL_UINT32 (0, pll.missed);
+    TEST_ASSERT_LESS_THAN (45, result.worst);
+}
+
+void test_lost_edges_are_bridged (void)
+{
+    mainsPLL pll (10000);
+    edgeStream stream = { 1e4, 30, 0, 10 };
+    pllResult result = run_stream (pll, stream, 2000);
+    TEST_ASSERT_TRUE (result.lock_edge < 100);
+    TEST_ASSERT_EQUAL_UINT32 (0, result.unlocked);
+    TEST_ASSERT_EQUAL_UINT32 (0, pll.glitches);
+    TEST_ASSERT_UINT32_WITHIN (2, result.lost, pll.missed);  // Those before it started aren't counted
+    TEST_ASSERT_LESS_THAN (45, result.worst);
+}
+
+void test_unlocks_when_the_mains_is_lost (void)
+{
+    mainsPLL pll (10000);
+    edgeStream stream = { 1e4, 0, 0, 0 };
+    run_stream (pll, stream, 50);
+    TEST_ASSERT_TRUE (pll.locked);
+    for (int i = 0; i < PLL_MAX_COAST; i++)     // Keep predicting for a while
+    {
+        pll.next_after (0);
+        TEST_ASSERT_TRUE (pll.locked);
+    }
+    pll.next_after (0);
+    TEST_ASSERT_FALSE (pll.locked);
+}
+
+void test_starts_over_after_a_phase_jump (void)
+{
+    mainsPLL pll (10000);
+    edgeStream stream = { 1e4, 0, 0, 0 };
+    run_stream (pll, stream, 50);
+    TEST_ASSERT_TRUE (pll.locked);
+    uint16_t time = (1234 + 50*10000 + 5000) & 0xFFFF;   // Half way between the old crossings
+    uint32_t edges = 0;
+    while (edges < 100)
+    {
+        pll.edge (time);
+        time += 10000;
+        edges++;
+        if (edges > PLL_MAX_REJECTS + 2 && pll.locked)
+        {
+            break;
+        }
+    }
+    TEST_ASSERT_TRUE (pll.locked);
+    TEST_ASSERT_LESS_THAN (PLL_MAX_REJECTS + 2 + PLL_LOCK_EDGES + 10, edges);
+    TEST_ASSERT_EQUAL_UINT16 ((uint16_t)(time - 10000), pll.current ());
+}
+
+void test_print_shows_the_state (void)
+{
+    mainsPLL pll (10000);
+    Serial.sent.clear ();
+    pll.print (Serial);
+    TEST_ASSERT_EQUAL_STRING ("Mains not locked, half period 10000 us, 0 glitches, 0 missed\r\n",
+                              Serial.sent.c_str ());
+}
+
+int main (void)
+{
+    UNITY_BEGIN ();
+    RUN_TEST (test_locks_onto_clean_mains_at_50_and_60_hz);
+    RUN_TEST (test_prediction_is_steadier_than_the_edges);
+    RUN_TEST (test_glitches_are_rejected);
+    RUN_TEST (test_lost_edges_are_bridged);
+    RUN_TEST (test_unlocks_when_the_mains_is_lost);
+    RUN_TEST (test_starts_over_after_a_phase_jump);
+    RUN_TEST (test_print_shows_the_state);
+    return UNITY_END ();
+}
@@ -0,0 +1,416 @@
+/** @file test_main.cpp
+ *    This file contains the unit tests for the Modbus RTU slave. Request frames are built
+ *    the way a PLC builds them and carried out with @c handle(), whose replies are checked
+ *    byte for byte, CRC included. Then characters are put in the fake serial port and the
+ *    silence timer's interrupt is run at each tick, to check that the end of a frame is
+ *    found after 3.5 to 4 character times of silence and not before, and that the reply is
+ *    sent well inside the 2 ms a PLC's scan allows. Last, @c handle() is served across a
+ *    pseudo-terminal the way it would be behind a PC's serial port, with the end of each
+ *    frame found by a @c select() timeout.
+ *  @date 2026-Oct-16
+ */
+
+#include <unity.h>
+#include <STM32FreeRTOS.h>
+#include "baseshare.cpp"
+#include "modbus.cpp"
+
+#define SLAVE           1                       // Address of the slave under test
+#define RX_PIN          20                      // Pins of the slave under test
+#define TX_PIN          21
+#define DE_PIN          22
+
+// The shares are made by the user interface and motor control tasks
+Share<int> speed_SP ("Set point");
+Share<int> maxMotorSpeed ("Max speed");
+SeqShare<int> actualMotorSpeed ("Speed");
+SeqShare<int> filteredMotorSpeed ("Filtered");
+SeqShare<int> speedReference ("Reference");
+SeqShare<bool> spindleStopped ("Stopped");
+SeqShare<int> motorDuty ("Duty");
+SeqShare<int> estimatedLoad ("Load");
+SeqShare<uint8_t> autotuneState ("Tuning");
+
+/** @brief   A slave whose serial port the tests can reach, to put characters on the line.
+ */
+class testSlave : public modbusSlave
+{
+    public:
+        using modbusSlave::modbusSlave;
+        HardwareSerial* line (void) { return port; }
+};
+
+static testSlave* slave;                        // Slave under test
+static uint8_t request[MODBUS_FRAME_SIZE];      // Frame being built, then the reply
+static uint16_t length;                         // Length of the frame in the buffer
+
+/** @brief   Puts a frame in the buffer with its CRC, low byte first, on the end.
+ */
+static void build (std::initializer_list<uint8_t> bytes)
+{
+    length = 0;
+    for (uint8_t byte : bytes)
+    {
+        request[length++] = byte;
+    }
+    uint16_t crc = modbusSlave::crc16 (request, length);
+    request[length++] = crc & 0xFF;
+    request[length++] = crc >> 8;
+}
+
+/** @brief   Checks that the reply in the buffer is some bytes followed by their CRC.
+ */
+static void check_reply (uint16_t reply, std::initializer_list<uint8_t> bytes)
+{
+    TEST_ASSERT_EQUAL_UINT16 (bytes.size () + 2, reply);
+    uint16_t i = 0;
+    for (uint8_t byte : bytes)
+    {
+        TEST_ASSERT_EQUAL_HEX8 (byte, request[i++]);
+    }
+    TEST_ASSERT_EQUAL_HEX16 (0, modbusSlave::crc16 (request, reply));
+}
+
+/** @brief   Runs the silence timer's interrupt for some ticks.
+ */
+static void ticks (uint32_t count)
+{
+    for (uint32_t n = 0; n < count; n++)
+    {
+        fake_micros += 286;
+        fake_last_timer->fire_update ();
+    }
+}
+
+void setUp (void)
+{
+    fake_micros = 0;
+    fake_notifications = 0;
+    slave = new testSlave (RX_PIN, TX_PIN, NC, TIM15, 19200, SLAVE);
+}
+
+void tearDown (void)
+{
+    delete slave;
+}
+
+void test_crc_matches_the_standard (void)
+{
+    uint8_t read[] = { 0x01, 0x03, 0x00, 0x00, 0x00, 0x01 };
+    TEST_ASSERT_EQUAL_HEX16 (0x0A84, modbusSlave::crc16 (read, sizeof (read)));
+    uint8_t write[] = { 0x11, 0x06, 0x00, 0x01, 0x00, 0x03 };
+    TEST_ASSERT_EQUAL_HEX16 (0x9B9A, modbusSlave::crc16 (write, sizeof (write)));
+    TEST_ASSERT_EQUAL_HEX16 (0xFFFF, modbusSlave::crc16 (read, 0));
+    uint8_t whole[] = { 0x01, 0x03, 0x00, 0x00, 0x00, 0x01, 0x84, 0x0A };
+    TEST_ASSERT_EQUAL_HEX16 (0, modbusSlave::crc16 (whole, sizeof (whole)));
+}
+
+void test_reads_holding_and_input_registers (void)
+{
+    slave->holding[MODBUS_HR_SETPOINT] = 18000;
+    for (uint8_t i = 0; i < MODBUS_INPUT_COUNT; i++)
+    {
+        slave->input[i] = 0x1100*i + i;
+    }
+    build ({ SLAVE, 3, 0, 0, 0, 1 });
+    check_reply (slave->handle (request, length), { SLAVE, 3, 2, 0x46, 0x50 });
+    build ({ SLAVE, 4, 0, 2, 0, 3 });
+    check_reply (slave->handle (request, length), { SLAVE, 4, 6, 0x22, 0x02, 0x33, 0x03, 0x44, 0x04 });
+    build ({ SLAVE, 4, 0, 0, 0, MODBUS_INPUT_COUNT });
+    TEST_ASSERT_EQUAL_UINT16 (3 + 2*MODBUS_INPUT_COUNT + 2, slave->handle (request, length));
+    TEST_ASSERT_EQUAL_HEX8 (0x77, request[3 + 2*MODBUS_IR_MAX_SPEED]);
+    TEST_ASSERT_EQUAL_UINT32 (3, slave->frames);
+    TEST_ASSERT_EQUAL_UINT32 (0, slave->exceptions);
+}
+
+void test_writes_the_set_point (void)
+{
+    build ({ SLAVE, 6, 0, MODBUS_HR_SETPOINT, 0x2E, 0xE0 });
+    check_reply (slave->handle (request, length), { SLAVE, 6, 0, MODBUS_HR_SETPOINT, 0x2E, 0xE0 });
+    TEST_ASSERT_EQUAL_UINT16 (12000, slave->holding[MODBUS_HR_SETPOINT]);
+    TEST_ASSERT_EQUAL_HEX32 (1UL << MODBUS_HR_SETPOINT, slave->written);
+    slave->written = 0;
+    build ({ SLAVE, 16, 0, MODBUS_HR_SETPOINT, 0, 1, 2, 0x3A, 0x98 });
+    check_reply (slave->handle (request, length), { SLAVE, 16, 0, MODBUS_HR_SETPOINT, 0, 1 });
+    TEST_ASSERT_EQUAL_UINT16 (15000, slave->holding[MODBUS_HR_SETPOINT]);
+    TEST_ASSERT_EQUAL_HEX32 (1UL << MODBUS_HR_SETPOINT, slave->written);
+}
+
+void test_write_above_the_limit_is_refused (void)
+{
+    slave->set_limit (MODBUS_HR_SETPOINT, 24000);
+    slave->holding[MODBUS_HR_SETPOINT] = 1000;
+    build ({ SLAVE, 6, 0, MODBUS_HR_SETPOINT, 0x5D, 0xC1 });   // 24001
+    check_reply (slave->handle (request, length), { SLAVE, 0x86, MODBUS_ILLEGAL_VALUE });
+    build ({ SLAVE, 16, 0, MODBUS_HR_SETPOINT, 0, 1, 2, 0x5D, 0xC1 });
+    check_reply (slave->handle (request, length), { SLAVE, 0x90, MODBUS_ILLEGAL_VALUE });
+    TEST_ASSERT_EQUAL_UINT16 (1000, slave->holding[MODBUS_HR_SETPOINT]);
+    TEST_ASSERT_EQUAL_HEX32 (0, slave->written);
+    TEST_ASSERT_EQUAL_UINT32 (2, slave->exceptions);
+    build ({ SLAVE, 6, 0, MODBUS_HR_SETPOINT, 0x5D, 0xC0 });   // 24000 is allowed
+    check_reply (slave->handle (request, length), { SLAVE, 6, 0, MODBUS_HR_SETPOINT, 0x5D, 0xC0 });
+    TEST_ASSERT_EQUAL_UINT16 (24000, slave->holding[MODBUS_HR_SETPOINT]);
+}
+
+void test_bad_requests_get_exceptions (void)
+{
+    build ({ SLAVE, 1, 0, 0, 0, 8 });           // Read coils isn't supported
+    check_reply (slave->handle (request, length), { SLAVE, 0x81, MODBUS_ILLEGAL_FUNCTION });
+    build ({ SLAVE, 4, 0, 6, 0, 3 });           // Past the last input register
+    check_reply (slave->handle (request, length), { SLAVE, 0x84, MODBUS_ILLEGAL_ADDRESS });
+    build ({ SLAVE, 3, 0, 0, 0, 0 });           // Reading no registers
+    check_reply (slave->handle (request, length), { SLAVE, 0x83, MODBUS_ILLEGAL_VALUE });
+    build ({ SLAVE, 6, 0, MODBUS_HOLDING_COUNT, 0, 1 });
+    check_reply (slave->handle (request, length), { SLAVE, 0x86, MODBUS_ILLEGAL_ADDRESS });
+    build ({ SLAVE, 16, 0, 0, 0, 1, 4, 0, 1, 0, 2 });   // Byte count doesn't match the count
+    check_reply (slave->handle (request, length), { SLAVE, 0x90, MODBUS_ILLEGAL_VALUE });
+    TEST_ASSERT_EQUAL_UINT32 (5, slave->exceptions);
+    TEST_ASSERT_EQUAL_UINT32 (5, slave->frames);
+}
+
+void test_damaged_and_other_frames_get_no_reply (void)
+{
+    build ({ SLAVE, 3, 0, 0, 0, 1 });
+    request[3] ^= 0x10;                         // A bit flipped on the line
+    TEST_ASSERT_EQUAL_UINT16 (0, slave->handle (request, length));
+    TEST_ASSERT_EQUAL_UINT32 (1, slave->crc_errors);
+    TEST_ASSERT_EQUAL_UINT16 (0, slave->handle (request, 3));   // Too short to be a frame
+    TEST_ASSERT_EQUAL_UINT32 (2, slave->crc_errors);
+    build ({ SLAVE + 1, 6, 0, MODBUS_HR_SETPOINT, 0, 99 });      // For another slave
+    TEST_ASSERT_EQUAL_UINT16 (0, slave->handle (request, length));
+    TEST_ASSERT_EQUAL_UINT16 (0, slave->holding[MODBUS_HR_SETPOINT]);
+    TEST_ASSERT_EQUAL_UINT32 (0, slave->frames);
+    build ({ 0, 6, 0, MODBUS_HR_SETPOINT, 0, 99 });              // A broadcast is carried out silently
+    TEST_ASSERT_EQUAL_UINT16 (0, slave->handle (request, length));
+    TEST_ASSERT_EQUAL_UINT16 (99, slave->holding[MODBUS_HR_SETPOINT]);
+    build ({ 0, 1, 0, 0, 0, 1 });                                // Even when it fails
+    TEST_ASSERT_EQUAL_UINT16 (0, slave->handle (request, length));
+    TEST_ASSERT_EQUAL_UINT32 (0, slave->exceptions);
+}
+
+void test_begin_sets_up_the_port_and_timer (void)
+{
+    slave->begin ();
+    TEST_ASSERT_EQUAL_UINT32 (19200, slave->line ()->baud);
+    TEST_ASSERT_EQUAL_UINT32 (SERIAL_8E1, slave->line ()->config);
+    TEST_ASSERT_EQUAL_PTR (TIM15, fake_last_timer->getHandle ()->Instance);
+    TEST_ASSERT_EQUAL_UINT32 (286*80, (TIM15->PSC + 1)*(TIM15->ARR + 1));   // Half of 11 bits at 19200
+    TEST_ASSERT_TRUE (fake_last_timer->running);
+    testSlave fast (RX_PIN, TX_PIN, NC, TIM15, 115200, SLAVE);
+    fast.begin ();
+    TEST_ASSERT_EQUAL_UINT32 (250*80, (TIM15->PSC + 1)*(TIM15->ARR + 1));   // Fixed above 19200
+}
+
+void test_driver_enable_goes_to_the_uart (void)
+{
+    static USART_TypeDef uart;
+    uart.CR1 = USART_CR1_UE;
+    uart.CR3 = 0;
+    fake_pin_peripheral = &uart;
+    testSlave rs485 (RX_PIN, TX_PIN, DE_PIN, TIM15, 19200, SLAVE);
+    rs485.begin ();
+    fake_pin_peripheral = TIM2;
+    TEST_ASSERT_TRUE (uart.CR3 & USART_CR3_DEM);
+    TEST_ASSERT_TRUE (uart.CR1 & USART_CR1_UE);
+}
+
+void test_frame_ends_after_three_and_a_half_characters_of_silence (void)
+{
+    slave->begin ();
+    ticks (20);                                 // Nothing on the line
+    TEST_ASSERT_EQUAL_UINT32 (0, fake_notifications);
+    build ({ SLAVE, 3, 0, 0, 0, 1 });
+    for (uint16_t i = 0; i < length; i++)       // A character every two ticks
+    {
+        slave->line ()->receive (&request[i], 1);
+        ticks (2);
+    }
+    TEST_ASSERT_EQUAL_UINT32 (0, fake_notifications);
+    ticks (MODBUS_SILENCE_TICKS - 2);           // Counting from the last character
+    TEST_ASSERT_EQUAL_UINT32 (0, fake_notifications);
+    ticks (1);
+    TEST_ASSERT_EQUAL_UINT32 (1, fake_notifications);
+    ticks (20);                                 // Only woken once
+    TEST_ASSERT_EQUAL_UINT32 (1, fake_notifications);
+    TEST_ASSERT_EQUAL_UINT16 (length, slave->receive ());
+    TEST_ASSERT_EQUAL_HEX8 (0x84, slave->frame[6]);
+    TEST_ASSERT_EQUAL_UINT32 (0, slave->line ()->available ());
+    ticks (20);                                 // Reading it doesn't look like another frame
+    TEST_ASSERT_EQUAL_UINT32 (0, fake_notifications);
+}
+
+void test_reply_is_queued_well_within_a_scan (void)
+{
+    slave->begin ();
+    slave->input[MODBUS_IR_MEASURED] = 17999;
+    build ({ SLAVE, 4, 0, MODBUS_IR_MEASURED, 0, 1 });
+    slave->line ()->receive (request, length);
+    uint32_t last_character = fake_micros;
+    ticks (MODBUS_SILENCE_TICKS + 1);
+    TEST_ASSERT_EQUAL_UINT32 (1, fake_notifications);
+    uint32_t silence = fake_micros - last_character;
+    uint16_t received = slave->receive ();
+    fake_micros += 40;                          // Time to carry it out
+    slave->send (slave->handle (slave->frame, received));
+    TEST_ASSERT_EQUAL_UINT32 (7, slave->line ()->sent.size ());
+    TEST_ASSERT_EQUAL_HEX8 (0x46, (uint8_t)slave->line ()->sent[3]);
+    TEST_ASSERT_EQUAL_HEX8 (0x4F, (uint8_t)slave->line ()->sent[4]);
+    char message[96];
+    snprintf (message, sizeof (message), "Silence found %u us after the last character, reply queued "
+              "%u us later", (unsigned)silence, (unsigned)slave->max_latency);
+    TEST_MESSAGE (message);
+    TEST_ASSERT_GREATER_OR_EQUAL (7*572/2, silence);     // 3.5 characters of 11 bits
+    TEST_ASSERT_LESS_OR_EQUAL (8*572/2 + 286, silence);  // 4, and the tick the timer was part way through
+    TEST_ASSERT_EQUAL_UINT32 (40, slave->max_latency);
+}
+
+void test_frame_too_long_is_thrown_away (void)
+{
+    slave->begin ();
+    static uint8_t junk[MODBUS_FRAME_SIZE + 10];
+    slave->line ()->receive (junk, sizeof (junk));
+    ticks (MODBUS_SILENCE_TICKS + 1);
+    TEST_ASSERT_EQUAL_UINT16 (0, slave->receive ());
+    TEST_ASSERT_EQUAL_UINT32 (1, slave->overruns);
+    TEST_ASSERT_EQUAL_UINT32 (0, slave->line ()->available ());
+}
+
+void test_print_shows_the_counts (void)
+{
+    build ({ SLAVE, 1, 0, 0, 0, 1 });
+    slave->handle (request, length);
+    Serial.sent.clear ();
+    slave->print (Serial);
+    TEST_ASSERT_EQUAL_STRING ("Modbus slave 1 at 19200 baud: 1 frames, 0 CRC errors, 1 exceptions, "
+                              "0 overruns, 0 us longest reply\r\n", Serial.sent.c_str ());
+}
+
+// The pseudo-terminal's headers come after the fakes, as termios.h defines some of the
+// fake registers' names as macros
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/select.h>
+
+#define SILENCE_US      1750                    // 3.5 characters at 19200 baud and above
+
+/** @brief   Reads one frame from a descriptor, ending it at the first silence.
+ *  @details Waits up to @c first_us for the first byte, then takes bytes until none come
+ *           for @c SILENCE_US, as an RTU receiver finds the end of a frame.
+ */
+static uint16_t read_frame (int fd, uint8_t* buffer, uint32_t first_us)
+{
+    uint16_t count = 0;
+    uint32_t wait_us = first_us;
+    while (count < MODBUS_FRAME_SIZE)
+    {
+        fd_set ready;
+        FD_ZERO (&ready);
+        FD_SET (fd, &ready);
+        struct timeval timeout = { 0, (suseconds_t)wait_us };
+        if (select (fd + 1, &ready, NULL, NULL, &timeout) <= 0)
+        {
+            break;
+        }
+        ssize_t got = read (fd, buffer + count, MODBUS_FRAME_SIZE - count);
+        if (got <= 0)
+        {
+            break;
+        }
+        count += got;
+        wait_us = SILENCE_US;
+    }
+    return count;
+}
+
+/** @brief   Opens a pseudo-terminal pair in raw mode, the master for the PLC's end.
+ */
+static void open_line (int& plc, int& port)
+{
+    plc = posix_openpt (O_RDWR | O_NOCTTY);
+    TEST_ASSERT_TRUE (plc >= 0);
+    TEST_ASSERT_EQUAL_INT (0, grantpt (plc));
+    TEST_ASSERT_EQUAL_INT (0, unlockpt (plc));
+    port = open (ptsname (plc), O_RDWR | O_NOCTTY);
+    TEST_ASSERT_TRUE (port >= 0);
+    struct termios raw;
+    tcgetattr (port, &raw);
+    cfmakeraw (&raw);
+    tcsetattr (port, TCSANOW, &raw);
+    tcgetattr (plc, &raw);
+    cfmakeraw (&raw);
+    tcsetattr (plc, TCSANOW, &raw);
+}
+
+/** @brief   Serves one frame from the port end of the line, as the Modbus task would.
+ */
+static void serve (int port)
+{
+    uint16_t received = read_frame (port, slave->frame, 100000);
+    uint16_t reply = received ? slave->handle (slave->frame, received) : 0;
+    if (reply)
+    {
+        TEST_ASSERT_EQUAL_INT (reply, write (port, slave->frame, reply));
+    }
+}
+
+/** @brief   Sends the frame in the buffer from the PLC's end and reads back the reply.
+ */
+static uint16_t poll (int plc, int port)
+{
+    TEST_ASSERT_EQUAL_INT (length, write (plc, request, length));
+    serve (port);
+    return read_frame (plc, request, 20000);
+}
+
+void test_slave_answers_across_a_pseudo_terminal (void)
+{
+    int plc, port;
+    open_line (plc, port);
+    slave->set_limit (MODBUS_HR_SETPOINT, 24000);
+    slave->input[MODBUS_IR_MEASURED] = 17999;
+    build ({ SLAVE, 6, 0, MODBUS_HR_SETPOINT, 0x46, 0x50 });
+    check_reply (poll (plc, port), { SLAVE, 6, 0, MODBUS_HR_SETPOINT, 0x46, 0x50 });
+    TEST_ASSERT_EQUAL_UINT16 (18000, slave->holding[MODBUS_HR_SETPOINT]);
+    build ({ SLAVE, 6, 0, MODBUS_HR_SETPOINT, 0x61, 0xA8 });
+    check_reply (poll (plc, port), { SLAVE, 0x86, MODBUS_ILLEGAL_VALUE });
+    build ({ SLAVE, 2, 0, 0, 0, 1 });
+    check_reply (poll (plc, port), { SLAVE, 0x82, MODBUS_ILLEGAL_FUNCTION });
+    build ({ SLAVE + 1, 4, 0, 0, 0, 1 });       // Another slave's frame gets no reply
+    TEST_ASSERT_EQUAL_UINT16 (0, poll (plc, port));
+    build ({ 0, 6, 0, MODBUS_HR_SETPOINT, 0x2E, 0xE0 });    // Nor does a broadcast
+    TEST_ASSERT_EQUAL_UINT16 (0, poll (plc, port));
+    TEST_ASSERT_EQUAL_UINT16 (12000, slave->holding[MODBUS_HR_SETPOINT]);
+    build ({ SLAVE, 4, 0, 0, 0, 1 });
+    request[2] ^= 0x01;                         // Nor does a damaged one
+    TEST_ASSERT_EQUAL_UINT16 (0, poll (plc, port));
+    TEST_ASSERT_EQUAL_UINT32 (1, slave->crc_errors);
+    uint32_t frames = slave->frames;
+    for (uint16_t n = 0; n < 200; n++)          // Back-to-back polls are all answered
+    {
+        build ({ SLAVE, 4, 0, MODBUS_IR_MEASURED, 0, 1 });
+        check_reply (poll (plc, port), { SLAVE, 4, 2, 0x46, 0x4F });
+    }
+    TEST_ASSERT_EQUAL_UINT32 (frames + 200, slave->frames);
+    close (port);
+    close (plc);
+}
+
+int main (void)
+{
+    UNITY_BEGIN ();
+    RUN_TEST (test_crc_matches_the_standard);
+    RUN_TEST (test_reads_holding_and_input_registers);
+    RUN_TEST (test_writes_the_set_point);
+    RUN_TEST (test_write_above_the_limit_is_refused);
+    RUN_TEST (test_bad_requests_get_exceptions);
+    RUN_TEST (test_damaged_and_other_frames_get_no_reply);
+    RUN_TEST (test_begin_sets_up_the_port_and_timer);
+    RUN_TEST (test_driver_enable_goes_to_the_uart);
+    RUN_TEST (test_frame_ends_after_three_and_a_half_characters_of_silence);
+    RUN_TEST (test_reply_is_queued_well_within_a_scan);
+    RUN_TEST (test_frame_too_long_is_thrown_away);
+    RUN_TEST (test_print_shows_the_counts);
+    RUN_TEST (test_slave_answers_across_a_pseudo_terminal);
+    return UNITY_END ();
+}
@@ -0,0 +1,191 @@
+/** @file test_main.cpp
+ *    This file contains the unit tests for the fixed-point PID controller. It closes the
+ *    loop around a simulated spindle, a first-order lag from duty cycle to speed, and checks
+ *    the settling time and overshoot of a step, the anti-windup, the bumpless starts, and
+ *    that the integral gain keeps its precision at control rates up to 10 kHz.
+ *  @date 2026-Oct-16
+ */
+
+#include <unity.h>
+#include "pidcontroller.cpp"
+
+#define PLANT_GAIN      80.0                    // Steady speed per unit of duty cycle [RPM]
+#define PLANT_TAU       0.3                     // Time constant of the spindle [s]
+#define KP              0.05                    // Proportional gain [duty/RPM]
+#define KI              (KP/PLANT_TAU)          // Integral gain, cancelling the spindle's pole [duty/RPM/s]
+
+/** @brief   A controller whose integral can be checked below one unit of output.
+ */
+class testPid : public pidController
+{
+    public:
+        testPid (uint32_t update_period_us) : pidController (update_period_us) { }
+        using pidController::integral_q32;
+};
+
+/** @brief   Results of a simulated step response.
+ */
+struct stepResult
+{
+    double overshoot;                           // Highest speed past the set point [RPM]
+    double settle;                              // Last time the speed was more than 2% away [s]
+    double final_speed;                         // Speed at the end of the run [RPM]
+    int32_t final_output;                       // Duty cycle at the end of the run
+};
+
+/** @brief   Runs a step in the set point from rest through the controller and spindle.
+ *  @details The spindle is integrated in steps of a tenth of the control period, and the
+ *           controller's output is held between updates, as the PWM would hold it.
+ */
+static stepResult run_step (uint32_t period_us, int32_t setpoint, double duration)
+{
+    pidController pid (period_us);
+    pid.set_gains (KP, KI, 0);
+    double dt = period_us/1e6;
+    double speed = 0;
+    stepResult result = { 0, 0, 0, 0 };
+    for (double t = 0; t < duration; t += dt)
+    {
+        int32_t duty = pid.update (setpoint, lround (speed));
+        for (int i = 0; i < 10; i++)
+        {
+            speed += (PLANT_GAIN*duty - speed)*dt/10/PLANT_TAU;
+        }
+        result.overshoot = max (result.overshoot, speed - setpoint);
+        if (fabs (speed - setpoint) > 0.02*setpoint)
+        {
+            result.settle = t + dt;
+        }
+    }
+    result.final_speed = speed;
+    result.final_output = pid.output;
+    return result;
+}
+
+void setUp (void)
+{
+}
+
+void tearDown (void)
+{
+}
+
+void test_step_settles_without_overshoot (void)
+{
+    stepResult result = run_step (1000, 10000, 2.0);
+    char message[96];
+    snprintf (message, sizeof (message), "Settled to 2%% in %.3f s, overshoot %.1f RPM",
+              result.settle, result.overshoot);
+    TEST_MESSAGE (message);
+    TEST_ASSERT_TRUE (result.settle < 1.0);
+    TEST_ASSERT_TRUE (result.overshoot < 0.01*10000);
+    TEST_ASSERT_TRUE (fabs (result.final_speed - 10000) < PLANT_GAIN);
+    TEST_ASSERT_INT32_WITHIN (1, 125, result.final_output);
+}
+
+void test_step_is_the_same_at_2_and_10_khz (void)
+{
+    stepResult slow = run_step (1000, 10000, 2.0);
+    stepResult fast = run_step (500, 10000, 2.0);
+    stepResult fastest = run_step (100, 10000, 2.0);
+    TEST_ASSERT_TRUE (fabs (fast.settle - slow.settle) < 0.02);
+    TEST_ASSERT_TRUE (fabs (fastest.settle - slow.settle) < 0.02);
+    TEST_ASSERT_TRUE (fastest.overshoot < 0.01*10000);
+    TEST_ASSERT_INT32_WITHIN (1, 125, fastest.final_output);
+}
+
+void test_integral_gain_keeps_its_precision (void)
+{
+    uint32_t periods[] = { 10000, 500, 100 };   // 100 Hz, 2 kHz and 10 kHz
+    for (uint32_t period_us : periods)
+    {
+        testPid pid (period_us);
+        pid.set_gains (0, 0.05, 0);
+        for (uint32_t n = 0; n < 1000000/period_us; n++)   // One second at an error of 1100
+        {
+            pid.update (1100, 0);
+        }
+        TEST_ASSERT_EQUAL_INT32 (55, pid.output);
+        TEST_ASSERT_TRUE (llabs (pid.integral_q32 - 55*Q32_ONE) < Q32_ONE/256);
+    }
+}
+
+void test_small_errors_add_up_at_10_khz (void)
+{
+    testPid pid (100);
+    pid.set_gains (0, 0.01, 0);                 // 1e-6 duty per step at an error of 1
+    for (uint32_t n = 0; n < 100000; n++)       // Ten seconds
+    {
+        pid.update (1, 0);
+    }
+    TEST_ASSERT_TRUE (llabs (pid.integral_q32 - (int64_t)(0.1*Q32_ONE)) < Q32_ONE/1024);
+}
+
+void test_set_point_step_does_not_kick_the_derivative (void)
+{
+    pidController pid (1000);
+    pid.set_gains (0.01, 0, 0.001);
+    pid.reset (1000, 1000, 100);
+    pid.update (2000, 1000);                    // Only the proportional term sees the step
+    TEST_ASSERT_EQUAL_INT32 (110, pid.output);
+    pid.update (2000, 1100);                    // A rising measurement is opposed
+    TEST_ASSERT_EQUAL_INT32 (109 - 100, pid.output);
+}
+
+void test_integral_does_not_wind_up (void)
+{
+    pidController pid (1000);
+    pid.set_gains (0.01, 1.0, 0);
+    for (uint32_t n = 0; n < 10000; n++)        // Ten seconds stuck at full duty
+    {
+        pid.update (20000, 0);
+    }
+    TEST_ASSERT_GREATER_OR_EQUAL (235, pid.output);
+    pid.update (0, 0);                          // Only the integral is left, and it stopped
+    TEST_ASSERT_LESS_OR_EQUAL (55, pid.output); // growing once the total reached the limit
+    uint32_t steps = 0;
+    while (pid.output > 0 && steps < 10000)
+    {
+        pid.update (0, 1000);
+        steps++;
+    }
+    TEST_ASSERT_LESS_THAN (60, steps);           // Unwinding 255 would take over 200
+}
+
+void test_reset_and_new_gains_are_bumpless (void)
+{
+    pidController pid (1000);
+    pid.set_gains (0.05, 0.2, 0.0001);
+    pid.reset (5000, 4900, 120);
+    TEST_ASSERT_EQUAL_INT32 (120, pid.output);
+    pid.update (5000, 4900);
+    TEST_ASSERT_INT32_WITHIN (1, 120, pid.output);
+    int32_t before = pid.output;
+    pid.set_gains (0.02, 0.2, 0.0001);          // A much smaller proportional gain
+    pid.update (5000, 4900);
+    TEST_ASSERT_INT32_WITHIN (1, before, pid.output);
+}
+
+void test_output_stays_within_the_limits (void)
+{
+    pidController pid (1000);
+    pid.set_gains (1.0, 10.0, 0);
+    pid.set_limits (-100, 100);
+    TEST_ASSERT_EQUAL_INT32 (100, pid.update (1000, 0));
+    TEST_ASSERT_EQUAL_INT32 (-100, pid.update (-1000, 0));
+    TEST_ASSERT_EQUAL_INT32 (-(100 << 16), pid.output_q16);
+}
+
+int main (void)
+{
+    UNITY_BEGIN ();
+    RUN_TEST (test_step_settles_without_overshoot);
+    RUN_TEST (test_step_is_the_same_at_2_and_10_khz);
+    RUN_TEST (test_integral_gain_keeps_its_precision);
+    RUN_TEST (test_small_errors_add_up_at_10_khz);
+    RUN_TEST (test_set_point_step_does_not_kick_the_derivative);
+    RUN_TEST (test_integral_does_not_wind_up);
+    RUN_TEST (test_reset_and_new_gains_are_bumpless);
+    RUN_TEST (test_output_stays_within_the_limits);
+    return UNITY_END ();
+}
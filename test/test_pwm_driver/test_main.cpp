@@ -0,0 +1,150 @@
+/** @file test_main.cpp
+ *    This file contains the unit tests for the high-resolution PWM motor driver. The fake
+ *    timer keeps its settings in fake registers, as the real one does, so the tests check
+ *    the prescaler, the period and the compare register the driver leaves there, at
+ *    carrier frequencies from 1 to 20 kHz, and that every step of the fine duty cycle
+ *    reaches the compare register.
+ *  @date 2026-Oct-16
+ */
+
+#include <unity.h>
+#include "pwmdriver.cpp"
+
+#define PWM_PIN         5                       // Pin on the timer channel
+#define DIRECTION_PIN   6                       // Direction output pin
+#define CHANNEL         3                       // Timer channel the fake pin map gives for the PWM pin
+#define TOP_RPM         32000                   // Speed of the router at full duty cycle
+
+// The base class is in motorstuff.cpp, which brings the whole user interface with it
+MotorDriver::MotorDriver (uint8_t PWM_GPIO, uint8_t direction_GPIO)
+{
+    PWM_pin = PWM_GPIO;
+    direction_pin = direction_GPIO;
+    pinMode(direction_pin, OUTPUT);
+}
+void MotorDriver::run (int32_t DUTYCYCLE, int32_t DIRECTION) { analogWrite(PWM_pin, DUTYCYCLE); (void)DIRECTION; }
+void MotorDriver::run_fine (int32_t DUTY_Q8, int32_t DIRECTION) { run((DUTY_Q8 + 0x80) >> 8, DIRECTION); }
+
+void setUp (void)
+{
+    fake_pin_peripheral = TIM2;
+    fake_pin_function = CHANNEL;
+    fake_analog_write[PWM_PIN] = 0;
+}
+
+void tearDown (void)
+{
+}
+
+void test_sets_up_the_pins_timer_and_channel (void)
+{
+    pwmDriver driver (PWM_PIN, DIRECTION_PIN, 20000);
+    HardwareTimer* timer = fake_last_timer;
+    TEST_ASSERT_EQUAL_PTR (TIM2, timer->getHandle ()->Instance);
+    TEST_ASSERT_EQUAL_INT (TIMER_OUTPUT_COMPARE_PWM1, timer->mode[CHANNEL]);
+    TEST_ASSERT_EQUAL_UINT32 (PWM_PIN, timer->mode_pin[CHANNEL]);
+    TEST_ASSERT_TRUE (timer->running);
+    TEST_ASSERT_EQUAL_UINT32 (OUTPUT, fake_pin_mode[DIRECTION_PIN]);
+    TEST_ASSERT_EQUAL_UINT32 (0, TIM2->CCR3);   // Starts with the motor off
+}
+
+void test_period_uses_the_most_counts_that_fit (void)
+{
+    uint32_t frequencies[] = { 1000, 2000, 5000, 10000, 20000 };
+    uint32_t prescales[] = { 2, 1, 1, 1, 1 };
+    uint32_t tops[] = { 40000, 40000, 16000, 8000, 4000 };
+    uint8_t bits[] = { 15, 15, 13, 12, 11 };
+    for (int i = 0; i < 5; i++)
+    {
+        pwmDriver driver (PWM_PIN, DIRECTION_PIN, frequencies[i]);
+        TEST_ASSERT_EQUAL_UINT32 (prescales[i], TIM2->PSC + 1);
+        TEST_ASSERT_EQUAL_UINT32 (tops[i], TIM2->ARR + 1);
+        TEST_ASSERT_EQUAL_UINT32 (tops[i], driver.steps ());
+        TEST_ASSERT_EQUAL_UINT8 (bits[i], driver.bits ());
+        TEST_ASSERT_EQUAL_UINT32 (frequencies[i], fake_last_timer->clock/prescales[i]/tops[i]);
+    }
+}
+
+void test_run_writes_only_the_compare_register (void)
+{
+    pwmDriver driver (PWM_PIN, DIRECTION_PIN, 20000);
+    uint32_t arr = TIM2->ARR, psc = TIM2->PSC, ccr1 = TIM2->CCR1;
+    for (int32_t duty = 0; duty < 256; duty++)
+    {
+        driver.run (duty, 0);
+        TEST_ASSERT_EQUAL_UINT32 ((duty*4000 + 127)/255, TIM2->CCR3);
+    }
+    TEST_ASSERT_EQUAL_UINT32 (arr, TIM2->ARR);
+    TEST_ASSERT_EQUAL_UINT32 (psc, TIM2->PSC);
+    TEST_ASSERT_EQUAL_UINT32 (ccr1, TIM2->CCR1);
+    TEST_ASSERT_EQUAL_UINT32 (0, fake_analog_write[PWM_PIN]);
+}
+
+void test_every_count_can_be_reached (void)
+{
+    uint32_t frequencies[] = { 1000, 20000 };
+    for (uint32_t frequency : frequencies)
+    {
+        pwmDriver driver (PWM_PIN, DIRECTION_PIN, frequency);
+        uint32_t previous = 0;
+        for (int32_t duty_q8 = 0; duty_q8 <= PWM_DUTY_FULL; duty_q8++)
+        {
+            driver.run_fine (duty_q8, 0);
+            TEST_ASSERT_TRUE (TIM2->CCR3 == previous || TIM2->CCR3 == previous + 1);
+            previous = TIM2->CCR3;
+        }
+        TEST_ASSERT_EQUAL_UINT32 (driver.steps (), previous);
+        char message[96];
+        snprintf (message, sizeof (message), "%u Hz: %u steps, %.2f RPM per step (%.1f with "
+                  "analogWrite)", (unsigned)frequency, (unsigned)driver.steps (),
+                  (double)TOP_RPM/driver.steps (), TOP_RPM/255.0);
+        TEST_MESSAGE (message);
+    }
+}
+
+void test_duty_cycle_is_clamped (void)
+{
+    pwmDriver driver (PWM_PIN, DIRECTION_PIN, 10000);
+    driver.run (-10, 0);
+    TEST_ASSERT_EQUAL_UINT32 (0, TIM2->CCR3);
+    driver.run (300, 0);
+    TEST_ASSERT_EQUAL_UINT32 (8000, TIM2->CCR3);
+    driver.run_fine (PWM_DUTY_FULL*4, 0);
+    TEST_ASSERT_EQUAL_UINT32 (8000, TIM2->CCR3);
+}
+
+void test_new_frequency_keeps_the_duty_cycle (void)
+{
+    pwmDriver driver (PWM_PIN, DIRECTION_PIN, 20000);
+    driver.run (32, 0);
+    TEST_ASSERT_EQUAL_UINT32 (502, TIM2->CCR3);
+    driver.set_frequency (1000);
+    TEST_ASSERT_EQUAL_UINT32 (40000, TIM2->ARR + 1);
+    TEST_ASSERT_EQUAL_UINT32 (5020, TIM2->CCR3);  // 32/255 of 40000, rounded
+}
+
+void test_direction_pin_is_written_on_change (void)
+{
+    pwmDriver driver (PWM_PIN, DIRECTION_PIN, 20000);
+    driver.run (100, 1);
+    TEST_ASSERT_EQUAL_UINT8 (HIGH, fake_pin_level[DIRECTION_PIN]);
+    fake_pin_level[DIRECTION_PIN] = LOW;        // Not written again while it's the same
+    driver.run (120, 5);
+    TEST_ASSERT_EQUAL_UINT8 (LOW, fake_pin_level[DIRECTION_PIN]);
+    fake_pin_level[DIRECTION_PIN] = HIGH;
+    driver.run (120, 0);
+    TEST_ASSERT_EQUAL_UINT8 (LOW, fake_pin_level[DIRECTION_PIN]);
+}
+
+int main (void)
+{
+    UNITY_BEGIN ();
+    RUN_TEST (test_sets_up_the_pins_timer_and_channel);
+    RUN_TEST (test_period_uses_the_most_counts_that_fit);
+    RUN_TEST (test_run_writes_only_the_compare_register);
+    RUN_TEST (test_every_count_can_be_reached);
+    RUN_TEST (test_duty_cycle_is_clamped);
+    RUN_TEST (test_new_frequency_keeps_the_duty_cycle);
+    RUN_TEST (test_direction_pin_is_written_on_change);
+    return UNITY_END ();
+}
@@ -0,0 +1,221 @@
+/** @file test_main.cpp
+ *    This file contains the unit tests for the PWM spindle speed input. Synthetic capture
+ *    streams stand in for a CNC controller's PWM output: at each rising edge the high time
+ *    is put in the falling channel's capture register and the period is latched into the
+ *    rising channel, whose interrupt is then run, as the timer would in duty cycle
+ *    measurement mode. The set point must follow a step in duty cycle by the end of the
+ *    first period at the new duty cycle, hold steady through jitter, ignore noise edges,
+ *    and be dropped when the signal stops.
+ *  @date 2026-Oct-16
+ */
+
+#include <unity.h>
+#include "pwminput.cpp"
+
+#define INPUT_PIN       7                       // Pin the PWM signal comes in on
+#define TICK_HZ         10000000                // Timer count rate
+#define PWM_PERIOD      10000                   // A 1 kHz signal, in ticks
+
+static pwmInput* input;                         // Input under test
+static HardwareTimer* timer;                    // The input's timer
+static uint32_t since_edge;                     // Ticks since the last rising edge
+static uint32_t seed;                           // Pseudo-random state for the jitter
+
+/** @brief   Lets time pass, running the overflow interrupt each time the counter wraps.
+ */
+static void wait_ticks (uint32_t ticks)
+{
+    since_edge += ticks;
+    while (since_edge >= 0x10000)
+    {
+        since_edge -= 0x10000;
+        timer->fire_update ();
+    }
+}
+
+/** @brief   Ends one cycle of the signal with a rising edge.
+ *  @param   cycle The length of the cycle [ticks]
+ *  @param   high  How long it was high [ticks]
+ */
+static void cycle (uint32_t cycle, uint32_t high)
+{
+    fake_pin_level[INPUT_PIN] = HIGH;
+    wait_ticks (cycle);
+    since_edge = 0;
+    TIM2->CCR2 = high;
+    timer->fire_channel (1, cycle);
+}
+
+/** @brief   Runs a number of cycles at a duty cycle given in tenths of a percent.
+ */
+static void cycles (uint32_t count, uint32_t permille)
+{
+    for (uint32_t n = 0; n < count; n++)
+    {
+        cycle (PWM_PERIOD, PWM_PERIOD*permille/1000);
+    }
+}
+
+/** @brief   Returns the speed the test curve gives for a duty cycle in tenths of a percent.
+ *  @details The curve runs in a straight line from 5000 RPM at 10% to 24000 RPM at 90%.
+ */
+static int32_t curve_rpm (double permille)
+{
+    return lround (5000 + (permille - 100)*19000/800);
+}
+
+void setUp (void)
+{
+    fake_pin_peripheral = TIM2;
+    fake_pin_function = 1;
+    fake_pin_level[INPUT_PIN] = LOW;
+    since_edge = 0;
+    seed = 42;
+    input = new pwmInput (INPUT_PIN, TICK_HZ);
+    input->set_point (100, 5000);
+    input->set_point (900, 24000);
+    input->begin ();
+    timer = fake_last_timer;
+}
+
+void tearDown (void)
+{
+    delete input;
+}
+
+void test_sets_up_the_timer_for_duty_cycle_measurement (void)
+{
+    TEST_ASSERT_EQUAL_INT (TIMER_INPUT_FREQ_DUTY_MEASUREMENT, timer->mode[1]);
+    TEST_ASSERT_EQUAL_UINT32 (INPUT_PIN, timer->mode_pin[1]);
+    TEST_ASSERT_EQUAL_UINT32 (TICK_HZ, timer->tick_rate ());
+    TEST_ASSERT_EQUAL_UINT32 (0xFFFF, TIM2->ARR);
+    TEST_ASSERT_TRUE (TIM2->CR1 & TIM_CR1_URS);
+    TEST_ASSERT_TRUE (timer->running);
+    TEST_ASSERT_EQUAL_UINT8 (PWM_IN_NONE, input->state);
+}
+
+void test_curve_is_followed_between_the_points (void)
+{
+    TEST_ASSERT_EQUAL_INT32 (0, input->lookup (0));
+    TEST_ASSERT_EQUAL_INT32 (0, input->lookup ((99 << 16)/1000));
+    for (uint32_t permille = 100; permille <= 900; permille += 50)
+    {
+        TEST_ASSERT_INT32_WITHIN (2, curve_rpm (permille), input->lookup ((permille << 16)/1000));
+    }
+    TEST_ASSERT_EQUAL_INT32 (24000, input->lookup (0x10000));
+    TEST_ASSERT_FALSE (input->set_point (900, 25000));  // Out of order
+    for (uint16_t permille = 910; permille < 910 + PWM_IN_MAX_POINTS - 2; permille++)
+    {
+        TEST_ASSERT_TRUE (input->set_point (permille, 24000));
+    }
+    TEST_ASSERT_FALSE (input->set_point (1000, 24000)); // Full
+}
+
+void test_step_is_followed_within_one_period (void)
+{
+    cycle (PWM_PERIOD, 3000);                   // The first edge only starts the timing
+    TEST_ASSERT_EQUAL_UINT8 (PWM_IN_NONE, input->state);
+    cycle (PWM_PERIOD, 3000);
+    TEST_ASSERT_EQUAL_UINT8 (PWM_IN_OK, input->state);
+    TEST_ASSERT_INT32_WITHIN (2, curve_rpm (300), input->setpoint);
+    cycles (20, 300);
+    cycle (PWM_PERIOD, 6000);                   // The first period at the new duty cycle
+    TEST_ASSERT_INT32_WITHIN (2, curve_rpm (600), input->setpoint);
+    TEST_ASSERT_EQUAL_UINT32 (PWM_PERIOD, input->period);
+    cycle (PWM_PERIOD, 500);                    // And down, below the curve
+    TEST_ASSERT_EQUAL_INT32 (0, input->setpoint);
+}
+
+void test_jitter_is_smoothed (void)
+{
+    cycles (20, 500);
+    int32_t lowest = INT32_MAX, highest = 0, raw_lowest = INT32_MAX, raw_highest = 0;
+    uint32_t changes = 0;
+    int32_t previous = input->setpoint;
+    for (int n = 0; n < 2000; n++)
+    {
+        seed = seed*1103515245 + 12345;
+        uint32_t high = 5000 - 20 + (seed >> 8) % 41;   // Up to 0.2% either way
+        cycle (PWM_PERIOD, high);
+        int32_t raw = curve_rpm (high/10.0);
+        raw_lowest = min (raw_lowest, raw);
+        raw_highest = max (raw_highest, raw);
+        lowest = min (lowest, (int32_t)input->setpoint);
+        highest = max (highest, (int32_t)input->setpoint);
+        changes += (input->setpoint != previous) ? 1 : 0;
+        previous = input->setpoint;
+    }
+    char message[96];
+    snprintf (message, sizeof (message), "Set point spread %d RPM, %u changes in 2000 periods; raw "
+              "spread %d RPM", (int)(highest - lowest), (unsigned)changes, (int)(raw_highest - raw_lowest));
+    TEST_MESSAGE (message);
+    TEST_ASSERT_TRUE (highest - lowest < (raw_highest - raw_lowest)/2);
+    TEST_ASSERT_LESS_THAN (100, changes);
+    TEST_ASSERT_INT32_WITHIN (PWM_IN_DEADBAND_RPM + 10, curve_rpm (500), input->setpoint);
+}
+
+void test_noise_edges_are_ignored (void)
+{
+    cycles (20, 400);
+    int32_t before = input->setpoint;
+    cycle (2500, 2500);                         // A spike a quarter of the way through a cycle
+    cycle (PWM_PERIOD - 2500, 1500);
+    TEST_ASSERT_EQUAL_INT32 (before, input->setpoint);
+    TEST_ASSERT_GREATER_OR_EQUAL (2, input->glitches);
+    uint32_t glitches = input->glitches;
+    cycles (3, 400);
+    TEST_ASSERT_EQUAL_INT32 (before, input->setpoint);
+    cycle (PWM_PERIOD, 7000);                   // Steady again, and following
+    TEST_ASSERT_INT32_WITHIN (2, curve_rpm (700), input->setpoint);
+    TEST_ASSERT_LESS_OR_EQUAL (glitches + 1, input->glitches);
+}
+
+void test_loss_of_signal_is_detected (void)
+{
+    cycles (20, 400);
+    fake_pin_level[INPUT_PIN] = LOW;            // The controller stops
+    wait_ticks (TICK_HZ/1000*PWM_IN_TIMEOUT_MS*9/10);
+    TEST_ASSERT_EQUAL_UINT8 (PWM_IN_OK, input->state);
+    wait_ticks (TICK_HZ/1000*PWM_IN_TIMEOUT_MS*2/10);   // Within a counter wrap of the timeout
+    TEST_ASSERT_EQUAL_UINT8 (PWM_IN_LOST, input->state);
+    input->clear ();
+    TEST_ASSERT_EQUAL_UINT8 (PWM_IN_NONE, input->state);
+    TEST_ASSERT_EQUAL_INT32 (0, input->setpoint);
+    cycle (PWM_PERIOD, 4000);                   // It comes back
+    cycle (PWM_PERIOD, 4000);
+    TEST_ASSERT_EQUAL_UINT8 (PWM_IN_OK, input->state);
+    TEST_ASSERT_INT32_WITHIN (2, curve_rpm (400), input->setpoint);
+}
+
+void test_steady_high_means_full_speed (void)
+{
+    cycles (20, 970);
+    fake_pin_level[INPUT_PIN] = HIGH;           // 100% duty cycle has no edges
+    wait_ticks (TICK_HZ/1000*PWM_IN_TIMEOUT_MS*2);
+    TEST_ASSERT_EQUAL_UINT8 (PWM_IN_OK, input->state);
+    TEST_ASSERT_EQUAL_INT32 (24000, input->setpoint);
+    TEST_ASSERT_EQUAL_UINT32 (0x10000, input->duty_q16);
+}
+
+void test_print_shows_the_signal (void)
+{
+    cycles (3, 500);
+    Serial.sent.clear ();
+    input->print (Serial);
+    TEST_ASSERT_EQUAL_STRING ("PWM input following, 1000 Hz, duty 500/1000, 14499 RPM, 0 glitches\r\n"
+                              "100/1000: 5000 RPM\r\n900/1000: 24000 RPM\r\n", Serial.sent.c_str ());
+}
+
+int main (void)
+{
+    UNITY_BEGIN ();
+    RUN_TEST (test_sets_up_the_timer_for_duty_cycle_measurement);
+    RUN_TEST (test_curve_is_followed_between_the_points);
+    RUN_TEST (test_step_is_followed_within_one_period);
+    RUN_TEST (test_jitter_is_smoothed);
+    RUN_TEST (test_noise_edges_are_ignored);
+    RUN_TEST (test_loss_of_signal_is_detected);
+    RUN_TEST (test_steady_high_means_full_speed);
+    RUN_TEST (test_print_shows_the_signal);
+    return UNITY_END ();
+}
@@ -0,0 +1,185 @@
+/** @file test_main.cpp
+ *    This file contains the unit tests for the 4x quadrature decoding in motorEncoder.
+ *    A and B signal sequences are replayed into @c update_quadrature(), and the position
+ *    and the count of illegal transitions are checked against what the sequence holds.
+ *  @date 2026-Oct-16
+ */
+
+#include <unity.h>
+#include "encoder.cpp"
+
+static const uint8_t forward[4] = { 0, 1, 3, 2 };   // States in forward order, B*2 + A
+
+static motorEncoder* encoder;                   // Encoder under test
+
+void setUp (void)
+{
+    encoder = new motorEncoder (7, 8);
+    encoder->reset_quadrature (0);
+}
+
+void tearDown (void)
+{
+    delete encoder;
+}
+
+/** @brief   Returns the state @c steps forward of @c state, or backward if negative.
+ */
+static uint8_t step_from (uint8_t state, int steps)
+{
+    int index = 0;
+    while (forward[index] != state)
+    {
+        index++;
+    }
+    return forward[((index + steps) % 4 + 4) % 4];
+}
+
+void test_forward_counts_four_per_cycle (void)
+{
+    for (int cycle = 0; cycle < 10; cycle++)
+    {
+        for (int i = 1; i <= 4; i++)
+        {
+            encoder->update_quadrature (forward[i % 4]);
+        }
+    }
+    TEST_ASSERT_EQUAL_INT (40, encoder->position ());
+    TEST_ASSERT_EQUAL_UINT32 (0, encoder->illegal_transitions);
+}
+
+void test_reverse_counts_down (void)
+{
+    for (int cycle = 0; cycle < 10; cycle++)
+    {
+        for (int i = 3; i >= 0; i--)
+        {
+            encoder->update_quadrature (forward[i]);
+        }
+    }
+    TEST_ASSERT_EQUAL_INT (-40, encoder->position ());
+    TEST_ASSERT_EQUAL_UINT32 (0, encoder->illegal_transitions);
+}
+
+void test_every_transition_in_the_table (void)
+{
+    for (uint8_t from = 0; from < 4; from++)
+    {
+        for (uint8_t to = 0; to < 4; to++)
+        {
+            motorEncoder fresh (7, 8);
+            fresh.reset_quadrature (from);
+            fresh.update_quadrature (to);
+            int expected = 0;
+            bool illegal = false;
+            if (to == step_from (from, 1))
+            {
+                expected = 1;
+            }
+            else if (to == step_from (from, -1))
+            {
+                expected = -1;
+            }
+            else if (to != from)
+            {
+                illegal = true;
+            }
+            TEST_ASSERT_EQUAL_INT (expected, fresh.position ());
+            TEST_ASSERT_EQUAL_UINT32 (illegal ? 1 : 0, fresh.illegal_transitions);
+        }
+    }
+}
+
+void test_repeated_state_is_ignored (void)
+{
+    encoder->update_quadrature (1);
+    encoder->update_quadrature (1);
+    encoder->update_quadrature (1);
+    TEST_ASSERT_EQUAL_INT (1, encoder->position ());
+    TEST_ASSERT_EQUAL_UINT32 (0, encoder->illegal_transitions);
+}
+
+void test_illegal_transition_is_skipped_and_decoding_carries_on (void)
+{
+    encoder->update_quadrature (1);             // 0 -> 1, +1
+    encoder->update_quadrature (2);             // 1 -> 2, both changed
+    TEST_ASSERT_EQUAL_INT (1, encoder->position ());
+    TEST_ASSERT_EQUAL_UINT32 (1, encoder->illegal_transitions);
+    encoder->update_quadrature (0);             // 2 -> 0, +1 from the new state
+    TEST_ASSERT_EQUAL_INT (2, encoder->position ());
+    TEST_ASSERT_EQUAL_UINT32 (1, encoder->illegal_transitions);
+}
+
+void test_only_the_signal_bits_are_used (void)
+{
+    encoder->update_quadrature (0xF1);
+    encoder->update_quadrature (0x07);
+    TEST_ASSERT_EQUAL_INT (2, encoder->position ());
+}
+
+void test_random_walk_with_missed_edges (void)
+{
+    uint32_t seed = 12345;
+    uint8_t state = 0;
+    int expected = 0;
+    uint32_t expected_illegal = 0;
+    for (int i = 0; i < 100000; i++)
+    {
+        seed = seed*1103515245 + 12345;
+        uint32_t roll = (seed >> 16) % 100;
+        if (roll < 55)                          // Mostly forward
+        {
+            state = step_from (state, 1);
+            expected++;
+        }
+        else if (roll < 95)
+        {
+            state = step_from (state, -1);
+            expected--;
+        }
+        else if (roll < 98)                     // A glitch which reads the same state
+        {
+        }
+        else                                    // An edge missed, so both signals changed
+        {
+            state = step_from (state, 2);
+            expected_illegal++;
+        }
+        encoder->update_quadrature (state);
+    }
+    TEST_ASSERT_EQUAL_INT (expected, encoder->position ());
+    TEST_ASSERT_EQUAL_UINT32 (expected_illegal, encoder->illegal_transitions);
+    TEST_ASSERT_GREATER_THAN (1000, expected_illegal);
+}
+
+void test_single_edge_mode_counts_with_direction (void)
+{
+    encoder->update (0);
+    encoder->update (0);
+    encoder->update (1);
+    TEST_ASSERT_EQUAL_INT (1, encoder->position ());
+}
+
+void test_print_shows_position_and_errors (void)
+{
+    encoder->update_quadrature (1);
+    encoder->update_quadrature (2);
+    Serial.sent.clear ();
+    encoder->print (Serial);
+    TEST_ASSERT_EQUAL_STRING ("Encoder at 1 counts, 1 illegal transitions\r\n", Serial.sent.c_str ());
+}
+
+int main (void)
+{
+    UNITY_BEGIN ();
+    RUN_TEST (test_forward_counts_four_per_cycle);
+    RUN_TEST (test_reverse_counts_down);
+    RUN_TEST (test_every_transition_in_the_table);
+    RUN_TEST (test_repeated_state_is_ignored);
+    RUN_TEST (test_illegal_transition_is_skipped_and_decoding_carries_on);
+    RUN_TEST (test_only_the_signal_bits_are_used);
+    RUN_TEST (test_random_walk_with_missed_edges);
+    RUN_TEST (test_single_edge_mode_counts_with_direction);
+    RUN_TEST (test_print_shows_position_and_errors);
+    return UNITY_END ();
+}
@@ -0,0 +1,190 @@
+/** @file test_main.cpp
+ *    This file contains the unit tests for the lock-free ring buffer. Besides the
+ *    single-threaded behavior, a producer thread and a consumer thread pass hundreds of
+ *    thousands of items through small buffers, the way the encoder ISR and the motor task
+ *    do, and every item has to come out whole, once and in order. The buffers are static,
+ *    as shares are in the firmware, because each one links itself into the list which
+ *    printouts follow.
+ *  @date 2026-Oct-16
+ */
+
+#include <unity.h>
+#include <thread>
+#include "baseshare.cpp"
+#include "ringbuffer.h"
+
+/** @brief   An item whose two halves must always agree, so a torn copy shows up.
+ */
+struct checkedItem
+{
+    uint32_t sequence;                          // Number of the item
+    uint32_t check;                             // Always ~sequence
+};
+
+void setUp (void)
+{
+}
+
+void tearDown (void)
+{
+}
+
+void test_items_come_out_in_order (void)
+{
+    static RingBuffer<uint32_t, 8> ring ("Order");
+    for (uint32_t i = 0; i < 5; i++)
+    {
+        TEST_ASSERT_TRUE (ring.put (i));
+    }
+    TEST_ASSERT_EQUAL_UINT16 (5, ring.available ());
+    for (uint32_t i = 0; i < 5; i++)
+    {
+        uint32_t item;
+        TEST_ASSERT_TRUE (ring.get (item));
+        TEST_ASSERT_EQUAL_UINT32 (i, item);
+    }
+    uint32_t item;
+    TEST_ASSERT_FALSE (ring.get (item));
+    TEST_ASSERT_EQUAL_UINT16 (0, ring.available ());
+}
+
+void test_full_buffer_drops_and_counts (void)
+{
+    static RingBuffer<uint32_t, 4> ring ("Full");
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        TEST_ASSERT_TRUE (ring.put (i));
+    }
+    TEST_ASSERT_FALSE (ring.put (99));
+    TEST_ASSERT_FALSE (ring.put (100));
+    TEST_ASSERT_EQUAL_UINT32 (2, ring.dropped ());
+    uint32_t item;
+    TEST_ASSERT_TRUE (ring.get (item));
+    TEST_ASSERT_EQUAL_UINT32 (0, item);         // The oldest items are kept
+    TEST_ASSERT_TRUE (ring.put (4));
+    for (uint32_t i = 1; i <= 4; i++)
+    {
+        TEST_ASSERT_TRUE (ring.get (item));
+        TEST_ASSERT_EQUAL_UINT32 (i, item);
+    }
+}
+
+void test_indices_wrap_past_65535 (void)
+{
+    static RingBuffer<uint32_t, 4> ring ("Wrap");
+    for (uint32_t i = 0; i < 200000; i++)
+    {
+        TEST_ASSERT_TRUE (ring.put (i));
+        if (i % 3 == 2)                         // Keep a few items waiting across the wrap
+        {
+            continue;
+        }
+        uint32_t item;
+        while (ring.available () > 1)
+        {
+            TEST_ASSERT_TRUE (ring.get (item));
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32 (0, ring.dropped ());
+}
+
+void test_print_shows_fill_and_drops (void)
+{
+    static RingBuffer<uint32_t, 4> ring ("Edges");
+    for (uint32_t i = 0; i < 6; i++)
+    {
+        ring.put (i);
+    }
+    Serial.sent.clear ();
+    ring.print_in_list (Serial);
+    TEST_ASSERT_EQUAL_STRING ("Edges           ring\t4/4 (2 dropped)\r\n",
+                              Serial.sent.substr (0, Serial.sent.find ('\n') + 1).c_str ());
+}
+
+void test_threads_pass_every_item_whole_and_in_order (void)
+{
+    static RingBuffer<checkedItem, 16> ring ("Threads");
+    const uint32_t items = 500000;
+    std::thread producer ([&] ()
+    {
+        for (uint32_t i = 0; i < items; i++)
+        {
+            checkedItem item = { i, ~i };
+            while (!ring.put (item))            // Wait for room, so nothing is lost
+            {
+                std::this_thread::yield ();
+            }
+        }
+    });
+    uint32_t expected = 0;
+    uint32_t torn = 0;
+    uint32_t out_of_order = 0;
+    while (expected < items)
+    {
+        checkedItem item;
+        if (!ring.get (item))
+        {
+            std::this_thread::yield ();         // Let the producer run on a single core
+            continue;
+        }
+        torn += (item.check != ~item.sequence);
+        out_of_order += (item.sequence != expected);
+        expected = item.sequence + 1;
+    }
+    producer.join ();
+    TEST_ASSERT_EQUAL_UINT32 (0, torn);
+    TEST_ASSERT_EQUAL_UINT32 (0, out_of_order);
+}
+
+void test_producer_which_never_waits_only_loses_whole_items (void)
+{
+    static RingBuffer<checkedItem, 8> ring ("Dropping");
+    const uint32_t items = 500000;
+    std::atomic<bool> done (false);
+    std::thread producer ([&] ()
+    {
+        for (uint32_t i = 0; i < items; i++)    // Like the ISR, drop an edge if there's no room
+        {
+            checkedItem item = { i, ~i };
+            ring.put (item);
+        }
+        done = true;
+    });
+    uint32_t received = 0;
+    uint32_t torn = 0;
+    uint32_t backwards = 0;
+    int64_t last = -1;
+    while (true)
+    {
+        bool finished = done;
+        checkedItem item;
+        while (ring.get (item))
+        {
+            received++;
+            torn += (item.check != ~item.sequence);
+            backwards += ((int64_t)item.sequence <= last);
+            last = item.sequence;
+        }
+        if (finished)
+        {
+            break;
+        }
+        std::this_thread::yield ();
+    }
+    producer.join ();
+    TEST_ASSERT_EQUAL_UINT32 (0, torn);
+    TEST_ASSERT_EQUAL_UINT32 (0, backwards);
+    TEST_ASSERT_EQUAL_UINT32 (items, received + ring.dropped ());
+}
+
+int main (void)
+{
+    UNITY_BEGIN ();
+    RUN_TEST (test_items_come_out_in_order);
+    RUN_TEST (test_full_buffer_drops_and_counts);
+    RUN_TEST (test_indices_wrap_past_65535);
+    RUN_TEST (test_print_shows_fill_and_drops);
+    RUN_TEST (test_threads_pass_every_item_whole_and_in_order);
+    RUN_TEST (test_producer_which_never_waits_only_loses_whole_items);
+    return UNITY_END ();
+}
@@ -0,0 +1,160 @@
+/** @file test_main.cpp
+ *    This file contains the unit tests for the integer RPM calculator. Every elapsed time
+ *    up to 2^22 ticks, and a geometric sweep above that, is checked against the same
+ *    calculation in double precision. A short benchmark prints how long a call takes
+ *    next to a floating-point division on the machine running the tests.
+ *  @date 2026-Oct-16
+ */
+
+#include <unity.h>
+#include <chrono>
+#include "rpmmath.cpp"
+
+/** @brief   Worst error of the calculator against double precision.
+ *  @details The result is rounded to a whole RPM, so half an RPM of every error is
+ *           rounding; the relative error is what is left over, divided by the exact speed.
+ *           Only speeds from 1 to @c max_rpm are checked, since above that the calculator
+ *           is allowed to saturate.
+ */
+struct errorResult
+{
+    double worst_relative;                      // Largest (|error| - 0.5)/exact
+    double worst_rpm;                           // Largest |error| in RPM
+    uint32_t checked;                           // Number of elapsed times checked
+};
+
+static void check_one (rpmCalculator& calculator, double scale, int32_t counts,
+                       uint32_t elapsed, double max_rpm, errorResult& result)
+{
+    double exact = scale*counts/elapsed;
+    if (fabs (exact) > max_rpm || fabs (exact) < 1)
+    {
+        return;
+    }
+    double error = fabs (calculator.rpm (counts, elapsed) - exact);
+    result.worst_rpm = max (result.worst_rpm, error);
+    result.worst_relative = max (result.worst_relative, (error - 0.5)/fabs (exact));
+    result.checked++;
+}
+
+static errorResult sweep (uint8_t counts_per_rev, uint32_t ticks_per_second, int32_t counts)
+{
+    rpmCalculator calculator;
+    calculator.configure (counts_per_rev, ticks_per_second);
+    double scale = (double)((uint64_t)ticks_per_second*60/counts_per_rev);
+    errorResult result = { 0, 0, 0 };
+    for (uint32_t elapsed = 1; elapsed < (1u << 22); elapsed++)
+    {
+        check_one (calculator, scale, counts, elapsed, 100000, result);
+    }
+    for (double elapsed = 1 << 22; elapsed < 4294967295.0; elapsed *= 1.0001)
+    {
+        check_one (calculator, scale, counts, (uint32_t)elapsed, 100000, result);
+    }
+    return result;
+}
+
+void setUp (void)
+{
+}
+
+void tearDown (void)
+{
+}
+
+void test_one_count_at_micros (void)
+{
+    errorResult result = sweep (1, 1000000, 1);
+    TEST_ASSERT_GREATER_THAN (1000000, result.checked);
+    TEST_ASSERT_TRUE (result.worst_relative < 2e-5);
+    TEST_ASSERT_TRUE (result.worst_rpm < 1.0);
+}
+
+void test_quadrature_at_capture_rate (void)
+{
+    errorResult result = sweep (4, 10000000, 1);
+    TEST_ASSERT_GREATER_THAN (1000000, result.checked);
+    TEST_ASSERT_TRUE (result.worst_relative < 2e-5);
+    TEST_ASSERT_TRUE (result.worst_rpm < 1.0);
+}
+
+void test_many_counts_in_a_window (void)
+{
+    errorResult result = sweep (64, 80000000, 200);
+    TEST_ASSERT_GREATER_THAN (1000000, result.checked);
+    TEST_ASSERT_TRUE (result.worst_relative < 2e-5);
+    TEST_ASSERT_TRUE (result.worst_rpm < 2.0);
+}
+
+void test_every_table_entry_after_one_newton_step (void)
+{
+    rpmCalculator calculator;
+    calculator.configure (1, 1000000);
+    for (uint32_t index = 0; index < 256; index++)      // Both ends of every interval
+    {
+        for (uint32_t end = 0; end < 2; end++)
+        {
+            uint32_t elapsed = 0x80000000u + (index << 23) + end*((1u << 23) - 1);
+            double exact = 60e6*1000000/elapsed;        // 1000000 counts keeps the result well above 1
+            double error = fabs (calculator.rpm (1000000, elapsed) - exact);
+            TEST_ASSERT_TRUE ((error - 0.5)/exact < 2e-5);
+        }
+    }
+}
+
+void test_sign_zero_and_saturation (void)
+{
+    rpmCalculator calculator;
+    calculator.configure (1, 1000000);
+    TEST_ASSERT_EQUAL_INT32 (6000, calculator.rpm (1, 10000));
+    TEST_ASSERT_EQUAL_INT32 (-6000, calculator.rpm (-1, 10000));
+    TEST_ASSERT_EQUAL_INT32 (0, calculator.rpm (0, 10000));
+    TEST_ASSERT_EQUAL_INT32 (0, calculator.rpm (1, 0));
+    calculator.configure (1, 80000000);
+    TEST_ASSERT_EQUAL_INT32 (INT32_MAX, calculator.rpm (1000000, 1));
+    TEST_ASSERT_EQUAL_INT32 (-INT32_MAX, calculator.rpm (-1000000, 1));
+    calculator.configure (0, 1000000);
+    TEST_ASSERT_EQUAL_INT32 (0, calculator.rpm (1, 10000));
+}
+
+/** @brief   Times rpm() and a float division, for comparing builds; nothing is asserted.
+ *  @details A PC divides in hardware, so the division usually wins here; what matters is
+ *           the count of cycles on the Cortex-M4, where rpm() is a few multiplies and shifts.
+ */
+void test_benchmark_against_float_division (void)
+{
+    rpmCalculator calculator;
+    calculator.configure (4, 10000000);
+    volatile int32_t sink = 0;
+    const uint32_t calls = 2000000;
+    auto start = std::chrono::steady_clock::now ();
+    for (uint32_t i = 0; i < calls; i++)
+    {
+        sink = sink + calculator.rpm (3, 20000 + i);
+    }
+    auto middle = std::chrono::steady_clock::now ();
+    volatile float scale = 150000000.0f;
+    for (uint32_t i = 0; i < calls; i++)
+    {
+        sink = sink + (int32_t)(scale*3/(float)(20000 + i));
+    }
+    auto end = std::chrono::steady_clock::now ();
+    double integer_ns = std::chrono::duration<double, std::nano> (middle - start).count ()/calls;
+    double float_ns = std::chrono::duration<double, std::nano> (end - middle).count ()/calls;
+    char message[96];
+    snprintf (message, sizeof (message), "rpm() %.2f ns per call, float division %.2f ns per call",
+              integer_ns, float_ns);
+    TEST_MESSAGE (message);
+}
+
+int main (void)
+{
+    UNITY_BEGIN ();
+    RUN_TEST (test_one_count_at_micros);
+    RUN_TEST (test_quadrature_at_capture_rate);
+    RUN_TEST (test_many_counts_in_a_window);
+    RUN_TEST (test_every_table_entry_after_one_newton_step);
+    RUN_TEST (test_sign_zero_and_saturation);
+    RUN_TEST (test_benchmark_against_float_division);
+    return UNITY_END ();
+}
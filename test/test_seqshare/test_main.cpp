@@ -0,0 +1,233 @@
+/** @file test_main.cpp
+ *    This file contains the unit tests for the sequence-locked share. The data is a block
+ *    of words which must always agree with each other, so a torn copy shows up. To check
+ *    the single-core cases the share was made for, a copy of the block can run a function
+ *    halfway through, standing in for an interrupt: an ISR which reads while the writer is
+ *    halfway through an update, and an ISR which writes while a reader is halfway through
+ *    a copy. Then a writer thread and reader threads hammer one share, and no reader may
+ *    ever see a torn block or one older than it has already seen. The shares are static,
+ *    as in the firmware, because each one links itself into the list which printouts follow.
+ *  @date 2026-Oct-16
+ */
+
+#include <unity.h>
+#include <thread>
+#include "baseshare.cpp"
+#include "seqshare.h"
+
+#define BLOCK_WORDS     16                      // Words in each block
+
+static std::function<void(void)> interrupt;    // Run halfway through copying a block, like an ISR
+static int32_t copies_before = -1;              // Copies to let by before the interrupt, or -1 for none
+
+/** @brief   A block of data whose words must all agree, so a torn copy shows up.
+ */
+struct checkedBlock
+{
+    uint32_t words[BLOCK_WORDS];                // Each is made from the same number
+
+    checkedBlock () = default;
+    checkedBlock (const checkedBlock&) = default;   // Only assignment is interrupted
+
+    /** @brief   Copies a block, running @c interrupt halfway through if its turn has come.
+     */
+    checkedBlock& operator= (const checkedBlock& other)
+    {
+        for (uint8_t i = 0; i < BLOCK_WORDS/2; i++)
+        {
+            words[i] = other.words[i];
+        }
+        if (copies_before == 0)
+        {
+            copies_before = -1;                 // It only happens once, and not inside itself
+            interrupt ();
+        }
+        else if (copies_before > 0)
+        {
+            copies_before--;
+        }
+        for (uint8_t i = BLOCK_WORDS/2; i < BLOCK_WORDS; i++)
+        {
+            words[i] = other.words[i];
+        }
+        return *this;
+    }
+};
+
+/** @brief   Returns a block made from a number.
+ */
+static checkedBlock block (uint32_t number)
+{
+    checkedBlock made;
+    for (uint8_t i = 0; i < BLOCK_WORDS; i++)
+    {
+        made.words[i] = (number ^ (i*0x9E3779B9)) + i;
+    }
+    return made;
+}
+
+/** @brief   Returns the number a block was made from, or -1 if its words don't agree.
+ */
+static int64_t number_of (const checkedBlock& data)
+{
+    uint32_t number = data.words[0];
+    for (uint8_t i = 1; i < BLOCK_WORDS; i++)
+    {
+        if (data.words[i] != (number ^ (i*0x9E3779B9)) + i)
+        {
+            return -1;
+        }
+    }
+    return number;
+}
+
+void setUp (void)
+{
+    copies_before = -1;
+}
+
+void tearDown (void)
+{
+}
+
+void test_reads_give_the_last_write (void)
+{
+    static SeqShare<checkedBlock> share ("Last");
+    checkedBlock data;
+    for (uint32_t n = 1; n <= 1000; n++)
+    {
+        share.put (block (n));
+        share.get (data);
+        TEST_ASSERT_EQUAL_INT64 (n, number_of (data));
+    }
+    share.ISR_put (block (7));
+    share.ISR_get (data);
+    TEST_ASSERT_EQUAL_INT64 (7, number_of (data));
+    static SeqShare<int32_t> small ("Small");
+    small.put (-123456);
+    int32_t value;
+    small.get (value);
+    TEST_ASSERT_EQUAL_INT32 (-123456, value);
+}
+
+void test_isr_reading_during_an_update_gets_a_whole_copy (void)
+{
+    static SeqShare<checkedBlock> share ("Writer hit");
+    int64_t seen[2];
+    for (int copy = 0; copy < 2; copy++)        // Interrupt the writing of each copy in turn
+    {
+        share.put (block (10*copy + 1));
+        interrupt = [&] ()
+        {
+            checkedBlock read;
+            share.ISR_get (read);
+            seen[copy] = number_of (read);
+        };
+        copies_before = copy;
+        share.put (block (10*copy + 2));
+        TEST_ASSERT_EQUAL_INT32 (-1, copies_before);
+    }
+    TEST_ASSERT_EQUAL_INT64 (1, seen[0]);       // Copy 0 being written sends it to the old copy 1
+    TEST_ASSERT_EQUAL_INT64 (12, seen[1]);      // Copy 1 being written sends it to the new copy 0
+}
+
+void test_isr_writing_during_a_read_makes_it_read_again (void)
+{
+    static SeqShare<checkedBlock> share ("Reader hit");
+    share.put (block (5));
+    uint32_t interrupts = 0;
+    interrupt = [&] ()
+    {
+        share.ISR_put (block (6));
+        interrupts++;
+    };
+    copies_before = 0;
+    checkedBlock data;
+    share.get (data);
+    TEST_ASSERT_EQUAL_UINT32 (1, interrupts);
+    TEST_ASSERT_EQUAL_INT64 (6, number_of (data));   // Whole, and the newer value
+}
+
+void test_threads_never_see_torn_or_older_data (void)
+{
+    static SeqShare<checkedBlock> share ("Threads");
+    share.put (block (0));
+    const uint32_t puts = 2000000;
+    const int readers = 2;
+    std::atomic<bool> done (false);
+    uint32_t reads[readers] = { 0 }, torn[readers] = { 0 }, backwards[readers] = { 0 }, changes[readers] = { 0 };
+    std::thread reader_threads[readers];
+    for (int r = 0; r < readers; r++)
+    {
+        reader_threads[r] = std::thread ([&, r] ()
+        {
+            int64_t last = 0;
+            while (!done)
+            {
+                checkedBlock data;
+                share.get (data);
+                int64_t number = number_of (data);
+                reads[r]++;
+                torn[r] += (number < 0);
+                backwards[r] += (number >= 0 && number < last);
+                changes[r] += (number > last);
+                last = (number >= 0) ? number : last;
+                if (reads[r] % 4096 == 0)
+                {
+                    std::this_thread::yield (); // Let the writer run on a single core
+                }
+            }
+        });
+    }
+    for (uint32_t n = 1; n <= puts; n++)
+    {
+        share.put (block (n));
+        if (n % 4096 == 0)
+        {
+            std::this_thread::yield ();
+        }
+    }
+    done = true;
+    for (std::thread& thread : reader_threads)
+    {
+        thread.join ();
+    }
+    char message[128];
+    snprintf (message, sizeof (message), "%u puts; readers made %u and %u reads and saw %u and %u "
+              "changes", (unsigned)puts, (unsigned)reads[0], (unsigned)reads[1], (unsigned)changes[0],
+              (unsigned)changes[1]);
+    TEST_MESSAGE (message);
+    for (int r = 0; r < readers; r++)
+    {
+        TEST_ASSERT_EQUAL_UINT32 (0, torn[r]);
+        TEST_ASSERT_EQUAL_UINT32 (0, backwards[r]);
+        TEST_ASSERT_GREATER_THAN (10, changes[r]);  // The reads were spread through the writes
+    }
+    checkedBlock data;
+    share.get (data);
+    TEST_ASSERT_EQUAL_INT64 (puts, number_of (data));
+}
+
+void test_print_shows_the_updates (void)
+{
+    static SeqShare<uint16_t> share ("Printed");
+    for (uint16_t n = 0; n < 3; n++)
+    {
+        share.put (n);
+    }
+    Serial.sent.clear ();
+    share.print_in_list (Serial);
+    TEST_ASSERT_EQUAL_STRING ("Printed         seqlock\t3 puts\r\n",
+                              Serial.sent.substr (0, Serial.sent.find ('\n') + 1).c_str ());
+}
+
+int main (void)
+{
+    UNITY_BEGIN ();
+    RUN_TEST (test_reads_give_the_last_write);
+    RUN_TEST (test_isr_reading_during_an_update_gets_a_whole_copy);
+    RUN_TEST (test_isr_writing_during_a_read_makes_it_read_again);
+    RUN_TEST (test_threads_never_see_torn_or_older_data);
+    RUN_TEST (test_print_shows_the_updates);
+    return UNITY_END ();
+}
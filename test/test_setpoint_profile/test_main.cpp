@@ -0,0 +1,152 @@
+/** @file test_main.cpp
+ *    This file contains the unit tests for the jerk-limited set point profile. Steps in the
+ *    set point are run through the profile at the control rate, and the reference must stay
+ *    within the acceleration and jerk limits, land on the set point without overshoot, and
+ *    take about as long as the time estimate said it would.
+ *  @date 2026-Oct-16
+ */
+
+#include <unity.h>
+#include "setpointprofile.cpp"
+
+#define PERIOD_US       1000                    // Control period
+#define MAX_ACCEL       20000                   // Acceleration limit [RPM/s]
+#define MAX_JERK        100000                  // Jerk limit [RPM/s^2]
+
+static setpointProfile* profile;                // Profile under test
+static int32_t worst_accel;                     // Largest acceleration seen [RPM/s]
+static int32_t worst_jerk;                      // Largest change in acceleration between steps [RPM/s]
+static int32_t overshoot;                       // Furthest the reference went past the set point [RPM]
+
+/** @brief   Runs the profile toward a set point until it lands or the steps run out.
+ *  @details The reference is checked against the limits and the set point at each step.
+ *  @returns The number of steps it took to land on the set point
+ */
+static uint32_t run_to (int32_t setpoint, int32_t start, uint32_t most = 100000)
+{
+    int32_t last_accel = profile->acceleration ();
+    for (uint32_t n = 1; n <= most; n++)
+    {
+        int32_t reference = profile->update (setpoint);
+        int32_t accel = profile->acceleration ();
+        worst_accel = max (worst_accel, abs (accel));
+        worst_jerk = max (worst_jerk, abs (accel - last_accel));
+        last_accel = accel;
+        int32_t past = (setpoint >= start) ? reference - setpoint : setpoint - reference;
+        overshoot = max (overshoot, past);
+        if (reference == setpoint && accel == 0)
+        {
+            return n;
+        }
+    }
+    return most;
+}
+
+void setUp (void)
+{
+    profile = new setpointProfile (PERIOD_US);
+    profile->set_limits (MAX_ACCEL, MAX_JERK);
+    worst_accel = 0;
+    worst_jerk = 0;
+    overshoot = 0;
+}
+
+void tearDown (void)
+{
+    delete profile;
+}
+
+void test_long_step_holds_the_limits_and_lands (void)
+{
+    uint32_t steps = run_to (10000, 0);
+    TEST_ASSERT_EQUAL_INT32 (10000, profile->speed ());
+    TEST_ASSERT_LESS_OR_EQUAL (0, overshoot);
+    TEST_ASSERT_TRUE (worst_accel <= MAX_ACCEL + 1);
+    TEST_ASSERT_TRUE (worst_jerk <= MAX_JERK*PERIOD_US/1000000 + 1);
+    TEST_ASSERT_TRUE (worst_accel >= MAX_ACCEL - MAX_JERK*PERIOD_US/1000000);   // Reaches the limit
+    uint32_t ideal = (10000.0/MAX_ACCEL + (double)MAX_ACCEL/MAX_JERK)*1000000/PERIOD_US;
+    TEST_ASSERT_UINT32_WITHIN (ideal/20, ideal, steps);
+}
+
+void test_short_step_never_reaches_the_acceleration_limit (void)
+{
+    uint32_t steps = run_to (1000, 0);
+    TEST_ASSERT_EQUAL_INT32 (1000, profile->speed ());
+    TEST_ASSERT_LESS_OR_EQUAL (0, overshoot);
+    TEST_ASSERT_TRUE (worst_accel < MAX_ACCEL/2);
+    uint32_t ideal = 2*sqrt (1000.0/MAX_JERK)*1000000/PERIOD_US;
+    TEST_ASSERT_UINT32_WITHIN (ideal/20, ideal, steps);
+}
+
+void test_slows_down_the_same_way (void)
+{
+    profile->reset (8000);
+    run_to (3000, 8000);
+    TEST_ASSERT_EQUAL_INT32 (3000, profile->speed ());
+    TEST_ASSERT_LESS_OR_EQUAL (0, overshoot);
+    TEST_ASSERT_TRUE (worst_accel <= MAX_ACCEL + 1);
+}
+
+void test_set_point_can_change_mid_ramp (void)
+{
+    for (int n = 0; n < 300; n++)               // Well into a ramp up to 10000
+    {
+        profile->update (10000);
+    }
+    TEST_ASSERT_TRUE (profile->acceleration () > 0);
+    int32_t start = profile->speed ();
+    run_to (2000, start);                       // Turned back down part way
+    TEST_ASSERT_EQUAL_INT32 (2000, profile->speed ());
+    TEST_ASSERT_TRUE (worst_accel <= MAX_ACCEL + 1);
+    TEST_ASSERT_TRUE (worst_jerk <= MAX_JERK*PERIOD_US/1000000 + 1);
+}
+
+void test_reset_starts_from_a_speed_at_rest (void)
+{
+    for (int n = 0; n < 100; n++)
+    {
+        profile->update (10000);
+    }
+    profile->reset (4321);
+    TEST_ASSERT_EQUAL_INT32 (4321, profile->speed ());
+    TEST_ASSERT_EQUAL_INT32 (0, profile->acceleration ());
+    TEST_ASSERT_EQUAL_INT32 (4321, profile->update (4321));
+}
+
+void test_time_remaining_matches_the_ramp (void)
+{
+    TEST_ASSERT_EQUAL_UINT32 (0, profile->time_remaining (5000, 5000, 0));
+    uint32_t estimate = profile->time_remaining (10000, 0, 0);
+    uint32_t steps = run_to (10000, 0);
+    TEST_ASSERT_UINT32_WITHIN (estimate/20, estimate, steps*PERIOD_US/1000);
+
+    profile->reset (0);                         // And part way through, accelerating
+    for (int n = 0; n < 150; n++)
+    {
+        profile->update (10000);
+    }
+    estimate = profile->time_remaining (10000, profile->speed (), profile->acceleration ());
+    steps = run_to (10000, profile->speed ());
+    TEST_ASSERT_UINT32_WITHIN (estimate/20 + 5, estimate, steps*PERIOD_US/1000);
+
+    profile->reset (0);                         // And turned back while accelerating away
+    for (int n = 0; n < 300; n++)
+    {
+        profile->update (10000);
+    }
+    estimate = profile->time_remaining (0, profile->speed (), profile->acceleration ());
+    steps = run_to (0, profile->speed ());
+    TEST_ASSERT_UINT32_WITHIN (estimate/10, estimate, steps*PERIOD_US/1000);
+}
+
+int main (void)
+{
+    UNITY_BEGIN ();
+    RUN_TEST (test_long_step_holds_the_limits_and_lands);
+    RUN_TEST (test_short_step_never_reaches_the_acceleration_limit);
+    RUN_TEST (test_slows_down_the_same_way);
+    RUN_TEST (test_set_point_can_change_mid_ramp);
+    RUN_TEST (test_reset_starts_from_a_speed_at_rest);
+    RUN_TEST (test_time_remaining_matches_the_ramp);
+    return UNITY_END ();
+}
@@ -0,0 +1,212 @@
+/** @file test_main.cpp
+ *    This file contains the unit tests for the input-capture timer. A fake timer latches
+ *    edge times and wraps its 16-bit counter the way the hardware does, including wraps
+ *    whose interrupt is still pending when an edge is captured, and the timestamps are
+ *    run through the M/T estimator to check the speed over the whole range.
+ *  @date 2026-Oct-16
+ */
+
+#include <unity.h>
+#include <STM32FreeRTOS.h>
+#include "speedcapture.cpp"
+#include "speedestimator.cpp"
+#include "rpmmath.cpp"
+#include "disccalibration.cpp"
+
+#define CAPTURE_PIN     7                       // Encoder pin A
+#define CAPTURE_RATE    10000000                // Timer count rate [ticks/second]
+
+static captureTimer* capture;                   // Timer under test
+static HardwareTimer* timer;                    // The fake timer it created
+static uint32_t last_read;                      // Timestamp read by the capture callback
+static uint32_t held_off_edges;                 // Edges captured with a wrap still pending
+
+/** @brief   Capture callback, which reads the timestamp as the motor's capture ISR does.
+ */
+static void on_capture (void)
+{
+    last_read = capture->read ();
+}
+
+void setUp (void)
+{
+    fake_pin_peripheral = TIM2;
+    fake_pin_function = 1;
+    capture = new captureTimer (CAPTURE_PIN, CAPTURE_RATE);
+    capture->begin (on_capture);
+    timer = fake_last_timer;
+}
+
+void tearDown (void)
+{
+    delete timer;
+    delete capture;
+}
+
+/** @brief   Moves the fake counter to the low 16 bits of a 64-bit time.
+ */
+static void set_time (uint64_t ticks)
+{
+    timer->handle.Instance->CNT = ticks & 0xFFFF;
+}
+
+/** @brief   Runs the counter from one time to another, servicing each wrap at once.
+ */
+static void run_to (uint64_t from, uint64_t to)
+{
+    for (uint64_t wrap = (from | 0xFFFF) + 1; wrap <= to; wrap += 0x10000)
+    {
+        timer->handle.Instance->SR |= TIM_SR_UIF;
+        timer->fire_update ();
+    }
+    set_time (to);
+}
+
+void test_begin_sets_up_the_timer (void)
+{
+    TEST_ASSERT_EQUAL_UINT32 (CAPTURE_RATE, capture->frequency ());
+    TEST_ASSERT_EQUAL_UINT32 (8, timer->getPrescaleFactor ());
+    TEST_ASSERT_EQUAL_UINT32 (0xFFFF, timer->handle.Instance->ARR);
+    TEST_ASSERT_EQUAL (TIMER_INPUT_CAPTURE_RISING, timer->mode[1]);
+    TEST_ASSERT_EQUAL_UINT32 (CAPTURE_PIN, timer->mode_pin[1]);
+    TEST_ASSERT_TRUE (timer->running);
+    TEST_ASSERT_TRUE ((bool)timer->update_callback);
+    TEST_ASSERT_TRUE ((bool)timer->channel_callback[1]);
+}
+
+void test_frequency_is_what_the_prescaler_gives (void)
+{
+    captureTimer odd (CAPTURE_PIN, 3000000);
+    odd.begin (on_capture);
+    TEST_ASSERT_EQUAL_UINT32 (80000000/26, odd.frequency ());
+    delete fake_last_timer;
+}
+
+void test_read_joins_wraps_and_capture (void)
+{
+    for (int wraps = 0; wraps < 5; wraps++)
+    {
+        timer->fire_update ();
+    }
+    timer->fire_channel (1, 0x1234);
+    TEST_ASSERT_EQUAL_HEX32 ((5u << 16) | 0x1234, last_read);
+}
+
+void test_read_counts_a_pending_wrap_before_the_edge (void)
+{
+    timer->fire_update ();
+    timer->handle.Instance->SR |= TIM_SR_UIF;   // Wrapped again, but its interrupt hasn't run
+    timer->fire_channel (1, 0x0010);            // The edge came just after the wrap
+    TEST_ASSERT_EQUAL_HEX32 ((2u << 16) | 0x0010, last_read);
+}
+
+void test_read_ignores_a_pending_wrap_after_the_edge (void)
+{
+    timer->fire_update ();
+    timer->handle.Instance->SR |= TIM_SR_UIF;   // Wrapped, but its interrupt hasn't run
+    timer->fire_channel (1, 0xFFF0);            // The edge came just before the wrap
+    TEST_ASSERT_EQUAL_HEX32 ((1u << 16) | 0xFFF0, last_read);
+}
+
+void test_now_counts_a_pending_wrap (void)
+{
+    timer->fire_update ();
+    timer->handle.Instance->SR |= TIM_SR_UIF;
+    set_time (0x20005);
+    TEST_ASSERT_EQUAL_HEX32 (0x20005, capture->now ());
+    timer->fire_update ();
+    TEST_ASSERT_EQUAL_HEX32 (0x20005, capture->now ());
+}
+
+/** @brief   Runs the encoder at a steady speed and returns the worst estimate error.
+ *  @details Edges are timed exactly in 64-bit ticks. Any edge which comes within a quarter
+ *           of the counter range after a wrap is captured before the wrap's interrupt runs,
+ *           as happens when the overflow interrupt is held off by the capture interrupt, so
+ *           the pending-wrap path is exercised as well. The estimator is sampled every 500 us
+ *           for 4 seconds.
+ */
+static int32_t worst_error (int32_t rpm, int32_t* samples_checked)
+{
+    speedEstimator estimator (1);
+    estimator.configure (1, capture->frequency ());
+    uint64_t period = (uint64_t)CAPTURE_RATE*60/rpm;
+    uint64_t sample_period = CAPTURE_RATE/2000;
+    uint64_t now = 0;
+    uint64_t next_edge = 1234;
+    int32_t position = 0;
+    int32_t worst = 0;
+    *samples_checked = 0;
+    held_off_edges = 0;
+    for (uint64_t next_sample = sample_period; next_sample < 4*(uint64_t)CAPTURE_RATE; next_sample += sample_period)
+    {
+        while (next_edge <= next_sample)
+        {
+            uint64_t wrap = next_edge & ~(uint64_t)0xFFFF;
+            bool held_off = (wrap > now) && (next_edge - wrap < 0x4000);
+            run_to (now, held_off ? wrap - 1 : next_edge);
+            if (held_off)                                               // Wrap flagged but not serviced yet
+            {
+                timer->handle.Instance->SR |= TIM_SR_UIF;
+                set_time (next_edge);
+                held_off_edges++;
+            }
+            timer->fire_channel (1, next_edge & 0xFFFF);
+            TEST_ASSERT_EQUAL_HEX32 ((uint32_t)next_edge, last_read);
+            if (held_off)
+            {
+                timer->fire_update ();
+            }
+            now = next_edge;
+            estimator.edge (last_read, ++position);
+            next_edge += period;
+        }
+        run_to (now, next_sample);
+        now = next_sample;
+        int32_t speed = estimator.sample (capture->now ());
+        if (position > 2 && estimator.updated)
+        {
+            worst = max (worst, abs (speed - rpm));
+            (*samples_checked)++;
+        }
+    }
+    return worst;
+}
+
+void test_speed_from_capture_at_1000_rpm (void)
+{
+    int32_t checked;
+    TEST_ASSERT_INT32_WITHIN (1, 0, worst_error (1000, &checked));
+    TEST_ASSERT_GREATER_THAN (10, checked);
+    TEST_ASSERT_GREATER_THAN (0, held_off_edges);
+}
+
+void test_speed_from_capture_at_10000_rpm (void)
+{
+    int32_t checked;
+    TEST_ASSERT_INT32_WITHIN (1, 0, worst_error (10000, &checked));
+    TEST_ASSERT_GREATER_THAN (100, checked);
+    TEST_ASSERT_GREATER_THAN (0, held_off_edges);
+}
+
+void test_speed_from_capture_at_30000_rpm (void)
+{
+    int32_t checked;
+    TEST_ASSERT_INT32_WITHIN (1, 0, worst_error (30000, &checked));
+    TEST_ASSERT_GREATER_THAN (400, checked);
+    TEST_ASSERT_GREATER_THAN (0, held_off_edges);
+}
+
+int main (void)
+{
+    UNITY_BEGIN ();
+    RUN_TEST (test_begin_sets_up_the_timer);
+    RUN_TEST (test_frequency_is_what_the_prescaler_gives);
+    RUN_TEST (test_read_joins_wraps_and_capture);
+    RUN_TEST (test_read_counts_a_pending_wrap_before_the_edge);
+    RUN_TEST (test_read_ignores_a_pending_wrap_after_the_edge);
+    RUN_TEST (test_now_counts_a_pending_wrap);
+    RUN_TEST (test_speed_from_capture_at_1000_rpm);
+    RUN_TEST (test_speed_from_capture_at_10000_rpm);
+    RUN_TEST (test_speed_from_capture_at_30000_rpm);
+    return UNITY_END ();
+}
@@ -0,0 +1,198 @@
+/** @file test_main.cpp
+ *    This file contains the unit tests for the M/T speed estimator. Synthetic encoder
+ *    traces, with and without interrupt latency jitter on the timestamps, are fed in
+ *    edge by edge and the estimator is sampled at a fixed rate, as the control step does.
+ *    The estimate is compared with the true speed and with timing each edge on its own.
+ *  @date 2026-Oct-16
+ */
+
+#include <unity.h>
+#include "speedestimator.cpp"
+#include "rpmmath.cpp"
+#include "disccalibration.cpp"
+
+/** @brief   Error statistics of one run, in RPM.
+ */
+struct runResult
+{
+    double mt_rms;                              // RMS error of the M/T estimate at each sample
+    double edge_rms;                            // RMS error of timing each edge period on its own
+    int32_t mt_worst;                           // Largest M/T error
+    uint32_t samples;                           // Samples which had a new estimate
+    uint32_t period_samples;                    // Of those, how many timed a single period
+};
+
+static uint32_t seed;                           // Pseudo-random state for the jitter
+
+/** @brief   Returns a pseudo-random number from 0 to @c range - 1.
+ */
+static uint32_t random_below (uint32_t range)
+{
+    seed = seed*1103515245 + 12345;
+    return range ? (seed >> 8) % range : 0;
+}
+
+/** @brief   Runs a steady speed through the estimator.
+ *  @details Edges are evenly spaced in true time; each timestamp is the true time, rounded
+ *           down to a microsecond, plus up to @c jitter_us of latency. The estimator is
+ *           sampled every @c sample_us for @c duration_us, and the first 50 ms are left out
+ *           of the statistics while it starts up.
+ */
+static runResult run_steady (int32_t rpm, uint8_t counts_per_rev, uint32_t sample_us,
+                             uint32_t duration_us, uint32_t jitter_us)
+{
+    speedEstimator estimator (counts_per_rev);
+    rpmCalculator per_edge;
+    per_edge.configure (counts_per_rev, 1000000);
+    double period = 60e6/((double)abs (rpm)*counts_per_rev);
+    int32_t step = rpm < 0 ? -1 : 1;
+    double next_edge = 137.0;
+    int32_t position = 0;
+    uint32_t previous_stamp = 0;
+    bool have_previous = false;
+    runResult result = { 0, 0, 0, 0, 0 };
+    double mt_sum = 0;
+    double edge_sum = 0;
+    uint32_t edge_count = 0;
+    for (uint32_t now = sample_us; now <= duration_us; now += sample_us)
+    {
+        while (next_edge <= now)
+        {
+            uint32_t stamp = (uint32_t)next_edge + random_below (jitter_us + 1);
+            position += step;
+            estimator.edge (stamp, position);
+            if (have_previous && next_edge > 50000)
+            {
+                double error = step*per_edge.rpm (1, stamp - previous_stamp) - rpm;
+                edge_sum += error*error;
+                edge_count++;
+            }
+            previous_stamp = stamp;
+            have_previous = true;
+            next_edge += period;
+        }
+        int32_t speed = estimator.sample (now);
+        if (now > 50000 && estimator.updated)
+        {
+            int32_t error = speed - rpm;
+            mt_sum += (double)error*error;
+            result.mt_worst = max (result.mt_worst, abs (error));
+            result.samples++;
+            result.period_samples += estimator.period_mode;
+        }
+    }
+    result.mt_rms = result.samples ? sqrt (mt_sum/result.samples) : 0;
+    result.edge_rms = edge_count ? sqrt (edge_sum/edge_count) : 0;
+    return result;
+}
+
+void setUp (void)
+{
+    seed = 42;
+}
+
+void tearDown (void)
+{
+}
+
+void test_count_window_is_exact_at_high_speed (void)
+{
+    runResult result = run_steady (20000, 4, 10000, 1000000, 0);
+    TEST_ASSERT_LESS_OR_EQUAL (1, result.mt_worst);
+    TEST_ASSERT_GREATER_THAN (90, result.samples);
+    TEST_ASSERT_EQUAL_UINT32 (0, result.period_samples);
+}
+
+void test_single_period_at_crawl_speed (void)
+{
+    runResult result = run_steady (300, 1, 10000, 3000000, 0);
+    TEST_ASSERT_LESS_OR_EQUAL (1, result.mt_worst);
+    TEST_ASSERT_GREATER_THAN (10, result.samples);
+    TEST_ASSERT_EQUAL_UINT32 (result.samples, result.period_samples);
+}
+
+void test_single_period_at_the_lowest_speed (void)
+{
+    runResult result = run_steady (100, 1, 10000, 6000000, 0);
+    TEST_ASSERT_LESS_OR_EQUAL (1, result.mt_worst);
+    TEST_ASSERT_GREATER_THAN (5, result.samples);
+    TEST_ASSERT_EQUAL_UINT32 (result.samples, result.period_samples);
+}
+
+void test_reverse_is_negative (void)
+{
+    runResult result = run_steady (-12000, 4, 2000, 500000, 0);
+    TEST_ASSERT_LESS_OR_EQUAL (1, result.mt_worst);
+    TEST_ASSERT_GREATER_THAN (100, result.samples);
+}
+
+void test_window_beats_single_edges_under_jitter (void)
+{
+    runResult result = run_steady (10000, 4, 10000, 2000000, 20);
+    char message[96];
+    snprintf (message, sizeof (message), "M/T RMS %.1f RPM, per-edge RMS %.1f RPM",
+              result.mt_rms, result.edge_rms);
+    TEST_MESSAGE (message);
+    TEST_ASSERT_TRUE (result.mt_rms < 20);
+    TEST_ASSERT_TRUE (result.mt_rms < result.edge_rms/4);
+}
+
+void test_empty_window_keeps_the_estimate (void)
+{
+    speedEstimator estimator (1);
+    estimator.edge (0, 1);
+    estimator.edge (10000, 2);                  // 6000 RPM
+    TEST_ASSERT_EQUAL_INT32 (6000, estimator.sample (10000));
+    TEST_ASSERT_TRUE (estimator.updated);
+    TEST_ASSERT_EQUAL_INT32 (6000, estimator.sample (10000));
+    TEST_ASSERT_FALSE (estimator.updated);
+    TEST_ASSERT_FALSE (estimator.stopped);
+}
+
+void test_speed_decays_to_the_bound_then_stops (void)
+{
+    speedEstimator estimator (1);
+    for (int32_t edge = 0; edge <= 10; edge++)  // 6000 RPM, 10 ms per edge
+    {
+        estimator.edge (edge*10000, edge);
+    }
+    TEST_ASSERT_EQUAL_INT32 (6000, estimator.sample (100000));
+    int32_t previous = 6000;
+    uint32_t stopped_at = 0;
+    for (uint32_t now = 101000; now <= 200000 && !stopped_at; now += 1000)
+    {
+        int32_t speed = estimator.sample (now);
+        TEST_ASSERT_LESS_OR_EQUAL (previous, speed);
+        TEST_ASSERT_LESS_OR_EQUAL (60000000/(now - 100000) + 1, speed);
+        previous = speed;
+        if (estimator.stopped)
+        {
+            stopped_at = now;
+            TEST_ASSERT_EQUAL_INT32 (0, speed);
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32 (141000, stopped_at);  // Just over stall_periods = 4 periods
+}
+
+void test_configure_scales_to_the_tick_rate (void)
+{
+    speedEstimator estimator (4);
+    estimator.configure (4, 10000000);
+    estimator.edge (0, 0);
+    estimator.edge (15000, 1);                  // 1.5 ms at 10 MHz, per count of 4
+    TEST_ASSERT_EQUAL_INT32 (10000, estimator.sample (20000));
+}
+
+int main (void)
+{
+    UNITY_BEGIN ();
+    RUN_TEST (test_count_window_is_exact_at_high_speed);
+    RUN_TEST (test_single_period_at_crawl_speed);
+    RUN_TEST (test_single_period_at_the_lowest_speed);
+    RUN_TEST (test_reverse_is_negative);
+    RUN_TEST (test_window_beats_single_edges_under_jitter);
+    RUN_TEST (test_empty_window_keeps_the_estimate);
+    RUN_TEST (test_speed_decays_to_the_bound_then_stops);
+    RUN_TEST (test_configure_scales_to_the_tick_rate);
+    return UNITY_END ();
+}
@@ -0,0 +1,229 @@
+/** @file test_main.cpp
+ *    This file contains the unit tests for the speed and acceleration observer. Both the
+ *    alpha-beta and the Kalman filter are run on a simulated spindle which rests, ramps
+ *    up and holds its speed, with noise added to each measurement. The lag and the RMS
+ *    error while ramping are reported and compared with a plain moving average.
+ *  @date 2026-Oct-16
+ */
+
+#include <unity.h>
+#include "speedobserver.cpp"
+
+#define PERIOD_US       1000                    // Observer update period
+#define RAMP_START      200000                  // Time at which the ramp starts [us]
+#define RAMP_RATE       10000                   // Ramp acceleration [RPM/s]
+#define TOP_SPEED       20000                   // Speed at the end of the ramp [RPM]
+#define NOISE_RMS       20.0                    // Standard deviation of the measurement noise [RPM]
+#define AVERAGE_LENGTH  16                      // Samples in the moving average compared against
+
+/** @brief   Error statistics of one run, in RPM and RPM/s.
+ */
+struct rampResult
+{
+    double lag;                                 // Mean of true minus filtered speed while ramping
+    double rms;                                 // RMS error while ramping
+    double hold_rms;                            // RMS error once the speed is steady
+    double accel;                               // Mean acceleration estimate while ramping
+    double average_lag;                         // Mean lag of the moving average while ramping
+    double average_rms;                         // RMS error of the moving average while ramping
+};
+
+static uint32_t seed;                           // Pseudo-random state for the noise
+
+/** @brief   Returns roughly Gaussian noise with a standard deviation of @c NOISE_RMS.
+ *  @details Twelve uniform numbers from 0 to 1 add up to something close to a normal
+ *           distribution with a mean of 6 and a variance of 1.
+ */
+static double noise (void)
+{
+    double sum = 0;
+    for (int i = 0; i < 12; i++)
+    {
+        seed = seed*1103515245 + 12345;
+        sum += (seed >> 8)/16777216.0;
+    }
+    return (sum - 6)*NOISE_RMS;
+}
+
+/** @brief   Returns the true speed of the simulated spindle at a given time.
+ */
+static double true_speed (uint32_t now)
+{
+    if (now < RAMP_START)
+    {
+        return 0;
+    }
+    return min ((double)TOP_SPEED, (now - RAMP_START)*(RAMP_RATE/1e6));
+}
+
+/** @brief   Runs the ramp through an observer and a moving average.
+ *  @details The first 300 ms of the ramp are left out while the filters catch up, and the
+ *           steady statistics start 300 ms after the ramp ends.
+ */
+static rampResult run_ramp (speedObserver& observer)
+{
+    uint32_t ramp_end = RAMP_START + (uint64_t)TOP_SPEED*1000000/RAMP_RATE;
+    int32_t history[AVERAGE_LENGTH] = { 0 };
+    int64_t history_sum = 0;
+    double lag = 0, square = 0, hold_square = 0, accel = 0, average_lag = 0, average_square = 0;
+    uint32_t ramp_samples = 0, hold_samples = 0;
+    rampResult result;
+    for (uint32_t now = PERIOD_US, n = 0; now < ramp_end + 800000; now += PERIOD_US, n++)
+    {
+        double exact = true_speed (now);
+        int32_t measured = lround (exact + noise ());
+        observer.update (measured, true);
+        history_sum += measured - history[n % AVERAGE_LENGTH];
+        history[n % AVERAGE_LENGTH] = measured;
+        double error = exact - observer.speed;
+        if (now > RAMP_START + 300000 && now < ramp_end)
+        {
+            double average_error = exact - (double)history_sum/AVERAGE_LENGTH;
+            lag += error;
+            square += error*error;
+            accel += observer.acceleration;
+            average_lag += average_error;
+            average_square += average_error*average_error;
+            ramp_samples++;
+        }
+        else if (now > ramp_end + 300000)
+        {
+            hold_square += error*error;
+            hold_samples++;
+        }
+    }
+    result.lag = lag/ramp_samples;
+    result.rms = sqrt (square/ramp_samples);
+    result.hold_rms = sqrt (hold_square/hold_samples);
+    result.accel = accel/ramp_samples;
+    result.average_lag = average_lag/ramp_samples;
+    result.average_rms = sqrt (average_square/ramp_samples);
+    return result;
+}
+
+/** @brief   Reports a run's statistics in the test output.
+ */
+static void report (const char* name, const rampResult& result)
+{
+    char message[160];
+    snprintf (message, sizeof (message), "%s: lag %.1f RPM, RMS %.1f RPM ramping and %.1f RPM "
+              "holding; moving average lag %.1f RPM, RMS %.1f RPM", name, result.lag,
+              result.rms, result.hold_rms, result.average_lag, result.average_rms);
+    TEST_MESSAGE (message);
+}
+
+void setUp (void)
+{
+    seed = 42;
+}
+
+void tearDown (void)
+{
+}
+
+void test_alpha_beta_keeps_up_with_a_ramp (void)
+{
+    speedObserver observer (OBSERVER_ALPHA_BETA, PERIOD_US);
+    rampResult result = run_ramp (observer);
+    report ("Alpha-beta", result);
+    TEST_ASSERT_TRUE (fabs (result.lag) < 5);
+    TEST_ASSERT_TRUE (result.rms < NOISE_RMS);
+    TEST_ASSERT_TRUE (result.hold_rms < NOISE_RMS);
+    TEST_ASSERT_TRUE (fabs (result.accel - RAMP_RATE) < RAMP_RATE/20);
+    TEST_ASSERT_TRUE (result.average_lag > 50);  // Half the window times the ramp rate
+}
+
+void test_kalman_keeps_up_with_a_ramp (void)
+{
+    speedObserver observer (OBSERVER_KALMAN, PERIOD_US);
+    rampResult result = run_ramp (observer);
+    report ("Kalman", result);
+    TEST_ASSERT_TRUE (fabs (result.lag) < 5);
+    TEST_ASSERT_TRUE (result.rms < NOISE_RMS);
+    TEST_ASSERT_TRUE (result.hold_rms < NOISE_RMS);
+    TEST_ASSERT_TRUE (fabs (result.accel - RAMP_RATE) < RAMP_RATE/20);
+}
+
+void test_quieter_kalman_filters_more (void)
+{
+    speedObserver observer (OBSERVER_KALMAN, PERIOD_US);
+    speedObserver quiet (OBSERVER_KALMAN, PERIOD_US);
+    quiet.set_noise (1.0e5f, 400.0f);           // Trust the model more than the default does
+    quiet.reset (0);
+    rampResult result = run_ramp (observer);
+    seed = 42;
+    rampResult quiet_result = run_ramp (quiet);
+    TEST_ASSERT_TRUE (quiet_result.hold_rms < result.hold_rms);
+}
+
+/** @brief   Returns the lowest speed an alpha-beta filter comes back down to after the
+ *           peak of its response to a 10000 RPM step. Below 10000 means it rings.
+ */
+static int32_t step_swing_back (float alpha, float beta)
+{
+    speedObserver observer (OBSERVER_ALPHA_BETA, PERIOD_US);
+    observer.set_gains (alpha, beta);
+    int32_t peak = 0;
+    int32_t lowest = INT32_MAX;
+    for (uint32_t n = 0; n < 400; n++)
+    {
+        observer.update (10000, true);
+        if (observer.speed < peak)
+        {
+            lowest = min (lowest, observer.speed);
+        }
+        peak = max (peak, observer.speed);
+    }
+    return lowest;
+}
+
+void test_default_gains_ring_and_critical_gains_do_not (void)
+{
+    TEST_ASSERT_LESS_THAN (9980, step_swing_back (0.5f, 0.15f));
+    TEST_ASSERT_GREATER_OR_EQUAL (9999, step_swing_back (0.5f, 0.0858f));   // 2 - alpha - 2*sqrt(1 - alpha)
+}
+
+void test_prediction_carries_on_without_measurements (void)
+{
+    uint8_t modes[2] = { OBSERVER_ALPHA_BETA, OBSERVER_KALMAN };
+    for (uint8_t mode : modes)
+    {
+        speedObserver observer (mode, PERIOD_US);
+        for (uint32_t n = 1; n <= 500; n++)     // Ramp at 10000 RPM/s with no noise
+        {
+            observer.update (n*10, true);
+        }
+        for (uint32_t n = 501; n <= 520; n++)   // Then 20 ms with no new edges
+        {
+            observer.update (0, false);
+        }
+        TEST_ASSERT_INT32_WITHIN (10, 5200, observer.speed);
+        TEST_ASSERT_INT32_WITHIN (500, 10000, observer.acceleration);
+    }
+}
+
+void test_reset_starts_at_rest_at_the_given_speed (void)
+{
+    speedObserver observer (OBSERVER_ALPHA_BETA, PERIOD_US);
+    for (uint32_t n = 1; n <= 100; n++)
+    {
+        observer.update (n*10, true);
+    }
+    observer.reset (3000);
+    TEST_ASSERT_EQUAL_INT32 (3000, observer.speed);
+    TEST_ASSERT_EQUAL_INT32 (0, observer.acceleration);
+    observer.update (3000, true);
+    TEST_ASSERT_EQUAL_INT32 (3000, observer.speed);
+}
+
+int main (void)
+{
+    UNITY_BEGIN ();
+    RUN_TEST (test_alpha_beta_keeps_up_with_a_ramp);
+    RUN_TEST (test_kalman_keeps_up_with_a_ramp);
+    RUN_TEST (test_quieter_kalman_filters_more);
+    RUN_TEST (test_default_gains_ring_and_critical_gains_do_not);
+    RUN_TEST (test_prediction_carries_on_without_measurements);
+    RUN_TEST (test_reset_starts_at_rest_at_the_given_speed);
+    return UNITY_END ();
+}
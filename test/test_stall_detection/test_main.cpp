@@ -0,0 +1,157 @@
+/** @file test_main.cpp
+ *    This file contains the regression tests for zero-speed detection in the M/T speed
+ *    estimator. A disc with one count per revolution is run from the slowest supported
+ *    speed to full speed and sampled at the slow task rate and at the control rate. The
+ *    motor must never read as stopped while it turns, and once its edges end it must read
+ *    as stopped within the stall timeout.
+ *  @date 2026-Oct-16
+ */
+
+#include <unity.h>
+#include "speedestimator.cpp"
+#include "rpmmath.cpp"
+#include "disccalibration.cpp"
+
+static const int32_t speeds[] = { 100, 300, 500, 1000, 3000, 6000, 12000, 20000 }; // RPM
+static const uint32_t stall_max_us = 60000000u*STALL_MIN_PERIODS/STALL_MIN_RPM;     // Longest timeout at 1 count per revolution
+static uint32_t seed;                           // Pseudo-random state for the jitter
+
+/** @brief   Result of running one speed until the edges stop.
+ */
+struct stallResult
+{
+    uint32_t false_stops;                       // Samples that read stopped while edges were arriving
+    uint32_t latency;                           // Time from the last edge until stopped [us]
+    uint32_t timeout;                           // Stall timeout expected at this speed [us]
+    bool rose;                                  // If the speed ever went up after the edges ended
+};
+
+/** @brief   Runs one count per revolution at a steady speed for two seconds, then stops.
+ *  @details Each edge comes up to 20 us late, as interrupt latency would make it. The
+ *           estimator is sampled every @c sample_us; no stop is allowed once a window has
+ *           closed with an edge in it, until the edges end.
+ */
+static stallResult run_and_stop (int32_t rpm, uint32_t sample_us)
+{
+    speedEstimator estimator (1);
+    uint32_t period = 60000000/rpm;
+    uint32_t run_until = max (2000000u, 4*period);
+    uint32_t next_edge = 1000;
+    uint32_t last_edge = 0;
+    int32_t position = 0;
+    int32_t previous = INT32_MAX;
+    bool measured = false;
+    stallResult result = { 0, 0, constrain (4*period, (uint32_t)STALL_MIN_US, stall_max_us), false };
+    for (uint32_t now = sample_us; now < run_until + 2*stall_max_us; now += sample_us)
+    {
+        while (next_edge <= now && next_edge < run_until)
+        {
+            seed = seed*1103515245 + 12345;
+            last_edge = next_edge + (seed >> 8) % 21;
+            estimator.edge (last_edge, ++position);
+            next_edge += period;
+        }
+        estimator.sample (now);
+        if (now < run_until)
+        {
+            measured |= estimator.updated && !estimator.stopped;
+            result.false_stops += measured && estimator.stopped;
+        }
+        else if (!result.latency)
+        {
+            result.rose |= estimator.speed > previous;
+            previous = estimator.speed;
+            if (estimator.stopped)
+            {
+                result.latency = now - last_edge;
+                TEST_ASSERT_EQUAL_INT32 (0, estimator.speed);
+            }
+        }
+    }
+    return result;
+}
+
+/** @brief   Checks every speed at one sample rate.
+ */
+static void check_all_speeds (uint32_t sample_us)
+{
+    for (int32_t rpm : speeds)
+    {
+        stallResult result = run_and_stop (rpm, sample_us);
+        char message[64];
+        snprintf (message, sizeof (message), "%d RPM sampled every %u us", rpm, sample_us);
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE (0, result.false_stops, message);
+        TEST_ASSERT_FALSE_MESSAGE (result.rose, message);
+        // The last period timed may be up to 20 us short, which shortens the timeout by 4 times that
+        TEST_ASSERT_TRUE_MESSAGE (result.latency + 4*20 > result.timeout, message);
+        TEST_ASSERT_TRUE_MESSAGE (result.latency <= result.timeout + sample_us, message);
+    }
+}
+
+void setUp (void)
+{
+    seed = 42;
+}
+
+void tearDown (void)
+{
+}
+
+void test_no_false_stops_and_bounded_latency_at_task_rate (void)
+{
+    check_all_speeds (10000);
+}
+
+void test_no_false_stops_and_bounded_latency_at_control_rate (void)
+{
+    check_all_speeds (500);
+}
+
+void test_stall_from_full_speed_within_a_few_milliseconds (void)
+{
+    stallResult result = run_and_stop (20000, 500);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32 (13000, result.latency);
+}
+
+void test_slow_first_edges_are_not_a_stall (void)
+{
+    speedEstimator estimator (1);
+    estimator.edge (1000, 1);                   // 100 RPM, 600 ms per revolution
+    for (uint32_t now = 1000; now < 601000; now += 10000)
+    {
+        estimator.sample (now);
+        TEST_ASSERT_FALSE (estimator.updated);
+    }
+    estimator.edge (601000, 2);
+    TEST_ASSERT_EQUAL_INT32 (100, estimator.sample (601000));
+    TEST_ASSERT_FALSE (estimator.stopped);
+}
+
+void test_restart_after_a_stop (void)
+{
+    speedEstimator estimator (1);
+    for (int32_t edge = 0; edge <= 10; edge++)  // 6000 RPM
+    {
+        estimator.edge (edge*10000, edge);
+    }
+    estimator.sample (100000);
+    estimator.sample (200000);
+    TEST_ASSERT_TRUE (estimator.stopped);
+    estimator.edge (300000, 11);                // The first edge after a stop only opens a window
+    estimator.sample (300000);
+    TEST_ASSERT_TRUE (estimator.stopped);
+    estimator.edge (305000, 12);
+    TEST_ASSERT_EQUAL_INT32 (12000, estimator.sample (305000));
+    TEST_ASSERT_FALSE (estimator.stopped);
+}
+
+int main (void)
+{
+    UNITY_BEGIN ();
+    RUN_TEST (test_no_false_stops_and_bounded_latency_at_task_rate);
+    RUN_TEST (test_no_false_stops_and_bounded_latency_at_control_rate);
+    RUN_TEST (test_stall_from_full_speed_within_a_few_milliseconds);
+    RUN_TEST (test_slow_first_edges_are_not_a_stall);
+    RUN_TEST (test_restart_after_a_stop);
+    return UNITY_END ();
+}
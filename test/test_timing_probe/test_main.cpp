@@ -0,0 +1,181 @@
+/** @file test_main.cpp
+ *    This file contains the unit tests for the timing probes. On a PC the probes read the
+ *    monotonic clock, so the code they time here spins on that clock for known times, and
+ *    the tests check the busy time, the period and the jitter which come out, and what a
+ *    probe costs. Spinning can only make a time longer, so the tight checks are on the
+ *    shortest times, and the longest are only checked loosely, since the test may be
+ *    switched out at any moment. The probes are global, as in the firmware, because each
+ *    one links itself into the list which the printout follows.
+ *  @date 2026-Oct-16
+ */
+
+#include <unity.h>
+#include "timingprobe.cpp"
+
+#define BUSY_NS         100000                  // Time the timed code takes [ns]
+#define PERIOD_NS       500000                  // Time from one start to the next [ns]
+
+/** @brief   A probe whose statistics the tests can see and set.
+ */
+class testProbe : public timingProbe
+{
+    public:
+        using timingProbe::timingProbe;
+        using timingProbe::count;
+        using timingProbe::busy_min;
+        using timingProbe::busy_max;
+        using timingProbe::busy_total;
+        using timingProbe::periods;
+        using timingProbe::period_min;
+        using timingProbe::period_max;
+        using timingProbe::period_total;
+};
+
+static testProbe loopProbe ("Loop");            // Times the simulated loop
+static testProbe costProbe ("Cost");            // Times nothing, to see what a probe costs
+TIMING_PROBE (macroProbe, "Macro");             // Made the way the firmware makes them
+
+/** @brief   Spins until the probe clock reaches a time.
+ */
+static void spin_until (uint32_t time)
+{
+    while ((int32_t)(timingProbe::ticks () - time) < 0)
+    {
+    }
+}
+
+/** @brief   Runs a loop which starts every period and is busy for part of it.
+ *  @param   probe The probe which times the loop
+ *  @param   runs  How many times the loop runs
+ *  @param   late  The run which starts three periods late, or -1 for none
+ */
+static void run_loop (testProbe& probe, uint32_t runs, int32_t late)
+{
+    uint32_t start = timingProbe::ticks ();
+    for (uint32_t n = 0; n < runs; n++)
+    {
+        spin_until (start + ((int32_t)n == late ? 3*PERIOD_NS : (n ? PERIOD_NS : 0)));
+        start = timingProbe::ticks ();
+        PROBE_START (probe);
+        spin_until (start + BUSY_NS);
+        PROBE_STOP (probe);
+    }
+}
+
+void setUp (void)
+{
+    clear_all_probes ();
+}
+
+void tearDown (void)
+{
+}
+
+void test_clock_counts_nanoseconds (void)
+{
+    TEST_ASSERT_EQUAL_UINT32 (1000000000UL, timingProbe::rate ());
+    auto before = std::chrono::steady_clock::now ();
+    uint32_t first = timingProbe::ticks ();
+    while (std::chrono::steady_clock::now () - before < std::chrono::milliseconds (2))
+    {
+    }
+    uint32_t elapsed = timingProbe::ticks () - first;
+    TEST_ASSERT_GREATER_OR_EQUAL (1990000, elapsed);
+    TEST_ASSERT_LESS_THAN (200000000, elapsed);
+}
+
+void test_busy_time_and_period_are_recorded (void)
+{
+    run_loop (loopProbe, 50, -1);
+    TEST_ASSERT_EQUAL_UINT32 (50, loopProbe.count);
+    TEST_ASSERT_EQUAL_UINT32 (49, loopProbe.periods);    // The first start only begins a period
+    TEST_ASSERT_GREATER_OR_EQUAL (BUSY_NS, loopProbe.busy_min);
+    TEST_ASSERT_LESS_OR_EQUAL (loopProbe.busy_max, loopProbe.busy_min);
+    TEST_ASSERT_GREATER_OR_EQUAL (BUSY_NS, loopProbe.busy_total/loopProbe.count);
+    TEST_ASSERT_LESS_THAN (3*BUSY_NS, loopProbe.busy_total/loopProbe.count);
+    TEST_ASSERT_GREATER_OR_EQUAL (PERIOD_NS, loopProbe.period_min);
+    TEST_ASSERT_LESS_OR_EQUAL (loopProbe.period_max, loopProbe.period_min);
+    TEST_ASSERT_GREATER_OR_EQUAL (PERIOD_NS, loopProbe.period_total/loopProbe.periods);
+    TEST_ASSERT_LESS_THAN (3*PERIOD_NS, loopProbe.period_total/loopProbe.periods);
+}
+
+void test_late_start_shows_as_jitter (void)
+{
+    run_loop (loopProbe, 20, 10);
+    TEST_ASSERT_GREATER_OR_EQUAL (3*PERIOD_NS, loopProbe.period_max);
+    TEST_ASSERT_GREATER_OR_EQUAL (2*PERIOD_NS, loopProbe.period_max - loopProbe.period_min);
+    TEST_ASSERT_GREATER_OR_EQUAL (BUSY_NS, loopProbe.busy_min);
+}
+
+void test_clearing_starts_afresh (void)
+{
+    run_loop (loopProbe, 5, -1);
+    loopProbe.clear ();
+    TEST_ASSERT_EQUAL_UINT32 (0, loopProbe.count);
+    TEST_ASSERT_EQUAL_UINT32 (0, loopProbe.periods);
+    TEST_ASSERT_EQUAL_UINT32 (0xFFFFFFFF, loopProbe.busy_min);
+    TEST_ASSERT_EQUAL_UINT32 (0, loopProbe.period_max);
+    run_loop (loopProbe, 1, -1);                // A start after clearing doesn't time a period
+    TEST_ASSERT_EQUAL_UINT32 (1, loopProbe.count);
+    TEST_ASSERT_EQUAL_UINT32 (0, loopProbe.periods);
+    run_loop (costProbe, 3, -1);
+    PROBE_START (macroProbe);
+    PROBE_STOP (macroProbe);
+    clear_all_probes ();
+    TEST_ASSERT_EQUAL_UINT32 (0, loopProbe.count);
+    TEST_ASSERT_EQUAL_UINT32 (0, costProbe.count);
+}
+
+void test_probe_costs_little (void)
+{
+    const uint32_t pairs = 1000000;
+    uint32_t begin = timingProbe::ticks ();
+    for (uint32_t n = 0; n < pairs; n++)
+    {
+        PROBE_START (costProbe);
+        PROBE_STOP (costProbe);
+    }
+    double pair_ns = (double)(timingProbe::ticks () - begin)/pairs;
+    char message[96];
+    snprintf (message, sizeof (message), "A start and stop take %.0f ns, of which %u ns between them",
+              pair_ns, (unsigned)costProbe.busy_min);
+    TEST_MESSAGE (message);
+    TEST_ASSERT_EQUAL_UINT32 (pairs, costProbe.count);
+    TEST_ASSERT_EQUAL_UINT32 (pairs - 1, costProbe.periods);
+    TEST_ASSERT_TRUE (pair_ns < 2000);
+}
+
+void test_printout_lists_every_probe (void)
+{
+    loopProbe.count = 4;
+    loopProbe.busy_min = 1500;
+    loopProbe.busy_total = 8000;
+    loopProbe.busy_max = 3250;
+    loopProbe.periods = 3;
+    loopProbe.period_min = 999000;
+    loopProbe.period_total = 3000000;
+    loopProbe.period_max = 1001500;
+    costProbe.count = 1;
+    costProbe.busy_min = costProbe.busy_max = costProbe.busy_total = 40;
+    Serial.sent.clear ();
+    print_all_probes (Serial);
+    TEST_ASSERT_EQUAL_STRING (
+        "Probe              Count     Busy us (min/mean/max)       Period us (min/mean/max), jitter\r\n"
+        "-----              -----     ----------------------       ----------------------------------\r\n"
+        "Macro                  0\r\n"
+        "Cost                   1       0.04       0.04       0.04\r\n"
+        "Loop                   4       1.50       2.00       3.25     999.00    1000.00    1001.50       2.50\r\n",
+        Serial.sent.c_str ());
+}
+
+int main (void)
+{
+    UNITY_BEGIN ();
+    RUN_TEST (test_clock_counts_nanoseconds);
+    RUN_TEST (test_busy_time_and_period_are_recorded);
+    RUN_TEST (test_late_start_shows_as_jitter);
+    RUN_TEST (test_clearing_starts_afresh);
+    RUN_TEST (test_probe_costs_little);
+    RUN_TEST (test_printout_lists_every_probe);
+    return UNITY_END ();
+}
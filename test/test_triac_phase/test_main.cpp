@@ -0,0 +1,241 @@
+/** @file test_main.cpp
+ *    This file contains the unit tests for the phase-angle triac driver. A fake zero-cross
+ *    detector interrupts at each crossing of simulated 50 and 60 Hz mains, and the timer's
+ *    counter is stepped a microsecond at a time, running the compare interrupt whenever it
+ *    reaches the compare value, as the hardware would. The gate is checked to rise at the
+ *    firing delay after each crossing and to fall a pulse later, and the firing delay table
+ *    is checked to give power in proportion to the duty cycle.
+ *  @date 2026-Oct-16
+ */
+
+#include <unity.h>
+#include "mainspll.cpp"
+#include "triacdriver.cpp"
+
+#define GATE_PIN        10                      // Pin driving the triac gate
+#define ZC_PIN          11                      // Pin from the zero-cross detector
+
+// The base class is in motorstuff.cpp, which brings the whole user interface with it
+MotorDriver::MotorDriver (void) { PWM_pin = 0xFF; direction_pin = 0xFF; }
+void MotorDriver::run (int32_t DUTYCYCLE, int32_t DIRECTION) { (void)DUTYCYCLE; (void)DIRECTION; }
+void MotorDriver::run_fine (int32_t DUTY_Q8, int32_t DIRECTION) { run((DUTY_Q8 + 0x80) >> 8, DIRECTION); }
+
+static HardwareTimer* timer;                    // The driver's timer
+static uint32_t now_us;                         // Simulated time [us]
+static uint32_t rises[512];                     // Times the gate went high [us]
+static uint32_t falls[512];                     // Times the gate went low [us]
+static uint32_t rise_count;                     // Number of entries in rises[]
+static uint32_t fall_count;                     // Number of entries in falls[]
+
+/** @brief   Returns the fraction of full power a resistive load gets when fired at a delay.
+ */
+static double power_at (uint16_t delay, double half_period)
+{
+    double angle = delay/half_period*M_PI;
+    return 1 - angle/M_PI + sin (2*angle)/(2*M_PI);
+}
+
+/** @brief   Runs an interrupt and records any change it makes to the gate.
+ */
+static void run_isr (callback_function_t& isr)
+{
+    uint8_t before = fake_pin_level[GATE_PIN];
+    isr ();
+    uint8_t after = fake_pin_level[GATE_PIN];
+    if (after && !before && rise_count < 512)
+    {
+        rises[rise_count++] = now_us;
+    }
+    if (before && !after && fall_count < 512)
+    {
+        falls[fall_count++] = now_us;
+    }
+}
+
+/** @brief   Steps the timer's counter up to a time, running the compare interrupt on the way.
+ */
+static void advance_to (uint32_t time)
+{
+    while (now_us < time)
+    {
+        now_us++;
+        TIM16->CNT = now_us & 0xFFFF;
+        if (TIM16->CNT == TIM16->CCR1)
+        {
+            run_isr (timer->channel_callback[TRIAC_CHANNEL]);
+        }
+    }
+}
+
+/** @brief   Runs the mains for a number of half cycles, with an edge at each crossing.
+ *  @param   first      Time of the first crossing [us]
+ *  @param   half_cycles Number of crossings
+ *  @param   half_period Time between crossings [us]
+ *  @returns The time of the first crossing after the last one [us]
+ */
+static double run_mains (double first, uint32_t half_cycles, double half_period)
+{
+    double crossing = first;
+    for (uint32_t n = 0; n < half_cycles; n++)
+    {
+        advance_to (lround (crossing));
+        run_isr (fake_pin_isr[ZC_PIN]);
+        crossing += half_period;
+    }
+    advance_to (lround (crossing) - 1);
+    return crossing;
+}
+
+/** @brief   Starts a driver's timer and interrupts, with the simulated time at 0.
+ */
+static void start (triacDriver& driver)
+{
+    driver.begin ();
+    timer = fake_last_timer;
+    now_us = 0;
+    rise_count = 0;
+    fall_count = 0;
+}
+
+void setUp (void)
+{
+}
+
+void tearDown (void)
+{
+}
+
+void test_timer_counts_microseconds (void)
+{
+    triacDriver driver (GATE_PIN, ZC_PIN, TIM16, 50);
+    start (driver);
+    TEST_ASSERT_EQUAL_UINT32 (TRIAC_TICK_HZ, timer->tick_rate ());
+    TEST_ASSERT_EQUAL_UINT32 (0xFFFF, TIM16->ARR);
+    TEST_ASSERT_TRUE (timer->running);
+    TEST_ASSERT_EQUAL_UINT32 (RISING, fake_pin_isr_mode[ZC_PIN]);
+    TEST_ASSERT_EQUAL_UINT8 (LOW, fake_pin_level[GATE_PIN]);
+}
+
+void test_table_gives_power_in_proportion (void)
+{
+    uint8_t frequencies[] = { 50, 60 };
+    for (uint8_t mains_hz : frequencies)
+    {
+        triacDriver driver (GATE_PIN, ZC_PIN, TIM16, mains_hz);
+        double half_period = 500000/mains_hz;
+        double worst = 0, linear = 0;
+        TEST_ASSERT_EQUAL_UINT16 (0, driver.delay (0));
+        for (int32_t duty = 1; duty < 256; duty++)
+        {
+            uint16_t delay = driver.delay (duty);
+            TEST_ASSERT_TRUE (delay >= TRIAC_MIN_DELAY_US && delay <= half_period - TRIAC_MARGIN_US);
+            if (duty > 1)
+            {
+                TEST_ASSERT_TRUE (delay <= driver.delay (duty - 1));
+            }
+            worst = max (worst, fabs (power_at (delay, half_period) - duty/255.0));
+            uint16_t straight = (1 - duty/255.0)*half_period;  // Delay in proportion instead
+            linear = max (linear, fabs (power_at (straight, half_period) - duty/255.0));
+        }
+        char message[96];
+        snprintf (message, sizeof (message), "%d Hz: worst power error %.4f%% from the table, "
+                  "%.1f%% from a linear delay", mains_hz, worst*100, linear*100);
+        TEST_MESSAGE (message);
+        TEST_ASSERT_TRUE (worst < 0.5/255);
+        TEST_ASSERT_TRUE (linear > 20*worst);
+        TEST_ASSERT_EQUAL_UINT16 (driver.delay (255), driver.delay (1000));
+    }
+}
+
+void test_gate_fires_at_the_delay_after_each_crossing (void)
+{
+    uint8_t frequencies[] = { 50, 60 };
+    for (uint8_t mains_hz : frequencies)
+    {
+        double half_period = 1e6/(2.0*mains_hz);
+        int32_t duties[] = { 1, 40, 128, 200, 255 };
+        for (int32_t duty : duties)
+        {
+            triacDriver driver (GATE_PIN, ZC_PIN, TIM16, mains_hz);
+            start (driver);
+            driver.run (duty, 0);
+            run_mains (1000, 8, half_period);   // Too few edges for the loop to lock
+            TEST_ASSERT_FALSE (driver.pll.locked);
+            TEST_ASSERT_EQUAL_UINT32 (8, rise_count);
+            TEST_ASSERT_EQUAL_UINT32 (8, fall_count);
+            for (uint32_t n = 0; n < 8; n++)
+            {
+                uint32_t crossing = lround (1000 + n*half_period);
+                TEST_ASSERT_EQUAL_UINT32 (driver.delay (duty), rises[n] - crossing);
+                TEST_ASSERT_EQUAL_UINT32 (TRIAC_PULSE_US, falls[n] - rises[n]);
+            }
+        }
+    }
+}
+
+void test_gate_fires_on_time_once_locked (void)
+{
+    uint8_t frequencies[] = { 50, 60 };
+    for (uint8_t mains_hz : frequencies)
+    {
+        triacDriver driver (GATE_PIN, ZC_PIN, TIM16, mains_hz);
+        start (driver);
+        double half_period = 1e6/(2.0*mains_hz);
+        driver.run (128, 0);
+        run_mains (1000, 40, half_period);      // Long enough to lock and to wrap the counter
+        TEST_ASSERT_TRUE (driver.pll.locked);
+        TEST_ASSERT_EQUAL_UINT32 (40, rise_count);
+        int32_t worst = 0;
+        for (uint32_t n = 0; n < rise_count; n++)
+        {
+            int32_t crossing = lround (1000 + n*half_period);
+            worst = max (worst, abs ((int32_t)(rises[n] - crossing) - driver.delay (128)));
+            TEST_ASSERT_EQUAL_UINT32 (TRIAC_PULSE_US, falls[n] - rises[n]);
+        }
+        TEST_ASSERT_LESS_OR_EQUAL (2, worst);
+    }
+}
+
+void test_delay_never_runs_into_the_next_half_cycle (void)
+{
+    triacDriver driver (GATE_PIN, ZC_PIN, TIM16, 60);
+    start (driver);
+    double half_period = 1e6/120;
+    driver.run (1, 0);
+    run_mains (1000, 40, half_period);
+    for (uint32_t n = 0; n < fall_count; n++)
+    {
+        uint32_t crossing = lround (1000 + n*half_period);
+        TEST_ASSERT_TRUE (falls[n] - crossing < half_period - TRIAC_MARGIN_US + TRIAC_PULSE_US + 2);
+    }
+    TEST_ASSERT_EQUAL_UINT32 (40, fall_count);
+}
+
+void test_duty_zero_never_fires (void)
+{
+    triacDriver driver (GATE_PIN, ZC_PIN, TIM16, 50);
+    start (driver);
+    double next = run_mains (1000, 40, 10000);
+    TEST_ASSERT_EQUAL_UINT32 (0, rise_count);
+    TEST_ASSERT_EQUAL_UINT8 (LOW, fake_pin_level[GATE_PIN]);
+    TEST_ASSERT_TRUE (driver.pll.locked);
+    driver.run (200, 1);                        // The direction is ignored
+    next = run_mains (next, 3, 10000);          // Starts from the first crossing, not the one after
+    TEST_ASSERT_EQUAL_UINT32 (3, rise_count);
+    driver.run (0, 0);
+    run_mains (next, 3, 10000);
+    TEST_ASSERT_EQUAL_UINT32 (4, rise_count);   // The half cycle already armed still fires
+    TEST_ASSERT_EQUAL_UINT8 (LOW, fake_pin_level[GATE_PIN]);
+}
+
+int main (void)
+{
+    UNITY_BEGIN ();
+    RUN_TEST (test_timer_counts_microseconds);
+    RUN_TEST (test_table_gives_power_in_proportion);
+    RUN_TEST (test_gate_fires_at_the_delay_after_each_crossing);
+    RUN_TEST (test_gate_fires_on_time_once_locked);
+    RUN_TEST (test_delay_never_runs_into_the_next_half_cycle);
+    RUN_TEST (test_duty_zero_never_fires);
+    return UNITY_END ();
+}